@@ -8,17 +8,23 @@
 #include "globals.h"
 #include "saveload.h"
 #include "subscriptions.h"
+#include "dialog.h"
+#include "rules.h"
 
-// Dashboard mode helper functions
-void add_category_dialog();
-void remove_category_dialog();
-void set_budget_dialog();
-void add_expense_dialog();
-void remove_transaction_dialog();
-void add_subscription_dialog();
-void remove_subscription_dialog(int selected_subscription);
+// Dashboard mode helper functions; each returns an open dialog for the main loop to drive
+Dialog *add_category_dialog();
+Dialog *remove_category_dialog();
+Dialog *set_budget_dialog();
+Dialog *add_expense_dialog();
+Dialog *remove_transaction_dialog();
+Dialog *remove_transactions_dialog(const unsigned long long *ids, int count);
+Dialog *edit_transaction_dialog(const Transaction *transaction);
+Dialog *add_subscription_dialog();
+Dialog *remove_subscription_dialog(int selected_subscription);
+Dialog *update_subscriptions_dialog();
+Dialog *export_csv_dialog();
 
 // Dashboard mode dialogs
-void budget_summary_dialog();
+Dialog *budget_summary_dialog();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef CATEGORY_IDS_H
+#define CATEGORY_IDS_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "globals.h"
+
+// Transactions name their category by id rather than by slot in the month's
+// categories. Ids belong to one month and are never handed out twice, so removing or
+// merging a category only touches the category records and this table: the slot is
+// emptied and an alias sends the old id to the category that replaced it.
+
+#define MAX_CATEGORY_ALIASES 64
+
+typedef struct
+{
+    int from_id;
+    int to_id; // -1 when the category was removed and its rows became uncategorized
+} CategoryAlias;
+
+typedef struct CategoryIds
+{
+    int next_id;
+    int alias_count;
+    CategoryAlias aliases[MAX_CATEGORY_ALIASES]; // never chained: to_id is a live id or -1
+} CategoryIds;
+
+// Slot of every id a month's transactions can carry, aliases included
+typedef struct
+{
+    int *slots; // indexed by id; -1 for uncategorized or unknown
+    int size;
+} CategoryMap;
+
+void category_ids_init(CategoryIds *ids, int next_id);
+int category_ids_assign(CategoryIds *ids); // an id no row has used
+// Send from_id, and every id already sent to it, to to_id; false if the table is full
+bool category_ids_alias(CategoryIds *ids, int from_id, int to_id);
+// The live id behind cat_id (itself unless aliased); -1 for uncategorized
+int category_ids_resolve(const CategoryIds *ids, int cat_id);
+
+// Start from a zeroed map; build again whenever the slots or aliases change
+int category_map_build(CategoryMap *map, const CategoryIds *ids, const Category *slots, int slot_count);
+int category_map_slot(const CategoryMap *map, int cat_id);
+void category_map_free(CategoryMap *map);
+
+#endif // CATEGORY_IDS_H
@@ -0,0 +1,82 @@
+#ifndef CATEGORY_STATS_H
+#define CATEGORY_STATS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "globals.h"
+#include "manifest.h"
+#include "month_file.h"
+
+// Per-category spending statistics, for flagging unusually large expenses. Each month
+// keeps a sidecar ("YYYY-M.stat" next to "YYYY-M.dat") with, for every category name,
+// the count, mean and sum of squared deviations of its expenses (Welford) and a
+// histogram of amounts on a log scale, plus the category and amount counted for every
+// record slot so a removal or edit can be taken back out. Merging the months is a few
+// additions per category, so no month file is read to answer.
+//
+// Every record in the sidecar has a fixed size, and room for CATEGORY_STATS_SPARE more
+// categories is left ahead of the slots, so adding, removing or editing a row patches
+// the header, the category it touches and its slot in place (a removal moves the last
+// slot into the hole and truncates), reading only the header and categories. A row in
+// a category that no longer fits rewrites the sidecar.
+//
+// An expense is unusual when, compared with every other expense in its category, it
+// is more than CATEGORY_STATS_SIGMAS standard deviations above the mean and falls in a
+// histogram bucket above the one holding the CATEGORY_STATS_QUANTILE quantile.
+
+#define CATEGORY_STATS_MAGIC "tbstats"
+#define CATEGORY_STATS_VERSION 2
+
+#define CATEGORY_STATS_SPARE 8 // categories a sidecar has room for beyond its own
+#define CATEGORY_STATS_BUCKETS 96 // three per doubling: 1 cent up to about $42M
+#define CATEGORY_STATS_MIN_COUNT 8 // other expenses needed before any are flagged
+#define CATEGORY_STATS_SIGMAS 2.0
+#define CATEGORY_STATS_QUANTILE 0.95
+
+typedef struct
+{
+    char magic[8];
+    int version;
+    int transaction_count; // slots that follow the categories
+    int category_count;
+    int category_capacity; // CategoryStats records before the slots, the unused ones zero
+    unsigned long long generation; // manifest generation of the month file this matches
+} CategoryStatsHeader;
+
+typedef struct
+{
+    char name[MAX_NAME_LEN]; // "Uncategorized" for rows without a category
+    int count;
+    int reserved;
+    double mean; // cents
+    double m2;   // sum of squared differences from the mean
+    int buckets[CATEGORY_STATS_BUCKETS];
+} CategoryStats;
+
+typedef struct
+{
+    int stats; // index into the month's CategoryStats, -1 for rows not counted (income)
+    int reserved;
+    Money amount;
+} CategoryStatsSlot;
+
+// Sidecar hooks, as described in month_file.h
+int category_stats_add(int year, int month, int first_slot, const Transaction *transactions, int count, unsigned long long previous_generation);
+int category_stats_remove(int year, int month, int slot, int moved_slot, unsigned long long previous_generation);
+int category_stats_remove_slots(int year, int month, const int *new_slots, int old_count, unsigned long long previous_generation);
+int category_stats_update(int year, int month, int slot, const Transaction *transaction, unsigned long long previous_generation);
+
+// Called by the dispatchers after the hooks above. The hooks count this process's
+// changes into the merged totals, so they move to the new manifest generation
+// instead of being merged again.
+void category_stats_advance(void);
+
+// Whether an expense in the named category stands out from the rest of its history.
+// Merges every month's sidecar the first time and after another process changes a
+// month, rebuilding missing or stale ones, so main thread only.
+bool category_stats_unusual(const char *category_name, const Transaction *transaction);
+void category_stats_free(void);
+
+#endif // CATEGORY_STATS_H
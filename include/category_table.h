@@ -0,0 +1,53 @@
+#ifndef CATEGORY_TABLE_H
+#define CATEGORY_TABLE_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "globals.h"
+#include "category_ids.h"
+
+// The loaded month's categories: a growable array of slots, the id lookup for its
+// transactions, and sorted_categories_indices kept in budget order as categories come
+// and go instead of being re-sorted after every change.
+//
+// A category may sit under a top-level parent (Category.parent_id). Each parent's
+// rollup adds its children's budget, spending and carry to its own; the rollups are
+// rebuilt when categories come and go, and adjusted by category_add_spent as
+// transactions change.
+
+typedef struct
+{
+    Money budget;
+    Money spent;
+    Money extra;
+} CategoryRollup;
+
+// Make room for slot_count slots; new slots are empty
+int category_table_reserve(int slot_count);
+// After categories[0..slot_count) and category_ids were replaced wholesale
+int category_table_rebuild(int slot_count);
+// After a slot was filled or emptied, its parent changed, or aliases were added
+int category_table_refresh_ids(void);
+// After the amounts of many slots changed at once
+void category_rollups_rebuild(void);
+// Change a slot's spending and its parent's rollup with it
+void category_add_spent(int slot, Money delta);
+// The slot's own figures, or with its children's added; a child's are the same either way
+CategoryRollup category_figures(int slot, bool rolled_up);
+int category_parent_slot(int slot); // -1 for a top-level category
+// Fill out_slots (room for category_count) with the rows to show: top-level categories
+// by rolled-up budget, each followed by its children unless top_level. Returns the count.
+int category_display_order(int *out_slots, bool top_level);
+
+// Keep sorted_categories_indices in step with one slot gaining or losing its budget
+void category_order_insert(int slot);
+void category_order_remove(int slot);
+
+void category_table_free(void);
+
+// Lookups for the loaded month
+int category_slot(int cat_id);
+int category_id(int slot); // -1 for -1
+const Category *category_of(int cat_id); // NULL for uncategorized
+
+#endif // CATEGORY_TABLE_H
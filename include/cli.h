@@ -0,0 +1,31 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <limits.h>
+#include "globals.h"
+#include "saveload.h"
+#include "utils.h"
+#include "query.h"
+#include "rules.h"
+#include "recurring.h"
+
+// Headless commands: run without ncurses so scripts and cron jobs can edit data.
+// Rows on stdin are "YYYY-MM-DD,amount,category,description", one per line; a negative
+// amount is income, an empty category is uncategorized and the description may hold commas.
+// Rows added without a category take the one the rules in rules.h give them, if any.
+
+#define CLI_EXIT_OK 0
+#define CLI_EXIT_USAGE 1
+#define CLI_EXIT_REJECTED 2 // some rows were skipped
+#define CLI_EXIT_IO 3
+
+bool is_cli_command(const char *arg);
+int run_cli_command(int argc, char *argv[]); // argv[0] is the command name
+void print_cli_usage(const char *program_name);
+
+#endif // CLI_H
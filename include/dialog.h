@@ -0,0 +1,87 @@
+#ifndef DIALOG_H
+#define DIALOG_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "ui.h"
+#include "globals.h"
+
+// A dialog is a sequence of input widgets driven one key at a time by the main loop,
+// so the dashboard keeps handling timers, background work and resizes while it is open
+
+typedef enum
+{
+    DIALOG_OPEN,
+    DIALOG_CLOSED
+} DialogStatus;
+
+typedef enum
+{
+    FIELD_NONE,
+    FIELD_INPUT,
+    FIELD_MENU,
+    FIELD_CONFIRM,
+    FIELD_DATE,
+    FIELD_TRANSACTION,
+    FIELD_MESSAGE // "Press any key to continue", then the dialog closes
+} DialogFieldKind;
+
+typedef struct Dialog Dialog;
+
+/*
+ * Called when the active field finishes or is cancelled. dialog->step says which field
+ * it was; read its value from dialog->field_state before starting the next field.
+ * Returning DIALOG_OPEN without starting a new field closes the dialog.
+ */
+typedef DialogStatus (*DialogAdvance)(Dialog *dialog, WidgetStatus status);
+
+struct Dialog
+{
+    BoundedWindow frame;
+    int height;
+    int width;
+    int step;
+    DialogFieldKind field;
+    union
+    {
+        InputField input;
+        MenuField menu;
+        ConfirmField confirm;
+        DateField date;
+        TransactionField transaction;
+    } field_state;
+    char **menu_items; // owned strings behind the active menu, if any
+    int *menu_values;  // owned value behind each of those strings, if any
+    int menu_item_count;
+    DialogAdvance advance;
+    Dialog *next; // opened by the main loop once this dialog closes
+    void *ctx;    // per-dialog state, freed with the dialog
+};
+
+// Create a centered dialog with zeroed ctx_size bytes of per-dialog state
+Dialog *dialog_open(const char *title, int height, int width, DialogAdvance advance, size_t ctx_size);
+void dialog_free(Dialog *dialog);
+
+DialogStatus dialog_handle_key(Dialog *dialog, int ch);
+
+// Re-center after a terminal resize
+void dialog_relayout(Dialog *dialog);
+
+// Queue the dialog for the next doupdate(), on top of whatever was drawn under it
+void dialog_noutrefresh(Dialog *dialog);
+
+// Start the next field; step is handed back to the advance callback when it finishes
+void dialog_input(Dialog *dialog, int step, const char *prompt, int max_len, InputType type);
+void dialog_menu(Dialog *dialog, int step, const char *prompt, const char *items[], int item_count, int max_visible_items, int start_y, bool show_numbers);
+// Takes ownership of items and values (which may be NULL)
+void dialog_owned_menu(Dialog *dialog, int step, const char *prompt, char **items, int *values, int item_count, int max_visible_items, int start_y, bool show_numbers);
+// Value behind the chosen item of an owned menu, or its position when it has no values
+int dialog_menu_value(Dialog *dialog);
+void dialog_confirm(Dialog *dialog, int step, const char *message[], int item_count);
+void dialog_date(Dialog *dialog, int step, const char *prompt);
+void dialog_transaction(Dialog *dialog, int step, const OrderIndex *transactions, int max_visible_items);
+
+// Show a message until the next key, then close; returns DIALOG_OPEN for use in advance
+DialogStatus dialog_message(Dialog *dialog, const char *message);
+
+#endif // DIALOG_H
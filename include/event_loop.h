@@ -0,0 +1,65 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <ncurses.h>
+#include <stdbool.h>
+
+#define MAX_EVENT_TIMERS 16
+#define MAX_EVENT_WATCHES 4
+
+typedef void (*EventCallback)(void *arg);
+typedef void (*WatchCallback)(const char *file_name, void *arg);
+
+// Set up the wake pipe and notification fd; call once before event_loop_next_key
+int event_loop_init();
+void event_loop_shutdown();
+
+/*
+ * Schedule cb to run on the UI thread after interval_ms, and every interval_ms after
+ * that if repeat is set.
+ *
+ * Returns:
+ *   >= 0  - Timer id
+ *   -1    - Too many timers
+ */
+int event_loop_add_timer(int interval_ms, bool repeat, EventCallback cb, void *arg);
+void event_loop_cancel_timer(int timer_id);
+
+/*
+ * Call cb with the file name whenever a file in dir is finished being written or is
+ * moved into it. Only available where inotify exists.
+ *
+ * Returns:
+ *   >= 0  - Watch id
+ *   -1    - Notifications unavailable or too many watches
+ */
+int event_loop_watch_dir(const char *dir, WatchCallback cb, void *arg);
+
+// Queue cb to run on the UI thread; safe to call from any thread. Tasks posted after
+// event_loop_shutdown are dropped.
+void event_loop_post(EventCallback cb, void *arg);
+
+/*
+ * Run work(arg) on a detached worker thread, then post done(arg) (if not NULL) back
+ * to the UI thread.
+ *
+ * Returns:
+ *   0     - Worker started
+ *   -1    - Thread could not be created
+ */
+int event_loop_submit(EventCallback work, EventCallback done, void *arg);
+
+/*
+ * Wait up to timeout_ms (-1 = forever) for the next key, dispatching timers, posted
+ * tasks and file notifications while waiting.
+ *
+ * Returns the key, or ERR if the wait ended without one (timeout or after dispatching
+ * events; check event_loop_take_redraw to see if anything changed on screen).
+ */
+int event_loop_next_key(int timeout_ms);
+
+// Callbacks ask for a repaint through this instead of drawing themselves
+void event_loop_request_redraw();
+bool event_loop_take_redraw();
+
+#endif // EVENT_LOOP_H
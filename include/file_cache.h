@@ -3,6 +3,7 @@
 
 #include <time.h>
 #include "globals.h"
+#include "manifest.h"
 
 // hopefully the rest is just handled by the OS caching system . . . fopen is slow right
 
@@ -26,5 +27,6 @@ FILE *open_file(const char *relative_file_path, bool create_if_not_exists);
 void remove_oldest_cached_file(void);
 void cache_recent_months(void);
 FILE* open_month_file(int year, int month);
+FILE *open_existing_month_file(int year, int month); // NULL if the month was never written
 
 #endif // FILE_CACHE_H 
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "globals.h"
+#include "manifest.h"
+#include "month_file.h"
+
+// Duplicate detection. A transaction's fingerprint hashes its date, signed amount and
+// description with case, spaces and punctuation dropped, so a row re-imported from
+// another export of the same statement hashes the same. Each month keeps the
+// fingerprint of every record slot in a sidecar ("YYYY-M.fp" next to "YYYY-M.dat"),
+// 8 bytes per transaction, kept in step with every write to the month file.
+
+#define FINGERPRINT_MAGIC "tbfprnt"
+#define FINGERPRINT_VERSION 1
+
+typedef struct
+{
+    char magic[8];
+    int version;
+    int transaction_count; // fingerprints that follow, in slot order
+    unsigned long long generation; // manifest generation of the month file this matches
+} FingerprintHeader;
+
+// A month's fingerprints as a multiset: the same purchase can really happen twice in
+// a day, so each stored copy can only be matched once
+typedef struct
+{
+    unsigned long long *keys;
+    int *counts; // 0 marks an empty slot
+    int capacity;
+} FingerprintSet;
+
+unsigned long long transaction_fingerprint(const Transaction *transaction);
+
+// Sidecar hooks, as described in month_file.h
+int fingerprint_index_add(int year, int month, int first_slot, const Transaction *transactions, int count, unsigned long long previous_generation);
+int fingerprint_index_remove(int year, int month, int slot, int moved_slot, unsigned long long previous_generation);
+int fingerprint_index_remove_slots(int year, int month, const int *new_slots, int old_count, unsigned long long previous_generation);
+int fingerprint_index_update(int year, int month, int slot, const Transaction *transaction, unsigned long long previous_generation);
+
+// Load a month's fingerprints, rebuilding a missing or stale sidecar first, so main
+// thread only. A month with no file gives an empty set.
+int fingerprint_set_load(int year, int month, FingerprintSet *set);
+// If the set holds a copy of the transaction's fingerprint, use it up and return true
+bool fingerprint_set_take(FingerprintSet *set, const Transaction *transaction);
+void fingerprint_set_free(FingerprintSet *set);
+
+#endif // FINGERPRINT_H
@@ -0,0 +1,40 @@
+#ifndef FUZZY_H
+#define FUZZY_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+
+// Type-to-filter matching for pickers. A candidate matches when the query's characters
+// appear in it in order, ignoring case. Matches are ranked by score: consecutive
+// characters and characters at the start of words count for more, gaps count against.
+
+#define FUZZY_MAX_QUERY 32
+
+typedef struct
+{
+    int index; // into the candidate list
+    int score;
+} FuzzyMatch;
+
+typedef struct
+{
+    const char *const *candidates; // not owned
+    int count;
+    unsigned long long *masks; // which characters each candidate contains
+    FuzzyMatch *matches;       // best first; equal scores keep candidate order
+    int match_count;
+    char query[FUZZY_MAX_QUERY];
+    int query_len;
+} FuzzyMatcher;
+
+int fuzzy_init(FuzzyMatcher *matcher, const char *const *candidates, int count);
+// Rescore for a new query; a query that extends the last one only revisits its matches
+void fuzzy_set_query(FuzzyMatcher *matcher, const char *query);
+void fuzzy_free(FuzzyMatcher *matcher);
+
+// Score one candidate, filling positions (query_len entries) when it matches; -1 if not
+int fuzzy_score(const char *candidate, const char *query, int *positions);
+
+#endif // FUZZY_H
@@ -6,6 +6,7 @@
 #include <string.h>
 #include <stddef.h>
 #include "flex_layout.h"
+#include "money.h"
 
 // Constants
 #define NUM_CONSTANTS 2
@@ -14,8 +15,8 @@
 #define DEFAULT_DIALOG_WIDTH 70
 
 // must be constant for savefiles
-#define MAX_CATEGORIES 32
 #define MAX_NAME_LEN 32
+#define MAX_TAGS 32 // one bit each in Transaction.tags
 
 // Period types for subscriptions
 #define PERIOD_WEEKLY 0
@@ -57,26 +58,30 @@ static inline char *trunc_str(const char *str, size_t len)
 // Structures
 typedef struct
 {
-    double budget;
-    double spent;
-    double extra;
+    Money budget;
+    Money spent;
+    Money extra; // carried in from earlier months when the month is loaded; see rollover.h
     char name[MAX_NAME_LEN];
+    int id;        // what transactions store in cat_id; -1 for an empty slot
+    int parent_id; // id of the category it sits under; -1 for a top-level category
 } Category;
 
 typedef struct
 {
     bool expense;
-    double amt;
-    int cat_index;
+    unsigned int tags; // bit i set for tag_names[i]; sits in what was padding before amt
+    Money amt;
+    int cat_id; // -1 for uncategorized; see category_ids.h
     char desc[MAX_NAME_LEN];
     char date[11]; // Format: YYYY-MM-DD
+    unsigned long long id; // stable across edits and moves within the file; see month_file.h
 } Transaction;
 
 typedef struct
 {
     char name[MAX_NAME_LEN];
     bool expense;         // true if it's an expense, false if income
-    double amount;        // amount of money
+    Money amount;         // amount of money
     int period_type;      // PERIOD_WEEKLY, PERIOD_MONTHLY, PERIOD_YEARLY
     int period_day;       // 0-6 for weekly (Sun-Sat), 1-31 for monthly, 1-12 for yearly (month)
     int period_month_day; // Only used for yearly (1-31 for day of month)
@@ -97,16 +102,19 @@ typedef struct TransactionNode
 // Global variables from data file (loaded by init)
 extern Subscription *subscriptions;
 extern int subscription_count;
-extern double default_monthly_budget;
-extern Category default_categories[MAX_CATEGORIES];
+extern Money default_monthly_budget;
+extern Category *default_categories; // no empty slots
 extern int default_category_count;
+extern char tag_names[MAX_TAGS][MAX_NAME_LEN]; // see tag_index.h
+extern int tag_count;
 
-// Global variables dependent on current month (loaded by load_month)
-extern int category_count;
-extern Category categories[MAX_CATEGORIES];
-extern int sorted_categories_indices[MAX_CATEGORIES];
-extern double uncategorized_spent;
-extern double current_month_total_budget;
+// Global variables dependent on current month (loaded by load_month); see category_table.h
+extern int category_count;             // categories with a budget
+extern int category_slot_count;        // slots in categories, removed ones included
+extern Category *categories;           // removed categories leave a slot with no budget
+extern int *sorted_categories_indices; // slots of the category_count categories, largest budget first
+extern Money uncategorized_spent;
+extern Money current_month_total_budget;
 
 // Month management
 extern int today_month;
@@ -127,7 +135,8 @@ extern const short pie_colors_darker[][2];
 
 extern TransactionNode *transaction_head;
 extern TransactionNode *transaction_tail;
-extern TransactionNode **sorted_transactions; // array of pointers to transactions, sorted (this is cursed)
+extern struct OrderIndex sorted_transactions; // the loaded month newest first; see order_index.h
+extern struct CategoryIds category_ids;       // the loaded month's; see category_ids.h
 extern int current_month_transaction_count;
 
 static const char days_in_week[][10] = {
@@ -0,0 +1,34 @@
+#ifndef HISTORY_FILTER_H
+#define HISTORY_FILTER_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "globals.h"
+#include "order_index.h"
+
+// Live "/" filter for the Transaction History pane. Each row of the pane's sort order
+// gets a lowercase "description category" string once; typing narrows the current
+// matches and only a shorter or edited query rescans every row.
+
+#define HISTORY_FILTER_TEXT_LEN (2 * MAX_NAME_LEN)
+
+typedef struct
+{
+    char query[MAX_NAME_LEN]; // lowercase
+    int query_len;
+    bool editing; // keys go to the query until Enter or Escape
+    char (*text)[HISTORY_FILTER_TEXT_LEN]; // per row of the order it was built for
+    int row_count;                         // rows the text column was built for
+    int *matches;                          // rows of that order, in display order
+    int match_count;
+} HistoryFilter;
+
+bool history_filter_active(const HistoryFilter *filter);
+// Rebuild the text column after the month's rows or the pane's sort order changed
+int history_filter_refresh(HistoryFilter *filter, const OrderIndex *order);
+int history_filter_set_query(HistoryFilter *filter, const char *query);
+void history_filter_clear(HistoryFilter *filter);
+void history_filter_free(HistoryFilter *filter);
+
+#endif // HISTORY_FILTER_H
@@ -0,0 +1,34 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <ncurses.h>
+#include <stdbool.h>
+
+// Longest digit run accepted as a vim-style count prefix
+#define MAX_COUNT_DIGITS 15
+// Counts and net motions are clamped to this, so no digit run can overflow an int
+#define MAX_COUNT 999999999
+
+// Upper bound on how long queued input may hold off a repaint
+#define MAX_INPUT_DEFER_MS 100
+
+bool is_vertical_motion(int ch);
+
+// Signed row movement for one motion key ('j' and 'k' honour the count, arrows move one row)
+int motion_delta(int ch, int count);
+
+// Count prefix spelled by digits, between 1 and MAX_COUNT
+int parse_count(const char *digits);
+
+// Fold the motion `first_ch` (with its count) and every motion already queued behind it
+// into one net row delta. Queued count prefixes are applied to the motion they precede;
+// the first non-motion key is pushed back so the caller sees it next.
+int coalesce_motions(int first_ch, int count);
+
+// Non-blocking read of the next queued key, ERR if there is none
+int read_queued_key();
+
+// True if a key is waiting in the input queue, without consuming it
+bool input_pending();
+
+#endif // INPUT_H
@@ -8,6 +8,10 @@
 #include "flex_layout.h"
 #include "subscriptions.h"
 #include "file_cache.h"
+#include "input.h"
+#include "event_loop.h"
+#include "cli.h"
+#include "history_filter.h"
 #include <locale.h>
 
 void print_usage(const char *program_name);
@@ -0,0 +1,81 @@
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include "globals.h"
+#include "month_file.h"
+
+// One small file in data_storage_dir summarizing every materialized month, so
+// questions about which months exist and what they total don't open each month file.
+// After the entries comes a variable-length section with each month's live
+// categories (id, name, budget and spent), category_records of them per entry in
+// entry order.
+//
+// Processes take turns through an flock on MANIFEST_LOCK_NAME, not on the manifest,
+// which a full rewrite replaces: recording a month holds it exclusively from re-reading
+// the manifest to writing it back, and reading holds it shared. A change that keeps the
+// month's category_records patches its entry and records in place and writes the
+// header last; only a change in the record count rewrites the file.
+
+#define MANIFEST_FILE_NAME "manifest.dat"
+#define MANIFEST_LOCK_NAME "manifest.dat.lock"
+#define MANIFEST_MAGIC "tbmanif"
+#define MANIFEST_VERSION 6
+
+typedef struct
+{
+    char magic[8];                 // MANIFEST_MAGIC
+    int version;                   // MANIFEST_VERSION
+    int entry_count;
+    int category_record_count;     // ManifestCategory records after the entries
+    int reserved;
+    unsigned long long generation; // bumped on every recorded change
+} ManifestHeader;
+
+typedef struct
+{
+    int year;
+    int month;
+    int transaction_count;
+    int category_count;
+    int category_first;   // where the month's ManifestCategory records start (recomputed on load)
+    int category_records; // categories with a budget
+    Money budget;
+    Money uncategorized_spent;
+    long byte_size;                // size of the month file
+    unsigned long long generation; // manifest generation of the month's last change
+} ManifestEntry;
+
+typedef struct
+{
+    int id;
+    int parent_id;
+    char name[MAX_NAME_LEN];
+    Money budget;
+    Money spent;
+} ManifestCategory;
+
+// Read the manifest, rebuilding it from the month files if it is missing or unreadable
+int manifest_load(void);
+int manifest_rebuild(void);
+// Another tbudget process may have recorded changes since we last read or wrote the
+// manifest: re-read it only if the generation on disk isn't ours
+int manifest_sync(void);
+
+// Refresh a month's entry from its (open) data file and persist the manifest
+int manifest_record_month(int year, int month, FILE *file);
+
+const ManifestEntry *manifest_find(int year, int month);
+const ManifestEntry *manifest_entries(int *count); // oldest month first
+// The entry's category_records categories, in slot order; valid until the next change
+const ManifestCategory *manifest_categories(const ManifestEntry *entry);
+unsigned long long manifest_generation(void);
+void manifest_free(void);
+
+#endif // MANIFEST_H
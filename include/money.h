@@ -0,0 +1,32 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Amounts of money as whole cents. Adding cents is exact, so a total comes out the
+// same whichever order its rows are summed in, and comparing two amounts never needs
+// a tolerance. Doubles only appear where a ratio is wanted (percentages, the pie chart).
+
+typedef long long Money;
+
+#define MONEY_SCALE 100
+#define MONEY_FORMAT_LEN 24 // "-92233720368547758.08" and the terminator
+
+// Nearest cent, halves away from zero; for amounts stored as doubles by older versions
+Money money_from_double(double value);
+double money_to_double(Money amount);
+
+// "1234.56", "-0.05"; buf must hold MONEY_FORMAT_LEN bytes. Returns the length.
+int money_format(char *buf, Money amount);
+// money_format into one of a few static buffers, so a single printf can take several;
+// main thread only
+const char *money_str(Money amount);
+
+// "12", "12.3", "12.34", "-12.34", "+12" or ".5"; false for anything else, including a
+// third decimal, so no input is silently rounded
+bool money_parse(const char *text, Money *out);
+
+#endif // MONEY_H
@@ -0,0 +1,126 @@
+#ifndef MONTH_FILE_H
+#define MONTH_FILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include "globals.h"
+#include "category_ids.h"
+
+// Layout of a month file ("YYYY-M.dat"), in order:
+//   MonthFileHeader (including the category slot count and alias table)
+//   budget (Money)
+//   category count (int), not counting empty slots
+//   header.category_slots Category records; removing a category empties its slot
+//   and the next category added fills it
+//   uncategorized spent (Money)
+//   transaction count (int)
+//   Transaction records, unordered
+// Files from before the header existed start straight at the budget and carry no
+// transaction ids, and versions 1 and 2 always stored LEGACY_CATEGORY_SLOTS category
+// records without ids; before version 4 every amount was a double rather than cents,
+// before version 5 categories had no parent, and before version 6 transactions had
+// no tags. migrate_month_files rewrites them once at startup.
+
+#define MONTH_FILE_MAGIC "tbmonth"
+#define MONTH_FILE_VERSION 6
+
+// Every month file stored this many category slots before version 3
+#define LEGACY_CATEGORY_SLOTS 32
+
+// Category record as stored before version 3, before it carried its id
+typedef struct
+{
+    double budget;
+    double spent;
+    double extra;
+    char name[MAX_NAME_LEN];
+} LegacyCategory;
+
+// Category record as stored by version 3, and by version 2 data files, with amounts
+// still doubles
+typedef struct
+{
+    double budget;
+    double spent;
+    double extra;
+    char name[MAX_NAME_LEN];
+    int id;
+} CategoryV3;
+
+// Category record as stored by version 4, and by version 3 data files, before parents;
+// the same size as Category, with padding where parent_id is now
+typedef struct
+{
+    Money budget;
+    Money spent;
+    Money extra;
+    char name[MAX_NAME_LEN];
+    int id;
+} CategoryV4;
+
+typedef struct
+{
+    char magic[8];                    // MONTH_FILE_MAGIC
+    int version;                      // MONTH_FILE_VERSION
+    int category_slots;               // Category records in the file
+    unsigned long long next_sequence; // sequence part of the next transaction id
+    CategoryIds category_ids;         // next category id and aliases of removed ones
+} MonthFileHeader;
+
+// Byte offsets of each section, so no caller has to add up the layout by hand.
+// Everything after the categories moves with the slot count in the header.
+#define MONTH_BUDGET_OFFSET ((long)sizeof(MonthFileHeader))
+#define MONTH_CATEGORY_COUNT_OFFSET (MONTH_BUDGET_OFFSET + (long)sizeof(Money))
+#define MONTH_CATEGORY_OFFSET(index) (MONTH_CATEGORY_COUNT_OFFSET + (long)sizeof(int) + (long)sizeof(Category) * (index))
+#define MONTH_UNCATEGORIZED_OFFSET(header) MONTH_CATEGORY_OFFSET((header)->category_slots)
+#define MONTH_TRANSACTION_COUNT_OFFSET(header) (MONTH_UNCATEGORIZED_OFFSET(header) + (long)sizeof(Money))
+#define MONTH_TRANSACTION_OFFSET(header, slot) (MONTH_TRANSACTION_COUNT_OFFSET(header) + (long)sizeof(int) + (long)sizeof(Transaction) * (slot))
+
+// Transaction ids are unique across months: the month they were created in sits
+// above a per-month sequence. Sequence 0 is never handed out, so id 0 means "none".
+#define TRANSACTION_ID(year, month, sequence) (((unsigned long long)(year) << 44) | ((unsigned long long)(month) << 40) | (unsigned long long)(sequence))
+#define TRANSACTION_ID_YEAR(id) ((int)((id) >> 44))
+#define TRANSACTION_ID_MONTH(id) ((int)(((id) >> 40) & 0xF))
+
+// Year and month from a "YYYY-M.dat" name; false for anything else, sidecars included
+bool parse_month_file_name(const char *name, int *year, int *month);
+
+void init_month_header(MonthFileHeader *header);
+// 1 for a current header, 0 for an empty file, -1 for anything else
+int read_month_header(FILE *file, MonthFileHeader *header);
+int write_month_header(FILE *file, const MonthFileHeader *header);
+// Read the header.category_slots records after a successful read_month_header; the caller frees them
+int read_month_categories_section(FILE *file, const MonthFileHeader *header, Category **out_slots);
+// Add an empty slot at the end of the categories, moving everything after them along
+int grow_month_categories(FILE *file, MonthFileHeader *header);
+
+// Upgrade every month file in data_storage_dir to the current layout
+int migrate_month_files(void);
+
+// Sidecars are per-month files next to "YYYY-M.dat" that index or summarize its
+// records by slot: the search index (.tri), tag bitmaps (.tag), fingerprints (.fp) and
+// category statistics (.stat). Each module keeps its sidecar in step with every write
+// to the month file through four hooks, called once the manifest has recorded it:
+//   *_add(year, month, first_slot, transactions, count, previous_generation)
+//     count records were appended from first_slot on
+//   *_remove(year, month, slot, moved_slot, previous_generation)
+//     the record in slot was removed and the last record, moved_slot, was moved into
+//     it to keep the file dense; moved_slot is -1 when slot was the last record
+//   *_remove_slots(year, month, new_slots, old_count, previous_generation)
+//     new_slots[i] is where the record in slot i of old_count went, or -1 if removed
+//   *_update(year, month, slot, transaction, previous_generation)
+//     the record in slot was rewritten in place
+// previous_generation is the month's manifest generation before the write. A sidecar
+// that doesn't carry it (missing, from another version or behind the month file) is
+// not patched but rebuilt from the month file under the new generation. The hooks
+// return 1, -1 for I/O errors or -2 for malloc errors.
+
+// "YYYY-M.<extension><suffix>" in data_storage_dir
+void sidecar_path(char *path, size_t size, int year, int month, const char *extension, const char *suffix);
+// The new_slots of a single removal over old_count slots, for handing a *_remove to
+// *_remove_slots; the caller frees it. NULL on malloc error.
+int *removal_slot_map(int slot, int moved_slot, int old_count);
+
+#endif // MONTH_FILE_H
@@ -0,0 +1,64 @@
+#ifndef ORDER_INDEX_H
+#define ORDER_INDEX_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "globals.h"
+#include "category_table.h"
+
+// A sorted view over the loaded month's transaction nodes that stays sorted as rows
+// come and go. It is a treap (a search tree kept balanced by random heap priorities)
+// whose nodes count their subtree, so inserting, removing, fetching row k and finding
+// a node's row are all O(log n).
+
+// Must be a total order over distinct transactions, so ties are broken on id
+typedef int (*OrderCompare)(const Transaction *a, const Transaction *b);
+
+typedef struct OrderNode
+{
+    TransactionNode *transaction;
+    struct OrderNode *left;
+    struct OrderNode *right;
+    unsigned int priority;
+    int size; // nodes in this subtree
+} OrderNode;
+
+typedef struct OrderIndex
+{
+    OrderCompare compare;
+    OrderNode *root;
+} OrderIndex;
+
+// Columns the Transaction History pane can be sorted on
+typedef enum
+{
+    SORT_BY_DATE,
+    SORT_BY_AMOUNT,
+    SORT_BY_CATEGORY,
+    SORT_BY_DESCRIPTION,
+    NUM_SORT_FIELDS
+} SortField;
+
+// Newest first; rows from the same day newest-added first
+int order_by_date(const Transaction *a, const Transaction *b);
+// The other columns fall back to order_by_date for ties
+int order_by_amount(const Transaction *a, const Transaction *b);      // largest charge first, income last
+int order_by_category(const Transaction *a, const Transaction *b);    // name A-Z, by the loaded categories
+int order_by_description(const Transaction *a, const Transaction *b); // A-Z, ignoring case
+const char *sort_field_name(SortField field);
+
+void order_index_init(OrderIndex *index, OrderCompare compare);
+// Replace the contents with every node of a transaction list
+int order_index_build(OrderIndex *index, TransactionNode *head);
+int order_index_insert(OrderIndex *index, TransactionNode *transaction);
+// The transaction's sort fields must be what they were when it was inserted
+bool order_index_remove(OrderIndex *index, const TransactionNode *transaction);
+TransactionNode *order_index_at(const OrderIndex *index, int row); // NULL past the end
+int order_index_rank(const OrderIndex *index, const TransactionNode *transaction); // -1 if absent
+// Row of the first transaction that doesn't sort before probe (the count if none)
+int order_index_lower_bound(const OrderIndex *index, const Transaction *probe);
+int order_index_count(const OrderIndex *index);
+void order_index_free(OrderIndex *index);
+
+#endif // ORDER_INDEX_H
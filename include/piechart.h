@@ -25,7 +25,8 @@ void init_pie_chart_colors();
 // Function to draw a pie chart of categories
 void draw_pie_chart(WINDOW *win, int center_y, int center_x, double height, double width, PieSlice slices[], int slice_count);
 
-// Function that displays both pie chart and legend
-void display_budget_pie_chart(WINDOW *win, double width, double height);
+// Function that displays both pie chart and legend; top-level categories with their
+// children rolled in, or every category on its own
+void display_budget_pie_chart(WINDOW *win, double width, double height, bool top_level);
 
 #endif // PIECHART_H 
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "globals.h"
+#include "saveload.h"
+#include "manifest.h"
+
+// Worker threads used to scan month files, at most one per month
+#define MAX_QUERY_THREADS 16
+
+typedef enum
+{
+    QUERY_GROUP_NONE,
+    QUERY_GROUP_MONTH,
+    QUERY_GROUP_CATEGORY,
+    QUERY_GROUP_PAYEE // transaction description
+} QueryGroupBy;
+
+typedef enum
+{
+    QUERY_ALL,
+    QUERY_EXPENSES,
+    QUERY_INCOME
+} QueryKind;
+
+typedef struct
+{
+    char from_date[11];          // inclusive YYYY-MM-DD, empty for no bound
+    char to_date[11];            // inclusive YYYY-MM-DD, empty for no bound
+    bool has_category;
+    char category[MAX_NAME_LEN]; // empty matches uncategorized transactions
+    bool has_min_amount;
+    Money min_amount;            // amounts are signed: income is negative
+    bool has_max_amount;
+    Money max_amount;
+    char match[MAX_NAME_LEN];    // case-insensitive substring of the description
+    unsigned int all_tags;       // tag bits a transaction must all carry
+    unsigned int no_tags;        // tag bits it must carry none of
+    QueryKind kind;
+    QueryGroupBy group_by;
+} Query;
+
+typedef struct
+{
+    char key[MAX_NAME_LEN]; // month, category or payee; empty when not grouping
+    int count;
+    Money sum; // exact, so merging the workers' tables in any order gives the same total
+} QueryGroup;
+
+typedef struct
+{
+    QueryGroup *groups;
+    int group_count;
+    int months_scanned;
+} QueryResult;
+
+/*
+ * Scan every month file in the query's date range in parallel and aggregate the
+ * matching transactions. Groups come back ordered by month, or by descending sum
+ * for category and payee groups.
+ */
+int run_query(const Query *query, QueryResult *result);
+void free_query_result(QueryResult *result);
+
+#endif // QUERY_H
@@ -0,0 +1,63 @@
+#ifndef RANGE_VIEW_H
+#define RANGE_VIEW_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "globals.h"
+#include "manifest.h"
+
+// Transactions from every month in a date range, newest first. Each month is sorted
+// once on open; rows are produced by a k-way merge of those runs only as far as the
+// requested window reaches.
+
+typedef enum
+{
+    HISTORY_MONTH, // the loaded month, served from sorted_transactions
+    HISTORY_LAST_90_DAYS,
+    HISTORY_QUARTER, // quarter containing the viewed month
+    NUM_HISTORY_RANGES
+} HistoryRange;
+
+typedef struct
+{
+    Transaction *rows; // in range, newest first
+    int count;
+    int next; // first row not yet taken by the merge
+    Category *categories; // the month's slots, taken over from its snapshot
+    CategoryMap category_map;
+} RangeRun;
+
+typedef struct
+{
+    const Transaction *transaction;
+    const char *category;
+} RangeRow;
+
+typedef struct
+{
+    char from_date[11];
+    char to_date[11];
+    RangeRun *runs;
+    int run_count;
+    int *heap; // run indices, max-heap on the date of each run's next row
+    int heap_size;
+    int position; // rows taken from the merge so far
+    int total_count;
+    unsigned long long generation; // manifest generation the runs were read at
+} RangeView;
+
+int range_view_open(RangeView *view, const char *from_date, const char *to_date);
+void range_view_close(RangeView *view);
+
+// Copy up to count rows starting at row first; returns the number copied
+int range_view_window(RangeView *view, int first, int count, RangeRow *out);
+
+// True once any month has been written since the view was opened
+bool range_view_stale(const RangeView *view);
+
+// Inclusive dates for a preset, relative to today or to the viewed month
+void history_range_dates(HistoryRange range, int year, int month, char *from_date, char *to_date);
+const char *history_range_name(HistoryRange range);
+
+#endif // RANGE_VIEW_H
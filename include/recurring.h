@@ -0,0 +1,39 @@
+#ifndef RECURRING_H
+#define RECURRING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include "globals.h"
+#include "manifest.h"
+#include "saveload.h"
+
+// Recurring-payment detection. Month files are read once each, oldest first, and every
+// transaction is hashed into a group by its description (lowercase letters and digits
+// only), whether it is income and an amount bucket RECURRING_BUCKET_STEP wide, so a
+// bill that creeps up a little stays in one group. A group whose gaps between dates
+// are mostly one week, one month, one year or some other steady number of days, and
+// that hasn't lapsed, becomes a suggested Subscription.
+
+#define RECURRING_MIN_OCCURRENCES 3
+#define RECURRING_BUCKET_STEP 1.10 // each amount bucket spans 10%
+#define RECURRING_MIN_MATCHING 0.75 // share of gaps that must fit the period
+
+typedef struct
+{
+    Subscription subscription; // ready for add_subscription; starts at the last occurrence
+    int occurrences;
+    char first_date[11];
+} RecurringSuggestion;
+
+/*
+ * Suggestions from the months in from..to (inclusive, as year * 12 + month - 1),
+ * most occurrences first, leaving out any that an existing subscription already
+ * covers. The caller frees *out_suggestions.
+ */
+int detect_recurring(int from_month_index, int to_month_index, RecurringSuggestion **out_suggestions, int *out_count);
+
+#endif // RECURRING_H
@@ -0,0 +1,39 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <ncurses.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Frame cap used by low-bandwidth mode when no rate is given
+#define DEFAULT_LOW_BANDWIDTH_FPS 8
+#define MAX_LOW_BANDWIDTH_FPS 60
+
+typedef struct
+{
+    bool low_bandwidth;       // Cap the frame rate and account terminal output
+    int max_fps;              // Frames per second allowed in low-bandwidth mode
+    bool bytes_available;     // Whether this platform can count output bytes
+    size_t frame_bytes;       // Bytes written to the terminal by the last frame
+    size_t total_bytes;       // Bytes written since the first frame
+    unsigned long frames;     // Number of frames presented
+    long long last_frame_ms;  // Monotonic timestamp of the last frame
+} RenderStats;
+
+extern RenderStats render_stats;
+
+// Enable low-bandwidth mode (fps <= 0 uses the default cap)
+void render_set_low_bandwidth(int fps);
+
+// Milliseconds until the next frame may be painted, 0 if one is due now
+int render_frame_wait_ms();
+
+// Flush pending window updates to the terminal and record the frame's output size
+void render_present();
+
+// Short status string ("8fps 412B/frame") for the dashboard help line
+void render_format_stats(char *buffer, size_t size);
+
+long long monotonic_ms();
+
+#endif // RENDER_H
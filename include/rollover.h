@@ -0,0 +1,54 @@
+#ifndef ROLLOVER_H
+#define ROLLOVER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "globals.h"
+#include "manifest.h"
+#include "saveload.h"
+
+// Envelope rollover: whatever a category has left at the end of a month (its budget
+// plus what it carried in, less what it spent) is carried into the next materialized
+// month's category of the same name as Category.extra. A month where the category
+// doesn't exist closes its envelope.
+//
+// Each month's closing balances are cached in one sidecar in data_storage_dir along
+// with the chain generation they were computed at: the highest manifest generation of
+// that month and every month before it. Writing to a month raises the chain generation
+// of it and every later month only, so their balances are recomputed from the nearest
+// earlier month still cached. The recomputation takes each month's budgets and
+// spending from the manifest, so opening a month never reads another month file.
+
+#define ROLLOVER_FILE_NAME "rollover.dat"
+#define ROLLOVER_MAGIC "tbroll"
+#define ROLLOVER_VERSION 1
+
+typedef struct
+{
+    char magic[8]; // ROLLOVER_MAGIC
+    int version;   // ROLLOVER_VERSION
+    int month_count;
+} RolloverHeader;
+
+// Each cached month is stored as this record followed by balance_count RolloverBalances
+typedef struct
+{
+    int year;
+    int month;
+    int balance_count;
+    int reserved;
+    unsigned long long chain_generation;
+} RolloverMonthRecord;
+
+typedef struct
+{
+    char name[MAX_NAME_LEN];
+    Money balance; // negative when the category was overspent
+} RolloverBalance;
+
+// Set extra on the month's slot_count category slots from the months before it
+int rollover_apply(int year, int month, Category *slots, int slot_count);
+void rollover_free(void);
+
+#endif // ROLLOVER_H
@@ -0,0 +1,34 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "globals.h"
+
+// Auto-categorization rules, one per line of RULES_FILE_NAME in data_storage_dir:
+//
+//   category,min,max,pattern
+//
+// min and max bound the signed amount (income is negative) and may be left empty.
+// pattern is matched case-insensitively anywhere in the description; a leading ^
+// anchors it to the start and a trailing $ to the end. An empty pattern matches on
+// the amount alone. Blank lines and lines starting with # are skipped. When several
+// rules match, the first one in the file wins.
+//
+// The patterns are compiled into one Aho-Corasick automaton, so a description is
+// matched against every rule in a single pass over its characters, and the rules
+// without a pattern into a table of amount ranges searched by bisection.
+
+#define RULES_FILE_NAME "rules.txt"
+
+// Read and compile the rules file, replacing any rules already loaded. Lines that
+// can't be parsed are skipped and counted in *out_skipped (which may be NULL).
+int rules_load(int *out_skipped);
+// Category name the rules give a transaction, or NULL; loads the rules on first use
+const char *rules_suggest(const char *desc, Money amount);
+void rules_free(void);
+
+#endif // RULES_H
@@ -14,6 +14,23 @@
 #include "ui.h"
 #include "globals.h"
 #include "file_cache.h"
+#include "search_index.h"
+#include "tag_index.h"
+#include "fingerprint.h"
+#include "category_stats.h"
+#include "month_file.h"
+#include "category_table.h"
+#include "rollover.h"
+
+// Version 5 ends with the tag names; version 4 stored each default category's parent
+// but no tags, version 3 stored amounts as cents but no parents, version 2 stored them
+// as doubles, and version 1 also stored LEGACY_CATEGORY_SLOTS LegacyCategory records.
+// All of them are rewritten on load.
+#define DATA_FILE_VERSION "tbudget_5.0"
+#define DATA_FILE_V4_VERSION "tbudget_4.0"
+#define DATA_FILE_V3_VERSION "tbudget_3.0"
+#define DATA_FILE_V2_VERSION "tbudget_2.0"
+#define DATA_FILE_LEGACY_VERSION "tbudget_1.0"
 
 typedef struct
 {
@@ -21,6 +38,19 @@ typedef struct
     time_t last_modified; // Last modification time
 } FileHeader;
 
+// Everything stored in one month file, read without touching the loaded month
+typedef struct
+{
+    Money budget;
+    int category_count;
+    int category_slots;
+    Category *categories; // category_slots records, empty slots included
+    Money uncategorized_spent;
+    int transaction_count;
+    Transaction *transactions;
+    CategoryIds category_ids; // map each transaction's cat_id to a slot with category_map_build
+} MonthSnapshot;
+
 // Function prototypes for utils.c
 char *get_home_directory();
 int create_directory_if_not_exists(const char *path);
@@ -29,15 +59,26 @@ int load_budget_data();
 int save_budget_data();
 int load_month(int year, int month);
 int add_transaction(Transaction *transaction, int year, int month);
+int add_transactions(Transaction *transactions, int count, int year, int month);
 int add_subscription(Subscription *subscription);
 int remove_subscription(int index);
 int add_category(Category *category, int year, int month);
-int remove_category(int category_index, int year, int month);
-int set_budget(double budget, int year, int month);
+int remove_category(int category_index, int new_index, int year, int month); // slots, not ids
+int set_budget(Money budget, int year, int month);
 int remove_transaction(int index);
+int remove_transactions(const unsigned long long *ids, int count);
+int update_transaction(const Transaction *updated);
+TransactionNode *find_transaction(unsigned long long id);
+const OrderIndex *transaction_order(SortField field);
+void drop_column_orders(void);
 
-int get_category_index(int year, int month, char *name);
-int read_month_categories(int year, int month, Category *out_categories, int *out_count);
+int get_category_index(int year, int month, char *name); // returns the category id
+// The caller frees *out_categories, which holds *out_slots records, empty slots included
+int read_month_categories(int year, int month, Category **out_categories, int *out_slots, CategoryIds *out_ids);
+int read_month_transactions(int year, int month, Transaction **out_transactions, int *out_count);
+int read_month_transaction(int year, int month, int slot, Transaction *out_transaction);
+int read_month_snapshot(int year, int month, MonthSnapshot *snapshot);
+void free_month_snapshot(MonthSnapshot *snapshot);
 // void write_export_content(FILE *export_file);
 // void export_data_to_csv(int silent);
 // void import_data_from_csv(const char *filename);
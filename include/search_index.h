@@ -0,0 +1,77 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "globals.h"
+#include "manifest.h"
+#include "month_file.h"
+
+// Trigram index over transaction descriptions, one sidecar per month ("YYYY-M.tri"
+// next to "YYYY-M.dat"). Each lowercase trigram maps to the sorted record slots of
+// the transactions containing it, so a search only reads the months and records
+// whose descriptions can match.
+//
+// Adds, removes and edits don't rewrite the index: they append delta groups after the
+// slot lists and rewrite the header last. A group is a SEARCH_DELTA_CLEAR record for
+// a slot followed by that slot's postings, and it replaces whatever postings the slot
+// had before, in the lists or in earlier groups. An add appends a group per new
+// record, an edit one for the edited slot, and a remove one for the hole holding the
+// record moved into it. Slots at or past transaction_count are ignored, so removing
+// the last record only rewrites the header. Searches apply the delta too. Once it
+// outgrows SEARCH_INDEX_MIN_DELTA and an eighth of the main postings, the next change
+// folds it in with a full rewrite, so that cost is spread over many changes.
+
+#define SEARCH_INDEX_MAGIC "tbtrigr"
+#define SEARCH_INDEX_VERSION 3
+
+#define SEARCH_INDEX_MIN_DELTA 4096 // delta records appended before folding in is considered
+#define SEARCH_DELTA_CLEAR 0xFFFFFFFFu // trigram of the record opening a delta group; real ones fit in 24 bits
+
+typedef struct
+{
+    char magic[8];
+    int version;
+    int transaction_count;
+    int trigram_count;
+    int posting_count;
+    int delta_count; // TrigramPostings after the slot lists, in groups
+    int reserved;
+    unsigned long long generation; // manifest generation of the month file this matches
+} SearchIndexHeader;
+
+// One delta record; also how postings are handled in memory
+typedef struct
+{
+    unsigned int trigram;
+    int slot;
+} TrigramPosting;
+
+// Directory entry: postings[first .. first + count) hold the slots for trigram
+typedef struct
+{
+    unsigned int trigram;
+    int first;
+    int count;
+} SearchTrigram;
+
+typedef struct
+{
+    int year;
+    int month;
+    Transaction transaction;
+    char category[MAX_NAME_LEN];
+} SearchHit;
+
+// Sidecar hooks, as described in month_file.h
+int search_index_add(int year, int month, int first_slot, const Transaction *transactions, int count, unsigned long long previous_generation);
+int search_index_remove(int year, int month, int slot, int moved_slot, unsigned long long previous_generation);
+int search_index_remove_slots(int year, int month, const int *new_slots, int old_count, unsigned long long previous_generation);
+int search_index_update(int year, int month, int slot, const Transaction *transaction, unsigned long long previous_generation);
+
+// Case-insensitive substring search over every month, newest first
+int search_transactions(const char *text, SearchHit **out_hits, int *out_count);
+
+#endif // SEARCH_INDEX_H
@@ -10,7 +10,23 @@
 // Function to update subscriptions and create transactions
 bool is_date_before(const char *date1, const char *date2);
 bool is_date_after(const char *date1, const char *date2);
-void update_subscription(int index);
-void update_subscriptions();
+
+// An occurrence of subscriptions[index] whose category has no match in its month
+typedef struct
+{
+  int index;
+  int year;
+  int month;
+  Transaction transaction; // cat_id still to be picked
+} SubscriptionOccurrence;
+
+// Add the transactions due since the subscription(s) last caught up. Each stops at the
+// first occurrence that needs a category picked, fills *pending and returns false;
+// add it with add_subscription_occurrence, then call again to carry on.
+bool update_subscription(int index, SubscriptionOccurrence *pending);
+bool update_subscriptions(SubscriptionOccurrence *pending);
+// Add the occurrence under cat_id (-1 for uncategorized); a picked category is reused
+// for the subscription's other occurrences that month
+int add_subscription_occurrence(const SubscriptionOccurrence *occurrence, int cat_id);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef TAG_INDEX_H
+#define TAG_INDEX_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "globals.h"
+#include "manifest.h"
+#include "month_file.h"
+
+// Tags are named in the data file (tag_names, at most MAX_TAGS) and set as bits of
+// Transaction.tags. Each month keeps one bitmap per tag over its record slots in a
+// sidecar ("YYYY-M.tag" next to "YYYY-M.dat"), so "tagged a and b but not c" over
+// many months is a few word ANDs and population counts per month instead of a scan
+// of every record.
+//
+// Bitmaps are stored compressed as runs of 64-bit words: a marker word holds a run
+// of all-zero or all-one words and how many literal words follow it, and the
+// literals are stored as they are. Sparse tags cost a few words per month.
+//
+// Adding, editing or removing a single transaction doesn't recompress the month:
+// the change is appended after the bitmaps as a TagDelta and the header is
+// rewritten last, so a reader applies the deltas on top of the bitmaps. Once the
+// deltas outgrow TAG_INDEX_MIN_DELTA and an eighth of the indexed slots, or the
+// tail of the file doesn't match, the month is written out whole again.
+
+#define TAG_INDEX_MAGIC "tbtags"
+#define TAG_INDEX_VERSION 2
+#define TAG_INDEX_MIN_DELTA 4096 // deltas appended before folding in is considered
+
+#define TAG_MARKER_FILL_BIT (1ULL << 63)
+#define TAG_MARKER_RUN(marker) ((int)(((marker) >> 32) & 0x7FFFFFFF))
+#define TAG_MARKER_LITERALS(marker) ((int)((marker) & 0xFFFFFFFF))
+#define TAG_WORDS(transaction_count) (((transaction_count) + 63) / 64)
+
+typedef struct
+{
+    char magic[8];
+    int version;
+    int transaction_count;
+    int tag_count;  // bitmaps stored; tags defined since then have no rows here
+    int word_count; // compressed words after the directory
+    int delta_count; // TagDeltas after the words, in the order they were made
+    int base_count; // slots the bitmaps were compressed over
+    unsigned long long generation; // manifest generation of the month file this matches
+} TagIndexHeader;
+
+// Directory entry: words[first .. first + count) hold the compressed bitmap of one tag
+typedef struct
+{
+    int first;
+    int count;
+} TagBitmap;
+
+// One change on top of the bitmaps: slot takes the tags source had at that point,
+// or tags when source is -1. Slots at or past transaction_count are dropped.
+typedef struct
+{
+    int slot;
+    int source;
+    unsigned int tags;
+} TagDelta;
+
+// Id of the named tag, or -1; tag_create adds it to the data file if it is new and
+// returns -2 once all MAX_TAGS are taken
+int tag_find(const char *name);
+int tag_create(const char *name);
+
+// Sidecar hooks, as described in month_file.h
+int tag_index_add(int year, int month, int first_slot, const Transaction *transactions, int count, unsigned long long previous_generation);
+int tag_index_remove(int year, int month, int slot, int moved_slot, unsigned long long previous_generation);
+int tag_index_remove_slots(int year, int month, const int *new_slots, int old_count, unsigned long long previous_generation);
+int tag_index_update(int year, int month, int slot, const Transaction *transaction, unsigned long long previous_generation);
+
+/*
+ * Slots of a month whose transactions carry every tag in all_tags and none in
+ * no_tags, as a bitmap of TAG_WORDS(entry->transaction_count) words the caller
+ * frees. Rebuilds a missing or stale sidecar first, so main thread only.
+ * Returns the number of matching slots, or a negative error.
+ */
+int tag_index_match(const ManifestEntry *entry, unsigned int all_tags, unsigned int no_tags, unsigned long long **out_bits);
+// Add each tag's number of transactions in the month to counts[0 .. MAX_TAGS)
+int tag_index_count(const ManifestEntry *entry, int *counts);
+
+#endif // TAG_INDEX_H
@@ -7,23 +7,58 @@
 #include <math.h>
 #include "flex_layout.h"
 #include "globals.h"
+#include "order_index.h"
 #include "utils.h"
 #include "piechart.h"
 #include "ui_helper.h"
+#include "range_view.h"
+#include "category_table.h"
+#include "category_stats.h"
 
-int get_transaction_choice(WINDOW *win, TransactionNode **sorted_transactions, int transaction_count, int max_visible_items);
-int get_category_choice_subscription(WINDOW *win, int year, int month, char *subscription_name, char *subscription_category);
-int get_category_choice_recategorize(WINDOW *win, char *category_name);
+typedef struct
+{
+  WINDOW *win;
+  const OrderIndex *transactions;
+  int transaction_count;
+  int visible_items;
+  int start_index;
+  int highlighted;                        // row in matcher.matches
+  char (*labels)[2 * MAX_NAME_LEN];       // "description category" per transaction
+  const char **label_ptrs;
+  FuzzyMatcher matcher;
+  bool filtering;
+  int choice; // transaction index picked, valid once the field reports DONE
+} TransactionField;
+
+typedef struct
+{
+  WINDOW *win;
+  int y, x;
+  int day, month, year;
+  int highlighted_field; // 0 = year, 1 = month, 2 = day, 3 = "Today" button
+  int cursor_positions[3];
+  int original_cursor_state;
+} DateField;
+
+// resumable pickers (see ui_helper.h)
+void transaction_field_begin(TransactionField *field, WINDOW *win, const OrderIndex *transactions, int max_visible_items);
+WidgetStatus transaction_field_feed(TransactionField *field, int ch);
+void transaction_field_draw(TransactionField *field);
+int transaction_field_value(TransactionField *field);
+void transaction_field_end(TransactionField *field);
+void date_field_begin(DateField *field, WINDOW *win, char *prompt);
+WidgetStatus date_field_feed(DateField *field, int ch);
+void date_field_value(DateField *field, char *date_buffer);
 
 // dashboard display
-void display_categories(WINDOW *win, int start_y);
-void display_transactions(WINDOW *win, int start_y, int selected_transaction, int *first_display_transaction, bool highlight_selected);
+void display_categories(WINDOW *win, int start_y, bool top_level);
+void display_transactions(WINDOW *win, int start_y, SortField sort, const int *rows, int row_count, int selected_transaction, int *first_display_transaction, bool highlight_selected, bool (*marked)(unsigned long long id));
+void display_range_transactions(WINDOW *win, int start_y, RangeView *view, int selected_transaction, int *first_display_transaction, bool highlight_selected);
 void display_subscriptions(WINDOW *win, int start_y, int selected_subscription, int *first_display_subscription, bool active);
-BoundedWindow draw_bar_chart(WINDOW *parent);
-BoundedWindow *create_bar_chart(BoundedWindow *parent);
+BoundedWindow draw_bar_chart(WINDOW *parent, bool top_level);
+BoundedWindow *create_bar_chart(BoundedWindow *parent, bool top_level);
 
 // formatting
-int get_date_input(WINDOW *win, char *date_buffer, char *prompt);
 void format_date(WINDOW *win, int y, int x, int day, int month, int year, int highlighted_field, int cursor_positions[]);
 
 #endif // UI_H
@@ -7,6 +7,9 @@
 #include <ctype.h>
 #include <time.h>
 #include <math.h>
+#include "render.h"
+#include "fuzzy.h"
+#include "money.h"
 
 // Color Overrides
 #define OVERRIDE_COLOR_BLACK 0
@@ -36,10 +39,57 @@ struct BoundedWindow
 
 typedef enum InputType {
   INPUT_STRING,
-  INPUT_DOUBLE,
+  INPUT_MONEY, // amounts, read back as Money
   INPUT_INT,
 } InputType;
 
+#define MAX_INPUT_LEN 1024
+
+// Input widgets are resumable: *_begin draws the widget, then each key is handed to
+// *_feed until it reports DONE or CANCELLED. The blocking get_* functions below are
+// thin loops around them; dialogs feed them from the main event loop instead.
+typedef enum WidgetStatus {
+  WIDGET_ACTIVE,
+  WIDGET_DONE,
+  WIDGET_CANCELLED,
+} WidgetStatus;
+
+typedef struct
+{
+  WINDOW *win;
+  int y, x; // where the editable text starts
+  int pos;  // cursor position within buffer
+  int max_len;
+  InputType type;
+  char buffer[MAX_INPUT_LEN];
+} InputField;
+
+typedef struct
+{
+  WINDOW *win;
+  const char **items;
+  int item_count;
+  int visible_items;
+  int start_y;
+  bool show_numbers;
+  int start_index;
+  int highlighted;
+  char number_buffer[10];
+  int buffer_pos;
+  time_t last_input_time;
+  FuzzyMatcher matcher; // typing filters the rows; highlighted indexes matcher.matches
+  bool filtering;       // matcher was allocated
+  int choice;           // item picked, valid once the field reports DONE
+} MenuField;
+
+typedef struct
+{
+  WINDOW *win;
+  int item_count;
+  int highlighted;
+  int choice; // 0 = yes, 1 = no
+} ConfirmField;
+
 void setup_ncurses();
 void cleanup_ncurses();
 
@@ -61,15 +111,21 @@ void bw_hierarchy_refresh(BoundedWindow win);
 BoundedWindow draw_bounded(int height, int width, int start_y, int start_x, bool highlight);
 BoundedWindow draw_bounded_with_title(int height, int width, int start_y, int start_x, const char* title, bool highlight, int alignment);
 BoundedWindow draw_alert(const char *title, const char *message[], int message_count);
-BoundedWindow draw_alert_persistent(const char *title, const char *message[], int message_count);
 void draw_title(WINDOW *win, const char *title);
-void draw_error(BoundedWindow win, const char *message);
 void draw_menu(WINDOW *win, int highlighted_item, const char *menu_items[], int item_count, int start_y);
+void print_fuzzy_highlighted(WINDOW *win, const char *text, const int *positions, int position_count);
 
-// getting input
-int get_confirmation(WINDOW *win, const char *message[], int item_count);
-int get_menu_choice(WINDOW *win, const char *menu_items[], int item_count, int start_y, int allow_back);
-int get_scrollable_menu_choice(WINDOW *win, char* prompt, const char *menu_items[], int item_count, int max_visible_items, int start_y, bool show_numbers);
-int get_input(WINDOW *win, void *return_value, char* prompt, int max_len, InputType type);
+// resumable input widgets
+void input_field_begin(InputField *field, WINDOW *win, const char *prompt, int max_len, InputType type);
+WidgetStatus input_field_feed(InputField *field, int ch);
+void input_field_value(InputField *field, void *value);
+void input_field_set(InputField *field, const char *text);
+void menu_field_begin(MenuField *field, WINDOW *win, const char *prompt, const char *menu_items[], int item_count, int max_visible_items, int start_y, bool show_numbers);
+WidgetStatus menu_field_feed(MenuField *field, int ch);
+void menu_field_draw(MenuField *field);
+int menu_field_value(MenuField *field);
+void menu_field_end(MenuField *field);
+void confirm_field_begin(ConfirmField *field, WINDOW *win, const char *message[], int item_count);
+WidgetStatus confirm_field_feed(ConfirmField *field, int ch);
 
 #endif // UI_HELPER_H
@@ -1,13 +1,13 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <ctype.h>
 #include "globals.h"
 #include "saveload.h"
+#include "order_index.h"
 
 int get_days_in_month(int m, int y);
 int validate_day(int day, int month, int year);
-void sort_categories_by_budget();
-int compare_transactions_by_date(const void *a, const void *b);
 void cleanup_transactions();
 
 // macOS notification utility for debugging
@@ -17,5 +17,6 @@ void show_macos_notification(const char *title, const char *message);
 
 int get_month_from_date(const char *date);
 int get_year_from_date(const char *date);
+bool contains_ignore_case(const char *haystack, const char *needle);
 
 #endif // UTILS_H
\ No newline at end of file
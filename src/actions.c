@@ -1,792 +1,1264 @@
 #include "actions.h"
 
-// Helper function for adding a category in dashboard mode
-void add_category_dialog()
+// Build menu labels for categories in budget order, skipping exclude_index.
+// *indices receives the category index behind each label; both go to dialog_owned_menu.
+static char **build_category_menu(int exclude_index, bool show_budget, int **indices, int *item_count)
 {
-    WINDOW *win = stdscr;
-    int max_y, max_x;
-    getmaxyx(win, max_y, max_x);
-
-    // Create a dialog box centered on screen
-    int dialog_height = DEFAULT_DIALOG_HEIGHT;
-    int dialog_width = DEFAULT_DIALOG_WIDTH;
-    int start_y = (max_y - dialog_height) / 2;
-    int start_x = (max_x - dialog_width) / 2;
-
-    BoundedWindow dialog = draw_bounded_with_title(dialog_height, dialog_width, start_y, start_x, "Add Category", false, ALIGN_CENTER);
-    wnoutrefresh(dialog.boundary);
-
-    if (category_count >= MAX_CATEGORIES)
+    char **category_menu = malloc((category_count > 0 ? category_count : 1) * sizeof(char *));
+    *indices = malloc((category_count > 0 ? category_count : 1) * sizeof(int));
+    if (category_menu == NULL || *indices == NULL)
     {
-        draw_error(dialog, "Maximum number of categories reached.");
-        return;
+        free(category_menu);
+        free(*indices);
+        return NULL;
     }
 
-    // Get category name
-    wnoutrefresh(dialog.textbox);
-
-    Category cat_to_add = {0};
-
-    if (!get_input(dialog.textbox, cat_to_add.name, "Enter category name: ", MAX_NAME_LEN, INPUT_STRING))
+    int count = 0;
+    for (int i = 0; i < category_count; i++)
     {
-        delete_bounded(dialog);
-        return; // User canceled
+        int index = sorted_categories_indices[i];
+        if (index == exclude_index)
+        {
+            continue;
+        }
+        category_menu[count] = malloc(MAX_NAME_LEN + 20); // Extra space for number and amount
+        if (category_menu[count] == NULL)
+        {
+            // Free previously allocated memory
+            for (int j = 0; j < count; j++)
+            {
+                free(category_menu[j]);
+            }
+            free(category_menu);
+            free(*indices);
+            return NULL;
+        }
+        if (show_budget)
+        {
+            sprintf(category_menu[count], "%s ($%s)", categories[index].name, money_str(categories[index].budget));
+        }
+        else
+        {
+            sprintf(category_menu[count], "%s", categories[index].name);
+        }
+        (*indices)[count] = index;
+        count++;
     }
+    *item_count = count;
+    return category_menu;
+}
 
-    // Get amount
-    wnoutrefresh(dialog.textbox);
-
-    double amount = -1.0;
-    if (!get_input(dialog.textbox, &amount, "Enter allocated amount: $", MAX_BUFFER, INPUT_DOUBLE))
+// Build menu labels for a new category's parent: "(none)" first, then every top-level
+// category in budget order. *indices receives the category index behind each label
+// (-1 for none); both go to dialog_owned_menu.
+static char **build_parent_menu(int **indices, int *item_count)
+{
+    char **parent_menu = malloc((category_count + 1) * sizeof(char *));
+    *indices = malloc((category_count + 1) * sizeof(int));
+    if (parent_menu == NULL || *indices == NULL)
     {
-        amount = -1.0; // Ensure -1.0 is returned if user cancels
+        free(parent_menu);
+        free(*indices);
+        return NULL;
     }
 
-    // Check if input was canceled
-    if (amount == -1.0)
+    int count = 0;
+    for (int i = -1; i < category_count; i++)
     {
-        delete_bounded(dialog);
-        return;
+        int index = i >= 0 ? sorted_categories_indices[i] : -1;
+        if (index >= 0 && categories[index].parent_id != -1)
+        {
+            continue;
+        }
+        parent_menu[count] = malloc(MAX_NAME_LEN + 20);
+        if (parent_menu[count] == NULL)
+        {
+            for (int j = 0; j < count; j++)
+            {
+                free(parent_menu[j]);
+            }
+            free(parent_menu);
+            free(*indices);
+            return NULL;
+        }
+        sprintf(parent_menu[count], "%s", index >= 0 ? categories[index].name : "(none)");
+        (*indices)[count] = index;
+        count++;
     }
+    *item_count = count;
+    return parent_menu;
+}
 
-    cat_to_add.budget = amount;
-    cat_to_add.spent = 0.0;
-    cat_to_add.extra = 0.0;
-    int res = add_category(&cat_to_add, current_year, current_month);
+static Dialog *open_default_dialog(const char *title, DialogAdvance advance, size_t ctx_size)
+{
+    return dialog_open(title, DEFAULT_DIALOG_HEIGHT, DEFAULT_DIALOG_WIDTH, advance, ctx_size);
+}
+
+/* Add category */
+
+enum
+{
+    ADD_CATEGORY_NAME,
+    ADD_CATEGORY_AMOUNT,
+    ADD_CATEGORY_PARENT
+};
+
+static DialogStatus add_category_commit(Dialog *dialog, Category *cat_to_add)
+{
+    int res = add_category(cat_to_add, current_year, current_month);
     if (res < 0)
     {
         char error_message[MAX_BUFFER];
         sprintf(error_message, "Failed to add category: Error %d", res);
-        draw_error(dialog, error_message);
+        return dialog_message(dialog, error_message);
     }
-    delete_bounded(dialog);
+    return DIALOG_CLOSED;
 }
 
-// Helper function for removing a category in dashboard mode
-void remove_category_dialog()
+static DialogStatus add_category_advance(Dialog *dialog, WidgetStatus status)
 {
-    WINDOW *win = stdscr;
-    int max_y, max_x;
-    getmaxyx(win, max_y, max_x);
-
-    // Calculate dialog size based on number of categories
-    int dialog_height = DEFAULT_DIALOG_HEIGHT;
-    int dialog_width = DEFAULT_DIALOG_WIDTH;
-    int start_y = (max_y - dialog_height) / 2;
-    int start_x = (max_x - dialog_width) / 2;
-
-    BoundedWindow dialog = draw_bounded_with_title(dialog_height, dialog_width, start_y, start_x, "Remove Category", false, ALIGN_CENTER);
-    wnoutrefresh(dialog.boundary);
-
-    if (category_count == 0)
+    Category *cat_to_add = dialog->ctx;
+    if (status == WIDGET_CANCELLED)
     {
-        draw_error(dialog, "No categories to remove.");
-        return;
+        return DIALOG_CLOSED;
     }
 
-    // Create dynamic menu for categories
-    char **category_menu = malloc(category_count * sizeof(char *));
-    if (category_menu == NULL)
+    switch (dialog->step)
     {
-        draw_error(dialog, "Memory allocation error.");
-        return;
-    }
-
-    for (int i = 0; i < category_count; i++)
+    case ADD_CATEGORY_NAME:
+        input_field_value(&dialog->field_state.input, cat_to_add->name);
+        dialog_input(dialog, ADD_CATEGORY_AMOUNT, "Enter allocated amount: $", MAX_BUFFER, INPUT_MONEY);
+        return DIALOG_OPEN;
+    case ADD_CATEGORY_AMOUNT:
     {
-        category_menu[i] = malloc(MAX_NAME_LEN + 20); // Extra space for number and amount
-        if (category_menu[i] == NULL)
+        Money amount = -1;
+        input_field_value(&dialog->field_state.input, &amount);
+        if (amount == -1)
         {
-            // Free previously allocated memory
-            for (int j = 0; j < i; j++)
-            {
-                free(category_menu[j]);
-            }
-            free(category_menu);
+            return DIALOG_CLOSED;
+        }
+        cat_to_add->budget = amount;
+        cat_to_add->spent = 0;
+        cat_to_add->extra = 0;
+        cat_to_add->parent_id = -1;
+        if (category_count == 0)
+        {
+            return add_category_commit(dialog, cat_to_add);
+        }
 
-            draw_error(dialog, "Memory allocation error.");
-            return;
+        int item_count, *menu_indices;
+        char **parent_menu = build_parent_menu(&menu_indices, &item_count);
+        if (parent_menu == NULL)
+        {
+            return dialog_message(dialog, "Memory allocation error.");
         }
-        sprintf(category_menu[i], "%s ($%.2f)", categories[sorted_categories_indices[i]].name, categories[sorted_categories_indices[i]].budget);
+        wclear(dialog->frame.textbox);
+        dialog_owned_menu(dialog, ADD_CATEGORY_PARENT, "Put it under (none for a top-level category):", parent_menu, menu_indices, item_count, 6, 1, true);
+        return DIALOG_OPEN;
     }
+    case ADD_CATEGORY_PARENT:
+        cat_to_add->parent_id = category_id(dialog_menu_value(dialog));
+        return add_category_commit(dialog, cat_to_add);
+    }
+    return DIALOG_CLOSED;
+}
 
-    int cat_choice = get_scrollable_menu_choice(dialog.textbox, "Select a category to remove:", (const char **)category_menu, category_count, 6, 1, true);
-
-    // Free allocated memory
-    for (int i = 0; i < category_count; i++)
+// Helper function for adding a category in dashboard mode
+Dialog *add_category_dialog()
+{
+    Dialog *dialog = open_default_dialog("Add Category", add_category_advance, sizeof(Category));
+    if (dialog == NULL)
     {
-        free(category_menu[i]);
+        return NULL;
     }
-    free(category_menu);
 
-    if (cat_choice == -1)
-    { // User pressed backspace or escape
-        delete_bounded(dialog);
-        return;
-    }
+    dialog_input(dialog, ADD_CATEGORY_NAME, "Enter category name: ", MAX_NAME_LEN, INPUT_STRING);
+    return dialog;
+}
 
-    const char *confirm_message[1];
-    char message_buffer[100];
-    sprintf(message_buffer, "Are you sure you want to remove \"%s\"?", categories[sorted_categories_indices[cat_choice]].name);
-    confirm_message[0] = message_buffer;
-    int confirm = get_confirmation(dialog.textbox, confirm_message, 1);
+/* Remove category */
 
-    if (confirm == 0)
-    {
-        int result = remove_category(cat_choice, current_year, current_month);
+enum
+{
+    REMOVE_CATEGORY_SELECT,
+    REMOVE_CATEGORY_CONFIRM,
+    REMOVE_CATEGORY_RECATEGORIZE
+};
 
-        if (result < 1)
+typedef struct
+{
+    int category_index;
+} RemoveCategoryState;
+
+static DialogStatus remove_category_commit(Dialog *dialog, int new_index)
+{
+    RemoveCategoryState *state = dialog->ctx;
+    int result = remove_category(state->category_index, new_index, current_year, current_month);
+    if (result < 1)
+    {
+        if (result == -4)
         {
-            if (result == -4)
-            {
-                draw_error(dialog, "Cannot remove category with existing transactions.");
-            }
-            else if (result == -2)
-            {
-                draw_error(dialog, "Invalid category index.");
-            }
-            else
-            {
-                draw_error(dialog, "Failed to remove category.");
-            }
+            return dialog_message(dialog, "Cannot remove category with existing transactions.");
+        }
+        else if (result == -2)
+        {
+            return dialog_message(dialog, "Invalid category index.");
         }
+        return dialog_message(dialog, "Failed to remove category.");
     }
-
-    delete_bounded(dialog);
+    return DIALOG_CLOSED;
 }
 
-// Helper function for setting budget in dashboard mode
-void set_budget_dialog()
+static DialogStatus remove_category_advance(Dialog *dialog, WidgetStatus status)
 {
-    WINDOW *win = stdscr;
-    int max_y, max_x;
-    getmaxyx(win, max_y, max_x);
-
-    // Create a dialog box centered on screen
-    int dialog_height = DEFAULT_DIALOG_HEIGHT;
-    int dialog_width = DEFAULT_DIALOG_WIDTH;
-    int start_y = (max_y - dialog_height) / 2;
-    int start_x = (max_x - dialog_width) / 2;
-
-    BoundedWindow dialog = draw_bounded_with_title(dialog_height, dialog_width, start_y, start_x, "Set Total Budget", false, ALIGN_CENTER);
-    wnoutrefresh(dialog.boundary);
+    RemoveCategoryState *state = dialog->ctx;
 
-    // Current budget
-    mvwprintw(dialog.textbox, 2, 0, "Current Budget: $%.2f", current_month_total_budget);
-    wmove(dialog.textbox, 3, 0);
-    wnoutrefresh(dialog.textbox);
-
-    double new_budget = -1.0;
-    if (!get_input(dialog.textbox, &new_budget, "Enter new total budget amount: $", MAX_BUFFER, INPUT_DOUBLE))
+    switch (dialog->step)
     {
-        new_budget = -1.0; // Ensure -1.0 is returned if user cancels
-    }
-
-    // Check if input was canceled
-    if (new_budget == -1.0)
+    case REMOVE_CATEGORY_SELECT:
     {
-        delete_bounded(dialog);
-        return;
+        if (status == WIDGET_CANCELLED)
+        {
+            return DIALOG_CLOSED;
+        }
+        state->category_index = dialog_menu_value(dialog);
+
+        const char *confirm_message[1];
+        char message_buffer[100];
+        snprintf(message_buffer, sizeof(message_buffer), "Are you sure you want to remove \"%s\"?", categories[state->category_index].name);
+        confirm_message[0] = message_buffer;
+        dialog_confirm(dialog, REMOVE_CATEGORY_CONFIRM, confirm_message, 1);
+        return DIALOG_OPEN;
     }
-    const char *confirm_message[2];
-    char message_buffer[100];
-    sprintf(message_buffer, "Are you sure you want to set the total budget to $%.2f?", new_budget);
-    confirm_message[0] = message_buffer;
-    int confirm = get_confirmation(dialog.textbox, confirm_message, 1);
-    if (confirm == 1) // no selected
+    case REMOVE_CATEGORY_CONFIRM:
     {
-        delete_bounded(dialog);
-        return;
-    }
+        if (status == WIDGET_CANCELLED || dialog->field_state.confirm.choice != 0)
+        {
+            return DIALOG_CLOSED;
+        }
+        if (category_count <= 1)
+        {
+            return remove_category_commit(dialog, -1);
+        }
 
-    current_month_total_budget = new_budget;
-    int res = set_budget(new_budget, current_year, current_month);
-    if (res == 0)
-    {
-        char error_message[MAX_BUFFER];
-        sprintf(error_message, "Failed to set budget: Error %d", res);
-        draw_error(dialog, error_message);
+        int item_count, *menu_indices;
+        char **category_menu = build_category_menu(state->category_index, false, &menu_indices, &item_count);
+        if (category_menu == NULL)
+        {
+            return dialog_message(dialog, "Memory allocation error.");
+        }
+        char prompt[MAX_NAME_LEN + 64];
+        snprintf(prompt, sizeof(prompt), "Move transactions in %s to (ESC leaves them uncategorized):", categories[state->category_index].name);
+        wclear(dialog->frame.textbox);
+        dialog_owned_menu(dialog, REMOVE_CATEGORY_RECATEGORIZE, prompt, category_menu, menu_indices, item_count, 6, 1, true);
+        return DIALOG_OPEN;
     }
-    delete_bounded(dialog);
+    case REMOVE_CATEGORY_RECATEGORIZE:
+        // Cancelling here still removes the category, leaving its transactions uncategorized
+        if (status == WIDGET_CANCELLED)
+        {
+            return remove_category_commit(dialog, -1);
+        }
+        return remove_category_commit(dialog, dialog_menu_value(dialog));
+    }
+    return DIALOG_CLOSED;
 }
 
-// Helper function for adding a transaction in dashboard mode
-void add_expense_dialog()
+// Helper function for removing a category in dashboard mode
+Dialog *remove_category_dialog()
 {
-    WINDOW *win = stdscr;
-    int max_y, max_x;
-    getmaxyx(win, max_y, max_x);
-
-    int dialog_height = DEFAULT_DIALOG_HEIGHT;
-    int dialog_width = DEFAULT_DIALOG_WIDTH;
-    int start_y = (max_y - dialog_height) / 2;
-    int start_x = (max_x - dialog_width) / 2;
-
-    BoundedWindow dialog = draw_bounded_with_title(dialog_height, dialog_width, start_y, start_x, "Add Expense", false, ALIGN_CENTER);
-    wnoutrefresh(dialog.boundary);
+    Dialog *dialog = open_default_dialog("Remove Category", remove_category_advance, sizeof(RemoveCategoryState));
+    if (dialog == NULL)
+    {
+        return NULL;
+    }
 
-    // Create dialog for transaction input
     if (category_count == 0)
     {
-        draw_error(dialog, "Please set up categories first.");
-        return;
+        dialog_message(dialog, "No categories to remove.");
+        return dialog;
     }
 
-    // Temporary transaction data
-    Transaction new_transaction;
-    memset(&new_transaction, 0, sizeof(Transaction));
-    new_transaction.expense = true;
-
-    // Get transaction description
-    wrefresh(dialog.textbox);
-
-    if (!get_input(dialog.textbox, new_transaction.desc, "Enter transaction description: ", MAX_NAME_LEN, INPUT_STRING))
+    int item_count, *menu_indices;
+    char **category_menu = build_category_menu(-1, true, &menu_indices, &item_count);
+    if (category_menu == NULL)
     {
-        delete_bounded(dialog);
-        return; // User canceled
+        dialog_message(dialog, "Memory allocation error.");
+        return dialog;
     }
 
-    // Get amount
-    wrefresh(dialog.textbox);
+    dialog_owned_menu(dialog, REMOVE_CATEGORY_SELECT, "Select a category to remove:", category_menu, menu_indices, item_count, 6, 1, true);
+    return dialog;
+}
+
+/* Set total budget */
+
+enum
+{
+    SET_BUDGET_AMOUNT,
+    SET_BUDGET_CONFIRM
+};
 
-    double amount = -1.0;
-    if (!get_input(dialog.textbox, &amount, "Enter amount: $", MAX_BUFFER, INPUT_DOUBLE))
+static DialogStatus set_budget_advance(Dialog *dialog, WidgetStatus status)
+{
+    Money *new_budget = dialog->ctx;
+    if (status == WIDGET_CANCELLED)
     {
-        amount = -1.0; // Ensure -1.0 is returned if user cancels
+        return DIALOG_CLOSED;
     }
 
-    // Check if input was canceled
-    if (amount == -1.0)
+    switch (dialog->step)
     {
-        delete_bounded(dialog);
-        return;
+    case SET_BUDGET_AMOUNT:
+    {
+        *new_budget = -1;
+        input_field_value(&dialog->field_state.input, new_budget);
+        if (*new_budget == -1)
+        {
+            return DIALOG_CLOSED;
+        }
+        const char *confirm_message[1];
+        char message_buffer[100];
+        sprintf(message_buffer, "Are you sure you want to set the total budget to $%s?", money_str(*new_budget));
+        confirm_message[0] = message_buffer;
+        dialog_confirm(dialog, SET_BUDGET_CONFIRM, confirm_message, 1);
+        return DIALOG_OPEN;
     }
+    case SET_BUDGET_CONFIRM:
+    {
+        if (dialog->field_state.confirm.choice == 1) // no selected
+        {
+            return DIALOG_CLOSED;
+        }
+        current_month_total_budget = *new_budget;
+        int res = set_budget(*new_budget, current_year, current_month);
+        if (res == 0)
+        {
+            char error_message[MAX_BUFFER];
+            sprintf(error_message, "Failed to set budget: Error %d", res);
+            return dialog_message(dialog, error_message);
+        }
+        return DIALOG_CLOSED;
+    }
+    }
+    return DIALOG_CLOSED;
+}
 
-    new_transaction.amt = amount;
-
-    char date_buffer[11] = "";
-    if (!get_date_input(dialog.textbox, date_buffer, "Enter date (YYYY-MM-DD): "))
+// Helper function for setting budget in dashboard mode
+Dialog *set_budget_dialog()
+{
+    Dialog *dialog = open_default_dialog("Set Total Budget", set_budget_advance, sizeof(Money));
+    if (dialog == NULL)
     {
-        delete_bounded(dialog);
-        return; // User canceled
+        return NULL;
     }
 
-    // Copy the date string (already in YYYY-MM-DD format)
-    strncpy(new_transaction.date, date_buffer, 10);
-    new_transaction.date[10] = '\0';
+    // Current budget
+    mvwprintw(dialog->frame.textbox, 2, 0, "Current Budget: $%s", money_str(current_month_total_budget));
+    wmove(dialog->frame.textbox, 3, 0);
+    dialog_input(dialog, SET_BUDGET_AMOUNT, "Enter new total budget amount: $", MAX_BUFFER, INPUT_MONEY);
+    return dialog;
+}
 
-    // Clean up previous dialog
-    wclear(dialog.textbox);
+/* Add expense */
 
-    // Create a new dialog for category selection
-    dialog_height = category_count + 6;
-    if (dialog_height > max_y - 4)
+enum
+{
+    ADD_EXPENSE_DESC,
+    ADD_EXPENSE_AMOUNT,
+    ADD_EXPENSE_DATE,
+    ADD_EXPENSE_CATEGORY
+};
+
+typedef struct
+{
+    Transaction transaction;
+} AddExpenseState;
+
+// Move the category the rules give the transaction to the top of the menu, so it is
+// what Enter picks
+static void suggest_category(char **menu, int *indices, int item_count, const Transaction *transaction)
+{
+    const char *suggested = rules_suggest(transaction->desc, transaction->amt);
+    for (int i = 0; suggested != NULL && i < item_count; i++)
     {
-        dialog_height = max_y - 4; // Cap at reasonable size
+        if (strcmp(categories[indices[i]].name, suggested) == 0)
+        {
+            char *item = menu[i];
+            int index = indices[i];
+            memmove(&menu[1], &menu[0], i * sizeof(char *));
+            memmove(&indices[1], &indices[0], i * sizeof(int));
+            menu[0] = item;
+            indices[0] = index;
+            strcat(item, " (suggested)");
+            break;
+        }
     }
+}
 
-    // dialog = draw_bounded_with_title(dialog_height, dialog_width, (max_y - dialog_height) / 2, start_x, "Select Category", false, ALIGN_CENTER);
-
-    // Create dynamic menu for categories
-    char **category_menu = malloc(category_count * sizeof(char *));
-    if (category_menu == NULL)
+static DialogStatus add_expense_advance(Dialog *dialog, WidgetStatus status)
+{
+    AddExpenseState *state = dialog->ctx;
+    Transaction *new_transaction = &state->transaction;
+    if (status == WIDGET_CANCELLED)
     {
-        draw_error(dialog, "Memory allocation error.");
-        return;
+        return DIALOG_CLOSED;
     }
 
-    for (int i = 0; i < category_count; i++)
+    switch (dialog->step)
+    {
+    case ADD_EXPENSE_DESC:
+        input_field_value(&dialog->field_state.input, new_transaction->desc);
+        dialog_input(dialog, ADD_EXPENSE_AMOUNT, "Enter amount: $", MAX_BUFFER, INPUT_MONEY);
+        return DIALOG_OPEN;
+    case ADD_EXPENSE_AMOUNT:
     {
-        category_menu[i] = malloc(MAX_NAME_LEN + 10); // Extra space for number and formatting
-        if (category_menu[i] == NULL)
+        Money amount = -1;
+        input_field_value(&dialog->field_state.input, &amount);
+        if (amount == -1)
         {
-            // Free previously allocated memory
-            for (int j = 0; j < i; j++)
-            {
-                free(category_menu[j]);
-            }
-            free(category_menu);
-
-            draw_error(dialog, "Memory allocation error.");
-            return;
+            return DIALOG_CLOSED;
         }
-        sprintf(category_menu[i], "%s", categories[sorted_categories_indices[i]].name);
+        new_transaction->amt = amount;
+        dialog_date(dialog, ADD_EXPENSE_DATE, "Enter date (YYYY-MM-DD): ");
+        return DIALOG_OPEN;
     }
+    case ADD_EXPENSE_DATE:
+    {
+        char date_buffer[11] = "";
+        date_field_value(&dialog->field_state.date, date_buffer);
+        // Copy the date string (already in YYYY-MM-DD format)
+        strncpy(new_transaction->date, date_buffer, 10);
+        new_transaction->date[10] = '\0';
+
+        int item_count, *menu_indices;
+        char **category_menu = build_category_menu(-1, false, &menu_indices, &item_count);
+        if (category_menu == NULL)
+        {
+            return dialog_message(dialog, "Memory allocation error.");
+        }
+        suggest_category(category_menu, menu_indices, item_count, new_transaction);
+        wclear(dialog->frame.textbox);
+        dialog_owned_menu(dialog, ADD_EXPENSE_CATEGORY, "Select a category for this expense:", category_menu, menu_indices, item_count, 6, 1, true);
+        return DIALOG_OPEN;
+    }
+    case ADD_EXPENSE_CATEGORY:
+    {
+        int slot = dialog_menu_value(dialog);
 
-    int cat_choice = get_scrollable_menu_choice(dialog.textbox, "Select a category for this expense:", (const char **)category_menu, category_count, 6, 1, true);
+        int year, month, day;
+        sscanf(new_transaction->date, "%d-%d-%d", &year, &month, &day);
+        // The menu lists the loaded month's categories; another month has its own ids
+        if (slot == -1 || (year == loaded_year && month == loaded_month))
+        {
+            new_transaction->cat_id = category_id(slot);
+        }
+        else
+        {
+            new_transaction->cat_id = get_category_index(year, month, categories[slot].name);
+        }
+        int result = add_transaction(new_transaction, year, month);
+        if (result < 0)
+        {
+            char error_message[MAX_BUFFER];
+            sprintf(error_message, "Failed to add transaction: Error %d", result);
+            return dialog_message(dialog, error_message);
+        }
+        return DIALOG_CLOSED;
+    }
+    }
+    return DIALOG_CLOSED;
+}
 
-    // Free allocated memory
-    for (int i = 0; i < category_count; i++)
+// Helper function for adding a transaction in dashboard mode
+Dialog *add_expense_dialog()
+{
+    Dialog *dialog = open_default_dialog("Add Expense", add_expense_advance, sizeof(AddExpenseState));
+    if (dialog == NULL)
     {
-        free(category_menu[i]);
+        return NULL;
     }
-    free(category_menu);
 
-    if (cat_choice == -1)
-    { // User pressed backspace or ESC
-        delete_bounded(dialog);
-        return;
+    if (category_count == 0)
+    {
+        dialog_message(dialog, "Please set up categories first.");
+        return dialog;
     }
-    new_transaction.cat_index = cat_choice;
 
-    int year, month, day;
-    sscanf(new_transaction.date, "%d-%d-%d", &year, &month, &day);
-    int result = add_transaction(&new_transaction, year, month);
-    if (result < 0)
+    AddExpenseState *state = dialog->ctx;
+    state->transaction.expense = true;
+    dialog_input(dialog, ADD_EXPENSE_DESC, "Enter transaction description: ", MAX_NAME_LEN, INPUT_STRING);
+    return dialog;
+}
+
+/* Remove transaction */
+
+enum
+{
+    REMOVE_TRANSACTION_SELECT,
+    REMOVE_TRANSACTION_CONFIRM
+};
+
+static DialogStatus remove_transaction_advance(Dialog *dialog, WidgetStatus status)
+{
+    int *trans_choice = dialog->ctx;
+    if (status == WIDGET_CANCELLED)
     {
-        char error_message[MAX_BUFFER];
-        sprintf(error_message, "Failed to add transaction: Error %d", result);
-        draw_error(dialog, error_message);
+        return DIALOG_CLOSED;
     }
 
-    delete_bounded(dialog);
+    switch (dialog->step)
+    {
+    case REMOVE_TRANSACTION_SELECT:
+    {
+        *trans_choice = transaction_field_value(&dialog->field_state.transaction);
+        Transaction *tx = &order_index_at(&sorted_transactions, *trans_choice)->data;
+
+        const char *confirm_message[5];
+        char message_buffer[4][100];
+        snprintf(message_buffer[0], sizeof(message_buffer[0]), "Date: %s", tx->date);
+        snprintf(message_buffer[1], sizeof(message_buffer[1]), "Description: %s", tx->desc);
+        snprintf(message_buffer[2], sizeof(message_buffer[2]), "Amount: $%s", money_str(tx->amt));
+        snprintf(message_buffer[3], sizeof(message_buffer[3]), "Category: %s", category_of(tx->cat_id) == NULL ? "Uncategorized" : category_of(tx->cat_id)->name);
+        confirm_message[0] = "Are you sure you want to remove this transaction?";
+        confirm_message[1] = message_buffer[0];
+        confirm_message[2] = message_buffer[1];
+        confirm_message[3] = message_buffer[2];
+        confirm_message[4] = message_buffer[3];
+        dialog_confirm(dialog, REMOVE_TRANSACTION_CONFIRM, confirm_message, 5);
+        return DIALOG_OPEN;
+    }
+    case REMOVE_TRANSACTION_CONFIRM:
+        if (dialog->field_state.confirm.choice == 0)
+        { // Yes, remove it
+            int result = remove_transaction(*trans_choice);
+            if (result == 0)
+            {
+                return dialog_message(dialog, "Failed to remove transaction.");
+            }
+        }
+        return DIALOG_CLOSED;
+    }
+    return DIALOG_CLOSED;
 }
 
-// Add function to remove transactions
 // Helper function for removing a transaction in dashboard mode
-void remove_transaction_dialog()
+Dialog *remove_transaction_dialog()
 {
-    WINDOW *win = stdscr;
-    int max_y, max_x;
-    getmaxyx(win, max_y, max_x);
-
     // Keep the variable height calculation for transactions
     int max_display = 10;
     int display_count = current_month_transaction_count < max_display ? current_month_transaction_count : max_display;
     int dialog_height = display_count > 1 ? display_count + 8 : 10;
-    int dialog_width = DEFAULT_DIALOG_WIDTH;
-    int start_y = (max_y - dialog_height) / 2;
-    int start_x = (max_x - dialog_width) / 2;
 
-    BoundedWindow dialog = draw_bounded_with_title(dialog_height, dialog_width, start_y, start_x, "Remove Transaction", false, ALIGN_CENTER);
-    wnoutrefresh(dialog.boundary);
+    Dialog *dialog = dialog_open("Remove Transaction", dialog_height, DEFAULT_DIALOG_WIDTH, remove_transaction_advance, sizeof(int));
+    if (dialog == NULL)
+    {
+        return NULL;
+    }
 
     if (current_month_transaction_count == 0)
     {
-        draw_error(dialog, "No transactions to remove.");
-        return;
+        dialog_message(dialog, "No transactions to remove.");
+        return dialog;
     }
 
-    // Ensure transactions are sorted with most recent first
-    // This sort has already been done in display_transactions
-    // for (int i = 0; i < transaction_count - 1; i++)
-    // {
-    //     for (int j = 0; j < transaction_count - i - 1; j++)
-    //     {
-    //         // Compare dates (format is YYYY-MM-DD so string comparison works)
-    //         if (strcmp(transactions[j].date, transactions[j + 1].date) < 0)
-    //         {
-    //             // Swap transactions
-    //             Transaction temp = transactions[j];
-    //             transactions[j] = transactions[j + 1];
-    //             transactions[j + 1] = temp;
-    //         }
-    //     }
-    // }
+    mvwprintw(dialog->frame.textbox, 1, 0, "Select a transaction to remove:");
+    dialog_transaction(dialog, REMOVE_TRANSACTION_SELECT, &sorted_transactions, 10);
+    return dialog;
+}
 
-    mvwprintw(dialog.textbox, 1, 0, "Select a transaction to remove:");
-    wrefresh(dialog.textbox);
+/* Remove several transactions */
 
-    int trans_choice = get_transaction_choice(dialog.textbox, sorted_transactions, current_month_transaction_count, 10);
+typedef struct
+{
+    int count;
+    unsigned long long ids[]; // of the loaded month
+} RemoveTransactionsState;
 
-    if (trans_choice == -1)
+static DialogStatus remove_transactions_advance(Dialog *dialog, WidgetStatus status)
+{
+    RemoveTransactionsState *state = dialog->ctx;
+    if (status == WIDGET_CANCELLED || dialog->step != REMOVE_TRANSACTION_CONFIRM ||
+        dialog->field_state.confirm.choice != 0)
     {
-        delete_bounded(dialog);
-        return;
+        return DIALOG_CLOSED;
     }
-
-    char category_name[MAX_NAME_LEN] = {0};
-    strcpy(category_name, categories[sorted_transactions[trans_choice]->data.cat_index].name);
-
-    // Format date for display
-    char display_date[11];
-    if (strlen(sorted_transactions[trans_choice]->data.date) == 10)
+    if (remove_transactions(state->ids, state->count) < 0)
     {
-        strcpy(display_date, sorted_transactions[trans_choice]->data.date);
+        return dialog_message(dialog, "Failed to remove transactions.");
     }
-    else
+    return DIALOG_CLOSED;
+}
+
+// Confirm and remove the given transactions of the loaded month in one write; ids are copied
+Dialog *remove_transactions_dialog(const unsigned long long *ids, int count)
+{
+    Dialog *dialog = open_default_dialog("Remove Transactions", remove_transactions_advance,
+                                         sizeof(RemoveTransactionsState) + count * sizeof(unsigned long long));
+    if (dialog == NULL)
     {
-        strcpy(display_date, sorted_transactions[trans_choice]->data.date);
+        return NULL;
     }
+    RemoveTransactionsState *state = dialog->ctx;
+    state->count = count;
+    memcpy(state->ids, ids, count * sizeof(unsigned long long));
 
-    const char *confirm_message[5];
-
-    char message_buffer[4][100];
-    sprintf(message_buffer[0], "Date: %s", display_date);
-    sprintf(message_buffer[1], "Description: %s", sorted_transactions[trans_choice]->data.desc);
-    sprintf(message_buffer[2], "Amount: $%.2f", sorted_transactions[trans_choice]->data.amt);
-    sprintf(message_buffer[3], "Category: %s", category_name);
-    confirm_message[0] = "Are you sure you want to remove this transaction?";
-    confirm_message[1] = message_buffer[0];
-    confirm_message[2] = message_buffer[1];
-    confirm_message[3] = message_buffer[2];
-    confirm_message[4] = message_buffer[3];
-    int confirm = get_confirmation(dialog.textbox, confirm_message, 5);
-
-    if (confirm == 0)
-    { // Yes, remove it
-        int result = remove_transaction(trans_choice);
-        if (result == 0)
+    Money total = 0;
+    for (int i = 0; i < count; i++)
+    {
+        TransactionNode *node = find_transaction(ids[i]);
+        if (node != NULL)
         {
-            draw_error(dialog, "Failed to remove transaction.");
+            total += node->data.amt;
         }
     }
-
-    delete_bounded(dialog);
+    char message_buffer[2][100];
+    snprintf(message_buffer[0], sizeof(message_buffer[0]), "Remove %d transaction%s?", count, count == 1 ? "" : "s");
+    snprintf(message_buffer[1], sizeof(message_buffer[1]), "Total: $%s", money_str(total));
+    const char *confirm_message[2] = {message_buffer[0], message_buffer[1]};
+    dialog_confirm(dialog, REMOVE_TRANSACTION_CONFIRM, confirm_message, 2);
+    return dialog;
 }
 
-void budget_summary_dialog()
+/* Edit transaction */
+
+enum
 {
-    WINDOW *win = stdscr;
-    int max_y, max_x;
-    getmaxyx(win, max_y, max_x);
+    EDIT_TRANSACTION_DESC,
+    EDIT_TRANSACTION_AMOUNT,
+    EDIT_TRANSACTION_DATE,
+    EDIT_TRANSACTION_CATEGORY
+};
 
-    int dialog_height = DEFAULT_DIALOG_HEIGHT;
-    int dialog_width = DEFAULT_DIALOG_WIDTH;
-    int start_y = (max_y - dialog_height) / 2;
-    int start_x = (max_x - dialog_width) / 2;
+typedef struct
+{
+    Transaction original;
+    Transaction transaction;
+} EditTransactionState;
 
-    BoundedWindow dialog = draw_bounded_with_title(dialog_height, dialog_width, start_y, start_x, "Budget Summary", false, ALIGN_CENTER);
-    wnoutrefresh(dialog.boundary);
+// Sorted row of a loaded-month node, or -1
+static int sorted_row_of(TransactionNode *node)
+{
+    return node != NULL ? order_index_rank(&sorted_transactions, node) : -1;
+}
 
-    const char *options_names[5] = {0};
-    int options_values[5] = {0};
-    int num_options = 0;
+/*
+ * Same month: rewrite the record in place. Another month: add it there (with a new
+ * id) and remove the original, which has to be in the month on screen.
+ */
+static int save_edited_transaction(EditTransactionState *state)
+{
+    Transaction *tx = &state->transaction;
+    int year = get_year_from_date(tx->date), month = get_month_from_date(tx->date);
+    if (year == TRANSACTION_ID_YEAR(tx->id) && month == TRANSACTION_ID_MONTH(tx->id))
+    {
+        return update_transaction(tx);
+    }
+    int row = sorted_row_of(find_transaction(state->original.id));
+    if (row < 0)
+    {
+        return -4;
+    }
+    Transaction moved = *tx;
+    moved.id = 0;
+    int res = add_transaction(&moved, year, month);
+    if (res < 0)
+    {
+        return res;
+    }
+    return remove_transaction(row) == 1 ? 1 : -1;
+}
 
-    if (category_count < MAX_CATEGORIES)
+static DialogStatus edit_transaction_advance(Dialog *dialog, WidgetStatus status)
+{
+    EditTransactionState *state = dialog->ctx;
+    Transaction *tx = &state->transaction;
+    if (status == WIDGET_CANCELLED)
     {
-        options_names[num_options] = "Add Category";
-        options_values[num_options] = 0;
-        num_options++;
+        return DIALOG_CLOSED;
     }
-    if (category_count > 0)
+
+    switch (dialog->step)
     {
-        options_names[num_options] = "Remove Category";
-        options_values[num_options] = 1;
-        num_options++;
+    case EDIT_TRANSACTION_DESC:
+    {
+        input_field_value(&dialog->field_state.input, tx->desc);
+        char amount[MONEY_FORMAT_LEN];
+        money_format(amount, tx->amt);
+        dialog_input(dialog, EDIT_TRANSACTION_AMOUNT, "Amount: $", MAX_BUFFER, INPUT_MONEY);
+        input_field_set(&dialog->field_state.input, amount);
+        return DIALOG_OPEN;
     }
-    if (current_month_transaction_count > 0)
+    case EDIT_TRANSACTION_AMOUNT:
     {
-        options_names[num_options] = "View Transactions";
-        options_values[num_options] = 2;
-        num_options++;
+        Money amount = -1;
+        input_field_value(&dialog->field_state.input, &amount);
+        if (amount == -1)
+        {
+            return DIALOG_CLOSED;
+        }
+        tx->amt = amount;
+        wclear(dialog->frame.textbox);
+        wmove(dialog->frame.textbox, 1, 0);
+        dialog_date(dialog, EDIT_TRANSACTION_DATE, "Date (YYYY-MM-DD): ");
+        // Start from the transaction's own date rather than the newest one
+        DateField *field = &dialog->field_state.date;
+        sscanf(tx->date, "%d-%d-%d", &field->year, &field->month, &field->day);
+        format_date(field->win, field->y, field->x, field->day, field->month, field->year, field->highlighted_field, field->cursor_positions);
+        return DIALOG_OPEN;
     }
-    options_names[num_options] = "Set Total Budget";
-    options_values[num_options] = 3;
-    num_options++;
-    options_names[num_options] = "Exit";
-    options_values[num_options] = 4;
-    num_options++;
+    case EDIT_TRANSACTION_DATE:
+    {
+        char date_buffer[11] = "";
+        date_field_value(&dialog->field_state.date, date_buffer);
+        strncpy(tx->date, date_buffer, 10);
+        tx->date[10] = '\0';
+
+        int year = get_year_from_date(tx->date), month = get_month_from_date(tx->date);
+        bool same_month = year == TRANSACTION_ID_YEAR(tx->id) && month == TRANSACTION_ID_MONTH(tx->id);
+        if (!same_month && find_transaction(tx->id) == NULL)
+        {
+            return dialog_message(dialog, "Open the transaction's own month to move it.");
+        }
+
+        // Category ids are per month, so offer the categories of the month it lands in
+        Category *month_categories;
+        CategoryIds month_ids;
+        int slot_count;
+        if (read_month_categories(year, month, &month_categories, &slot_count, &month_ids) < 0)
+        {
+            return dialog_message(dialog, "Failed to read the month's categories.");
+        }
+        int item_count = 0, highlighted = 0;
+        char **category_menu = malloc((slot_count + 1) * sizeof(char *));
+        int *menu_ids = malloc((slot_count + 1) * sizeof(int));
+        if (category_menu == NULL || menu_ids == NULL)
+        {
+            free(category_menu);
+            free(menu_ids);
+            free(month_categories);
+            return dialog_message(dialog, "Memory allocation error.");
+        }
+        const Category *old_category = category_of(state->original.cat_id);
+        const char *old_name = old_category != NULL ? old_category->name : NULL;
+        int old_id = category_ids_resolve(&month_ids, tx->cat_id);
+        for (int i = -1; i < slot_count; i++)
+        {
+            if (i >= 0 && month_categories[i].budget <= 0)
+            {
+                continue; // removed category
+            }
+            const char *name = i >= 0 ? month_categories[i].name : "Uncategorized";
+            int id = i >= 0 ? month_categories[i].id : -1;
+            if ((category_menu[item_count] = strdup(name)) == NULL)
+            {
+                for (int j = 0; j < item_count; j++)
+                {
+                    free(category_menu[j]);
+                }
+                free(category_menu);
+                free(menu_ids);
+                free(month_categories);
+                return dialog_message(dialog, "Memory allocation error.");
+            }
+            // Keep the current category selected; across months, match it by name
+            if (same_month ? id == old_id : (i >= 0 && old_name != NULL && strcmp(name, old_name) == 0))
+            {
+                highlighted = item_count;
+            }
+            menu_ids[item_count++] = id;
+        }
+        free(month_categories);
+        wclear(dialog->frame.textbox);
+        dialog_owned_menu(dialog, EDIT_TRANSACTION_CATEGORY, "Category:", category_menu, menu_ids, item_count, 6, 1, true);
+        MenuField *menu = &dialog->field_state.menu;
+        menu->highlighted = highlighted;
+        menu->start_index = MAX(0, highlighted - menu->visible_items + 1);
+        menu_field_draw(menu);
+        return DIALOG_OPEN;
+    }
+    case EDIT_TRANSACTION_CATEGORY:
+    {
+        tx->cat_id = dialog_menu_value(dialog);
+        int result = save_edited_transaction(state);
+        if (result < 0)
+        {
+            char error_message[MAX_BUFFER];
+            sprintf(error_message, "Failed to update transaction: Error %d", result);
+            return dialog_message(dialog, error_message);
+        }
+        return DIALOG_CLOSED;
+    }
+    }
+    return DIALOG_CLOSED;
+}
+
+// Edit a transaction from the history pane; transaction is copied
+Dialog *edit_transaction_dialog(const Transaction *transaction)
+{
+    Dialog *dialog = open_default_dialog("Edit Transaction", edit_transaction_advance, sizeof(EditTransactionState));
+    if (dialog == NULL)
+    {
+        return NULL;
+    }
+    EditTransactionState *state = dialog->ctx;
+    state->original = *transaction;
+    state->transaction = *transaction;
+    if (transaction->id == 0)
+    {
+        dialog_message(dialog, "This transaction has no id and can't be edited.");
+        return dialog;
+    }
+
+    // Fields start out holding the current values
+    wmove(dialog->frame.textbox, 1, 0);
+    dialog_input(dialog, EDIT_TRANSACTION_DESC, "Description: ", MAX_NAME_LEN, INPUT_STRING);
+    input_field_set(&dialog->field_state.input, transaction->desc);
+    return dialog;
+}
+
+/* Budget summary */
 
-    int option_choice = get_scrollable_menu_choice(dialog.textbox, "Select an option:", options_names, num_options, 5, 1, true);
-    if (option_choice == -1)
+typedef struct
+{
+    const char *options_names[5]; // the menu keeps pointing at these while open
+    int options_values[5];
+} BudgetSummaryState;
+
+static DialogStatus budget_summary_advance(Dialog *dialog, WidgetStatus status)
+{
+    BudgetSummaryState *state = dialog->ctx;
+    if (status == WIDGET_CANCELLED)
     {
-        delete_bounded(dialog);
-        return;
+        return DIALOG_CLOSED;
     }
 
-    switch (options_values[option_choice])
+    // The chosen action opens as its own dialog once this menu closes
+    switch (state->options_values[menu_field_value(&dialog->field_state.menu)])
     {
     case 0:
-        add_category_dialog();
-        sort_categories_by_budget();
+        dialog->next = add_category_dialog();
         break;
     case 1:
-        remove_category_dialog();
-        // sorted inside of this
+        dialog->next = remove_category_dialog();
         break;
     case 2:
-        draw_error(dialog, "Not implemented yet");
-        break;
+        return dialog_message(dialog, "Not implemented yet");
     case 3:
-        set_budget_dialog();
+        dialog->next = set_budget_dialog();
         break;
     case 4:
         break;
     }
-
-    delete_bounded(dialog);
+    return DIALOG_CLOSED;
 }
 
-void add_subscription_dialog()
+Dialog *budget_summary_dialog()
 {
-    WINDOW *win = stdscr;
-    int max_y, max_x;
-    getmaxyx(win, max_y, max_x);
-
-    int dialog_height = 14;
-    int dialog_width = DEFAULT_DIALOG_WIDTH;
-    int start_y = (max_y - dialog_height) / 2;
-    int start_x = (max_x - dialog_width) / 2;
-
-    BoundedWindow dialog = draw_bounded_with_title(dialog_height, dialog_width, start_y, start_x, "Add Subscription", false, ALIGN_CENTER);
-    wnoutrefresh(dialog.boundary);
+    Dialog *dialog = open_default_dialog("Budget Summary", budget_summary_advance, sizeof(BudgetSummaryState));
+    if (dialog == NULL)
+    {
+        return NULL;
+    }
 
-    // Create a new subscription
-    Subscription new_sub;
-    memset(&new_sub, 0, sizeof(Subscription));
+    BudgetSummaryState *state = dialog->ctx;
+    const char **options_names = state->options_names;
+    int num_options = 0;
 
-    // Get subscription name
-    if (!get_input(dialog.textbox, new_sub.name, "Enter subscription name: ", MAX_NAME_LEN, INPUT_STRING))
+    options_names[num_options] = "Add Category";
+    state->options_values[num_options] = 0;
+    num_options++;
+    if (category_count > 0)
     {
-        delete_bounded(dialog);
-        return; // User canceled
+        options_names[num_options] = "Remove Category";
+        state->options_values[num_options] = 1;
+        num_options++;
     }
-
-    if (!get_input(dialog.textbox, &new_sub.amount, "Enter amount: $", MAX_BUFFER, INPUT_DOUBLE))
+    if (current_month_transaction_count > 0)
     {
-        delete_bounded(dialog);
-        return; // User canceled
+        options_names[num_options] = "View Transactions";
+        state->options_values[num_options] = 2;
+        num_options++;
     }
+    options_names[num_options] = "Set Total Budget";
+    state->options_values[num_options] = 3;
+    num_options++;
+    options_names[num_options] = "Exit";
+    state->options_values[num_options] = 4;
+    num_options++;
+
+    dialog_menu(dialog, 0, "Select an option:", options_names, num_options, 5, 1, true);
+    return dialog;
+}
+
+/* Add subscription */
+
+enum
+{
+    ADD_SUBSCRIPTION_NAME,
+    ADD_SUBSCRIPTION_AMOUNT,
+    ADD_SUBSCRIPTION_TYPE,
+    ADD_SUBSCRIPTION_PERIOD,
+    ADD_SUBSCRIPTION_WEEKDAY,
+    ADD_SUBSCRIPTION_MONTH_DAY,
+    ADD_SUBSCRIPTION_YEAR_MONTH,
+    ADD_SUBSCRIPTION_YEAR_DAY,
+    ADD_SUBSCRIPTION_CUSTOM_DAYS,
+    ADD_SUBSCRIPTION_START,
+    ADD_SUBSCRIPTION_END,
+    ADD_SUBSCRIPTION_CATEGORY
+};
+
+static const char *day_menu[] = {
+    "Sunday",
+    "Monday",
+    "Tuesday",
+    "Wednesday",
+    "Thursday",
+    "Friday",
+    "Saturday"};
+
+static int clamp_int(int value, int min, int max)
+{
+    return (value < min) ? min : (value > max) ? max
+                                               : value;
+}
 
-    const char *type_menu[] = {
-        "Expense",
-        "Income"};
-    int y, x;
-    getyx(dialog.textbox, y, x);
-    int type_choice = get_scrollable_menu_choice(dialog.textbox, "Select type:", type_menu, 2, 5, y, false);
-    if (type_choice == -1)
+static DialogStatus add_subscription_commit(Dialog *dialog)
+{
+    Subscription *new_sub = dialog->ctx;
+
+    // Set initial last_updated to start_date
+    struct tm start_tm = {0};
+    sscanf(new_sub->start_date, "%d-%d-%d",
+           &start_tm.tm_year, &start_tm.tm_mon, &start_tm.tm_mday);
+    start_tm.tm_year -= 1900; // Adjust year (tm_year is years since 1900)
+    start_tm.tm_mon -= 1;     // Adjust month (tm_mon is 0-11)
+    mktime(&start_tm);        // Normalize the time
+    new_sub->last_updated = start_tm;
+
+    int res = add_subscription(new_sub);
+    dialog->next = update_subscriptions_dialog();
+    if (res == -1)
     {
-        delete_bounded(dialog);
-        return; // User canceled
+        return dialog_message(dialog, "Error adding subscription");
     }
-    new_sub.expense = (type_choice == 0);
+    return DIALOG_CLOSED;
+}
 
-    // Get period type
-    const char *period_menu[] = {
-        "Weekly",
-        "Monthly",
-        "Yearly",
-        "Custom Days"};
-    wclear(dialog.textbox);
-    mvwprintw(dialog.textbox, 1, 0, "Select period:");
-    int period_choice = get_scrollable_menu_choice(dialog.textbox, "", period_menu, 4, 5, 1, false);
-    if (period_choice == -1)
+static DialogStatus add_subscription_advance(Dialog *dialog, WidgetStatus status)
+{
+    Subscription *new_sub = dialog->ctx;
+    WINDOW *textbox = dialog->frame.textbox;
+    if (status == WIDGET_CANCELLED)
     {
-        delete_bounded(dialog);
-        return; // User canceled
+        return DIALOG_CLOSED;
     }
-    new_sub.period_type = period_choice;
 
-    // Get period day based on type
-    wclear(dialog.textbox);
-    switch (period_choice)
+    switch (dialog->step)
     {
-    case PERIOD_WEEKLY:
+    case ADD_SUBSCRIPTION_NAME:
+        input_field_value(&dialog->field_state.input, new_sub->name);
+        dialog_input(dialog, ADD_SUBSCRIPTION_AMOUNT, "Enter amount: $", MAX_BUFFER, INPUT_MONEY);
+        return DIALOG_OPEN;
+    case ADD_SUBSCRIPTION_AMOUNT:
+    {
+        input_field_value(&dialog->field_state.input, &new_sub->amount);
+        static const char *type_menu[] = {
+            "Expense",
+            "Income"};
+        int y = getcury(textbox);
+        dialog_menu(dialog, ADD_SUBSCRIPTION_TYPE, "Select type:", type_menu, 2, 5, y, false);
+        return DIALOG_OPEN;
+    }
+    case ADD_SUBSCRIPTION_TYPE:
     {
-        getyx(dialog.textbox, y, x);
-        const char *day_menu[] = {
-            "Sunday",
-            "Monday",
-            "Tuesday",
-            "Wednesday",
-            "Thursday",
-            "Friday",
-            "Saturday"};
-        mvwprintw(dialog.textbox, 1, 0, "Select day of the week:");
-        int day_choice = get_menu_choice(dialog.textbox, day_menu, 7, 2, true);
-        if (day_choice == -1)
+        new_sub->expense = (menu_field_value(&dialog->field_state.menu) == 0);
+
+        // Get period type
+        static const char *period_menu[] = {
+            "Weekly",
+            "Monthly",
+            "Yearly",
+            "Custom Days"};
+        wclear(textbox);
+        mvwprintw(textbox, 1, 0, "Select period:");
+        dialog_menu(dialog, ADD_SUBSCRIPTION_PERIOD, "", period_menu, 4, 5, 1, false);
+        return DIALOG_OPEN;
+    }
+    case ADD_SUBSCRIPTION_PERIOD:
+        new_sub->period_type = menu_field_value(&dialog->field_state.menu);
+
+        // Get period day based on type
+        wclear(textbox);
+        switch (new_sub->period_type)
         {
-            delete_bounded(dialog);
-            return; // User canceled
+        case PERIOD_WEEKLY:
+            dialog_menu(dialog, ADD_SUBSCRIPTION_WEEKDAY, "Select day of the week:", day_menu, 7, 7, 1, false);
+            break;
+        case PERIOD_MONTHLY:
+            dialog_input(dialog, ADD_SUBSCRIPTION_MONTH_DAY, "Enter day of month (1-31): ", MAX_BUFFER, INPUT_INT);
+            break;
+        case PERIOD_YEARLY:
+            dialog_input(dialog, ADD_SUBSCRIPTION_YEAR_MONTH, "Enter month (1-12): ", MAX_BUFFER, INPUT_INT);
+            break;
+        case PERIOD_CUSTOM_DAYS:
+            dialog_input(dialog, ADD_SUBSCRIPTION_CUSTOM_DAYS, "Enter number of days between recurrences (1-365): ", MAX_BUFFER, INPUT_INT);
+            break;
         }
-        new_sub.period_day = day_choice;
-
-        mvwprintw(dialog.textbox, 1, 0, "Select day of the week: %s", day_menu[day_choice]);
-        wclrtobot(dialog.textbox);
-        wmove(dialog.textbox, 2, 0);
+        return DIALOG_OPEN;
+    case ADD_SUBSCRIPTION_WEEKDAY:
+        new_sub->period_day = menu_field_value(&dialog->field_state.menu);
+        mvwprintw(textbox, 1, 0, "Select day of the week: %s", day_menu[new_sub->period_day]);
+        wclrtobot(textbox);
+        wmove(textbox, 2, 0);
         break;
-    }
-    case PERIOD_MONTHLY:
+    case ADD_SUBSCRIPTION_MONTH_DAY:
     {
         int day;
-        wclear(dialog.textbox);
-        if (!get_input(dialog.textbox, &day, "Enter day of month (1-31): ", MAX_BUFFER, INPUT_INT))
-        {
-            delete_bounded(dialog);
-            return; // User canceled
-        }
-        new_sub.period_day = (day < 1) ? 1 : (day > 31) ? 31
-                                                        : day;
+        input_field_value(&dialog->field_state.input, &day);
+        new_sub->period_day = clamp_int(day, 1, 31);
         break;
     }
-    case PERIOD_YEARLY:
+    case ADD_SUBSCRIPTION_YEAR_MONTH:
     {
         int month;
-        wclear(dialog.textbox);
-        if (!get_input(dialog.textbox, &month, "Enter month (1-12): ", MAX_BUFFER, INPUT_INT))
-        {
-            delete_bounded(dialog);
-            return; // User canceled
-        }
-        new_sub.period_day = (month < 1) ? 1 : (month > 12) ? 12
-                                                            : month;
-
+        input_field_value(&dialog->field_state.input, &month);
+        new_sub->period_day = clamp_int(month, 1, 12);
+        wclear(textbox);
+        dialog_input(dialog, ADD_SUBSCRIPTION_YEAR_DAY, "Enter day of month (1-31): ", MAX_BUFFER, INPUT_INT);
+        return DIALOG_OPEN;
+    }
+    case ADD_SUBSCRIPTION_YEAR_DAY:
+    {
         int day;
-        wclear(dialog.textbox);
-        if (!get_input(dialog.textbox, &day, "Enter day of month (1-31): ", MAX_BUFFER, INPUT_INT))
-        {
-            delete_bounded(dialog);
-            return; // User canceled
-        }
-        new_sub.period_month_day = (day < 1) ? 1 : (day > 31) ? 31
-                                                              : day;
+        input_field_value(&dialog->field_state.input, &day);
+        new_sub->period_month_day = clamp_int(day, 1, 31);
         break;
     }
-    case PERIOD_CUSTOM_DAYS:
+    case ADD_SUBSCRIPTION_CUSTOM_DAYS:
     {
         int days;
-        wclear(dialog.textbox);
-        if (!get_input(dialog.textbox, &days, "Enter number of days between recurrences (1-365): ", MAX_BUFFER, INPUT_INT))
-        {
-            delete_bounded(dialog);
-            return; // User canceled
-        }
-        new_sub.period_day = (days < 1) ? 1 : (days > 365) ? 365
-                                                           : days;
+        input_field_value(&dialog->field_state.input, &days);
+        new_sub->period_day = clamp_int(days, 1, 365);
         break;
     }
-    }
-
-    // Get start date
-    char date_buffer[11];
-    if (!get_date_input(dialog.textbox, date_buffer, "Enter start date (YYYY-MM-DD): "))
-    {
-        delete_bounded(dialog);
-        return; // User canceled
-    }
-    getyx(dialog.textbox, y, x);
-    wmove(dialog.textbox, y + 1, 0);
-    strncpy(new_sub.start_date, date_buffer, 10);
-    new_sub.start_date[10] = '\0';
-
-    if (!get_date_input(dialog.textbox, date_buffer, "Enter end date (YYYY-MM-DD), or use same as start date for indefinite:"))
+    case ADD_SUBSCRIPTION_START:
     {
-        delete_bounded(dialog);
-        return; // User canceled
+        char date_buffer[11];
+        date_field_value(&dialog->field_state.date, date_buffer);
+        strncpy(new_sub->start_date, date_buffer, 10);
+        new_sub->start_date[10] = '\0';
+        wmove(textbox, getcury(textbox) + 1, 0);
+        dialog_date(dialog, ADD_SUBSCRIPTION_END, "Enter end date (YYYY-MM-DD), or use same as start date for indefinite:");
+        return DIALOG_OPEN;
     }
-    else
+    case ADD_SUBSCRIPTION_END:
     {
-        if (strcmp(date_buffer, new_sub.start_date) == 0)
+        char date_buffer[11];
+        date_field_value(&dialog->field_state.date, date_buffer);
+        if (strcmp(date_buffer, new_sub->start_date) == 0)
         {
-            strcpy(new_sub.end_date, "9999-12-31"); // Far future date
+            strcpy(new_sub->end_date, "9999-12-31"); // Far future date
         }
         else
         {
-            strcpy(new_sub.end_date, date_buffer);
-        }
-    }
-    new_sub.end_date[10] = '\0';
-
-    // Get category if it's an expense
-    if (new_sub.expense && category_count > 0)
-    {
-        char **category_menu = malloc(category_count * sizeof(char *));
-        if (category_menu == NULL)
-        {
-            draw_error(dialog, "Memory allocation error.");
-            delete_bounded(dialog);
-            return;
-        }
-
-        for (int i = 0; i < category_count; i++)
-        {
-            category_menu[i] = malloc(MAX_NAME_LEN);
-            if (category_menu[i] == NULL)
-            {
-                for (int j = 0; j < i; j++)
-                {
-                    free(category_menu[j]);
-                }
-                free(category_menu);
-                draw_error(dialog, "Memory allocation error.");
-                delete_bounded(dialog);
-                return;
-            }
-            strcpy(category_menu[i], categories[i].name);
+            strcpy(new_sub->end_date, date_buffer);
         }
+        new_sub->end_date[10] = '\0';
 
-        wclear(dialog.textbox);
-        int cat_choice = get_scrollable_menu_choice(dialog.textbox, "Select category:", (const char **)category_menu, category_count, 5, 1, true);
-
-        // Free allocated memory
-        for (int i = 0; i < category_count; i++)
+        // Get category if it's an expense
+        if (!new_sub->expense || category_count == 0)
         {
-            free(category_menu[i]);
+            strcpy(new_sub->cat_name, "Uncategorized");
+            return add_subscription_commit(dialog);
         }
-        free(category_menu);
 
-        if (cat_choice == -1)
+        int item_count, *menu_indices;
+        char **category_menu = build_category_menu(-1, false, &menu_indices, &item_count);
+        if (category_menu == NULL)
         {
-            delete_bounded(dialog);
-            return; // User canceled
+            return dialog_message(dialog, "Memory allocation error.");
         }
-
-        strcpy(new_sub.cat_name, categories[cat_choice].name);
+        wclear(textbox);
+        dialog_owned_menu(dialog, ADD_SUBSCRIPTION_CATEGORY, "Select category:", category_menu, menu_indices, item_count, 5, 1, true);
+        return DIALOG_OPEN;
     }
-    else
-    {
-        strcpy(new_sub.cat_name, "Uncategorized");
+    case ADD_SUBSCRIPTION_CATEGORY:
+        strcpy(new_sub->cat_name, categories[dialog_menu_value(dialog)].name);
+        return add_subscription_commit(dialog);
     }
 
-    // Set initial last_updated to start_date
-    struct tm start_tm = {0};
-    sscanf(new_sub.start_date, "%d-%d-%d",
-           &start_tm.tm_year, &start_tm.tm_mon, &start_tm.tm_mday);
-    start_tm.tm_year -= 1900; // Adjust year (tm_year is years since 1900)
-    start_tm.tm_mon -= 1;     // Adjust month (tm_mon is 0-11)
-    mktime(&start_tm);        // Normalize the time
-    new_sub.last_updated = start_tm;
+    // Every period path ends by asking for the start date
+    dialog_date(dialog, ADD_SUBSCRIPTION_START, "Enter start date (YYYY-MM-DD): ");
+    return DIALOG_OPEN;
+}
 
-    int res = add_subscription(&new_sub);
-    if (res == -1)
+Dialog *add_subscription_dialog()
+{
+    Dialog *dialog = dialog_open("Add Subscription", 14, DEFAULT_DIALOG_WIDTH, add_subscription_advance, sizeof(Subscription));
+    if (dialog == NULL)
     {
-        draw_error(dialog, "Error adding subscription");
+        return NULL;
     }
-    update_subscriptions();
 
-    delete_bounded(dialog);
+    dialog_input(dialog, ADD_SUBSCRIPTION_NAME, "Enter subscription name: ", MAX_NAME_LEN, INPUT_STRING);
+    return dialog;
 }
 
-void remove_subscription_dialog(int selected_subscription)
-{
-    WINDOW *win = stdscr;
-    int max_y, max_x;
-    getmaxyx(win, max_y, max_x);
-
-    int dialog_height = DEFAULT_DIALOG_HEIGHT;
-    int dialog_width = DEFAULT_DIALOG_WIDTH;
-    int start_y = (max_y - dialog_height) / 2;
-    int start_x = (max_x - dialog_width) / 2;
+/* Remove subscription */
 
-    BoundedWindow dialog = draw_bounded_with_title(dialog_height, dialog_width, start_y, start_x, "Remove Subscription", false, ALIGN_CENTER);
-    wnoutrefresh(dialog.boundary);
+static DialogStatus remove_subscription_advance(Dialog *dialog, WidgetStatus status)
+{
+    int *selected_subscription = dialog->ctx;
+    if (status == WIDGET_DONE && dialog->field_state.confirm.choice == 0)
+    {
+        remove_subscription(*selected_subscription);
+    }
+    return DIALOG_CLOSED;
+}
 
-    if (selected_subscription == -1 || selected_subscription >= subscription_count)
+Dialog *remove_subscription_dialog(int selected_subscription)
+{
+    Dialog *dialog = open_default_dialog("Remove Subscription", remove_subscription_advance, sizeof(int));
+    if (dialog == NULL)
     {
-        draw_error(dialog, "Subscription not found.");
-        return;
+        return NULL;
     }
 
-    // Create dynamic menu for subscriptions
-    char **sub_menu = malloc(subscription_count * sizeof(char *));
-    if (sub_menu == NULL)
+    if (selected_subscription == -1 || selected_subscription >= subscription_count)
     {
-        draw_error(dialog, "Memory allocation error.");
-        return;
+        dialog_message(dialog, "Subscription not found.");
+        return dialog;
     }
+    *(int *)dialog->ctx = selected_subscription;
 
     const char *confirm_message[2];
     char message_buffer[100];
     sprintf(message_buffer, "Are you sure you want to remove \"%s\"?", subscriptions[selected_subscription].name);
     confirm_message[0] = message_buffer;
     confirm_message[1] = "This will not remove any transactions already created.";
-    int confirm = get_confirmation(dialog.textbox, confirm_message, 2);
+    dialog_confirm(dialog, 0, confirm_message, 2);
+    return dialog;
+}
+
+/* Subscription category */
 
-    if (confirm == 0)
+static DialogStatus subscription_category_advance(Dialog *dialog, WidgetStatus status)
+{
+    SubscriptionOccurrence *occurrence = dialog->ctx;
+    // Skipping files it uncategorized and asks again for the next occurrence
+    int cat_id = status == WIDGET_DONE ? dialog_menu_value(dialog) : -1;
+    if (add_subscription_occurrence(occurrence, cat_id) < 0)
     {
-        remove_subscription(selected_subscription);
+        return dialog_message(dialog, "Failed to add the subscription's transaction.");
     }
+    dialog->next = update_subscriptions_dialog();
+    return DIALOG_CLOSED;
+}
 
-    delete_bounded(dialog);
-}
\ No newline at end of file
+// Ask which of the month's budgeted categories, largest first, an occurrence goes
+// under; NULL when the month has none to offer
+static Dialog *subscription_category_dialog(const SubscriptionOccurrence *occurrence)
+{
+    Category *month_categories;
+    int slot_count;
+    if (read_month_categories(occurrence->year, occurrence->month, &month_categories, &slot_count, NULL) != 1)
+    {
+        return NULL;
+    }
+    char **category_menu = malloc((slot_count > 0 ? slot_count : 1) * sizeof(char *));
+    int *menu_ids = malloc((slot_count > 0 ? slot_count : 1) * sizeof(int));
+    Money *budgets = malloc((slot_count > 0 ? slot_count : 1) * sizeof(Money));
+    int item_count = 0;
+    bool ok = category_menu != NULL && menu_ids != NULL && budgets != NULL;
+    for (int i = 0; i < slot_count && ok; i++)
+    {
+        if (month_categories[i].budget <= 0)
+        {
+            continue;
+        }
+        char *label = malloc(MAX_NAME_LEN + 40);
+        if (label == NULL)
+        {
+            ok = false;
+            break;
+        }
+        snprintf(label, MAX_NAME_LEN + 40, "%-29.29s $%-12s $%s", month_categories[i].name,
+                 money_str(month_categories[i].spent), money_str(month_categories[i].budget));
+        int j = item_count++;
+        while (j > 0 && budgets[j - 1] < month_categories[i].budget)
+        {
+            category_menu[j] = category_menu[j - 1];
+            menu_ids[j] = menu_ids[j - 1];
+            budgets[j] = budgets[j - 1];
+            j--;
+        }
+        category_menu[j] = label;
+        menu_ids[j] = month_categories[i].id;
+        budgets[j] = month_categories[i].budget;
+    }
+    free(budgets);
+    free(month_categories);
+    Dialog *dialog = ok && item_count > 0
+                         ? open_default_dialog("Updating Subscriptions", subscription_category_advance, sizeof(SubscriptionOccurrence))
+                         : NULL;
+    if (dialog == NULL)
+    {
+        for (int i = 0; i < item_count; i++)
+        {
+            free(category_menu[i]);
+        }
+        free(category_menu);
+        free(menu_ids);
+        return NULL;
+    }
+
+    *(SubscriptionOccurrence *)dialog->ctx = *occurrence;
+    char prompt[MAX_NAME_LEN + 64];
+    snprintf(prompt, sizeof(prompt), "No category for \"%.20s\" in %d-%02d (ESC skips):",
+             occurrence->transaction.desc, occurrence->year, occurrence->month);
+    dialog_owned_menu(dialog, 0, prompt, category_menu, menu_ids, item_count, 6, 1, true);
+    return dialog;
+}
+
+// Catch the subscriptions up; returns a dialog for the first occurrence whose category
+// has to be picked, or NULL once they are all up to date
+Dialog *update_subscriptions_dialog()
+{
+    SubscriptionOccurrence occurrence;
+    while (!update_subscriptions(&occurrence))
+    {
+        Dialog *dialog = subscription_category_dialog(&occurrence);
+        if (dialog != NULL)
+        {
+            return dialog;
+        }
+        // Nothing to pick from: file it uncategorized and carry on
+        if (add_subscription_occurrence(&occurrence, -1) < 0)
+        {
+            break; // tried again on the next update
+        }
+    }
+    return NULL;
+}
+
+/* Export to CSV */
+
+Dialog *export_csv_dialog()
+{
+    // Only a message, so there is nothing to advance
+    Dialog *dialog = open_default_dialog("Export to CSV", NULL, 0);
+    if (dialog == NULL)
+    {
+        return NULL;
+    }
+
+    // // Export the data
+    // export_data_to_csv(0);
+
+    char export_path[MAX_BUFFER];
+    snprintf(export_path, sizeof(export_path), "Export doesn't work but if it did, it would be exported to: %.30s", export_file_path);
+    dialog_message(dialog, export_path);
+    return dialog;
+}
@@ -0,0 +1,94 @@
+#include "category_ids.h"
+
+void category_ids_init(CategoryIds *ids, int next_id)
+{
+    memset(ids, 0, sizeof(CategoryIds));
+    ids->next_id = next_id;
+}
+
+int category_ids_assign(CategoryIds *ids)
+{
+    return ids->next_id++;
+}
+
+bool category_ids_alias(CategoryIds *ids, int from_id, int to_id)
+{
+    if (ids->alias_count == MAX_CATEGORY_ALIASES)
+    {
+        return false;
+    }
+    // Keep every alias one hop long
+    for (int i = 0; i < ids->alias_count; i++)
+    {
+        if (ids->aliases[i].to_id == from_id)
+        {
+            ids->aliases[i].to_id = to_id;
+        }
+    }
+    ids->aliases[ids->alias_count].from_id = from_id;
+    ids->aliases[ids->alias_count].to_id = to_id;
+    ids->alias_count++;
+    return true;
+}
+
+int category_ids_resolve(const CategoryIds *ids, int cat_id)
+{
+    for (int i = 0; i < ids->alias_count && cat_id >= 0; i++)
+    {
+        if (ids->aliases[i].from_id == cat_id)
+        {
+            return ids->aliases[i].to_id;
+        }
+    }
+    return cat_id;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+int category_map_build(CategoryMap *map, const CategoryIds *ids, const Category *slots, int slot_count)
+{
+    int size = ids->next_id > 0 ? ids->next_id : 1;
+    int *grown = realloc(map->slots, size * sizeof(int));
+    if (grown == NULL)
+    {
+        return -2;
+    }
+    map->slots = grown;
+    map->size = size;
+    for (int i = 0; i < size; i++)
+    {
+        map->slots[i] = -1;
+    }
+    for (int slot = 0; slot < slot_count; slot++)
+    {
+        if (slots[slot].id >= 0 && slots[slot].id < size)
+        {
+            map->slots[slots[slot].id] = slot;
+        }
+    }
+    // Aliases point at live ids, which were all filled in above
+    for (int i = 0; i < ids->alias_count; i++)
+    {
+        int from = ids->aliases[i].from_id, to = ids->aliases[i].to_id;
+        if (from >= 0 && from < size)
+        {
+            map->slots[from] = to >= 0 && to < size ? map->slots[to] : -1;
+        }
+    }
+    return 1;
+}
+
+int category_map_slot(const CategoryMap *map, int cat_id)
+{
+    return cat_id >= 0 && cat_id < map->size ? map->slots[cat_id] : -1;
+}
+
+void category_map_free(CategoryMap *map)
+{
+    free(map->slots);
+    map->slots = NULL;
+    map->size = 0;
+}
@@ -0,0 +1,918 @@
+#include "category_stats.h"
+#include "saveload.h"
+
+// One month's sidecar in memory
+typedef struct
+{
+    CategoryStats *categories;
+    int category_count;
+    int category_capacity;
+    CategoryStatsSlot *slots;
+    int slot_count;
+} MonthStats;
+
+// Every month merged, by category name (categories only). The hooks count this
+// process's changes into it as they patch the sidecars; it is merged again when the
+// manifest generation moves for any other reason.
+static MonthStats totals = {NULL, 0, 0, NULL, 0};
+static unsigned long long totals_generation = 0;
+static bool totals_loaded = false;
+
+static long category_offset(int index)
+{
+    return sizeof(CategoryStatsHeader) + (long)index * sizeof(CategoryStats);
+}
+
+static long slot_offset(const CategoryStatsHeader *header, int slot)
+{
+    return category_offset(header->category_capacity) + (long)slot * sizeof(CategoryStatsSlot);
+}
+
+static int amount_bucket(Money amount)
+{
+    if (amount <= 1)
+    {
+        return 0;
+    }
+    int bucket = (int)(3 * log2((double)amount));
+    return bucket < CATEGORY_STATS_BUCKETS ? bucket : CATEGORY_STATS_BUCKETS - 1;
+}
+
+static void stats_insert(CategoryStats *stats, Money amount)
+{
+    double value = (double)amount;
+    stats->count++;
+    double delta = value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+    stats->buckets[amount_bucket(amount)]++;
+}
+
+// Welford's update run backwards; amount must have been inserted before
+static void stats_erase(CategoryStats *stats, Money amount)
+{
+    double value = (double)amount;
+    stats->buckets[amount_bucket(amount)]--;
+    if (stats->count <= 1)
+    {
+        stats->count = 0;
+        stats->mean = 0;
+        stats->m2 = 0;
+        return;
+    }
+    double delta = value - stats->mean;
+    stats->mean -= delta / (stats->count - 1);
+    stats->m2 -= delta * (value - stats->mean);
+    if (stats->m2 < 0)
+    {
+        stats->m2 = 0; // rounding
+    }
+    stats->count--;
+}
+
+// Chan et al.'s pairwise combination of two sets of moments
+static void stats_merge(CategoryStats *into, const CategoryStats *from)
+{
+    if (from->count == 0)
+    {
+        return;
+    }
+    int count = into->count + from->count;
+    double delta = from->mean - into->mean;
+    into->mean += delta * from->count / count;
+    into->m2 += from->m2 + delta * delta * ((double)into->count * from->count / count);
+    into->count = count;
+    for (int i = 0; i < CATEGORY_STATS_BUCKETS; i++)
+    {
+        into->buckets[i] += from->buckets[i];
+    }
+}
+
+static void month_stats_free(MonthStats *stats)
+{
+    free(stats->categories);
+    free(stats->slots);
+    memset(stats, 0, sizeof(MonthStats));
+}
+
+/*
+ * Index of the named category, adding it if it's new
+ *
+ * Returns:
+ *   >= 0  - Index into stats->categories
+ *   -2    - Malloc error
+ */
+static int find_category(MonthStats *stats, const char *name)
+{
+    for (int i = 0; i < stats->category_count; i++)
+    {
+        if (strncmp(stats->categories[i].name, name, MAX_NAME_LEN) == 0)
+        {
+            return i;
+        }
+    }
+    if (stats->category_count == stats->category_capacity)
+    {
+        int capacity = stats->category_capacity > 0 ? stats->category_capacity * 2 : 16;
+        CategoryStats *grown = realloc(stats->categories, capacity * sizeof(CategoryStats));
+        if (grown == NULL)
+        {
+            return -2;
+        }
+        stats->categories = grown;
+        stats->category_capacity = capacity;
+    }
+    CategoryStats *category = &stats->categories[stats->category_count];
+    memset(category, 0, sizeof(CategoryStats));
+    strncpy(category->name, name, MAX_NAME_LEN - 1);
+    return stats->category_count++;
+}
+
+static bool counted(const Transaction *transaction)
+{
+    return transaction->expense && transaction->amt > 0;
+}
+
+/*
+ * Count transaction into a slot record; the record must not be counted already
+ *
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+static int count_slot(MonthStats *stats, CategoryStatsSlot *record, const Transaction *transaction, const char *category_name)
+{
+    record->stats = -1;
+    record->reserved = 0;
+    record->amount = transaction->amt;
+    if (!counted(transaction))
+    {
+        return 1;
+    }
+    int index = find_category(stats, category_name);
+    if (index < 0)
+    {
+        return index;
+    }
+    record->stats = index;
+    stats_insert(&stats->categories[index], transaction->amt);
+    return 1;
+}
+
+static void uncount_slot(MonthStats *stats, CategoryStatsSlot *record)
+{
+    int index = record->stats;
+    if (index >= 0 && index < stats->category_count)
+    {
+        stats_erase(&stats->categories[index], record->amount);
+    }
+    record->stats = -1;
+}
+
+/*
+ * Write the sidecar through a temporary file so a reader never sees half of it
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ */
+static int save_stats(int year, int month, const MonthStats *stats, unsigned long long generation)
+{
+    CategoryStatsHeader header = {
+        .magic = CATEGORY_STATS_MAGIC,
+        .version = CATEGORY_STATS_VERSION,
+        .transaction_count = stats->slot_count,
+        .category_count = stats->category_count,
+        .category_capacity = stats->category_count + CATEGORY_STATS_SPARE,
+        .generation = generation};
+    CategoryStats spare[CATEGORY_STATS_SPARE];
+    memset(spare, 0, sizeof(spare));
+    char path[MAX_BUFFER + 32], tmp_path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "stat", "");
+    sidecar_path(tmp_path, sizeof(tmp_path), year, month, "stat", ".tmp");
+    FILE *file = fopen(tmp_path, "wb");
+    bool ok = file != NULL &&
+              fwrite(&header, sizeof(CategoryStatsHeader), 1, file) == 1 &&
+              fwrite(stats->categories, sizeof(CategoryStats), stats->category_count, file) == (size_t)stats->category_count &&
+              fwrite(spare, sizeof(CategoryStats), CATEGORY_STATS_SPARE, file) == CATEGORY_STATS_SPARE &&
+              fwrite(stats->slots, sizeof(CategoryStatsSlot), stats->slot_count, file) == (size_t)stats->slot_count;
+    if (file == NULL || fclose(file) != 0 || !ok)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return rename(tmp_path, path) == 0 ? 1 : -1;
+}
+
+/*
+ * Read a month's sidecar, with room for extra more slots
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - No sidecar, or one that doesn't match generation and transaction_count
+ *   -2    - Malloc error
+ */
+static int load_stats(int year, int month, int transaction_count, unsigned long long generation, int extra, MonthStats *out)
+{
+    memset(out, 0, sizeof(MonthStats));
+    char path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "stat", "");
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    CategoryStatsHeader header;
+    if (fread(&header, sizeof(CategoryStatsHeader), 1, file) != 1 ||
+        strcmp(header.magic, CATEGORY_STATS_MAGIC) != 0 || header.version != CATEGORY_STATS_VERSION ||
+        header.generation != generation || header.transaction_count != transaction_count ||
+        header.category_count < 0 || header.category_capacity < header.category_count)
+    {
+        fclose(file);
+        return 0;
+    }
+    MonthStats stats = {
+        .categories = malloc((header.category_count > 0 ? header.category_count : 1) * sizeof(CategoryStats)),
+        .category_count = header.category_count,
+        .category_capacity = header.category_count > 0 ? header.category_count : 1,
+        .slots = malloc((transaction_count + extra > 0 ? transaction_count + extra : 1) * sizeof(CategoryStatsSlot)),
+        .slot_count = transaction_count};
+    if (stats.categories == NULL || stats.slots == NULL)
+    {
+        fclose(file);
+        month_stats_free(&stats);
+        return -2;
+    }
+    bool ok = fread(stats.categories, sizeof(CategoryStats), stats.category_count, file) == (size_t)stats.category_count &&
+              fseek(file, slot_offset(&header, 0), SEEK_SET) == 0 &&
+              fread(stats.slots, sizeof(CategoryStatsSlot), transaction_count, file) == (size_t)transaction_count;
+    fclose(file);
+    if (!ok)
+    {
+        month_stats_free(&stats);
+        return 0;
+    }
+    *out = stats;
+    return 1;
+}
+
+// Count every record in the month file from scratch; keeps the result in *out when it
+// isn't NULL. Hooks pass NULL, and the totals can't follow a month counted from
+// scratch, so they are merged again.
+static int rebuild_stats(int year, int month, unsigned long long generation, MonthStats *out)
+{
+    if (out == NULL)
+    {
+        category_stats_free();
+    }
+    MonthSnapshot snapshot;
+    int res = read_month_snapshot(year, month, &snapshot);
+    if (res <= 0)
+    {
+        return res < 0 ? res : -1;
+    }
+    MonthStats stats = {
+        .slots = malloc((snapshot.transaction_count > 0 ? snapshot.transaction_count : 1) * sizeof(CategoryStatsSlot)),
+        .slot_count = snapshot.transaction_count};
+    CategoryMap map = {NULL, 0};
+    res = stats.slots != NULL && category_map_build(&map, &snapshot.category_ids, snapshot.categories, snapshot.category_slots) >= 0 ? 1 : -2;
+    for (int i = 0; i < snapshot.transaction_count && res > 0; i++)
+    {
+        int slot = category_map_slot(&map, snapshot.transactions[i].cat_id);
+        res = count_slot(&stats, &stats.slots[i], &snapshot.transactions[i], slot >= 0 ? snapshot.categories[slot].name : "Uncategorized");
+    }
+    category_map_free(&map);
+    free_month_snapshot(&snapshot);
+    if (res > 0)
+    {
+        res = save_stats(year, month, &stats, generation);
+    }
+    if (res > 0 && out != NULL)
+    {
+        *out = stats;
+        return res;
+    }
+    month_stats_free(&stats);
+    return res;
+}
+
+/*
+ * Category names of the month's records, to count new ones under
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+static int load_names(int year, int month, Category **out_slots, CategoryMap *map)
+{
+    int slot_count;
+    CategoryIds ids;
+    int res = read_month_categories(year, month, out_slots, &slot_count, &ids);
+    if (res < 0)
+    {
+        return res;
+    }
+    if (category_map_build(map, &ids, *out_slots, slot_count) < 0)
+    {
+        free(*out_slots);
+        return -2;
+    }
+    return 1;
+}
+
+static const char *name_of(const Category *slots, const CategoryMap *map, int cat_id)
+{
+    int slot = category_map_slot(map, cat_id);
+    return slot >= 0 ? slots[slot].name : "Uncategorized";
+}
+
+// Count a row into or out of the totals, if they are loaded
+static void total_apply(const char *name, Money amount, bool insert)
+{
+    if (!totals_loaded)
+    {
+        return;
+    }
+    int index = find_category(&totals, name);
+    if (index < 0)
+    {
+        category_stats_free();
+        return;
+    }
+    if (insert)
+    {
+        stats_insert(&totals.categories[index], amount);
+    }
+    else
+    {
+        stats_erase(&totals.categories[index], amount);
+    }
+}
+
+// Name a slot record is counted under, "" if it isn't
+static void slot_name(const MonthStats *stats, const CategoryStatsSlot *record, char *name)
+{
+    bool valid = record->stats >= 0 && record->stats < stats->category_count;
+    strcpy(name, valid ? stats->categories[record->stats].name : "");
+}
+
+// A sidecar being patched in place: its header and categories as read, and the
+// categories as they are being changed
+typedef struct
+{
+    FILE *file;
+    CategoryStatsHeader header;
+    CategoryStats *original;
+    MonthStats stats; // categories only
+} StatsPatch;
+
+static void close_patch(StatsPatch *patch)
+{
+    if (patch->file != NULL)
+    {
+        fclose(patch->file);
+    }
+    free(patch->original);
+    month_stats_free(&patch->stats);
+    patch->file = NULL;
+    patch->original = NULL;
+}
+
+/*
+ * Open a sidecar that matched previous_generation with old_count slots and read its
+ * header and categories
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - No sidecar to patch
+ *   -2    - Malloc error
+ */
+static int open_patch(int year, int month, int old_count, unsigned long long previous_generation, StatsPatch *patch)
+{
+    memset(patch, 0, sizeof(StatsPatch));
+    char path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "stat", "");
+    patch->file = fopen(path, "r+b");
+    CategoryStatsHeader *header = &patch->header;
+    if (patch->file == NULL ||
+        fread(header, sizeof(CategoryStatsHeader), 1, patch->file) != 1 ||
+        strcmp(header->magic, CATEGORY_STATS_MAGIC) != 0 || header->version != CATEGORY_STATS_VERSION ||
+        header->generation != previous_generation || header->transaction_count != old_count ||
+        header->category_count < 0 || header->category_capacity < header->category_count)
+    {
+        close_patch(patch);
+        return 0;
+    }
+    int capacity = header->category_capacity > 0 ? header->category_capacity : 1;
+    patch->original = malloc(capacity * sizeof(CategoryStats));
+    patch->stats.categories = malloc(capacity * sizeof(CategoryStats));
+    patch->stats.category_capacity = capacity;
+    if (patch->original == NULL || patch->stats.categories == NULL)
+    {
+        close_patch(patch);
+        return -2;
+    }
+    if (fread(patch->original, sizeof(CategoryStats), header->category_count, patch->file) != (size_t)header->category_count)
+    {
+        close_patch(patch);
+        return 0;
+    }
+    memcpy(patch->stats.categories, patch->original, header->category_count * sizeof(CategoryStats));
+    patch->stats.category_count = header->category_count;
+    return 1;
+}
+
+static bool read_slot(StatsPatch *patch, int slot, CategoryStatsSlot *record)
+{
+    return fseek(patch->file, slot_offset(&patch->header, slot), SEEK_SET) == 0 &&
+           fread(record, sizeof(CategoryStatsSlot), 1, patch->file) == 1;
+}
+
+/*
+ * Write the categories that changed and records[0 .. count) from slot first onwards,
+ * cut the slots to entry's count and write the header last, so a torn patch leaves a
+ * stale sidecar that is rebuilt. Closes the patch.
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - New categories don't fit; nothing was written
+ *   -1    - I/O error occurred
+ */
+static int finish_patch(StatsPatch *patch, int first, const CategoryStatsSlot *records, int count, const ManifestEntry *entry)
+{
+    CategoryStatsHeader *header = &patch->header;
+    if (patch->stats.category_count > header->category_capacity)
+    {
+        close_patch(patch);
+        return 0;
+    }
+    FILE *file = patch->file;
+    bool ok = true;
+    for (int i = 0; i < patch->stats.category_count && ok; i++)
+    {
+        if (i >= header->category_count || memcmp(&patch->stats.categories[i], &patch->original[i], sizeof(CategoryStats)) != 0)
+        {
+            ok = fseek(file, category_offset(i), SEEK_SET) == 0 &&
+                 fwrite(&patch->stats.categories[i], sizeof(CategoryStats), 1, file) == 1;
+        }
+    }
+    ok = ok &&
+         fseek(file, slot_offset(header, first), SEEK_SET) == 0 &&
+         fwrite(records, sizeof(CategoryStatsSlot), count, file) == (size_t)count &&
+         fflush(file) == 0;
+    if (ok && entry->transaction_count < header->transaction_count)
+    {
+        ok = ftruncate(fileno(file), slot_offset(header, entry->transaction_count)) == 0;
+    }
+    header->transaction_count = entry->transaction_count;
+    header->category_count = patch->stats.category_count;
+    header->generation = entry->generation;
+    ok = ok &&
+         fseek(file, 0, SEEK_SET) == 0 &&
+         fwrite(header, sizeof(CategoryStatsHeader), 1, file) == 1;
+    patch->file = NULL;
+    ok = fclose(file) == 0 && ok;
+    close_patch(patch);
+    return ok ? 1 : -1;
+}
+
+/*
+ * Count new records into the sidecar in place
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - Sidecar has to be written out whole instead
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+static int patch_add(int year, int month, int first_slot, const Transaction *transactions, int count,
+                     const Category *slots, const CategoryMap *map, unsigned long long previous_generation, const ManifestEntry *entry)
+{
+    CategoryStatsSlot *records = malloc((count > 0 ? count : 1) * sizeof(CategoryStatsSlot));
+    if (records == NULL)
+    {
+        return -2;
+    }
+    StatsPatch patch;
+    int res = open_patch(year, month, first_slot, previous_generation, &patch);
+    for (int i = 0; i < count && res > 0; i++)
+    {
+        res = count_slot(&patch.stats, &records[i], &transactions[i], name_of(slots, map, transactions[i].cat_id));
+    }
+    if (res > 0)
+    {
+        res = finish_patch(&patch, first_slot, records, count, entry);
+    }
+    else if (res < 0)
+    {
+        close_patch(&patch);
+    }
+    free(records);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int category_stats_add(int year, int month, int first_slot, const Transaction *transactions, int count, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        return 1;
+    }
+    if (first_slot + count != entry->transaction_count)
+    {
+        return rebuild_stats(year, month, entry->generation, NULL);
+    }
+
+    // The month file's category table, only read when there is an expense to file
+    Category *slots = NULL;
+    CategoryMap map = {NULL, 0};
+    int res = 1;
+    for (int i = 0; i < count && slots == NULL && res > 0; i++)
+    {
+        if (counted(&transactions[i]))
+        {
+            res = load_names(year, month, &slots, &map);
+        }
+    }
+    if (res < 0)
+    {
+        return res;
+    }
+
+    bool appending = previous_generation != 0 || first_slot != 0;
+    res = appending ? patch_add(year, month, first_slot, transactions, count, slots, &map, previous_generation, entry) : 0;
+    if (res == 0)
+    {
+        // A new category that doesn't fit, or no sidecar yet: write it out whole
+        MonthStats stats;
+        if (appending)
+        {
+            res = load_stats(year, month, first_slot, previous_generation, count, &stats);
+        }
+        else
+        {
+            memset(&stats, 0, sizeof(MonthStats));
+            stats.slots = malloc((count > 0 ? count : 1) * sizeof(CategoryStatsSlot));
+            res = stats.slots != NULL ? 1 : -2;
+        }
+        if (res == 0)
+        {
+            res = rebuild_stats(year, month, entry->generation, NULL);
+        }
+        else if (res > 0)
+        {
+            for (int i = 0; i < count && res > 0; i++)
+            {
+                res = count_slot(&stats, &stats.slots[first_slot + i], &transactions[i], name_of(slots, &map, transactions[i].cat_id));
+            }
+            stats.slot_count = entry->transaction_count;
+            if (res > 0)
+            {
+                res = save_stats(year, month, &stats, entry->generation);
+            }
+            month_stats_free(&stats);
+        }
+    }
+    for (int i = 0; i < count && res > 0; i++)
+    {
+        if (counted(&transactions[i]))
+        {
+            total_apply(name_of(slots, &map, transactions[i].cat_id), transactions[i].amt, true);
+        }
+    }
+    if (res < 0)
+    {
+        category_stats_free();
+    }
+    category_map_free(&map);
+    free(slots);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int category_stats_remove(int year, int month, int slot, int moved_slot, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    StatsPatch patch;
+    if (entry != NULL && slot >= 0 && slot <= entry->transaction_count &&
+        open_patch(year, month, entry->transaction_count + 1, previous_generation, &patch) > 0)
+    {
+        // Take the row out and move the last slot into the hole, if it wasn't the last
+        CategoryStatsSlot removed, moved;
+        int res = read_slot(&patch, slot, &removed) ? 1 : 0;
+        if (res > 0 && moved_slot >= 0)
+        {
+            res = moved_slot == entry->transaction_count && read_slot(&patch, moved_slot, &moved) ? 1 : 0;
+        }
+        if (res > 0)
+        {
+            char name[MAX_NAME_LEN];
+            slot_name(&patch.stats, &removed, name);
+            uncount_slot(&patch.stats, &removed);
+            res = finish_patch(&patch, slot, &moved, moved_slot >= 0 ? 1 : 0, entry);
+            if (res > 0 && name[0] != '\0')
+            {
+                total_apply(name, removed.amount, false);
+            }
+        }
+        else
+        {
+            close_patch(&patch);
+        }
+        if (res < 0)
+        {
+            category_stats_free();
+        }
+        if (res != 0)
+        {
+            return res;
+        }
+    }
+
+    int old_count = entry != NULL ? entry->transaction_count + 1 : 1;
+    int *new_slots = removal_slot_map(slot, moved_slot, old_count);
+    if (new_slots == NULL)
+    {
+        return -2;
+    }
+    int res = category_stats_remove_slots(year, month, new_slots, old_count, previous_generation);
+    free(new_slots);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int category_stats_remove_slots(int year, int month, const int *new_slots, int old_count, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        // Month is empty now
+        char path[MAX_BUFFER + 32];
+        sidecar_path(path, sizeof(path), year, month, "stat", "");
+        remove(path);
+        return 1;
+    }
+
+    MonthStats stats;
+    int res = load_stats(year, month, old_count, previous_generation, 0, &stats);
+    if (res < 0)
+    {
+        return res;
+    }
+    if (res == 0)
+    {
+        return rebuild_stats(year, month, entry->generation, NULL);
+    }
+    CategoryStatsSlot *slots = malloc((entry->transaction_count > 0 ? entry->transaction_count : 1) * sizeof(CategoryStatsSlot));
+    if (slots == NULL)
+    {
+        month_stats_free(&stats);
+        return -2;
+    }
+    for (int slot = 0; slot < old_count; slot++)
+    {
+        if (new_slots[slot] >= 0 && new_slots[slot] < entry->transaction_count)
+        {
+            slots[new_slots[slot]] = stats.slots[slot];
+        }
+        else
+        {
+            char name[MAX_NAME_LEN];
+            slot_name(&stats, &stats.slots[slot], name);
+            if (name[0] != '\0')
+            {
+                total_apply(name, stats.slots[slot].amount, false);
+            }
+            uncount_slot(&stats, &stats.slots[slot]);
+        }
+    }
+    free(stats.slots);
+    stats.slots = slots;
+    stats.slot_count = entry->transaction_count;
+    res = save_stats(year, month, &stats, entry->generation);
+    month_stats_free(&stats);
+    if (res < 0)
+    {
+        category_stats_free();
+    }
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int category_stats_update(int year, int month, int slot, const Transaction *transaction, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL || slot < 0 || slot >= entry->transaction_count)
+    {
+        return 1;
+    }
+
+    Category *slots = NULL;
+    CategoryMap map = {NULL, 0};
+    int res = counted(transaction) ? load_names(year, month, &slots, &map) : 1;
+    if (res < 0)
+    {
+        return res;
+    }
+    const char *name = name_of(slots, &map, transaction->cat_id);
+    char old_name[MAX_NAME_LEN] = "";
+    Money old_amount = 0;
+
+    StatsPatch patch;
+    CategoryStatsSlot record;
+    res = open_patch(year, month, entry->transaction_count, previous_generation, &patch);
+    if (res > 0 && !read_slot(&patch, slot, &record))
+    {
+        close_patch(&patch);
+        res = 0;
+    }
+    if (res > 0)
+    {
+        slot_name(&patch.stats, &record, old_name);
+        old_amount = record.amount;
+        uncount_slot(&patch.stats, &record);
+        res = count_slot(&patch.stats, &record, transaction, name);
+        if (res > 0)
+        {
+            res = finish_patch(&patch, slot, &record, 1, entry);
+        }
+        else
+        {
+            close_patch(&patch);
+        }
+    }
+    if (res == 0)
+    {
+        // A new category that doesn't fit, or nothing to patch: write it out whole
+        MonthStats stats;
+        res = load_stats(year, month, entry->transaction_count, previous_generation, 0, &stats);
+        if (res == 0)
+        {
+            res = rebuild_stats(year, month, entry->generation, NULL);
+        }
+        else if (res > 0)
+        {
+            slot_name(&stats, &stats.slots[slot], old_name);
+            old_amount = stats.slots[slot].amount;
+            uncount_slot(&stats, &stats.slots[slot]);
+            res = count_slot(&stats, &stats.slots[slot], transaction, name);
+            if (res > 0)
+            {
+                res = save_stats(year, month, &stats, entry->generation);
+            }
+            month_stats_free(&stats);
+        }
+    }
+    if (res > 0)
+    {
+        if (old_name[0] != '\0')
+        {
+            total_apply(old_name, old_amount, false);
+        }
+        if (counted(transaction))
+        {
+            total_apply(name, transaction->amt, true);
+        }
+    }
+    else if (res < 0)
+    {
+        category_stats_free();
+    }
+    category_map_free(&map);
+    free(slots);
+    return res;
+}
+
+static CategoryStats *find_total(const char *name)
+{
+    for (int i = 0; i < totals.category_count; i++)
+    {
+        if (strncmp(totals.categories[i].name, name, MAX_NAME_LEN) == 0)
+        {
+            return &totals.categories[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Merge every month's statistics by category name, unless the totals are current. A
+ * month that can't be read is left out until the next change, rather than retried on
+ * every row drawn.
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+static int refresh_totals(void)
+{
+    if (totals_loaded && totals_generation == manifest_generation())
+    {
+        return 1;
+    }
+    category_stats_free();
+    MonthStats merged = {NULL, 0, 0, NULL, 0};
+    int entry_count, res = 1;
+    const ManifestEntry *entries = manifest_entries(&entry_count);
+    for (int i = 0; i < entry_count && res != -2; i++)
+    {
+        MonthStats stats;
+        res = load_stats(entries[i].year, entries[i].month, entries[i].transaction_count, entries[i].generation, 0, &stats);
+        if (res == 0)
+        {
+            // Missing or behind the month file: count it now
+            res = rebuild_stats(entries[i].year, entries[i].month, entries[i].generation, &stats);
+        }
+        if (res < 0)
+        {
+            continue;
+        }
+        for (int j = 0; j < stats.category_count && res > 0; j++)
+        {
+            int index = find_category(&merged, stats.categories[j].name);
+            if (index < 0)
+            {
+                res = index;
+                break;
+            }
+            stats_merge(&merged.categories[index], &stats.categories[j]);
+        }
+        month_stats_free(&stats);
+    }
+    totals = merged;
+    totals_generation = manifest_generation();
+    totals_loaded = true;
+    return res < 0 ? res : 1;
+}
+
+bool category_stats_unusual(const char *category_name, const Transaction *transaction)
+{
+    if (!transaction->expense || transaction->amt <= 0)
+    {
+        return false;
+    }
+    refresh_totals();
+    CategoryStats *total = find_total(category_name);
+    if (total == NULL || total->count <= CATEGORY_STATS_MIN_COUNT)
+    {
+        return false;
+    }
+
+    // Compare with the category's other expenses only, so the row can't hide itself
+    CategoryStats others = *total;
+    stats_erase(&others, transaction->amt);
+    if (others.buckets[amount_bucket(transaction->amt)] < 0)
+    {
+        return false; // not an amount the statistics hold
+    }
+    double deviation = sqrt(others.m2 / (others.count - 1));
+    if ((double)transaction->amt <= others.mean + CATEGORY_STATS_SIGMAS * deviation)
+    {
+        return false;
+    }
+    int below = 0;
+    for (int i = 0; i < amount_bucket(transaction->amt); i++)
+    {
+        below += others.buckets[i];
+    }
+    return below >= CATEGORY_STATS_QUANTILE * others.count;
+}
+
+void category_stats_advance(void)
+{
+    // Every recorded change bumps the generation by one, so anything more means
+    // another process or the watcher changed the manifest too
+    if (totals_loaded && totals_generation + 1 == manifest_generation())
+    {
+        totals_generation = manifest_generation();
+    }
+}
+
+void category_stats_free(void)
+{
+    month_stats_free(&totals);
+    totals_loaded = false;
+}
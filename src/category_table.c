@@ -0,0 +1,266 @@
+#include "category_table.h"
+
+static int slot_capacity = 0;
+static CategoryMap category_map = {NULL, 0};
+static CategoryRollup *rollups = NULL; // indexed by slot
+
+// Larger budgets first; equal budgets keep slot order
+static bool budget_before(int a, int b)
+{
+    if (categories[a].budget != categories[b].budget)
+    {
+        return categories[a].budget > categories[b].budget;
+    }
+    return a < b;
+}
+
+static int compare_slots_by_budget(const void *a, const void *b)
+{
+    int slot_a = *(const int *)a, slot_b = *(const int *)b;
+    return slot_a == slot_b ? 0 : budget_before(slot_a, slot_b) ? -1 : 1;
+}
+
+// First position in sorted_categories_indices that slot doesn't sort after
+static int order_position(int slot)
+{
+    int left = 0, right = category_count;
+    while (left < right)
+    {
+        int mid = (left + right) / 2;
+        if (budget_before(sorted_categories_indices[mid], slot))
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    return left;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+int category_table_reserve(int slot_count)
+{
+    if (slot_count <= slot_capacity)
+    {
+        return 1;
+    }
+    int new_capacity = slot_capacity > 0 ? slot_capacity : 16;
+    while (new_capacity < slot_count)
+    {
+        new_capacity *= 2;
+    }
+    Category *grown = realloc(categories, new_capacity * sizeof(Category));
+    if (grown == NULL)
+    {
+        return -2;
+    }
+    categories = grown;
+    int *grown_order = realloc(sorted_categories_indices, new_capacity * sizeof(int));
+    if (grown_order == NULL)
+    {
+        return -2;
+    }
+    sorted_categories_indices = grown_order;
+    CategoryRollup *grown_rollups = realloc(rollups, new_capacity * sizeof(CategoryRollup));
+    if (grown_rollups == NULL)
+    {
+        return -2;
+    }
+    rollups = grown_rollups;
+    for (int i = slot_capacity; i < new_capacity; i++)
+    {
+        memset(&categories[i], 0, sizeof(Category));
+        categories[i].id = -1;
+        categories[i].parent_id = -1;
+        memset(&rollups[i], 0, sizeof(CategoryRollup));
+    }
+    slot_capacity = new_capacity;
+    return 1;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+int category_table_rebuild(int slot_count)
+{
+    category_slot_count = slot_count;
+    category_count = 0;
+    for (int slot = 0; slot < slot_count; slot++)
+    {
+        if (categories[slot].budget > 0)
+        {
+            sorted_categories_indices[category_count++] = slot;
+        }
+    }
+    qsort(sorted_categories_indices, category_count, sizeof(int), compare_slots_by_budget);
+    return category_table_refresh_ids();
+}
+
+int category_table_refresh_ids(void)
+{
+    int res = category_map_build(&category_map, &category_ids, categories, category_slot_count);
+    if (res > 0)
+    {
+        category_rollups_rebuild();
+    }
+    return res;
+}
+
+void category_rollups_rebuild(void)
+{
+    memset(rollups, 0, category_slot_count * sizeof(CategoryRollup));
+    for (int i = 0; i < category_count; i++)
+    {
+        int slot = sorted_categories_indices[i];
+        rollups[slot].budget += categories[slot].budget;
+        rollups[slot].spent += categories[slot].spent;
+        rollups[slot].extra += categories[slot].extra;
+        int parent = category_parent_slot(slot);
+        if (parent >= 0)
+        {
+            rollups[parent].budget += categories[slot].budget;
+            rollups[parent].spent += categories[slot].spent;
+            rollups[parent].extra += categories[slot].extra;
+        }
+    }
+}
+
+void category_add_spent(int slot, Money delta)
+{
+    categories[slot].spent += delta;
+    rollups[slot].spent += delta;
+    int parent = category_parent_slot(slot);
+    if (parent >= 0)
+    {
+        rollups[parent].spent += delta;
+    }
+}
+
+CategoryRollup category_figures(int slot, bool rolled_up)
+{
+    if (rolled_up)
+    {
+        return rollups[slot];
+    }
+    CategoryRollup own = {categories[slot].budget, categories[slot].spent, categories[slot].extra};
+    return own;
+}
+
+// Categories nest one level deep: a parent that was removed or has a parent itself
+// leaves its children at the top level
+int category_parent_slot(int slot)
+{
+    int parent = category_map_slot(&category_map, categories[slot].parent_id);
+    if (parent < 0 || parent == slot || categories[parent].budget <= 0 || categories[parent].parent_id >= 0)
+    {
+        return -1;
+    }
+    return parent;
+}
+
+// The top-level category a slot is shown under: its parent, or itself
+static int group_of(int slot)
+{
+    int parent = category_parent_slot(slot);
+    return parent >= 0 ? parent : slot;
+}
+
+// Groups by their rolled-up budget, largest first; a parent before its children, which
+// keep budget order
+static int compare_display_rows(const void *a, const void *b)
+{
+    int slot_a = *(const int *)a, slot_b = *(const int *)b;
+    int group_a = group_of(slot_a), group_b = group_of(slot_b);
+    if (group_a != group_b)
+    {
+        if (rollups[group_a].budget != rollups[group_b].budget)
+        {
+            return rollups[group_a].budget > rollups[group_b].budget ? -1 : 1;
+        }
+        return budget_before(group_a, group_b) ? -1 : 1;
+    }
+    if (slot_a == slot_b)
+    {
+        return 0;
+    }
+    if (slot_a == group_a || slot_b == group_b)
+    {
+        return slot_a == group_a ? -1 : 1;
+    }
+    return budget_before(slot_a, slot_b) ? -1 : 1;
+}
+
+int category_display_order(int *out_slots, bool top_level)
+{
+    int count = 0;
+    for (int i = 0; i < category_count; i++)
+    {
+        int slot = sorted_categories_indices[i];
+        if (!top_level || category_parent_slot(slot) < 0)
+        {
+            out_slots[count++] = slot;
+        }
+    }
+    qsort(out_slots, count, sizeof(int), compare_display_rows);
+    return count;
+}
+
+void category_order_insert(int slot)
+{
+    int position = order_position(slot);
+    memmove(&sorted_categories_indices[position + 1], &sorted_categories_indices[position],
+            (category_count - position) * sizeof(int));
+    sorted_categories_indices[position] = slot;
+    category_count++;
+}
+
+// Must run before the slot's budget changes, while the search can still find it
+void category_order_remove(int slot)
+{
+    int position = order_position(slot);
+    if (position >= category_count || sorted_categories_indices[position] != slot)
+    {
+        return;
+    }
+    memmove(&sorted_categories_indices[position], &sorted_categories_indices[position + 1],
+            (category_count - position - 1) * sizeof(int));
+    category_count--;
+}
+
+void category_table_free(void)
+{
+    free(categories);
+    free(sorted_categories_indices);
+    free(rollups);
+    categories = NULL;
+    sorted_categories_indices = NULL;
+    rollups = NULL;
+    slot_capacity = 0;
+    category_slot_count = 0;
+    category_count = 0;
+    category_map_free(&category_map);
+}
+
+int category_slot(int cat_id)
+{
+    return category_map_slot(&category_map, cat_id);
+}
+
+int category_id(int slot)
+{
+    return slot >= 0 && slot < category_slot_count ? categories[slot].id : -1;
+}
+
+const Category *category_of(int cat_id)
+{
+    int slot = category_slot(cat_id);
+    return slot >= 0 ? &categories[slot] : NULL;
+}
@@ -0,0 +1,1051 @@
+#include "cli.h"
+
+typedef struct
+{
+    Transaction transaction;
+    char category[MAX_NAME_LEN];
+    int year;
+    int month;
+    int line;
+    bool rejected;
+} CliRow;
+
+static const char *cli_commands[] = {"add", "rm", "set-budget", "import", "export", "query", "search", "tag", "tags", "detect-recurring"};
+
+bool is_cli_command(const char *arg)
+{
+    for (size_t i = 0; i < sizeof(cli_commands) / sizeof(cli_commands[0]); i++)
+    {
+        if (strcmp(arg, cli_commands[i]) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void print_cli_usage(const char *program_name)
+{
+    fprintf(stderr, "Commands (no terminal UI):\n");
+    fprintf(stderr, "  %s add                  Add transactions read from stdin, skipping any the\n", program_name);
+    fprintf(stderr, "                    month already holds (--allow-duplicates keeps them)\n");
+    fprintf(stderr, "  %s rm                   Remove the transactions read from stdin\n", program_name);
+    fprintf(stderr, "  %s import FILE          Add transactions from FILE (- for stdin), as add\n", program_name);
+    fprintf(stderr, "  %s export [FROM [TO]]   Write transactions for months FROM..TO (YYYY-MM)\n", program_name);
+    fprintf(stderr, "                    to stdout, defaulting to the current month\n");
+    fprintf(stderr, "  %s set-budget AMOUNT [YYYY-MM]\n", program_name);
+    fprintf(stderr, "                    Set a month's total budget\n");
+    fprintf(stderr, "  %s query [FILTERS] [--group month|category|payee]\n", program_name);
+    fprintf(stderr, "                    Count, sum and average transactions across months.\n");
+    fprintf(stderr, "                    Filters: --from DATE --to DATE (YYYY-MM or YYYY-MM-DD),\n");
+    fprintf(stderr, "                    --category NAME, --min AMOUNT, --max AMOUNT, --match TEXT,\n");
+    fprintf(stderr, "                    --expenses, --income, --tag NAME, --not-tag NAME\n");
+    fprintf(stderr, "  %s search TEXT [--limit N]\n", program_name);
+    fprintf(stderr, "                    Print transactions whose description contains TEXT,\n");
+    fprintf(stderr, "                    newest first (case-insensitive)\n");
+    fprintf(stderr, "  %s tag [--remove] NAME  Tag (or untag) the transactions read from stdin\n", program_name);
+    fprintf(stderr, "  %s tags [FROM [TO]]     Count the transactions carrying each tag in months\n", program_name);
+    fprintf(stderr, "                    FROM..TO (YYYY-MM), defaulting to every month\n");
+    fprintf(stderr, "  %s detect-recurring [FROM [TO]] [--add N]...\n", program_name);
+    fprintf(stderr, "                    Suggest subscriptions from payments that repeat weekly,\n");
+    fprintf(stderr, "                    monthly, yearly or every N days (default: every month);\n");
+    fprintf(stderr, "                    --add N adds suggestion N as a subscription\n");
+    fprintf(stderr, "  Rows are YYYY-MM-DD,amount,category,description; negative amounts are income\n");
+}
+
+static bool parse_month(const char *arg, int *year, int *month)
+{
+    char extra;
+    if (sscanf(arg, "%d-%d%c", year, month, &extra) != 2)
+    {
+        return false;
+    }
+    return *month >= 1 && *month <= 12 && *year > 0;
+}
+
+static void copy_field(char *dest, const char *src, size_t len, size_t size)
+{
+    // Trim surrounding spaces and clip to the on-disk field size
+    while (len > 0 && (*src == ' ' || *src == '\t'))
+    {
+        src++;
+        len--;
+    }
+    while (len > 0 && (src[len - 1] == ' ' || src[len - 1] == '\t'))
+    {
+        len--;
+    }
+    if (len >= size)
+    {
+        len = size - 1;
+    }
+    memcpy(dest, src, len);
+    dest[len] = '\0';
+}
+
+/*
+ * Parse one "date,amount,category,description" row
+ *
+ * Returns:
+ *   1     - Row parsed
+ *   0     - Blank, comment or header line
+ *   -1    - Malformed row (message written to error)
+ */
+static int parse_row(char *line, CliRow *row, char *error, size_t error_size)
+{
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0' || line[0] == '#' || strncasecmp(line, "date,", 5) == 0)
+    {
+        return 0;
+    }
+
+    char *fields[4];
+    fields[0] = line;
+    for (int i = 1; i < 4; i++)
+    {
+        char *comma = strchr(fields[i - 1], ',');
+        if (comma == NULL)
+        {
+            snprintf(error, error_size, "expected 4 comma-separated fields");
+            return -1;
+        }
+        *comma = '\0';
+        fields[i] = comma + 1;
+    }
+
+    memset(row, 0, sizeof(CliRow));
+    int day;
+    char extra;
+    if (sscanf(fields[0], " %d-%d-%d %c", &row->year, &row->month, &day, &extra) != 3 ||
+        row->year < 1 || row->year > 9999 || row->month < 1 || row->month > 12 || day < 1 || day > get_days_in_month(row->month, row->year))
+    {
+        snprintf(error, error_size, "invalid date \"%s\"", fields[0]);
+        return -1;
+    }
+    snprintf(row->transaction.date, sizeof(row->transaction.date), "%04u-%02u-%02u", (unsigned)row->year % 10000, (unsigned)row->month % 100, (unsigned)day % 100);
+
+    char amount_text[MONEY_FORMAT_LEN];
+    Money amount;
+    copy_field(amount_text, fields[1], strlen(fields[1]), sizeof(amount_text));
+    if (strlen(fields[1]) >= sizeof(amount_text) || !money_parse(amount_text, &amount))
+    {
+        snprintf(error, error_size, "invalid amount \"%s\"", fields[1]);
+        return -1;
+    }
+    row->transaction.expense = amount >= 0;
+    row->transaction.amt = amount >= 0 ? amount : -amount;
+
+    copy_field(row->category, fields[2], strlen(fields[2]), sizeof(row->category));
+    copy_field(row->transaction.desc, fields[3], strlen(fields[3]), sizeof(row->transaction.desc));
+    return 1;
+}
+
+/*
+ * Read every row from in, reporting malformed lines on stderr
+ *
+ * Returns:
+ *   >= 0  - Number of rejected lines
+ *   -1    - Malloc error
+ */
+static int read_rows(FILE *in, CliRow **out_rows, int *out_count)
+{
+    int capacity = 256, count = 0, rejected = 0, line_number = 0;
+    CliRow *rows = malloc(capacity * sizeof(CliRow));
+    if (rows == NULL)
+    {
+        return -1;
+    }
+
+    char line[MAX_BUFFER];
+    char error[128];
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        line_number++;
+        if (count == capacity)
+        {
+            CliRow *grown = realloc(rows, capacity * 2 * sizeof(CliRow));
+            if (grown == NULL)
+            {
+                free(rows);
+                return -1;
+            }
+            rows = grown;
+            capacity *= 2;
+        }
+        int res = parse_row(line, &rows[count], error, sizeof(error));
+        if (res < 0)
+        {
+            fprintf(stderr, "line %d: %s\n", line_number, error);
+            rejected++;
+        }
+        else if (res > 0)
+        {
+            rows[count++].line = line_number;
+        }
+    }
+    *out_rows = rows;
+    *out_count = count;
+    return rejected;
+}
+
+static int compare_rows_by_month(const void *a, const void *b)
+{
+    const CliRow *row_a = a, *row_b = b;
+    if (row_a->year != row_b->year)
+    {
+        return row_a->year - row_b->year;
+    }
+    if (row_a->month != row_b->month)
+    {
+        return row_a->month - row_b->month;
+    }
+    return row_a->line - row_b->line; // keep input order within a month
+}
+
+static int find_month_category(const Category *month_categories, int slot_count, const char *name)
+{
+    for (int j = 0; j < slot_count; j++)
+    {
+        if (month_categories[j].budget > 0 && strcmp(month_categories[j].name, name) == 0)
+        {
+            return month_categories[j].id;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Match category names against a month's categories. An empty name is uncategorized,
+ * unless apply_rules is set and a rule names a category the month has.
+ */
+static int resolve_categories(CliRow *rows, int count, const Category *month_categories, int slot_count, bool apply_rules)
+{
+    int rejected = 0;
+    for (int i = 0; i < count; i++)
+    {
+        rows[i].transaction.cat_id = -1;
+        if (rows[i].category[0] == '\0')
+        {
+            const Transaction *tx = &rows[i].transaction;
+            const char *suggested = apply_rules ? rules_suggest(tx->desc, tx->expense ? tx->amt : -tx->amt) : NULL;
+            if (suggested != NULL)
+            {
+                rows[i].transaction.cat_id = find_month_category(month_categories, slot_count, suggested);
+            }
+            continue;
+        }
+        rows[i].transaction.cat_id = find_month_category(month_categories, slot_count, rows[i].category);
+        if (rows[i].transaction.cat_id == -1)
+        {
+            fprintf(stderr, "line %d: unknown category \"%s\" for %d-%02d\n", rows[i].line, rows[i].category, rows[i].year, rows[i].month);
+            rows[i].rejected = true;
+            rejected++;
+        }
+    }
+    return rejected;
+}
+
+// Apply rows grouped by month: one batched write per month instead of one per row.
+// Rows matching a transaction the month already holds are skipped unless
+// allow_duplicates is set, so importing the same statement twice adds nothing.
+static int add_rows(FILE *in, bool allow_duplicates)
+{
+    CliRow *rows;
+    int count;
+    int rejected = read_rows(in, &rows, &count);
+    if (rejected < 0)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return CLI_EXIT_IO;
+    }
+    qsort(rows, count, sizeof(CliRow), compare_rows_by_month);
+    int skipped_rules;
+    if (rules_load(&skipped_rules) > 0 && skipped_rules > 0)
+    {
+        fprintf(stderr, "Skipped %d malformed line%s in %s\n", skipped_rules, skipped_rules == 1 ? "" : "s", RULES_FILE_NAME);
+    }
+
+    Transaction *batch = malloc((count > 0 ? count : 1) * sizeof(Transaction));
+    if (batch == NULL)
+    {
+        free(rows);
+        fprintf(stderr, "Out of memory\n");
+        return CLI_EXIT_IO;
+    }
+
+    int added = 0, months = 0, status = CLI_EXIT_OK;
+    for (int start = 0; start < count;)
+    {
+        int end = start;
+        while (end < count && rows[end].year == rows[start].year && rows[end].month == rows[start].month)
+        {
+            end++;
+        }
+
+        // A month that has never been written starts out with the default categories
+        Category *month_categories;
+        int slot_count;
+        if (read_month_categories(rows[start].year, rows[start].month, &month_categories, &slot_count, NULL) < 0)
+        {
+            fprintf(stderr, "Failed to read %d-%02d\n", rows[start].year, rows[start].month);
+            status = CLI_EXIT_IO;
+            start = end;
+            continue;
+        }
+        rejected += resolve_categories(&rows[start], end - start, month_categories, slot_count, true);
+        free(month_categories);
+
+        FingerprintSet existing = {0};
+        if (!allow_duplicates && fingerprint_set_load(rows[start].year, rows[start].month, &existing) < 0)
+        {
+            fprintf(stderr, "Failed to read %d-%02d\n", rows[start].year, rows[start].month);
+            status = CLI_EXIT_IO;
+            start = end;
+            continue;
+        }
+        int batch_count = 0;
+        for (int i = start; i < end; i++)
+        {
+            if (rows[i].rejected)
+            {
+                continue;
+            }
+            if (!allow_duplicates && fingerprint_set_take(&existing, &rows[i].transaction))
+            {
+                fprintf(stderr, "line %d: probable duplicate, skipped\n", rows[i].line);
+                rejected++;
+                continue;
+            }
+            batch[batch_count++] = rows[i].transaction;
+        }
+        fingerprint_set_free(&existing);
+        int res = add_transactions(batch, batch_count, rows[start].year, rows[start].month);
+        if (res < 0)
+        {
+            fprintf(stderr, "Failed to write %d-%02d: Error %d\n", rows[start].year, rows[start].month, res);
+            status = CLI_EXIT_IO;
+        }
+        else if (batch_count > 0)
+        {
+            added += batch_count;
+            months++;
+        }
+        start = end;
+    }
+
+    free(batch);
+    free(rows);
+    printf("Added %d transaction%s across %d month%s\n", added, added == 1 ? "" : "s", months, months == 1 ? "" : "s");
+    if (status == CLI_EXIT_OK && rejected > 0)
+    {
+        status = CLI_EXIT_REJECTED;
+    }
+    return status;
+}
+
+// Both from the loaded month; rows of a merged category still carry its old id
+static bool same_transaction(const Transaction *a, const Transaction *b)
+{
+    return a->expense == b->expense && category_slot(a->cat_id) == category_slot(b->cat_id) &&
+           a->amt == b->amt &&
+           strcmp(a->date, b->date) == 0 && strcmp(a->desc, b->desc) == 0;
+}
+
+typedef enum
+{
+    ROWS_REMOVE,
+    ROWS_TAG,
+    ROWS_UNTAG
+} RowChange;
+
+// Set or clear a tag on each of the loaded month's transactions in ids
+static int retag_transactions(const unsigned long long *ids, int count, int tag, bool set)
+{
+    int changed = 0;
+    for (int i = 0; i < count; i++)
+    {
+        TransactionNode *node = find_transaction(ids[i]);
+        if (node == NULL)
+        {
+            continue;
+        }
+        Transaction tx = node->data;
+        unsigned int tags = set ? tx.tags | 1U << tag : tx.tags & ~(1U << tag);
+        if (tags == tx.tags)
+        {
+            continue;
+        }
+        tx.tags = tags;
+        int res = update_transaction(&tx);
+        if (res < 0)
+        {
+            return res;
+        }
+        changed++;
+    }
+    return changed;
+}
+
+// Remove or (un)tag one stored transaction per row, matching every field
+static int change_rows(FILE *in, RowChange change, int tag)
+{
+    CliRow *rows;
+    int count;
+    int rejected = read_rows(in, &rows, &count);
+    if (rejected < 0)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return CLI_EXIT_IO;
+    }
+    qsort(rows, count, sizeof(CliRow), compare_rows_by_month);
+
+    int changed = 0, status = CLI_EXIT_OK;
+    for (int start = 0; start < count;)
+    {
+        int end = start;
+        while (end < count && rows[end].year == rows[start].year && rows[end].month == rows[start].month)
+        {
+            end++;
+        }
+
+        // Only months that exist can hold the rows
+        Transaction *stored;
+        int stored_count;
+        if (read_month_transactions(rows[start].year, rows[start].month, &stored, &stored_count) <= 0 || stored_count == 0)
+        {
+            for (int i = start; i < end; i++)
+            {
+                fprintf(stderr, "line %d: no matching transaction\n", rows[i].line);
+            }
+            rejected += end - start;
+            start = end;
+            continue;
+        }
+        free(stored);
+
+        current_year = rows[start].year;
+        current_month = rows[start].month;
+        int res = load_month(current_year, current_month);
+        if (res < 0)
+        {
+            fprintf(stderr, "Failed to load %d-%02d: Error %d\n", current_year, current_month, res);
+            status = CLI_EXIT_IO;
+            start = end;
+            continue;
+        }
+        rejected += resolve_categories(&rows[start], end - start, categories, category_slot_count, false);
+
+        // Match every row first, then remove the month's matches in one write
+        unsigned long long *ids = malloc((end - start) * sizeof(unsigned long long));
+        bool *claimed = calloc(current_month_transaction_count > 0 ? current_month_transaction_count : 1, sizeof(bool));
+        if (ids == NULL || claimed == NULL)
+        {
+            free(ids);
+            free(claimed);
+            free(rows);
+            fprintf(stderr, "Out of memory\n");
+            return CLI_EXIT_IO;
+        }
+        int id_count = 0;
+        for (int i = start; i < end; i++)
+        {
+            if (rows[i].rejected)
+            {
+                continue;
+            }
+            // Only the rows stored under the same date can match
+            Transaction probe = rows[i].transaction;
+            probe.id = ULLONG_MAX;
+            TransactionNode *match = NULL;
+            for (int row = order_index_lower_bound(&sorted_transactions, &probe);; row++)
+            {
+                TransactionNode *node = order_index_at(&sorted_transactions, row);
+                if (node == NULL || strcmp(node->data.date, probe.date) != 0)
+                {
+                    break;
+                }
+                if (!claimed[node->index] && same_transaction(&node->data, &rows[i].transaction))
+                {
+                    match = node;
+                    break;
+                }
+            }
+            if (match == NULL)
+            {
+                fprintf(stderr, "line %d: no matching transaction\n", rows[i].line);
+                rejected++;
+                continue;
+            }
+            claimed[match->index] = true;
+            ids[id_count++] = match->data.id;
+        }
+        free(claimed);
+
+        res = change == ROWS_REMOVE ? remove_transactions(ids, id_count)
+                                    : retag_transactions(ids, id_count, tag, change == ROWS_TAG);
+        free(ids);
+        if (res < 0)
+        {
+            fprintf(stderr, "Failed to %s transactions in %d-%02d: Error %d\n", change == ROWS_REMOVE ? "remove" : "tag",
+                    current_year, current_month, res);
+            status = CLI_EXIT_IO;
+        }
+        else
+        {
+            changed += res;
+        }
+        start = end;
+    }
+
+    free(rows);
+    printf("%s %d transaction%s\n", change == ROWS_REMOVE ? "Removed" : change == ROWS_TAG ? "Tagged" : "Untagged",
+           changed, changed == 1 ? "" : "s");
+    if (status == CLI_EXIT_OK && rejected > 0)
+    {
+        status = CLI_EXIT_REJECTED;
+    }
+    return status;
+}
+
+static int compare_transactions_by_date_asc(const void *a, const void *b)
+{
+    return strcmp(((const Transaction *)a)->date, ((const Transaction *)b)->date);
+}
+
+static int export_months(int from_year, int from_month, int to_year, int to_month)
+{
+    printf("date,amount,category,description\n");
+    int year = from_year, month = from_month;
+    while (year < to_year || (year == to_year && month <= to_month))
+    {
+        Transaction *transactions;
+        int tx_count;
+        int res = read_month_transactions(year, month, &transactions, &tx_count);
+        if (res < 0)
+        {
+            fprintf(stderr, "Failed to read %d-%02d: Error %d\n", year, month, res);
+            return CLI_EXIT_IO;
+        }
+        if (tx_count > 0)
+        {
+            Category *month_categories;
+            CategoryIds month_ids;
+            CategoryMap map = {NULL, 0};
+            int slot_count;
+            if (read_month_categories(year, month, &month_categories, &slot_count, &month_ids) < 0 ||
+                category_map_build(&map, &month_ids, month_categories, slot_count) < 0)
+            {
+                fprintf(stderr, "Failed to read %d-%02d categories\n", year, month);
+                free(transactions);
+                return CLI_EXIT_IO;
+            }
+            qsort(transactions, tx_count, sizeof(Transaction), compare_transactions_by_date_asc);
+            for (int i = 0; i < tx_count; i++)
+            {
+                Transaction *tx = &transactions[i];
+                int slot = category_map_slot(&map, tx->cat_id);
+                const char *category = slot >= 0 ? month_categories[slot].name : "";
+                printf("%s,%s,%s,%s\n", tx->date, money_str(tx->expense ? tx->amt : -tx->amt), category, tx->desc);
+            }
+            category_map_free(&map);
+            free(month_categories);
+        }
+        free(transactions);
+
+        if (++month > 12)
+        {
+            month = 1;
+            year++;
+        }
+    }
+    return CLI_EXIT_OK;
+}
+
+static int set_month_budget(Money budget, int year, int month)
+{
+    current_year = year;
+    current_month = month;
+    int res = load_month(year, month);
+    if (res < 0)
+    {
+        fprintf(stderr, "Failed to load %d-%02d: Error %d\n", year, month, res);
+        return CLI_EXIT_IO;
+    }
+    current_month_total_budget = budget;
+    if (set_budget(budget, year, month) != 1)
+    {
+        fprintf(stderr, "Failed to set budget for %d-%02d\n", year, month);
+        return CLI_EXIT_IO;
+    }
+    printf("Budget for %s %d set to $%s\n", month_names[month], year, money_str(budget));
+    return CLI_EXIT_OK;
+}
+
+// Accept YYYY-MM-DD, or YYYY-MM meaning the first (or last) day of the month
+static bool parse_query_date(const char *arg, char *date, bool end_of_month)
+{
+    int year, month, day;
+    char extra;
+    if (sscanf(arg, "%d-%d-%d%c", &year, &month, &day, &extra) != 3)
+    {
+        if (!parse_month(arg, &year, &month))
+        {
+            return false;
+        }
+        day = end_of_month ? 31 : 1;
+    }
+    if (year < 1 || year > 9999 || month < 1 || month > 12 || day < 1 || day > 31)
+    {
+        return false;
+    }
+    snprintf(date, 11, "%04u-%02u-%02u", (unsigned)year, (unsigned)month, (unsigned)day);
+    return true;
+}
+
+
+// Nearest cent, halves away from zero
+static Money average(Money sum, int count)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    Money half = (sum >= 0 ? count : -count) / 2;
+    return (sum + half) / count;
+}
+
+static int query_command(int argc, char *argv[])
+{
+    Query query = {0};
+    query.kind = QUERY_ALL;
+    query.group_by = QUERY_GROUP_NONE;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool ok = true;
+        if (strcmp(option, "--expenses") == 0)
+        {
+            query.kind = QUERY_EXPENSES;
+            continue;
+        }
+        if (strcmp(option, "--income") == 0)
+        {
+            query.kind = QUERY_INCOME;
+            continue;
+        }
+        if (value == NULL)
+        {
+            ok = false;
+        }
+        else if (strcmp(option, "--from") == 0)
+        {
+            ok = parse_query_date(value, query.from_date, false);
+        }
+        else if (strcmp(option, "--to") == 0)
+        {
+            ok = parse_query_date(value, query.to_date, true);
+        }
+        else if (strcmp(option, "--category") == 0)
+        {
+            query.has_category = true;
+            copy_field(query.category, value, strlen(value), sizeof(query.category));
+        }
+        else if (strcmp(option, "--min") == 0)
+        {
+            query.has_min_amount = ok = money_parse(value, &query.min_amount);
+        }
+        else if (strcmp(option, "--max") == 0)
+        {
+            query.has_max_amount = ok = money_parse(value, &query.max_amount);
+        }
+        else if (strcmp(option, "--match") == 0)
+        {
+            copy_field(query.match, value, strlen(value), sizeof(query.match));
+        }
+        else if (strcmp(option, "--tag") == 0 || strcmp(option, "--not-tag") == 0)
+        {
+            int tag = tag_find(value);
+            if (tag < 0)
+            {
+                fprintf(stderr, "Unknown tag: %s\n", value);
+                return CLI_EXIT_USAGE;
+            }
+            if (option[2] == 't')
+                query.all_tags |= 1U << tag;
+            else
+                query.no_tags |= 1U << tag;
+        }
+        else if (strcmp(option, "--group") == 0)
+        {
+            if (strcmp(value, "month") == 0)
+                query.group_by = QUERY_GROUP_MONTH;
+            else if (strcmp(value, "category") == 0)
+                query.group_by = QUERY_GROUP_CATEGORY;
+            else if (strcmp(value, "payee") == 0)
+                query.group_by = QUERY_GROUP_PAYEE;
+            else
+                ok = false;
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "Invalid query option: %s%s%s\n", option, value ? " " : "", value ? value : "");
+            return CLI_EXIT_USAGE;
+        }
+        i++;
+    }
+
+    QueryResult result;
+    int res = run_query(&query, &result);
+    if (res < 0)
+    {
+        fprintf(stderr, "Query failed: Error %d\n", res);
+        return CLI_EXIT_IO;
+    }
+
+    int total_count = 0;
+    Money total_sum = 0;
+    printf("%-32s %8s %12s %12s\n", query.group_by == QUERY_GROUP_NONE ? "" : "group", "count", "sum", "avg");
+    for (int i = 0; i < result.group_count; i++)
+    {
+        QueryGroup *group = &result.groups[i];
+        total_count += group->count;
+        total_sum += group->sum;
+        if (query.group_by != QUERY_GROUP_NONE)
+        {
+            printf("%-32s %8d %12s %12s\n", group->key, group->count, money_str(group->sum), money_str(average(group->sum, group->count)));
+        }
+    }
+    printf("%-32s %8d %12s %12s\n", "total", total_count, money_str(total_sum), money_str(average(total_sum, total_count)));
+    fprintf(stderr, "%d month%s scanned\n", result.months_scanned, result.months_scanned == 1 ? "" : "s");
+    free_query_result(&result);
+    return CLI_EXIT_OK;
+}
+
+static int search_command(int argc, char *argv[])
+{
+    const char *text = NULL;
+    long limit = -1;
+    for (int i = 1; i < argc; i++)
+    {
+        char *end;
+        if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc)
+        {
+            limit = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || limit < 0)
+            {
+                text = NULL;
+                break;
+            }
+        }
+        else if (text == NULL)
+        {
+            text = argv[i];
+        }
+        else
+        {
+            text = NULL;
+            break;
+        }
+    }
+    if (text == NULL || text[0] == '\0')
+    {
+        fprintf(stderr, "Usage: tbudget search TEXT [--limit N]\n");
+        return CLI_EXIT_USAGE;
+    }
+
+    SearchHit *hits;
+    int hit_count;
+    int res = search_transactions(text, &hits, &hit_count);
+    if (res < 0)
+    {
+        fprintf(stderr, "Search failed: Error %d\n", res);
+        return CLI_EXIT_IO;
+    }
+    printf("date,amount,category,description\n");
+    for (int i = 0; i < hit_count && (limit < 0 || i < limit); i++)
+    {
+        Transaction *tx = &hits[i].transaction;
+        printf("%s,%s,%s,%s\n", tx->date, money_str(tx->expense ? tx->amt : -tx->amt), hits[i].category, tx->desc);
+    }
+    free(hits);
+    return CLI_EXIT_OK;
+}
+
+static int tag_command(int argc, char *argv[])
+{
+    bool untag = argc == 3 && strcmp(argv[1], "--remove") == 0;
+    if (argc != 2 && !untag)
+    {
+        fprintf(stderr, "Usage: tbudget tag [--remove] NAME (rows on stdin)\n");
+        return CLI_EXIT_USAGE;
+    }
+    const char *name = argv[argc - 1];
+    int tag = untag ? tag_find(name) : tag_create(name);
+    if (tag < 0)
+    {
+        if (tag == -2)
+            fprintf(stderr, "No room for another tag (at most %d)\n", MAX_TAGS);
+        else if (tag == -1 && !untag)
+            fprintf(stderr, "Failed to save tag %s\n", name);
+        else
+            fprintf(stderr, "%s tag: %s\n", untag ? "Unknown" : "Invalid", name);
+        return tag == -1 && !untag ? CLI_EXIT_IO : CLI_EXIT_USAGE;
+    }
+    return change_rows(stdin, untag ? ROWS_UNTAG : ROWS_TAG, tag);
+}
+
+// Each tag's count over a range of months, from the months' tag bitmaps alone
+static int tags_command(int argc, char *argv[])
+{
+    int from_year = 1, from_month = 1, to_year = 9999, to_month = 12;
+    if (argc > 3 || (argc >= 2 && !parse_month(argv[1], &from_year, &from_month)) ||
+        (argc == 3 && !parse_month(argv[2], &to_year, &to_month)))
+    {
+        fprintf(stderr, "Usage: tbudget tags [YYYY-MM [YYYY-MM]]\n");
+        return CLI_EXIT_USAGE;
+    }
+    if (argc == 2)
+    {
+        to_year = from_year;
+        to_month = from_month;
+    }
+
+    int counts[MAX_TAGS] = {0};
+    int entry_count;
+    const ManifestEntry *entries = manifest_entries(&entry_count);
+    for (int i = 0; i < entry_count; i++)
+    {
+        int year = entries[i].year, month = entries[i].month;
+        if (year < from_year || (year == from_year && month < from_month) ||
+            year > to_year || (year == to_year && month > to_month))
+        {
+            continue;
+        }
+        int res = tag_index_count(&entries[i], counts);
+        if (res < 0)
+        {
+            fprintf(stderr, "Failed to read %d-%02d tags: Error %d\n", year, month, res);
+            return CLI_EXIT_IO;
+        }
+    }
+    for (int tag = 0; tag < tag_count; tag++)
+    {
+        printf("%-32s %8d\n", tag_names[tag], counts[tag]);
+    }
+    return CLI_EXIT_OK;
+}
+
+static const char *period_name(const Subscription *sub, char *buf, size_t size)
+{
+    static const char *weekdays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    switch (sub->period_type)
+    {
+    case PERIOD_WEEKLY:
+        snprintf(buf, size, "weekly (%s)", weekdays[sub->period_day % 7]);
+        break;
+    case PERIOD_MONTHLY:
+        snprintf(buf, size, "monthly (day %d)", sub->period_day);
+        break;
+    case PERIOD_YEARLY:
+        snprintf(buf, size, "yearly (%02d-%02d)", sub->period_day, sub->period_month_day);
+        break;
+    default:
+        snprintf(buf, size, "every %d days", sub->period_day);
+        break;
+    }
+    return buf;
+}
+
+static int detect_recurring_command(int argc, char *argv[])
+{
+    int from_year = 1, from_month = 1, to_year = 9999, to_month = 12;
+    int months_given = 0;
+    int *to_add = malloc((argc > 0 ? argc : 1) * sizeof(int));
+    int add_count = 0;
+    bool ok = to_add != NULL;
+    for (int i = 1; i < argc && ok; i++)
+    {
+        char *end;
+        if (strcmp(argv[i], "--add") == 0 && i + 1 < argc)
+        {
+            long number = strtol(argv[++i], &end, 10);
+            ok = *end == '\0' && number >= 1 && number <= INT_MAX;
+            to_add[add_count++] = (int)number;
+        }
+        else if (months_given == 0)
+        {
+            ok = parse_month(argv[i], &from_year, &from_month);
+            to_year = from_year;
+            to_month = from_month;
+            months_given++;
+        }
+        else if (months_given == 1)
+        {
+            ok = parse_month(argv[i], &to_year, &to_month);
+            months_given++;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+    if (!ok)
+    {
+        free(to_add);
+        fprintf(stderr, "Usage: tbudget detect-recurring [YYYY-MM [YYYY-MM]] [--add N]...\n");
+        return CLI_EXIT_USAGE;
+    }
+
+    RecurringSuggestion *suggestions;
+    int count;
+    int res = detect_recurring(from_year * 12 + from_month - 1, to_year * 12 + to_month - 1, &suggestions, &count);
+    if (res < 0)
+    {
+        free(to_add);
+        fprintf(stderr, "Failed to scan transactions: Error %d\n", res);
+        return CLI_EXIT_IO;
+    }
+
+    int status = CLI_EXIT_OK;
+    if (add_count == 0)
+    {
+        printf("%3s %-32s %10s %-20s %5s %-10s %-10s %s\n", "#", "name", "amount", "period", "seen", "first", "last", "category");
+        for (int i = 0; i < count; i++)
+        {
+            const Subscription *sub = &suggestions[i].subscription;
+            char period[32];
+            printf("%3d %-32s %10s %-20s %5d %-10s %-10s %s\n", i + 1, sub->name, money_str(sub->expense ? sub->amount : -sub->amount),
+                   period_name(sub, period, sizeof(period)), suggestions[i].occurrences, suggestions[i].first_date, sub->start_date,
+                   sub->cat_name);
+        }
+    }
+    for (int i = 0; i < add_count; i++)
+    {
+        if (to_add[i] > count)
+        {
+            fprintf(stderr, "No suggestion %d\n", to_add[i]);
+            status = CLI_EXIT_REJECTED;
+            continue;
+        }
+        Subscription *sub = &suggestions[to_add[i] - 1].subscription;
+        if (add_subscription(sub) < 0)
+        {
+            fprintf(stderr, "Failed to add subscription %s\n", sub->name);
+            status = CLI_EXIT_IO;
+            break;
+        }
+        printf("Added subscription %s\n", sub->name);
+    }
+    free(to_add);
+    free(suggestions);
+    return status;
+}
+
+int run_cli_command(int argc, char *argv[])
+{
+    const char *command = argv[0];
+
+    // add and import take --allow-duplicates after the command name
+    bool allow_duplicates = argc > 1 && strcmp(argv[1], "--allow-duplicates") == 0 &&
+                            (strcmp(command, "add") == 0 || strcmp(command, "import") == 0);
+    if (allow_duplicates)
+    {
+        argv++;
+        argc--;
+    }
+
+    if (strcmp(command, "add") == 0 || strcmp(command, "rm") == 0)
+    {
+        if (argc != 1)
+        {
+            fprintf(stderr, "%s takes its rows on stdin\n", command);
+            return CLI_EXIT_USAGE;
+        }
+        return command[0] == 'a' ? add_rows(stdin, allow_duplicates) : change_rows(stdin, ROWS_REMOVE, -1);
+    }
+
+    if (strcmp(command, "import") == 0)
+    {
+        if (argc != 2)
+        {
+            fprintf(stderr, "Usage: tbudget import [--allow-duplicates] FILE\n");
+            return CLI_EXIT_USAGE;
+        }
+        if (strcmp(argv[1], "-") == 0)
+        {
+            return add_rows(stdin, allow_duplicates);
+        }
+        FILE *in = fopen(argv[1], "r");
+        if (in == NULL)
+        {
+            fprintf(stderr, "Cannot open %s\n", argv[1]);
+            return CLI_EXIT_IO;
+        }
+        int status = add_rows(in, allow_duplicates);
+        fclose(in);
+        return status;
+    }
+
+    if (strcmp(command, "export") == 0)
+    {
+        int from_year = today_year, from_month = today_month;
+        if (argc > 3 || (argc >= 2 && !parse_month(argv[1], &from_year, &from_month)))
+        {
+            fprintf(stderr, "Usage: tbudget export [YYYY-MM [YYYY-MM]]\n");
+            return CLI_EXIT_USAGE;
+        }
+        int to_year = from_year, to_month = from_month;
+        if (argc == 3 && !parse_month(argv[2], &to_year, &to_month))
+        {
+            fprintf(stderr, "Usage: tbudget export [YYYY-MM [YYYY-MM]]\n");
+            return CLI_EXIT_USAGE;
+        }
+        return export_months(from_year, from_month, to_year, to_month);
+    }
+
+    if (strcmp(command, "query") == 0)
+    {
+        return query_command(argc, argv);
+    }
+
+    if (strcmp(command, "search") == 0)
+    {
+        return search_command(argc, argv);
+    }
+
+    if (strcmp(command, "tag") == 0)
+    {
+        return tag_command(argc, argv);
+    }
+
+    if (strcmp(command, "tags") == 0)
+    {
+        return tags_command(argc, argv);
+    }
+
+    if (strcmp(command, "detect-recurring") == 0)
+    {
+        return detect_recurring_command(argc, argv);
+    }
+
+    if (strcmp(command, "set-budget") == 0)
+    {
+        Money budget = -1;
+        int year = today_year, month = today_month;
+        if (argc < 2 || argc > 3 || !money_parse(argv[1], &budget) || budget < 0 ||
+            (argc == 3 && !parse_month(argv[2], &year, &month)))
+        {
+            fprintf(stderr, "Usage: tbudget set-budget AMOUNT [YYYY-MM]\n");
+            return CLI_EXIT_USAGE;
+        }
+        return set_month_budget(budget, year, month);
+    }
+
+    return CLI_EXIT_USAGE;
+}
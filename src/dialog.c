@@ -0,0 +1,196 @@
+#include "dialog.h"
+
+static void dialog_position(int height, int width, int *start_y, int *start_x)
+{
+    int max_y, max_x;
+    getmaxyx(stdscr, max_y, max_x);
+    *start_y = (max_y - height) / 2;
+    *start_x = (max_x - width) / 2;
+}
+
+static void free_menu_items(Dialog *dialog)
+{
+    if (dialog->menu_items == NULL)
+    {
+        return;
+    }
+    for (int i = 0; i < dialog->menu_item_count; i++)
+    {
+        free(dialog->menu_items[i]);
+    }
+    free(dialog->menu_items);
+    free(dialog->menu_values);
+    dialog->menu_items = NULL;
+    dialog->menu_values = NULL;
+    dialog->menu_item_count = 0;
+}
+
+Dialog *dialog_open(const char *title, int height, int width, DialogAdvance advance, size_t ctx_size)
+{
+    Dialog *dialog = calloc(1, sizeof(Dialog));
+    if (dialog == NULL)
+    {
+        return NULL;
+    }
+    if (ctx_size > 0 && (dialog->ctx = calloc(1, ctx_size)) == NULL)
+    {
+        free(dialog);
+        return NULL;
+    }
+
+    int start_y, start_x;
+    dialog_position(height, width, &start_y, &start_x);
+    dialog->frame = draw_bounded_with_title(height, width, start_y, start_x, title, false, ALIGN_CENTER);
+    dialog->height = height;
+    dialog->width = width;
+    dialog->advance = advance;
+    dialog->field = FIELD_NONE;
+    return dialog;
+}
+
+void dialog_free(Dialog *dialog)
+{
+    if (dialog == NULL)
+    {
+        return;
+    }
+    // A picker that never finished still owns its filter state
+    if (dialog->field == FIELD_MENU)
+    {
+        menu_field_end(&dialog->field_state.menu);
+    }
+    else if (dialog->field == FIELD_TRANSACTION)
+    {
+        transaction_field_end(&dialog->field_state.transaction);
+    }
+    free_menu_items(dialog);
+    free(dialog->ctx);
+    if (dialog->next != NULL)
+    {
+        dialog_free(dialog->next);
+    }
+    delete_bounded(dialog->frame);
+    curs_set(0);
+    free(dialog);
+}
+
+DialogStatus dialog_handle_key(Dialog *dialog, int ch)
+{
+    WidgetStatus status = WIDGET_ACTIVE;
+    switch (dialog->field)
+    {
+    case FIELD_NONE:
+    case FIELD_MESSAGE:
+        return DIALOG_CLOSED;
+    case FIELD_INPUT:
+        status = input_field_feed(&dialog->field_state.input, ch);
+        break;
+    case FIELD_MENU:
+        status = menu_field_feed(&dialog->field_state.menu, ch);
+        break;
+    case FIELD_CONFIRM:
+        status = confirm_field_feed(&dialog->field_state.confirm, ch);
+        break;
+    case FIELD_DATE:
+        status = date_field_feed(&dialog->field_state.date, ch);
+        break;
+    case FIELD_TRANSACTION:
+        status = transaction_field_feed(&dialog->field_state.transaction, ch);
+        break;
+    }
+    if (status == WIDGET_ACTIVE)
+    {
+        return DIALOG_OPEN;
+    }
+
+    // The advance callback has to start another field for the dialog to stay open
+    dialog->field = FIELD_NONE;
+    DialogStatus result = dialog->advance(dialog, status);
+    if (dialog->field == FIELD_NONE)
+    {
+        result = DIALOG_CLOSED;
+    }
+    return result;
+}
+
+void dialog_relayout(Dialog *dialog)
+{
+    int start_y, start_x;
+    dialog_position(dialog->height, dialog->width, &start_y, &start_x);
+    if (start_y < 2 || start_x < 2)
+    {
+        return; // terminal is smaller than the dialog; leave it where it was
+    }
+    mvwin(dialog->frame.boundary, start_y - 2, start_x - 2);
+    mvwin(dialog->frame.textbox, start_y, start_x);
+}
+
+void dialog_noutrefresh(Dialog *dialog)
+{
+    // The dashboard may have been repainted underneath since the last key
+    touchwin(dialog->frame.boundary);
+    wnoutrefresh(dialog->frame.boundary);
+    touchwin(dialog->frame.textbox);
+    wnoutrefresh(dialog->frame.textbox);
+}
+
+void dialog_input(Dialog *dialog, int step, const char *prompt, int max_len, InputType type)
+{
+    dialog->step = step;
+    dialog->field = FIELD_INPUT;
+    input_field_begin(&dialog->field_state.input, dialog->frame.textbox, prompt, max_len, type);
+}
+
+void dialog_menu(Dialog *dialog, int step, const char *prompt, const char *items[], int item_count, int max_visible_items, int start_y, bool show_numbers)
+{
+    free_menu_items(dialog);
+    dialog->step = step;
+    dialog->field = FIELD_MENU;
+    menu_field_begin(&dialog->field_state.menu, dialog->frame.textbox, prompt, items, item_count, max_visible_items, start_y, show_numbers);
+}
+
+void dialog_owned_menu(Dialog *dialog, int step, const char *prompt, char **items, int *values, int item_count, int max_visible_items, int start_y, bool show_numbers)
+{
+    dialog_menu(dialog, step, prompt, (const char **)items, item_count, max_visible_items, start_y, show_numbers);
+    dialog->menu_items = items;
+    dialog->menu_values = values;
+    dialog->menu_item_count = item_count;
+}
+
+int dialog_menu_value(Dialog *dialog)
+{
+    int choice = menu_field_value(&dialog->field_state.menu);
+    return dialog->menu_values != NULL ? dialog->menu_values[choice] : choice;
+}
+
+void dialog_confirm(Dialog *dialog, int step, const char *message[], int item_count)
+{
+    dialog->step = step;
+    dialog->field = FIELD_CONFIRM;
+    confirm_field_begin(&dialog->field_state.confirm, dialog->frame.textbox, message, item_count);
+}
+
+void dialog_date(Dialog *dialog, int step, const char *prompt)
+{
+    dialog->step = step;
+    dialog->field = FIELD_DATE;
+    date_field_begin(&dialog->field_state.date, dialog->frame.textbox, (char *)prompt);
+}
+
+void dialog_transaction(Dialog *dialog, int step, const OrderIndex *transactions, int max_visible_items)
+{
+    dialog->step = step;
+    dialog->field = FIELD_TRANSACTION;
+    transaction_field_begin(&dialog->field_state.transaction, dialog->frame.textbox, transactions, max_visible_items);
+}
+
+DialogStatus dialog_message(Dialog *dialog, const char *message)
+{
+    WINDOW *win = dialog->frame.textbox;
+    wclear(win);
+    mvwprintw(win, 1, 0, "%s", message);
+    mvwprintw(win, 2, 0, "Press any key to continue...");
+    curs_set(0);
+    dialog->field = FIELD_MESSAGE;
+    return DIALOG_OPEN;
+}
@@ -0,0 +1,373 @@
+#include "event_loop.h"
+#include "input.h"
+#include "render.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+typedef struct
+{
+    bool active;
+    bool repeat;
+    int interval_ms;
+    long long deadline_ms;
+    EventCallback cb;
+    void *arg;
+} EventTimer;
+
+typedef struct
+{
+    int wd;
+    WatchCallback cb;
+    void *arg;
+} EventWatch;
+
+typedef struct PostedTask
+{
+    EventCallback cb;
+    void *arg;
+    struct PostedTask *next;
+} PostedTask;
+
+typedef struct
+{
+    EventCallback work;
+    EventCallback done;
+    void *arg;
+} WorkerJob;
+
+static EventTimer timers[MAX_EVENT_TIMERS];
+static EventWatch watches[MAX_EVENT_WATCHES];
+static int watch_count = 0;
+static int notify_fd = -1;
+static int wake_pipe[2] = {-1, -1};
+static bool redraw_requested = false;
+
+// Posted tasks are the only state shared with worker threads
+static pthread_mutex_t task_lock = PTHREAD_MUTEX_INITIALIZER;
+static PostedTask *task_head = NULL;
+static PostedTask *task_tail = NULL;
+
+int event_loop_init()
+{
+    memset(timers, 0, sizeof(timers));
+    watch_count = 0;
+    if (pipe(wake_pipe) != 0)
+    {
+        return -1;
+    }
+    fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+#ifdef __linux__
+    notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    return 0;
+}
+
+void event_loop_shutdown()
+{
+    if (notify_fd >= 0)
+    {
+        close(notify_fd);
+        notify_fd = -1;
+    }
+    // Workers still running post under the lock, so they never see a closed pipe
+    pthread_mutex_lock(&task_lock);
+    for (int i = 0; i < 2; i++)
+    {
+        if (wake_pipe[i] >= 0)
+        {
+            close(wake_pipe[i]);
+            wake_pipe[i] = -1;
+        }
+    }
+    while (task_head != NULL)
+    {
+        PostedTask *next = task_head->next;
+        free(task_head);
+        task_head = next;
+    }
+    task_tail = NULL;
+    pthread_mutex_unlock(&task_lock);
+}
+
+int event_loop_add_timer(int interval_ms, bool repeat, EventCallback cb, void *arg)
+{
+    for (int i = 0; i < MAX_EVENT_TIMERS; i++)
+    {
+        if (!timers[i].active)
+        {
+            timers[i] = (EventTimer){
+                .active = true,
+                .repeat = repeat,
+                .interval_ms = interval_ms,
+                .deadline_ms = monotonic_ms() + interval_ms,
+                .cb = cb,
+                .arg = arg};
+            return i;
+        }
+    }
+    return -1;
+}
+
+void event_loop_cancel_timer(int timer_id)
+{
+    if (timer_id >= 0 && timer_id < MAX_EVENT_TIMERS)
+    {
+        timers[timer_id].active = false;
+    }
+}
+
+int event_loop_watch_dir(const char *dir, WatchCallback cb, void *arg)
+{
+#ifdef __linux__
+    if (notify_fd < 0 || watch_count >= MAX_EVENT_WATCHES)
+    {
+        return -1;
+    }
+    // Only completed writes: our own cached month files stay open for the whole session
+    int wd = inotify_add_watch(notify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0)
+    {
+        return -1;
+    }
+    watches[watch_count] = (EventWatch){wd, cb, arg};
+    return watch_count++;
+#else
+    (void)dir;
+    (void)cb;
+    (void)arg;
+    return -1;
+#endif
+}
+
+void event_loop_post(EventCallback cb, void *arg)
+{
+    PostedTask *task = malloc(sizeof(PostedTask));
+    if (task == NULL)
+    {
+        return;
+    }
+    task->cb = cb;
+    task->arg = arg;
+    task->next = NULL;
+
+    pthread_mutex_lock(&task_lock);
+    if (wake_pipe[1] < 0)
+    {
+        // The loop has shut down (or never started): nobody would run it
+        pthread_mutex_unlock(&task_lock);
+        free(task);
+        return;
+    }
+    if (task_tail)
+    {
+        task_tail->next = task;
+    }
+    else
+    {
+        task_head = task;
+    }
+    task_tail = task;
+    char byte = 1;
+    ssize_t written = write(wake_pipe[1], &byte, 1); // a full pipe already means "wake up"
+    (void)written;
+    pthread_mutex_unlock(&task_lock);
+}
+
+static void *worker_main(void *arg)
+{
+    WorkerJob *job = arg;
+    job->work(job->arg);
+    if (job->done)
+    {
+        event_loop_post(job->done, job->arg);
+    }
+    free(job);
+    return NULL;
+}
+
+int event_loop_submit(EventCallback work, EventCallback done, void *arg)
+{
+    WorkerJob *job = malloc(sizeof(WorkerJob));
+    if (job == NULL)
+    {
+        return -1;
+    }
+    job->work = work;
+    job->done = done;
+    job->arg = arg;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, worker_main, job) != 0)
+    {
+        free(job);
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
+
+void event_loop_request_redraw()
+{
+    redraw_requested = true;
+}
+
+bool event_loop_take_redraw()
+{
+    bool requested = redraw_requested;
+    redraw_requested = false;
+    return requested;
+}
+
+// Milliseconds until the earliest timer fires, or -1 if none are armed
+static int next_timer_wait(long long now)
+{
+    long long earliest = -1;
+    for (int i = 0; i < MAX_EVENT_TIMERS; i++)
+    {
+        if (timers[i].active && (earliest < 0 || timers[i].deadline_ms < earliest))
+        {
+            earliest = timers[i].deadline_ms;
+        }
+    }
+    if (earliest < 0)
+    {
+        return -1;
+    }
+    return earliest <= now ? 0 : (int)(earliest - now);
+}
+
+static bool dispatch_timers(long long now)
+{
+    bool dispatched = false;
+    for (int i = 0; i < MAX_EVENT_TIMERS; i++)
+    {
+        if (!timers[i].active || timers[i].deadline_ms > now)
+        {
+            continue;
+        }
+        if (timers[i].repeat)
+        {
+            timers[i].deadline_ms = now + timers[i].interval_ms;
+        }
+        else
+        {
+            timers[i].active = false;
+        }
+        timers[i].cb(timers[i].arg);
+        dispatched = true;
+    }
+    return dispatched;
+}
+
+static bool dispatch_tasks()
+{
+    char drain[64];
+    while (read(wake_pipe[0], drain, sizeof(drain)) > 0)
+        ;
+
+    pthread_mutex_lock(&task_lock);
+    PostedTask *task = task_head;
+    task_head = task_tail = NULL;
+    pthread_mutex_unlock(&task_lock);
+
+    bool dispatched = task != NULL;
+    while (task != NULL)
+    {
+        PostedTask *next = task->next;
+        task->cb(task->arg);
+        free(task);
+        task = next;
+    }
+    return dispatched;
+}
+
+static bool dispatch_notifications()
+{
+    bool dispatched = false;
+#ifdef __linux__
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while ((len = read(notify_fd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char *ptr = buffer; ptr < buffer + len;)
+        {
+            struct inotify_event *event = (struct inotify_event *)ptr;
+            for (int i = 0; i < watch_count; i++)
+            {
+                if (watches[i].wd == event->wd && event->len > 0)
+                {
+                    watches[i].cb(event->name, watches[i].arg);
+                    dispatched = true;
+                }
+            }
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+#endif
+    return dispatched;
+}
+
+int event_loop_next_key(int timeout_ms)
+{
+    long long start = monotonic_ms();
+    while (1)
+    {
+        // Keys already buffered by curses (including ungetch) never show up on the fd
+        int ch = read_queued_key();
+        if (ch != ERR)
+        {
+            return ch;
+        }
+
+        long long now = monotonic_ms();
+        int wait = next_timer_wait(now);
+        if (timeout_ms >= 0)
+        {
+            int remaining = (int)(start + timeout_ms - now);
+            if (remaining <= 0)
+            {
+                return ERR;
+            }
+            if (wait < 0 || remaining < wait)
+            {
+                wait = remaining;
+            }
+        }
+
+        struct pollfd fds[3] = {
+            {.fd = STDIN_FILENO, .events = POLLIN},
+            {.fd = wake_pipe[0], .events = POLLIN},
+            {.fd = notify_fd, .events = POLLIN}};
+        int nfds = notify_fd >= 0 ? 3 : 2;
+        int ready = poll(fds, nfds, wait);
+        if (ready < 0 && errno != EINTR)
+        {
+            return ERR;
+        }
+
+        bool dispatched = dispatch_timers(monotonic_ms());
+        if (ready > 0 && (fds[1].revents & POLLIN))
+        {
+            dispatched = dispatch_tasks() || dispatched;
+        }
+        if (ready > 0 && nfds == 3 && (fds[2].revents & POLLIN))
+        {
+            dispatched = dispatch_notifications() || dispatched;
+        }
+        if (dispatched)
+        {
+            return ERR;
+        }
+        // Otherwise a key arrived, a signal (e.g. SIGWINCH) queued KEY_RESIZE, or the
+        // timeout ran out; the next pass sorts out which
+    }
+}
@@ -119,24 +119,23 @@ void cache_recent_months(void)
     int current_year = current_time->tm_year + 1900;
     int current_month = current_time->tm_mon + 1;
 
-    // Cache the last 10 months
-    for (int i = 0; i < 12; i++)
+    // Open the most recent months that actually exist, newest first
+    int count;
+    const ManifestEntry *entries = manifest_entries(&count);
+    int cached = 0;
+    for (int i = count - 1; i >= 0 && cached < MAX_CACHED_FILES; i--)
     {
-        int year = current_year;
-        int month = current_month - i;
-
-        // Handle year rollover
-        if (month <= 0)
+        if (entries[i].year > current_year || (entries[i].year == current_year && entries[i].month > current_month))
         {
-            month += 12;
-            year--;
+            continue;
         }
 
         char relative_file_path[MAX_BUFFER];
-        sprintf(relative_file_path, "%d-%d.dat", year, month);
-
-        // Try to load the month's data
-        open_file(relative_file_path, false);
+        sprintf(relative_file_path, "%d-%d.dat", entries[i].year, entries[i].month);
+        if (open_file(relative_file_path, false) != NULL)
+        {
+            cached++;
+        }
     }
 }
 
@@ -145,4 +144,11 @@ FILE *open_month_file(int year, int month)
     char relative_file_path[MAX_BUFFER];
     sprintf(relative_file_path, "%d-%d.dat", year, month);
     return open_file(relative_file_path, true);
-}
\ No newline at end of file
+}
+
+FILE *open_existing_month_file(int year, int month)
+{
+    char relative_file_path[MAX_BUFFER];
+    sprintf(relative_file_path, "%d-%d.dat", year, month);
+    return open_file(relative_file_path, false);
+}
@@ -0,0 +1,414 @@
+#include "fingerprint.h"
+#include "saveload.h"
+
+static unsigned long long hash_bytes(unsigned long long hash, const void *data, size_t len)
+{
+    // FNV-1a, 64-bit
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+unsigned long long transaction_fingerprint(const Transaction *transaction)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    hash = hash_bytes(hash, transaction->date, strnlen(transaction->date, sizeof(transaction->date)));
+    Money amount = transaction->expense ? transaction->amt : -transaction->amt;
+    hash = hash_bytes(hash, &amount, sizeof(amount));
+    for (size_t i = 0; i < sizeof(transaction->desc) && transaction->desc[i] != '\0'; i++)
+    {
+        unsigned char c = (unsigned char)transaction->desc[i];
+        if (isalnum(c))
+        {
+            c = tolower(c);
+            hash = hash_bytes(hash, &c, 1);
+        }
+    }
+    return hash;
+}
+
+/*
+ * Write the fingerprints through a temporary file so a reader never sees half of them
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ */
+static int save_index(int year, int month, const unsigned long long *fingerprints, int count, unsigned long long generation)
+{
+    FingerprintHeader header = {
+        .magic = FINGERPRINT_MAGIC,
+        .version = FINGERPRINT_VERSION,
+        .transaction_count = count,
+        .generation = generation};
+    char path[MAX_BUFFER + 32], tmp_path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "fp", "");
+    sidecar_path(tmp_path, sizeof(tmp_path), year, month, "fp", ".tmp");
+    FILE *file = fopen(tmp_path, "wb");
+    bool ok = file != NULL &&
+              fwrite(&header, sizeof(FingerprintHeader), 1, file) == 1 &&
+              fwrite(fingerprints, sizeof(unsigned long long), count, file) == (size_t)count;
+    if (file == NULL || fclose(file) != 0 || !ok)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return rename(tmp_path, path) == 0 ? 1 : -1;
+}
+
+/*
+ * Read a month's fingerprints
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - No sidecar, or one that doesn't match generation and transaction_count
+ *   -2    - Malloc error
+ */
+static int load_index(int year, int month, int transaction_count, unsigned long long generation, unsigned long long **out)
+{
+    char path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "fp", "");
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    FingerprintHeader header;
+    if (fread(&header, sizeof(FingerprintHeader), 1, file) != 1 ||
+        strcmp(header.magic, FINGERPRINT_MAGIC) != 0 || header.version != FINGERPRINT_VERSION ||
+        header.generation != generation || header.transaction_count != transaction_count)
+    {
+        fclose(file);
+        return 0;
+    }
+    unsigned long long *fingerprints = malloc((transaction_count > 0 ? transaction_count : 1) * sizeof(unsigned long long));
+    if (fingerprints == NULL)
+    {
+        fclose(file);
+        return -2;
+    }
+    int res = fread(fingerprints, sizeof(unsigned long long), transaction_count, file) == (size_t)transaction_count;
+    fclose(file);
+    if (res <= 0)
+    {
+        free(fingerprints);
+        return 0;
+    }
+    *out = fingerprints;
+    return 1;
+}
+
+/*
+ * Patch a sidecar that matched previous_generation with old_count slots so it matches
+ * entry: write count fingerprints from slot first onwards, or when fingerprints is
+ * NULL and count is 1 move the old last one to first, then cut the file to entry's
+ * count. The header goes last, so a torn patch leaves a stale sidecar that is rebuilt
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - No matching sidecar to patch
+ *   -1    - I/O error occurred
+ */
+static int patch_index(int year, int month, int old_count, int first, const unsigned long long *fingerprints, int count,
+                       unsigned long long previous_generation, const ManifestEntry *entry)
+{
+    char path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "fp", "");
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    FingerprintHeader header;
+    if (fread(&header, sizeof(FingerprintHeader), 1, file) != 1 ||
+        strcmp(header.magic, FINGERPRINT_MAGIC) != 0 || header.version != FINGERPRINT_VERSION ||
+        header.generation != previous_generation || header.transaction_count != old_count)
+    {
+        fclose(file);
+        return 0;
+    }
+
+    unsigned long long moved;
+    if (fingerprints == NULL && count == 1)
+    {
+        if (fseek(file, sizeof(FingerprintHeader) + (old_count - 1) * sizeof(unsigned long long), SEEK_SET) != 0 ||
+            fread(&moved, sizeof(unsigned long long), 1, file) != 1)
+        {
+            fclose(file);
+            return 0;
+        }
+        fingerprints = &moved;
+    }
+    header.transaction_count = entry->transaction_count;
+    header.generation = entry->generation;
+    bool ok = fseek(file, sizeof(FingerprintHeader) + first * sizeof(unsigned long long), SEEK_SET) == 0 &&
+              fwrite(fingerprints, sizeof(unsigned long long), count, file) == (size_t)count &&
+              fflush(file) == 0;
+    if (ok && entry->transaction_count < old_count)
+    {
+        ok = ftruncate(fileno(file), sizeof(FingerprintHeader) + entry->transaction_count * sizeof(unsigned long long)) == 0;
+    }
+    ok = ok &&
+         fseek(file, 0, SEEK_SET) == 0 &&
+         fwrite(&header, sizeof(FingerprintHeader), 1, file) == 1;
+    return fclose(file) == 0 && ok ? 1 : -1;
+}
+
+// Fingerprint every record in the month file from scratch; keeps them in *out when it
+// isn't NULL
+static int rebuild_index(int year, int month, unsigned long long generation, unsigned long long **out, int *out_count)
+{
+    Transaction *transactions;
+    int transaction_count;
+    int res = read_month_transactions(year, month, &transactions, &transaction_count);
+    if (res < 0)
+    {
+        return res;
+    }
+    unsigned long long *fingerprints = malloc((transaction_count > 0 ? transaction_count : 1) * sizeof(unsigned long long));
+    if (fingerprints == NULL)
+    {
+        free(transactions);
+        return -2;
+    }
+    for (int i = 0; i < transaction_count; i++)
+    {
+        fingerprints[i] = transaction_fingerprint(&transactions[i]);
+    }
+    free(transactions);
+    res = save_index(year, month, fingerprints, transaction_count, generation);
+    if (res > 0 && out != NULL)
+    {
+        *out = fingerprints;
+        *out_count = transaction_count;
+        return res;
+    }
+    free(fingerprints);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int fingerprint_index_add(int year, int month, int first_slot, const Transaction *transactions, int count, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        return 1;
+    }
+
+    unsigned long long *fingerprints = malloc((count > 0 ? count : 1) * sizeof(unsigned long long));
+    if (fingerprints == NULL)
+    {
+        return -2;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        fingerprints[i] = transaction_fingerprint(&transactions[i]);
+    }
+    int res = 0;
+    if ((previous_generation != 0 || first_slot != 0) && first_slot + count == entry->transaction_count)
+    {
+        res = patch_index(year, month, first_slot, first_slot, fingerprints, count, previous_generation, entry);
+    }
+    else if (first_slot == 0 && count == entry->transaction_count)
+    {
+        // First records of the month
+        res = save_index(year, month, fingerprints, count, entry->generation);
+    }
+    free(fingerprints);
+    return res != 0 ? res : rebuild_index(year, month, entry->generation, NULL, NULL);
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int fingerprint_index_remove(int year, int month, int slot, int moved_slot, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry != NULL && slot >= 0 && (moved_slot < 0 ? slot == entry->transaction_count : moved_slot == entry->transaction_count))
+    {
+        // The tail moves into the hole, or was the hole
+        int res = patch_index(year, month, entry->transaction_count + 1, slot, NULL, moved_slot < 0 ? 0 : 1,
+                              previous_generation, entry);
+        if (res != 0)
+        {
+            return res;
+        }
+    }
+
+    int old_count = entry != NULL ? entry->transaction_count + 1 : 1;
+    int *new_slots = removal_slot_map(slot, moved_slot, old_count);
+    if (new_slots == NULL)
+    {
+        return -2;
+    }
+    int res = fingerprint_index_remove_slots(year, month, new_slots, old_count, previous_generation);
+    free(new_slots);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int fingerprint_index_remove_slots(int year, int month, const int *new_slots, int old_count, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        // Month is empty now
+        char path[MAX_BUFFER + 32];
+        sidecar_path(path, sizeof(path), year, month, "fp", "");
+        remove(path);
+        return 1;
+    }
+
+    unsigned long long *old_fingerprints;
+    int res = load_index(year, month, old_count, previous_generation, &old_fingerprints);
+    if (res < 0)
+    {
+        return res;
+    }
+    if (res == 0)
+    {
+        return rebuild_index(year, month, entry->generation, NULL, NULL);
+    }
+    unsigned long long *fingerprints = malloc((entry->transaction_count > 0 ? entry->transaction_count : 1) * sizeof(unsigned long long));
+    if (fingerprints == NULL)
+    {
+        free(old_fingerprints);
+        return -2;
+    }
+    for (int slot = 0; slot < old_count; slot++)
+    {
+        if (new_slots[slot] >= 0 && new_slots[slot] < entry->transaction_count)
+        {
+            fingerprints[new_slots[slot]] = old_fingerprints[slot];
+        }
+    }
+    free(old_fingerprints);
+    res = save_index(year, month, fingerprints, entry->transaction_count, entry->generation);
+    free(fingerprints);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int fingerprint_index_update(int year, int month, int slot, const Transaction *transaction, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        return 1;
+    }
+
+    int res = 0;
+    if (slot >= 0 && slot < entry->transaction_count)
+    {
+        unsigned long long fingerprint = transaction_fingerprint(transaction);
+        res = patch_index(year, month, entry->transaction_count, slot, &fingerprint, 1, previous_generation, entry);
+    }
+    return res != 0 ? res : rebuild_index(year, month, entry->generation, NULL, NULL);
+}
+
+static int set_index(const FingerprintSet *set, unsigned long long key)
+{
+    int i = (int)(key & (unsigned long long)(set->capacity - 1));
+    while (set->counts[i] != 0 && set->keys[i] != key)
+    {
+        i = (i + 1) & (set->capacity - 1);
+    }
+    return i;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int fingerprint_set_load(int year, int month, FingerprintSet *set)
+{
+    memset(set, 0, sizeof(FingerprintSet));
+    const ManifestEntry *entry = manifest_find(year, month);
+    unsigned long long *fingerprints = NULL;
+    int count = 0, res = 1;
+    if (entry != NULL)
+    {
+        count = entry->transaction_count;
+        res = load_index(year, month, count, entry->generation, &fingerprints);
+        if (res == 0)
+        {
+            // Missing or behind the month file: fingerprint it now
+            res = rebuild_index(year, month, entry->generation, &fingerprints, &count);
+        }
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    // Power of two, at most half full
+    set->capacity = 16;
+    while (set->capacity < count * 2)
+    {
+        set->capacity *= 2;
+    }
+    set->keys = malloc(set->capacity * sizeof(unsigned long long));
+    set->counts = calloc(set->capacity, sizeof(int));
+    if (set->keys == NULL || set->counts == NULL)
+    {
+        free(fingerprints);
+        fingerprint_set_free(set);
+        return -2;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        int slot = set_index(set, fingerprints[i]);
+        set->keys[slot] = fingerprints[i];
+        set->counts[slot]++;
+    }
+    free(fingerprints);
+    return 1;
+}
+
+bool fingerprint_set_take(FingerprintSet *set, const Transaction *transaction)
+{
+    if (set->capacity == 0)
+    {
+        return false;
+    }
+    int slot = set_index(set, transaction_fingerprint(transaction));
+    if (set->counts[slot] <= 0)
+    {
+        return false;
+    }
+    // A used-up copy stays as a tombstone (-1) so probing still walks past it
+    set->counts[slot] = set->counts[slot] > 1 ? set->counts[slot] - 1 : -1;
+    return true;
+}
+
+void fingerprint_set_free(FingerprintSet *set)
+{
+    free(set->keys);
+    free(set->counts);
+    memset(set, 0, sizeof(FingerprintSet));
+}
@@ -0,0 +1,193 @@
+#include "fuzzy.h"
+
+#define SCORE_MATCH 16
+#define SCORE_CONSECUTIVE 12
+#define SCORE_WORD_START 8
+#define PENALTY_GAP 1
+
+// Letters and digits get their own bit; everything else shares the remaining ones
+static unsigned long long char_bit(char c)
+{
+    unsigned char lower = tolower((unsigned char)c);
+    if (lower >= 'a' && lower <= 'z')
+    {
+        return 1ULL << (lower - 'a');
+    }
+    if (lower >= '0' && lower <= '9')
+    {
+        return 1ULL << (26 + lower - '0');
+    }
+    return 1ULL << (36 + lower % 28);
+}
+
+static unsigned long long string_mask(const char *text)
+{
+    unsigned long long mask = 0;
+    for (; *text; text++)
+    {
+        mask |= char_bit(*text);
+    }
+    return mask;
+}
+
+static bool is_word_start(const char *text, int i)
+{
+    if (i == 0)
+    {
+        return true;
+    }
+    unsigned char prev = text[i - 1], cur = text[i];
+    return (!isalnum(prev) && isalnum(cur)) || (islower(prev) && isupper(cur));
+}
+
+int fuzzy_score(const char *candidate, const char *query, int *positions)
+{
+    int query_len = strlen(query);
+    if (query_len == 0)
+    {
+        return 0;
+    }
+
+    // Find where the leftmost match ends, then walk back from there to the latest
+    // start that still matches, which gives the tightest window
+    int q = 0, end = -1;
+    for (int i = 0; candidate[i]; i++)
+    {
+        if (tolower((unsigned char)candidate[i]) == tolower((unsigned char)query[q]) && ++q == query_len)
+        {
+            end = i;
+            break;
+        }
+    }
+    if (end < 0)
+    {
+        return -1;
+    }
+    int start = end;
+    q = query_len - 1;
+    for (int i = end; i >= 0; i--)
+    {
+        if (tolower((unsigned char)candidate[i]) == tolower((unsigned char)query[q]))
+        {
+            start = i;
+            if (--q < 0)
+            {
+                break;
+            }
+        }
+    }
+
+    int score = 0, prev = -1;
+    q = 0;
+    for (int i = start; i <= end && q < query_len; i++)
+    {
+        if (tolower((unsigned char)candidate[i]) != tolower((unsigned char)query[q]))
+        {
+            continue;
+        }
+        score += SCORE_MATCH;
+        if (is_word_start(candidate, i))
+        {
+            score += SCORE_WORD_START;
+        }
+        if (prev >= 0)
+        {
+            score += i == prev + 1 ? SCORE_CONSECUTIVE : -PENALTY_GAP * (i - prev - 1);
+        }
+        if (positions != NULL)
+        {
+            positions[q] = i;
+        }
+        prev = i;
+        q++;
+    }
+    return score;
+}
+
+int fuzzy_init(FuzzyMatcher *matcher, const char *const *candidates, int count)
+{
+    memset(matcher, 0, sizeof(FuzzyMatcher));
+    matcher->candidates = candidates;
+    matcher->count = count;
+    matcher->masks = malloc((count > 0 ? count : 1) * sizeof(unsigned long long));
+    matcher->matches = malloc((count > 0 ? count : 1) * sizeof(FuzzyMatch));
+    if (matcher->masks == NULL || matcher->matches == NULL)
+    {
+        fuzzy_free(matcher);
+        return -2;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        matcher->masks[i] = string_mask(candidates[i]);
+        matcher->matches[i].index = i;
+        matcher->matches[i].score = 0;
+    }
+    matcher->match_count = count;
+    return 1;
+}
+
+static int compare_matches(const void *a, const void *b)
+{
+    const FuzzyMatch *ma = a, *mb = b;
+    if (ma->score != mb->score)
+    {
+        return mb->score - ma->score;
+    }
+    return ma->index - mb->index;
+}
+
+void fuzzy_set_query(FuzzyMatcher *matcher, const char *query)
+{
+    if (matcher->matches == NULL)
+    {
+        return;
+    }
+    int len = strlen(query);
+    if (len >= FUZZY_MAX_QUERY)
+    {
+        len = FUZZY_MAX_QUERY - 1;
+    }
+    bool extends = len >= matcher->query_len && strncmp(query, matcher->query, matcher->query_len) == 0;
+    memcpy(matcher->query, query, len);
+    matcher->query[len] = '\0';
+    matcher->query_len = len;
+
+    if (!extends)
+    {
+        // Back to every candidate in its original order
+        for (int i = 0; i < matcher->count; i++)
+        {
+            matcher->matches[i].index = i;
+        }
+        matcher->match_count = matcher->count;
+    }
+
+    unsigned long long query_mask = string_mask(matcher->query);
+    int kept = 0;
+    for (int i = 0; i < matcher->match_count; i++)
+    {
+        int index = matcher->matches[i].index;
+        if ((matcher->masks[index] & query_mask) != query_mask)
+        {
+            continue; // missing a character outright, no need to score it
+        }
+        int score = fuzzy_score(matcher->candidates[index], matcher->query, NULL);
+        if (score >= 0)
+        {
+            matcher->matches[kept].index = index;
+            matcher->matches[kept].score = score;
+            kept++;
+        }
+    }
+    matcher->match_count = kept;
+    qsort(matcher->matches, kept, sizeof(FuzzyMatch), compare_matches);
+}
+
+void fuzzy_free(FuzzyMatcher *matcher)
+{
+    free(matcher->masks);
+    free(matcher->matches);
+    matcher->masks = NULL;
+    matcher->matches = NULL;
+    matcher->match_count = 0;
+}
@@ -1,22 +1,28 @@
 #include "globals.h"
+#include "order_index.h"
+#include "category_ids.h"
 
 // Current month data
 int category_count = 0;
-Category categories[MAX_CATEGORIES] = {0};
-int sorted_categories_indices[MAX_CATEGORIES] = {0};
-double current_month_total_budget = 0.0;
-double uncategorized_spent = 0.0;
+int category_slot_count = 0;
+Category *categories = NULL;
+int *sorted_categories_indices = NULL;
+Money current_month_total_budget = 0;
+Money uncategorized_spent = 0;
 TransactionNode *transaction_head = NULL;
 TransactionNode *transaction_tail = NULL;
 int current_month_transaction_count = 0;
-TransactionNode **sorted_transactions = NULL;
+OrderIndex sorted_transactions = {order_by_date, NULL};
+CategoryIds category_ids;
 
 // data file
 int subscription_count = 0;
 Subscription *subscriptions = 0;
 int default_category_count = 0;
-Category default_categories[MAX_CATEGORIES] = {0};
-double default_monthly_budget = 0.0;
+Category *default_categories = NULL;
+Money default_monthly_budget = 0;
+char tag_names[MAX_TAGS][MAX_NAME_LEN];
+int tag_count = 0;
 
 FlexContainer *main_layout = NULL;
 
@@ -0,0 +1,113 @@
+#include "history_filter.h"
+
+bool history_filter_active(const HistoryFilter *filter)
+{
+    return filter->editing || filter->query_len > 0;
+}
+
+// Check every row against the query
+static void rescan(HistoryFilter *filter)
+{
+    filter->match_count = 0;
+    for (int i = 0; i < filter->row_count; i++)
+    {
+        if (strstr(filter->text[i], filter->query) != NULL)
+        {
+            filter->matches[filter->match_count++] = i;
+        }
+    }
+}
+
+// A longer query can only drop rows, so only the current matches are checked
+static void narrow(HistoryFilter *filter)
+{
+    int kept = 0;
+    for (int i = 0; i < filter->match_count; i++)
+    {
+        if (strstr(filter->text[filter->matches[i]], filter->query) != NULL)
+        {
+            filter->matches[kept++] = filter->matches[i];
+        }
+    }
+    filter->match_count = kept;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+int history_filter_refresh(HistoryFilter *filter, const OrderIndex *order)
+{
+    int count = current_month_transaction_count;
+    char(*text)[HISTORY_FILTER_TEXT_LEN] = realloc(filter->text, (count > 0 ? count : 1) * sizeof(*text));
+    if (text == NULL)
+    {
+        return -2;
+    }
+    filter->text = text;
+    int *matches = realloc(filter->matches, (count > 0 ? count : 1) * sizeof(int));
+    if (matches == NULL)
+    {
+        return -2;
+    }
+    filter->matches = matches;
+
+    for (int i = 0; i < count; i++)
+    {
+        const Transaction *tx = &order_index_at(order, i)->data;
+        const Category *category = category_of(tx->cat_id);
+        const char *category_name = category != NULL ? category->name : "uncategorized";
+        int len = snprintf(filter->text[i], HISTORY_FILTER_TEXT_LEN, "%.31s %.31s", tx->desc, category_name);
+        for (int j = 0; j < len && j < HISTORY_FILTER_TEXT_LEN; j++)
+        {
+            filter->text[i][j] = tolower((unsigned char)filter->text[i][j]);
+        }
+    }
+    filter->row_count = count;
+    rescan(filter);
+    return 1;
+}
+
+int history_filter_set_query(HistoryFilter *filter, const char *query)
+{
+    char lowered[MAX_NAME_LEN];
+    int len = 0;
+    for (; query[len] && len < MAX_NAME_LEN - 1; len++)
+    {
+        lowered[len] = tolower((unsigned char)query[len]);
+    }
+    lowered[len] = '\0';
+
+    bool extends = len >= filter->query_len && strncmp(lowered, filter->query, filter->query_len) == 0;
+    memcpy(filter->query, lowered, len + 1);
+    filter->query_len = len;
+    if (filter->text == NULL)
+    {
+        return history_filter_refresh(filter, &sorted_transactions);
+    }
+    if (extends)
+    {
+        narrow(filter);
+    }
+    else
+    {
+        rescan(filter);
+    }
+    return 1;
+}
+
+void history_filter_clear(HistoryFilter *filter)
+{
+    filter->query[0] = '\0';
+    filter->query_len = 0;
+    filter->editing = false;
+    rescan(filter);
+}
+
+void history_filter_free(HistoryFilter *filter)
+{
+    free(filter->text);
+    free(filter->matches);
+    memset(filter, 0, sizeof(HistoryFilter));
+}
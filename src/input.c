@@ -0,0 +1,96 @@
+#include "input.h"
+#include <stdlib.h>
+
+bool is_vertical_motion(int ch)
+{
+    return ch == 'j' || ch == 'k' || ch == KEY_DOWN || ch == KEY_UP;
+}
+
+int motion_delta(int ch, int count)
+{
+    switch (ch)
+    {
+    case 'j':
+        return count;
+    case 'k':
+        return -count;
+    case KEY_DOWN:
+        return 1;
+    case KEY_UP:
+        return -1;
+    }
+    return 0;
+}
+
+int parse_count(const char *digits)
+{
+    long long count = strtoll(digits, NULL, 10);
+    if (count < 1)
+    {
+        return 1;
+    }
+    return count > MAX_COUNT ? MAX_COUNT : (int)count;
+}
+
+int read_queued_key()
+{
+    nodelay(stdscr, TRUE);
+    int ch = getch();
+    nodelay(stdscr, FALSE);
+    return ch;
+}
+
+int coalesce_motions(int first_ch, int count)
+{
+    long long net = motion_delta(first_ch, count);
+
+    char digits[MAX_COUNT_DIGITS + 1];
+    int digit_count = 0;
+
+    while (1)
+    {
+        int ch = read_queued_key();
+        if (ch == ERR)
+        {
+            break;
+        }
+        if (ch >= '0' && ch <= '9' && digit_count < MAX_COUNT_DIGITS)
+        {
+            digits[digit_count++] = ch;
+            continue;
+        }
+        if (is_vertical_motion(ch))
+        {
+            digits[digit_count] = '\0';
+            net += motion_delta(ch, digit_count > 0 ? parse_count(digits) : 1);
+            net = net > MAX_COUNT ? MAX_COUNT : net < -MAX_COUNT ? -MAX_COUNT : net;
+            digit_count = 0;
+            continue;
+        }
+
+        // ungetch() is last-in first-out, so push the key before the digits that preceded it
+        ungetch(ch);
+        while (digit_count > 0)
+        {
+            ungetch(digits[--digit_count]);
+        }
+        return (int)net;
+    }
+
+    while (digit_count > 0)
+    {
+        ungetch(digits[--digit_count]);
+    }
+    return (int)net;
+}
+
+bool input_pending()
+{
+    int ch = read_queued_key();
+    if (ch == ERR)
+    {
+        return false;
+    }
+    ungetch(ch);
+    return true;
+}
@@ -7,8 +7,10 @@ int main(int argc, char *argv[])
     // int mode = MODE_MENU; // Default mode
 
     initialize_data_directories();
+    migrate_month_files(); // Older month files get a header and transaction ids
     init_file_cache();     // Initialize the file cache
-    cache_recent_months(); // Cache the 10 most recent months
+    manifest_load();       // Which months exist, rebuilt from the month files if missing
+    cache_recent_months(); // Cache the most recent months
 
     time_t now = time(NULL);
     struct tm *today = localtime(&now);
@@ -30,6 +32,42 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    // Headless commands edit the data files and exit without starting ncurses
+    if (argc > 1 && is_cli_command(argv[1]))
+    {
+        res = run_cli_command(argc - 1, argv + 1);
+        if (cleanup_file_cache() < 0 && res == CLI_EXIT_OK)
+        {
+            res = CLI_EXIT_IO;
+        }
+        return res;
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--low-bandwidth") == 0 || strcmp(argv[i], "-b") == 0)
+        {
+            // Optional frame cap follows the flag
+            int fps = 0;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0]))
+            {
+                fps = atoi(argv[++i]);
+            }
+            render_set_low_bandwidth(fps);
+        }
+        else
+        {
+            fprintf(stderr, "Invalid argument: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
     // // Parse command line arguments
     // if (argc > 1)
     // {
@@ -126,6 +164,7 @@ int main(int argc, char *argv[])
 void print_usage(const char *program_name)
 {
     fprintf(stderr, "Usage: %s [OPTION]\n", program_name);
+    fprintf(stderr, "       %s COMMAND [ARGS]\n", program_name);
     fprintf(stderr, "Budget management application for graduate students.\n\n");
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "  -m, --menu        Run in menu-based mode (default)\n");
@@ -134,13 +173,261 @@ void print_usage(const char *program_name)
     fprintf(stderr, "  -i, --import      Import data from CSV file (requires filename)\n");
     fprintf(stderr, "                    Example: %s --import path/to/data.csv\n", program_name);
     fprintf(stderr, "  -l, --history     List export history files (stored in %s)\n", data_storage_dir);
+    fprintf(stderr, "  -b, --low-bandwidth [FPS]\n");
+    fprintf(stderr, "                    Cap the dashboard frame rate (default %d fps) for slow\n", DEFAULT_LOW_BANDWIDTH_FPS);
+    fprintf(stderr, "                    links and show the bytes written per frame\n");
     fprintf(stderr, "  -h, --help        Display this help and exit\n");
     fprintf(stderr, "  1                 Run in menu-based mode\n");
     fprintf(stderr, "  2                 Run in dashboard mode\n");
     fprintf(stderr, "\n");
+    print_cli_usage(program_name);
+    fprintf(stderr, "\n");
     fprintf(stderr, "Data is stored in %s\n", app_data_dir);
 }
 
+// Dialog currently taking keys, drawn on top of the dashboard
+static Dialog *active_dialog = NULL;
+
+// Another process finished writing one of our month files; reload it if it's on screen
+static void on_data_file_changed(const char *file_name, void *arg)
+{
+    (void)arg;
+    char loaded_file[MAX_BUFFER];
+    sprintf(loaded_file, "%d-%d.dat", loaded_year, loaded_month);
+    if (strcmp(file_name, loaded_file) == 0)
+    {
+        loaded_month = 0; // forces load_month on the next pass of the main loop
+        event_loop_request_redraw();
+    }
+    else if (strcmp(file_name, MANIFEST_FILE_NAME) == 0)
+    {
+        // Our own writes land here too; only a write elsewhere changes the generation on
+        // disk, which invalidates any open range view
+        if (manifest_sync() > 0)
+        {
+            event_loop_request_redraw();
+        }
+    }
+}
+
+// Transaction History over a multi-month range; rebuilt when the range or any month changes
+static HistoryRange history_range = HISTORY_MONTH;
+static RangeView history_view;
+static bool history_view_open = false;
+
+static void refresh_history_view(void)
+{
+    if (history_range == HISTORY_MONTH)
+    {
+        if (history_view_open)
+        {
+            range_view_close(&history_view);
+            history_view_open = false;
+        }
+        return;
+    }
+    char from_date[11], to_date[11];
+    history_range_dates(history_range, current_year, current_month, from_date, to_date);
+    if (history_view_open && !range_view_stale(&history_view) &&
+        strcmp(history_view.from_date, from_date) == 0 && strcmp(history_view.to_date, to_date) == 0)
+    {
+        return;
+    }
+    if (history_view_open)
+    {
+        range_view_close(&history_view);
+    }
+    history_view_open = range_view_open(&history_view, from_date, to_date) > 0;
+}
+
+// "/" filter over the loaded month's rows
+static HistoryFilter history_filter;
+
+// Column the loaded month's rows are sorted on
+static SortField history_sort = SORT_BY_DATE;
+
+// The month in history_sort order; falls back to date order if it can't be built
+static const OrderIndex *history_order(void)
+{
+    const OrderIndex *order = transaction_order(history_sort);
+    if (order == NULL)
+    {
+        history_sort = SORT_BY_DATE;
+        order = &sorted_transactions;
+    }
+    return order;
+}
+
+static int history_row_count(void)
+{
+    if (history_range == HISTORY_MONTH)
+    {
+        return history_filter_active(&history_filter) ? history_filter.match_count : current_month_transaction_count;
+    }
+    return history_view_open ? history_view.total_count : 0;
+}
+
+// Ids of the loaded month's rows marked with Space, kept sorted for lookup
+static unsigned long long *marked_ids = NULL;
+static int marked_count = 0;
+static int marked_capacity = 0;
+
+// Index of id in marked_ids, or where it would be inserted (as -index - 1)
+static int find_mark(unsigned long long id)
+{
+    int left = 0, right = marked_count - 1;
+    while (left <= right)
+    {
+        int mid = (left + right) / 2;
+        if (marked_ids[mid] == id)
+        {
+            return mid;
+        }
+        if (marked_ids[mid] < id)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid - 1;
+        }
+    }
+    return -left - 1;
+}
+
+static bool is_marked(unsigned long long id)
+{
+    return find_mark(id) >= 0;
+}
+
+static void set_mark(unsigned long long id, bool mark)
+{
+    int index = find_mark(id);
+    if (mark && index < 0)
+    {
+        if (marked_count == marked_capacity)
+        {
+            int capacity = marked_capacity > 0 ? marked_capacity * 2 : 64;
+            unsigned long long *grown = realloc(marked_ids, capacity * sizeof(unsigned long long));
+            if (grown == NULL)
+            {
+                return;
+            }
+            marked_ids = grown;
+            marked_capacity = capacity;
+        }
+        index = -index - 1;
+        memmove(&marked_ids[index + 1], &marked_ids[index], (marked_count - index) * sizeof(unsigned long long));
+        marked_ids[index] = id;
+        marked_count++;
+    }
+    else if (!mark && index >= 0)
+    {
+        memmove(&marked_ids[index], &marked_ids[index + 1], (marked_count - index - 1) * sizeof(unsigned long long));
+        marked_count--;
+    }
+}
+
+// Forget marks on rows that are no longer in the loaded month
+static void prune_marks(void)
+{
+    int kept = 0;
+    for (int i = 0; i < marked_count; i++)
+    {
+        if (find_transaction(marked_ids[i]) != NULL)
+        {
+            marked_ids[kept++] = marked_ids[i];
+        }
+    }
+    marked_count = kept;
+}
+
+// Copy of the transaction shown at a history row; false if there is none
+static bool history_transaction_at(int row, Transaction *out)
+{
+    if (row < 0 || row >= history_row_count())
+    {
+        return false;
+    }
+    if (history_range != HISTORY_MONTH)
+    {
+        RangeRow range_row;
+        if (!history_view_open || range_view_window(&history_view, row, 1, &range_row) != 1)
+        {
+            return false;
+        }
+        *out = *range_row.transaction;
+        return true;
+    }
+    int index = history_filter_active(&history_filter) ? history_filter.matches[row] : row;
+    *out = order_index_at(history_order(), index)->data;
+    return true;
+}
+
+// Catch subscriptions up when the date rolls over while the dashboard is open
+static void on_clock_tick(void *arg)
+{
+    (void)arg;
+    time_t now = time(NULL);
+    struct tm *today = localtime(&now);
+    static int last_day = -1;
+    if (last_day == -1)
+    {
+        last_day = today->tm_mday;
+        return;
+    }
+    // An open dialog may be holding on to the month's transactions; retry next tick
+    if (today->tm_mday == last_day || active_dialog != NULL)
+    {
+        return;
+    }
+    last_day = today->tm_mday;
+    today_month = today->tm_mon + 1;
+    today_year = today->tm_year + 1900;
+    active_dialog = update_subscriptions_dialog();
+    loaded_month = 0;
+    event_loop_request_redraw();
+}
+
+// Read a month file on a worker so paging back to it is served from the OS cache
+static void prefetch_month_file(void *arg)
+{
+    char *path = arg;
+    FILE *file = fopen(path, "rb");
+    if (file != NULL)
+    {
+        char buffer[8192];
+        while (fread(buffer, 1, sizeof(buffer), file) == sizeof(buffer))
+            ;
+        fclose(file);
+    }
+}
+
+static void free_prefetch_path(void *arg)
+{
+    free(arg);
+}
+
+static void prefetch_previous_month(int year, int month)
+{
+    if (--month < 1)
+    {
+        month = 12;
+        year--;
+    }
+    size_t path_size = MAX_BUFFER + 32;
+    char *path = malloc(path_size);
+    if (path == NULL)
+    {
+        return;
+    }
+    snprintf(path, path_size, "%s/%d-%d.dat", data_storage_dir, year, month);
+    if (event_loop_submit(prefetch_month_file, free_prefetch_path, path) < 0)
+    {
+        free(path);
+    }
+}
+
 // New dashboard mode that shows everything at once with flexible boxes
 int run_dashboard_mode()
 {
@@ -183,8 +470,10 @@ int run_dashboard_mode()
     draw_title(win, "tbudget Dashboard");
 
     bool needs_redraw = true;
+    bool needs_dialog_paint = false; // only the open dialog changed since the last frame
     bool is_leaving = false;
     bool show_pie_chart = true; // Flag to toggle between table and pie chart view
+    bool top_level_only = false; // Budget Summary and charts show parents with their children rolled in
 
     // Create flex layout containers
     FlexContainer *top_row = NULL;
@@ -203,20 +492,39 @@ int run_dashboard_mode()
     int count_buffer_pos = 0;    // Current position in the count buffer
     int res;
 
-    update_subscriptions(); // Update subscriptions and create transactions
+    active_dialog = update_subscriptions_dialog(); // Update subscriptions and create transactions
+
+    // Background work (file notifications, timers, worker completions) is dispatched
+    // while the loop waits for keys
+    event_loop_init();
+    event_loop_watch_dir(data_storage_dir, on_data_file_changed, NULL);
+    event_loop_add_timer(60 * 1000, true, on_clock_tick, NULL);
+    on_clock_tick(NULL);
 
     // Main dashboard loop
     while (1)
     {
-        if (current_month != loaded_month || current_year != loaded_year)
+        // Reloading frees the transaction list, so wait until no dialog is using it
+        if (active_dialog == NULL && (current_month != loaded_month || current_year != loaded_year))
         {
             if ((res = load_month(current_year, current_month)) < 0)
             {
                 fprintf(stderr, "Failed to load budget data: %d\n", res);
                 return 0;
             }
+            prefetch_previous_month(current_year, current_month);
+            prune_marks();
+            if (history_filter_active(&history_filter))
+            {
+                history_filter_refresh(&history_filter, history_order());
+            }
+            needs_redraw = true;
         }
-        if (needs_redraw)
+        // In low-bandwidth mode a frame is only painted once the frame cap allows it;
+        // keys arriving before then are applied first so one paint covers all of them.
+        // Queued input likewise defers the paint, bounded so the screen still moves.
+        if (needs_redraw && render_frame_wait_ms() == 0 &&
+            (!input_pending() || monotonic_ms() - render_stats.last_frame_ms >= MAX_INPUT_DEFER_MS))
         {
             // Recalculate sizes in case of window resize
             getmaxyx(win, max_y, max_x);
@@ -271,7 +579,29 @@ int run_dashboard_mode()
             flex_container_add_item(top_row, flex_window(2, 0, window_titles[2], active_window == 2, ALIGN_LEFT, &breakdown_win));
 
             // Add items to bottom row
-            flex_container_add_item(bottom_row, flex_window(2, 0, window_titles[3], active_window == 3, ALIGN_LEFT, &trans_win));
+            char history_title[96];
+            char sort_note[32] = "";
+            if (history_sort != SORT_BY_DATE)
+            {
+                snprintf(sort_note, sizeof(sort_note), " (by %s)", sort_field_name(history_sort));
+            }
+            if (history_range == HISTORY_MONTH && marked_count > 0)
+            {
+                snprintf(sort_note + strlen(sort_note), sizeof(sort_note) - strlen(sort_note), " [%d marked]", marked_count);
+            }
+            if (history_range == HISTORY_MONTH && history_filter_active(&history_filter))
+            {
+                snprintf(history_title, sizeof(history_title), "%s%s /%s%s", window_titles[3], sort_note, history_filter.query, history_filter.editing ? "_" : "");
+            }
+            else if (history_range == HISTORY_MONTH)
+            {
+                snprintf(history_title, sizeof(history_title), "%s%s", window_titles[3], sort_note);
+            }
+            else
+            {
+                snprintf(history_title, sizeof(history_title), "%s (%s)", window_titles[3], history_range_name(history_range));
+            }
+            flex_container_add_item(bottom_row, flex_window(2, 0, history_title, active_window == 3, ALIGN_LEFT, &trans_win));
             flex_container_add_item(bottom_row, flex_window(1, 0, window_titles[4], active_window == 4, ALIGN_LEFT, &subscription_win));
             flex_container_add_item(bottom_row, flex_window(1, 0, window_titles[5], active_window == 5, ALIGN_LEFT, &TODO_win));
 
@@ -284,22 +614,28 @@ int run_dashboard_mode()
             // Display help line at the bottom
             mvwhline(win, max_y - 1, 0, ' ', max_x); // Clear the line first
             mvwprintw(win, max_y - 1, (max_x - strlen(help_text)) / 2, "%s", help_text);
+            if (render_stats.low_bandwidth)
+            {
+                char stats[64];
+                render_format_stats(stats, sizeof(stats));
+                mvwprintw(win, max_y - 1, max_x - strlen(stats) - 1, "%s", stats);
+            }
 
             const char *month = month_names[current_month];
             // Display budget summary
-            mvwprintw(budget_win.textbox, 1, 2, "%s %d Budget: $%.2f", month, current_year, current_month_total_budget);
+            mvwprintw(budget_win.textbox, 1, 2, "%s %d Budget: $%s", month, current_year, money_str(current_month_total_budget));
             if (category_count > 0)
             {
                 // Show tabular view
-                display_categories(budget_win.textbox, 3);
+                display_categories(budget_win.textbox, 3, top_level_only);
                 if (show_pie_chart)
                 {
                     int x, y;
                     getmaxyx(breakdown_win.textbox, y, x);
-                    display_budget_pie_chart(breakdown_win.textbox, 0.8 * x, 0.65 * y);
+                    display_budget_pie_chart(breakdown_win.textbox, 0.8 * x, 0.65 * y, top_level_only);
 
                     // Create bar chart as a child of the breakdown window
-                    create_bar_chart(&breakdown_win);
+                    create_bar_chart(&breakdown_win, top_level_only);
                 }
             }
             else
@@ -309,7 +645,17 @@ int run_dashboard_mode()
             }
 
             // Display transaction history
-            display_transactions(trans_win.textbox, 1, selected_transaction, &first_display_transaction, active_window == TRANSACTION_HISTORY_WINDOW);
+            refresh_history_view();
+            if (history_view_open)
+            {
+                display_range_transactions(trans_win.textbox, 1, &history_view, selected_transaction, &first_display_transaction, active_window == TRANSACTION_HISTORY_WINDOW);
+            }
+            else
+            {
+                bool filtered = history_filter_active(&history_filter);
+                display_transactions(trans_win.textbox, 1, history_sort, filtered ? history_filter.matches : NULL, filtered ? history_filter.match_count : 0,
+                                     selected_transaction, &first_display_transaction, active_window == TRANSACTION_HISTORY_WINDOW, is_marked);
+            }
 
             // Display subscriptions
             if (subscription_count > 0)
@@ -340,12 +686,97 @@ int run_dashboard_mode()
             // Refresh windows
             wnoutrefresh(win);
             bwarrnoutrefresh(all_windows, NUM_WINDOWS);
-            doupdate();
+            if (active_dialog != NULL)
+            {
+                dialog_noutrefresh(active_dialog);
+            }
+            render_present();
             needs_redraw = false;
+            needs_dialog_paint = false;
+        }
+        else if (needs_dialog_paint && active_dialog != NULL && render_frame_wait_ms() == 0)
+        {
+            dialog_noutrefresh(active_dialog);
+            render_present();
+            needs_dialog_paint = false;
         }
 
-        // Get user input
-        ch = getch();
+        // Get user input, waking up when a deferred frame becomes due or background
+        // work needs the screen updated
+        ch = event_loop_next_key(needs_redraw || needs_dialog_paint ? render_frame_wait_ms() : -1);
+        if (event_loop_take_redraw())
+        {
+            needs_redraw = true;
+        }
+        if (ch == ERR)
+        {
+            continue;
+        }
+
+        // An open dialog takes every key; the dashboard keeps repainting underneath it
+        if (active_dialog != NULL)
+        {
+            if (ch == KEY_RESIZE)
+            {
+                dialog_relayout(active_dialog);
+                needs_redraw = true;
+            }
+            else if (dialog_handle_key(active_dialog, ch) == DIALOG_CLOSED)
+            {
+                Dialog *next = active_dialog->next;
+                active_dialog->next = NULL;
+                dialog_free(active_dialog);
+                active_dialog = next;
+                if (history_filter_active(&history_filter))
+                {
+                    history_filter_refresh(&history_filter, history_order()); // the dialog may have added or removed rows
+                }
+                prune_marks();
+                needs_redraw = true;
+            }
+            else
+            {
+                needs_dialog_paint = true;
+            }
+            continue;
+        }
+
+        // While the filter is being typed, printable keys edit it instead of acting as commands
+        if (history_filter.editing && ch != KEY_UP && ch != KEY_DOWN && ch != KEY_RESIZE)
+        {
+            char query[MAX_NAME_LEN];
+            strcpy(query, history_filter.query);
+            size_t len = strlen(query);
+            if (ch == 27) // ESC drops the filter
+            {
+                history_filter_clear(&history_filter);
+            }
+            else if (ch == '\n')
+            {
+                if (len == 0)
+                    history_filter_clear(&history_filter);
+                else
+                    history_filter.editing = false;
+            }
+            else if (ch == KEY_BACKSPACE || ch == KEY_BACKSPACE_ALT || ch == '\b')
+            {
+                if (len > 0)
+                {
+                    query[len - 1] = '\0';
+                    history_filter_set_query(&history_filter, query);
+                }
+            }
+            else if (isprint(ch) && len < MAX_NAME_LEN - 1)
+            {
+                query[len] = ch;
+                query[len + 1] = '\0';
+                history_filter_set_query(&history_filter, query);
+            }
+            selected_transaction = 0;
+            first_display_transaction = 0;
+            needs_redraw = true;
+            continue;
+        }
 
         if (ch == 'q' || ch == 'Q')
         {
@@ -390,9 +821,7 @@ int run_dashboard_mode()
         int count = 1;
         if (count_buffer_pos > 0)
         {
-            count = atoi(count_buffer);
-            if (count < 1)
-                count = 1; // Ensure at least 1
+            count = parse_count(count_buffer); // at least 1
         }
 
         // Handle window selection
@@ -419,53 +848,57 @@ int run_dashboard_mode()
             break;
         case 'j':
         case KEY_DOWN:
-        {
-            int amount = ch == 'j' ? count : 1;
-            if (active_window == ACTIONS_MENU_WINDOW && highlighted_action < action_menu_size - 1)
-            {
-                highlighted_action += amount;
-                highlighted_action = MIN(highlighted_action, action_menu_size - 1);
-            }
-            else if (active_window == TRANSACTION_HISTORY_WINDOW && selected_transaction < current_month_transaction_count - 1)
-            {
-                selected_transaction += amount;
-                selected_transaction = MIN(selected_transaction, current_month_transaction_count - 1);
-            }
-            else if (active_window == SUBSCRIPTIONS_WINDOW && selected_subscription < subscription_count - 1)
-            {
-                selected_subscription += amount;
-                selected_subscription = MIN(selected_subscription, subscription_count - 1);
-            }
-            else
-            {
-                active_window = (active_window + amount) % NUM_SELECTABLE_WINDOWS;
-            }
-            needs_redraw = true;
-            break;
-        }
-
         case 'k':
         case KEY_UP:
         {
-            int amount = ch == 'k' ? count : 1;
-            if (active_window == ACTIONS_MENU_WINDOW && highlighted_action > 0)
-            {
-                highlighted_action -= amount;
-                highlighted_action = MAX(highlighted_action, 0);
-            }
-            else if (active_window == TRANSACTION_HISTORY_WINDOW && selected_transaction > 0)
+            // Key repeat queues many motions; fold them into one move and one redraw
+            int delta = coalesce_motions(ch, count);
+            if (delta > 0)
             {
-                selected_transaction -= amount;
-                selected_transaction = MAX(selected_transaction, 0);
-            }
-            else if (active_window == SUBSCRIPTIONS_WINDOW && selected_subscription > 0)
-            {
-                selected_subscription -= amount;
-                selected_subscription = MAX(selected_subscription, 0);
+                int amount = delta;
+                if (active_window == ACTIONS_MENU_WINDOW && highlighted_action < action_menu_size - 1)
+                {
+                    highlighted_action += amount;
+                    highlighted_action = MIN(highlighted_action, action_menu_size - 1);
+                }
+                else if (active_window == TRANSACTION_HISTORY_WINDOW && selected_transaction < history_row_count() - 1)
+                {
+                    selected_transaction += amount;
+                    selected_transaction = MIN(selected_transaction, history_row_count() - 1);
+                }
+                else if (active_window == SUBSCRIPTIONS_WINDOW && selected_subscription < subscription_count - 1)
+                {
+                    selected_subscription += amount;
+                    selected_subscription = MIN(selected_subscription, subscription_count - 1);
+                }
+                else
+                {
+                    // At the end of the list: move on one pane, however many presses were queued
+                    active_window = (active_window + 1) % NUM_SELECTABLE_WINDOWS;
+                }
             }
-            else
+            else if (delta < 0)
             {
-                active_window = (active_window - (amount % NUM_SELECTABLE_WINDOWS) + NUM_SELECTABLE_WINDOWS) % NUM_SELECTABLE_WINDOWS;
+                int amount = -delta;
+                if (active_window == ACTIONS_MENU_WINDOW && highlighted_action > 0)
+                {
+                    highlighted_action -= amount;
+                    highlighted_action = MAX(highlighted_action, 0);
+                }
+                else if (active_window == TRANSACTION_HISTORY_WINDOW && selected_transaction > 0)
+                {
+                    selected_transaction -= amount;
+                    selected_transaction = MAX(selected_transaction, 0);
+                }
+                else if (active_window == SUBSCRIPTIONS_WINDOW && selected_subscription > 0)
+                {
+                    selected_subscription -= amount;
+                    selected_subscription = MAX(selected_subscription, 0);
+                }
+                else
+                {
+                    active_window = (active_window - 1 + NUM_SELECTABLE_WINDOWS) % NUM_SELECTABLE_WINDOWS;
+                }
             }
             needs_redraw = true;
             break;
@@ -479,38 +912,25 @@ int run_dashboard_mode()
                 switch (highlighted_action)
                 {
                 case 0: // Add Expense
-                    add_expense_dialog();
-                    needs_redraw = true;
+                    active_dialog = add_expense_dialog();
+                    needs_dialog_paint = true;
                     break;
 
                 case 1: // Remove Transaction
-                    remove_transaction_dialog();
-                    needs_redraw = true;
+                    active_dialog = remove_transaction_dialog();
+                    needs_dialog_paint = true;
                     break;
 
                 case 2: // Add Subscription
-                    add_subscription_dialog();
-                    needs_redraw = true;
+                    active_dialog = add_subscription_dialog();
+                    needs_dialog_paint = true;
                     break;
 
                 case 4: // Export to CSV
-                {
-                    const char *export_msg[] = {"This may take a while..."};
-                    BoundedWindow alert = draw_alert("Export to CSV", export_msg, 1);
-                    doupdate();
-
-                    // // Export the data
-                    // export_data_to_csv(0);
-
-                    // Show the alert
-                    char export_path[MAX_BUFFER];
-                    sprintf(export_path, "Export doesn't work but if it did, it would be exported to: %.30s", export_file_path);
-                    const char *export_path_msg[] = {export_path};
-                    draw_alert_persistent("Export to CSV", export_path_msg, 1);
-                    delete_bounded(alert);
-                    needs_redraw = true;
+                    active_dialog = export_csv_dialog();
+                    needs_dialog_paint = true;
                     break;
-                }
+
                 case 5: // Previous Month
                     current_month--;
                     if (current_month < 1)
@@ -540,29 +960,135 @@ int run_dashboard_mode()
                         free_flex_layout(main_layout);
                     }
                     delete_bounded_array(all_windows, NUM_WINDOWS);
+                    event_loop_shutdown();
                     return 0;
                 }
                 break;
             case BUDGET_SUMMARY_WINDOW:
-                budget_summary_dialog();
-                needs_redraw = true;
+                active_dialog = budget_summary_dialog();
+                needs_dialog_paint = true;
                 break;
+            case TRANSACTION_HISTORY_WINDOW:
+            {
+                Transaction selected;
+                if (history_transaction_at(selected_transaction, &selected))
+                {
+                    active_dialog = edit_transaction_dialog(&selected);
+                    needs_dialog_paint = true;
+                }
+                break;
+            }
             case SUBSCRIPTIONS_WINDOW:
-                remove_subscription_dialog(selected_subscription);
-                needs_redraw = true;
+                active_dialog = remove_subscription_dialog(selected_subscription);
+                needs_dialog_paint = true;
                 break;
             }
             break;
         case KEY_RESIZE:
             needs_redraw = true;
             break;
+        case '/':
+            // Filter the month's rows by description or category as you type
+            if (active_window == TRANSACTION_HISTORY_WINDOW)
+            {
+                history_range = HISTORY_MONTH;
+                history_filter_refresh(&history_filter, history_order());
+                history_filter.editing = true;
+                selected_transaction = 0;
+                first_display_transaction = 0;
+                needs_redraw = true;
+            }
+            break;
+        case 27: // ESC drops the marks, then a filter that is no longer being typed
+            if (active_window == TRANSACTION_HISTORY_WINDOW && marked_count > 0)
+            {
+                marked_count = 0;
+                needs_redraw = true;
+            }
+            else if (active_window == TRANSACTION_HISTORY_WINDOW && history_filter_active(&history_filter))
+            {
+                history_filter_clear(&history_filter);
+                selected_transaction = 0;
+                first_display_transaction = 0;
+                needs_redraw = true;
+            }
+            break;
+        case 's':
+            // Sort the month's rows on the next column: date, amount, category, description
+            if (active_window == TRANSACTION_HISTORY_WINDOW)
+            {
+                history_range = HISTORY_MONTH;
+                history_sort = (history_sort + 1) % NUM_SORT_FIELDS;
+                const OrderIndex *order = history_order();
+                if (history_filter_active(&history_filter))
+                {
+                    history_filter_refresh(&history_filter, order); // matches are rows of the old order
+                }
+                selected_transaction = 0;
+                first_display_transaction = 0;
+                needs_redraw = true;
+            }
+            break;
+        case ' ':
+            // Mark or unmark the selected row and the count - 1 rows below it, then move past them
+            if (active_window == TRANSACTION_HISTORY_WINDOW && history_range == HISTORY_MONTH)
+            {
+                Transaction row;
+                bool mark = history_transaction_at(selected_transaction, &row) && !is_marked(row.id);
+                for (int i = 0; i < count && history_transaction_at(selected_transaction, &row); i++)
+                {
+                    set_mark(row.id, mark);
+                    if (selected_transaction == history_row_count() - 1)
+                    {
+                        break;
+                    }
+                    selected_transaction++;
+                }
+                needs_redraw = true;
+            }
+            break;
+        case 'd':
+        case KEY_DC:
+            // Remove the marked rows, or the selected one if none are marked
+            if (active_window == TRANSACTION_HISTORY_WINDOW && history_range == HISTORY_MONTH)
+            {
+                Transaction row;
+                if (marked_count > 0)
+                {
+                    active_dialog = remove_transactions_dialog(marked_ids, marked_count);
+                }
+                else if (history_transaction_at(selected_transaction, &row))
+                {
+                    active_dialog = remove_transactions_dialog(&row.id, 1);
+                }
+                needs_dialog_paint = true;
+            }
+            break;
+        case 'v':
+            // Cycle the history range: month, last 90 days, quarter
+            if (active_window == TRANSACTION_HISTORY_WINDOW)
+            {
+                history_filter_clear(&history_filter);
+                history_range = (history_range + 1) % NUM_HISTORY_RANGES;
+                selected_transaction = 0;
+                first_display_transaction = 0;
+                needs_redraw = true;
+            }
+            break;
+        case 'c':
+            // Collapse child categories into their parents, or show every category
+            if (active_window == BUDGET_SUMMARY_WINDOW || active_window == BUDGET_BREAKDOWN_WINDOW)
+            {
+                top_level_only = !top_level_only;
+                needs_redraw = true;
+            }
+            break;
         case '+':
             switch (active_window)
             {
             case SUBSCRIPTIONS_WINDOW:
-                add_subscription_dialog();
-                update_subscriptions();
-                needs_redraw = true;
+                active_dialog = add_subscription_dialog();
+                needs_dialog_paint = true;
                 break;
             }
             break;
@@ -581,6 +1107,7 @@ int save_and_exit()
     //     fprintf(stderr, "Failed to save data to file: %d\n", res);
     //     success = false;
     // }
+    event_loop_shutdown();
     int res = cleanup_file_cache();
     if (res < 0)
     {
@@ -597,6 +1124,10 @@ int save_and_exit()
         free_flex_layout(main_layout);
     }
     cleanup_transactions();
+    category_table_free();
+    rollover_free();
+    rules_free();
+    category_stats_free();
     cleanup_ncurses();
     curs_set(1);
     return 0;
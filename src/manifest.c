@@ -0,0 +1,564 @@
+#include "manifest.h"
+
+static ManifestEntry *entries = NULL;
+static int entry_count = 0;
+static int entry_capacity = 0;
+static unsigned long long generation = 0;
+
+// Every entry's category records back to back, in entry order
+static ManifestCategory *month_categories = NULL;
+static int month_category_count = 0;
+static int month_category_capacity = 0;
+
+static int lock_fd = -1;
+static int lock_depth = 0; // nested holds; only the outermost takes and drops the lock
+
+static void manifest_path(char *path, size_t size, const char *suffix)
+{
+    snprintf(path, size, "%s/%s%s", data_storage_dir, MANIFEST_FILE_NAME, suffix);
+}
+
+// Take the lock shared (LOCK_SH) or exclusively (LOCK_EX). A nested call keeps the
+// lock as it is held, so take it exclusively first when writing.
+static void lock_manifest(int operation)
+{
+    if (lock_depth++ > 0)
+    {
+        return;
+    }
+    if (lock_fd < 0)
+    {
+        char path[MAX_BUFFER + 32];
+        snprintf(path, sizeof(path), "%s/%s", data_storage_dir, MANIFEST_LOCK_NAME);
+        lock_fd = open(path, O_RDONLY | O_CREAT, 0644);
+    }
+    if (lock_fd >= 0)
+    {
+        flock(lock_fd, operation); // without a lock file, go on unlocked as before
+    }
+}
+
+static void unlock_manifest(void)
+{
+    if (--lock_depth == 0 && lock_fd >= 0)
+    {
+        flock(lock_fd, LOCK_UN);
+    }
+}
+
+static int compare_months(int year_a, int month_a, int year_b, int month_b)
+{
+    return year_a != year_b ? year_a - year_b : month_a - month_b;
+}
+
+// Index of the month's entry, or where it would be inserted (as -index - 1)
+static int find_index(int year, int month)
+{
+    int left = 0, right = entry_count - 1;
+    while (left <= right)
+    {
+        int mid = (left + right) / 2;
+        int cmp = compare_months(entries[mid].year, entries[mid].month, year, month);
+        if (cmp == 0)
+        {
+            return mid;
+        }
+        if (cmp < 0)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid - 1;
+        }
+    }
+    return -left - 1;
+}
+
+static int reserve(int capacity)
+{
+    if (capacity <= entry_capacity)
+    {
+        return 0;
+    }
+    int new_capacity = entry_capacity > 0 ? entry_capacity : 32;
+    while (new_capacity < capacity)
+    {
+        new_capacity *= 2;
+    }
+    ManifestEntry *grown = realloc(entries, new_capacity * sizeof(ManifestEntry));
+    if (grown == NULL)
+    {
+        return -1;
+    }
+    entries = grown;
+    entry_capacity = new_capacity;
+    return 0;
+}
+
+static int reserve_categories(int capacity)
+{
+    if (capacity <= month_category_capacity)
+    {
+        return 0;
+    }
+    int new_capacity = month_category_capacity > 0 ? month_category_capacity : 256;
+    while (new_capacity < capacity)
+    {
+        new_capacity *= 2;
+    }
+    ManifestCategory *grown = realloc(month_categories, new_capacity * sizeof(ManifestCategory));
+    if (grown == NULL)
+    {
+        return -1;
+    }
+    month_categories = grown;
+    month_category_capacity = new_capacity;
+    return 0;
+}
+
+static void number_categories(void)
+{
+    int first = 0;
+    for (int i = 0; i < entry_count; i++)
+    {
+        entries[i].category_first = first;
+        first += entries[i].category_records;
+    }
+}
+
+/*
+ * Put entry at index, replacing the entry there if replace is set, along with its
+ * category records
+ *
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+static int place_entry(int index, bool replace, ManifestEntry *entry, const ManifestCategory *records)
+{
+    int at = index < entry_count ? entries[index].category_first : month_category_count;
+    int removed = replace ? entries[index].category_records : 0;
+    if (reserve(entry_count + 1) < 0 || reserve_categories(month_category_count - removed + entry->category_records) < 0)
+    {
+        return -2;
+    }
+    memmove(&month_categories[at + entry->category_records], &month_categories[at + removed],
+            (month_category_count - at - removed) * sizeof(ManifestCategory));
+    memcpy(&month_categories[at], records, entry->category_records * sizeof(ManifestCategory));
+    month_category_count += entry->category_records - removed;
+    if (!replace)
+    {
+        memmove(&entries[index + 1], &entries[index], (entry_count - index) * sizeof(ManifestEntry));
+        entry_count++;
+    }
+    entries[index] = *entry;
+    number_categories();
+    return 1;
+}
+
+static void drop_entry(int index)
+{
+    int at = entries[index].category_first, removed = entries[index].category_records;
+    memmove(&month_categories[at], &month_categories[at + removed], (month_category_count - at - removed) * sizeof(ManifestCategory));
+    month_category_count -= removed;
+    memmove(&entries[index], &entries[index + 1], (entry_count - index - 1) * sizeof(ManifestEntry));
+    entry_count--;
+    number_categories();
+}
+
+/*
+ * Summarize a month file's header section and its categories; the caller frees
+ * *out_records, which holds entry->category_records records
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - Empty file (month not materialized yet)
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+static int read_entry(FILE *file, int year, int month, ManifestEntry *entry, ManifestCategory **out_records)
+{
+    *out_records = NULL;
+    memset(entry, 0, sizeof(ManifestEntry));
+    entry->year = year;
+    entry->month = month;
+
+    fseek(file, 0, SEEK_END);
+    entry->byte_size = ftell(file);
+    if (entry->byte_size <= 0)
+    {
+        return 0;
+    }
+
+    MonthFileHeader header;
+    Category *slots;
+    if (read_month_header(file, &header) != 1 ||
+        fread(&entry->budget, sizeof(Money), 1, file) != 1 ||
+        fread(&entry->category_count, sizeof(int), 1, file) != 1 ||
+        read_month_categories_section(file, &header, &slots) != 1)
+    {
+        return -1;
+    }
+    if (fread(&entry->uncategorized_spent, sizeof(Money), 1, file) != 1 ||
+        fread(&entry->transaction_count, sizeof(int), 1, file) != 1)
+    {
+        free(slots);
+        return -1;
+    }
+    ManifestCategory *records = malloc((header.category_slots > 0 ? header.category_slots : 1) * sizeof(ManifestCategory));
+    if (records == NULL)
+    {
+        free(slots);
+        return -2;
+    }
+    for (int i = 0; i < header.category_slots; i++)
+    {
+        if (slots[i].budget > 0)
+        {
+            ManifestCategory *record = &records[entry->category_records++];
+            memset(record, 0, sizeof(ManifestCategory));
+            record->id = slots[i].id;
+            record->parent_id = slots[i].parent_id;
+            memcpy(record->name, slots[i].name, sizeof(record->name));
+            record->budget = slots[i].budget;
+            record->spent = slots[i].spent;
+        }
+    }
+    free(slots);
+    *out_records = records;
+    return 1;
+}
+
+static ManifestHeader current_header(void)
+{
+    ManifestHeader header = {
+        .magic = MANIFEST_MAGIC,
+        .version = MANIFEST_VERSION,
+        .entry_count = entry_count,
+        .category_record_count = month_category_count,
+        .generation = generation};
+    return header;
+}
+
+// Write to a temporary file and rename it over the manifest so readers never see half a file
+static int save_manifest(void)
+{
+    char path[MAX_BUFFER + 32], tmp_path[MAX_BUFFER + 32];
+    manifest_path(path, sizeof(path), "");
+    manifest_path(tmp_path, sizeof(tmp_path), ".tmp");
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    ManifestHeader header = current_header();
+    bool ok = fwrite(&header, sizeof(ManifestHeader), 1, file) == 1 &&
+              fwrite(entries, sizeof(ManifestEntry), entry_count, file) == (size_t)entry_count &&
+              fwrite(month_categories, sizeof(ManifestCategory), month_category_count, file) == (size_t)month_category_count;
+    if (fclose(file) != 0 || !ok)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return rename(tmp_path, path) == 0 ? 1 : -1;
+}
+
+/*
+ * Write the entry at index and its category records over the ones on disk, then the
+ * header with the new generation. The file must hold what this process last read or
+ * wrote, with the same number of records.
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ */
+static int patch_manifest(int index)
+{
+    char path[MAX_BUFFER + 32];
+    manifest_path(path, sizeof(path), "");
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL)
+    {
+        return save_manifest();
+    }
+    ManifestHeader header = current_header();
+    const ManifestEntry *entry = &entries[index];
+    long categories_start = sizeof(ManifestHeader) + (long)entry_count * sizeof(ManifestEntry);
+    bool ok = fseek(file, sizeof(ManifestHeader) + (long)index * sizeof(ManifestEntry), SEEK_SET) == 0 &&
+              fwrite(entry, sizeof(ManifestEntry), 1, file) == 1 &&
+              fseek(file, categories_start + (long)entry->category_first * sizeof(ManifestCategory), SEEK_SET) == 0 &&
+              fwrite(&month_categories[entry->category_first], sizeof(ManifestCategory), entry->category_records, file) == (size_t)entry->category_records &&
+              fflush(file) == 0 &&
+              fseek(file, 0, SEEK_SET) == 0 &&
+              fwrite(&header, sizeof(ManifestHeader), 1, file) == 1;
+    return fclose(file) == 0 && ok ? 1 : -1;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   0     - No manifest on disk
+ *   -1    - I/O error or unrecognized manifest
+ *   -2    - Malloc error
+ */
+static int read_manifest(void)
+{
+    char path[MAX_BUFFER + 32];
+    manifest_path(path, sizeof(path), "");
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return 0;
+    }
+
+    ManifestHeader header;
+    if (fread(&header, sizeof(ManifestHeader), 1, file) != 1 ||
+        strcmp(header.magic, MANIFEST_MAGIC) != 0 || header.version != MANIFEST_VERSION ||
+        header.entry_count < 0 || header.category_record_count < 0)
+    {
+        fclose(file);
+        return -1;
+    }
+    if (reserve(header.entry_count) < 0 || reserve_categories(header.category_record_count) < 0)
+    {
+        fclose(file);
+        return -2;
+    }
+    if (fread(entries, sizeof(ManifestEntry), header.entry_count, file) != (size_t)header.entry_count ||
+        fread(month_categories, sizeof(ManifestCategory), header.category_record_count, file) != (size_t)header.category_record_count)
+    {
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    int records = 0;
+    for (int i = 0; i < header.entry_count; i++)
+    {
+        records += entries[i].category_records >= 0 ? entries[i].category_records : header.category_record_count + 1;
+    }
+    if (records != header.category_record_count)
+    {
+        entry_count = 0;
+        month_category_count = 0;
+        return -1;
+    }
+    entry_count = header.entry_count;
+    month_category_count = header.category_record_count;
+    number_categories();
+    generation = header.generation;
+    return 1;
+}
+
+/*
+ * Re-read the manifest if another process wrote it; the caller holds the lock
+ *
+ * Returns:
+ *   1     - The manifest on disk was written by someone else and has been read
+ *   0     - It is the one this process last read or wrote
+ *   -1    - It changed but can't be read, and needs a rebuild
+ */
+static int sync_with_disk(void)
+{
+    char path[MAX_BUFFER + 32];
+    manifest_path(path, sizeof(path), "");
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    ManifestHeader header;
+    bool changed = fread(&header, sizeof(ManifestHeader), 1, file) == 1 && header.generation != generation;
+    fclose(file);
+    if (!changed)
+    {
+        return 0;
+    }
+    return read_manifest() < 0 ? -1 : 1;
+}
+
+/*
+ * Returns:
+ *   1     - The manifest on disk was written by someone else and has been read
+ *   0     - It is the one this process last read or wrote
+ */
+int manifest_sync(void)
+{
+    lock_manifest(LOCK_SH);
+    int res = sync_with_disk();
+    unlock_manifest();
+    if (res < 0)
+    {
+        manifest_rebuild();
+    }
+    return res != 0 ? 1 : 0;
+}
+
+int manifest_load(void)
+{
+    lock_manifest(LOCK_SH);
+    int res = read_manifest();
+    unlock_manifest();
+    if (res > 0)
+    {
+        return 1;
+    }
+    return manifest_rebuild();
+}
+
+/*
+ * Rebuild the manifest by reading every month file's header once
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int manifest_rebuild(void)
+{
+    DIR *dir = opendir(data_storage_dir);
+    if (dir == NULL)
+    {
+        return -1;
+    }
+    lock_manifest(LOCK_EX);
+    entry_count = 0;
+    month_category_count = 0;
+
+    struct dirent *dir_entry;
+    while ((dir_entry = readdir(dir)) != NULL)
+    {
+        int year, month;
+        if (!parse_month_file_name(dir_entry->d_name, &year, &month))
+        {
+            continue;
+        }
+        char path[MAX_BUFFER + 32];
+        snprintf(path, sizeof(path), "%s/%d-%d.dat", data_storage_dir, year, month);
+        FILE *file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            continue;
+        }
+        ManifestEntry entry;
+        ManifestCategory *records;
+        int res = read_entry(file, year, month, &entry, &records);
+        fclose(file);
+        int index = find_index(year, month);
+        if (res > 0 && index < 0) // else empty, unreadable, or the same month under another spelling, e.g. 2024-01.dat
+        {
+            res = place_entry(-index - 1, false, &entry, records);
+        }
+        free(records);
+        if (res == -2)
+        {
+            closedir(dir);
+            unlock_manifest();
+            return -2;
+        }
+    }
+    closedir(dir);
+
+    generation++;
+    for (int i = 0; i < entry_count; i++)
+    {
+        entries[i].generation = generation;
+    }
+    int res = save_manifest();
+    unlock_manifest();
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int manifest_record_month(int year, int month, FILE *file)
+{
+    fflush(file);
+    // Hold the lock from reading the month to writing the manifest, so a change another
+    // process records in between isn't overwritten
+    lock_manifest(LOCK_EX);
+    ManifestEntry entry;
+    ManifestCategory *records;
+    int res = read_entry(file, year, month, &entry, &records);
+    if (res < 0)
+    {
+        unlock_manifest();
+        return res;
+    }
+    if (sync_with_disk() < 0)
+    {
+        manifest_rebuild();
+    }
+    int index = find_index(year, month);
+    bool in_place = false;
+    if (res == 0)
+    {
+        // Empty file: the month isn't materialized, so it has no entry
+        if (index < 0)
+        {
+            unlock_manifest();
+            return 1;
+        }
+        drop_entry(index);
+    }
+    else
+    {
+        in_place = index >= 0 && entries[index].category_records == entry.category_records;
+        entry.generation = generation + 1;
+        res = place_entry(index >= 0 ? index : -index - 1, index >= 0, &entry, records);
+        free(records);
+        if (res < 0)
+        {
+            unlock_manifest();
+            return res;
+        }
+    }
+    generation++;
+    res = in_place ? patch_manifest(index) : save_manifest();
+    unlock_manifest();
+    return res;
+}
+
+const ManifestEntry *manifest_find(int year, int month)
+{
+    int index = find_index(year, month);
+    return index >= 0 ? &entries[index] : NULL;
+}
+
+const ManifestEntry *manifest_entries(int *count)
+{
+    *count = entry_count;
+    return entries;
+}
+
+const ManifestCategory *manifest_categories(const ManifestEntry *entry)
+{
+    return &month_categories[entry->category_first];
+}
+
+unsigned long long manifest_generation(void)
+{
+    return generation;
+}
+
+void manifest_free(void)
+{
+    free(entries);
+    entries = NULL;
+    entry_count = 0;
+    entry_capacity = 0;
+    free(month_categories);
+    month_categories = NULL;
+    month_category_count = 0;
+    month_category_capacity = 0;
+    if (lock_fd >= 0)
+    {
+        close(lock_fd);
+        lock_fd = -1;
+    }
+}
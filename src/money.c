@@ -0,0 +1,117 @@
+#include "money.h"
+
+Money money_from_double(double value)
+{
+    return (Money)llround(value * MONEY_SCALE);
+}
+
+double money_to_double(Money amount)
+{
+    return (double)amount / MONEY_SCALE;
+}
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Digits are written backwards from the end of a scratch buffer, two at a time
+int money_format(char *buf, Money amount)
+{
+    char scratch[MONEY_FORMAT_LEN];
+    char *p = scratch + sizeof(scratch);
+    // Negate as unsigned so the most negative amount has a magnitude too
+    unsigned long long magnitude = amount < 0 ? 0ULL - (unsigned long long)amount : (unsigned long long)amount;
+
+    unsigned int cents = (unsigned int)(magnitude % MONEY_SCALE);
+    unsigned long long units = magnitude / MONEY_SCALE;
+    *--p = digit_pairs[cents * 2 + 1];
+    *--p = digit_pairs[cents * 2];
+    *--p = '.';
+    while (units >= 100)
+    {
+        unsigned int pair = (unsigned int)(units % 100);
+        units /= 100;
+        *--p = digit_pairs[pair * 2 + 1];
+        *--p = digit_pairs[pair * 2];
+    }
+    if (units >= 10)
+    {
+        *--p = digit_pairs[units * 2 + 1];
+        *--p = digit_pairs[units * 2];
+    }
+    else
+    {
+        *--p = (char)('0' + units);
+    }
+    if (amount < 0)
+    {
+        *--p = '-';
+    }
+
+    int length = (int)(scratch + sizeof(scratch) - p);
+    memcpy(buf, p, length);
+    buf[length] = '\0';
+    return length;
+}
+
+const char *money_str(Money amount)
+{
+    static char buffers[4][MONEY_FORMAT_LEN];
+    static int next = 0;
+    char *buf = buffers[next];
+    next = (next + 1) % 4;
+    money_format(buf, amount);
+    return buf;
+}
+
+bool money_parse(const char *text, Money *out)
+{
+    const char *p = text;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+')
+    {
+        p++;
+    }
+    Money units = 0;
+    int digits = 0;
+    for (; *p >= '0' && *p <= '9'; p++, digits++)
+    {
+        if (units > (Money)(9000000000000000LL))
+        {
+            return false;
+        }
+        units = units * 10 + (*p - '0');
+    }
+    Money cents = 0;
+    int decimals = 0;
+    if (*p == '.')
+    {
+        for (p++; *p >= '0' && *p <= '9'; p++, decimals++)
+        {
+            if (decimals == 2)
+            {
+                return false;
+            }
+            cents = cents * 10 + (*p - '0');
+        }
+    }
+    if (*p != '\0' || digits + decimals == 0)
+    {
+        return false;
+    }
+    if (decimals == 1)
+    {
+        cents *= 10;
+    }
+    Money amount = units * MONEY_SCALE + cents;
+    *out = negative ? -amount : amount;
+    return true;
+}
@@ -0,0 +1,540 @@
+#include "month_file.h"
+
+// Transaction record as stored before ids existed
+typedef struct
+{
+    bool expense;
+    double amt;
+    int cat_index;
+    char desc[MAX_NAME_LEN];
+    char date[11];
+} LegacyTransaction;
+
+// Transaction record as stored by versions 1 to 3, before amounts were cents
+typedef struct
+{
+    bool expense;
+    double amt;
+    int cat_id;
+    char desc[MAX_NAME_LEN];
+    char date[11];
+    unsigned long long id;
+} TransactionV3;
+
+// Version 1 header, before the category id table
+typedef struct
+{
+    char magic[8];
+    int version;
+    int reserved;
+    unsigned long long next_sequence;
+} MonthFileHeaderV1;
+
+// Version 2 header, which kept each slot's category id here rather than in the record
+typedef struct
+{
+    MonthFileHeaderV1 base;
+    int next_id;
+    int slot_ids[LEGACY_CATEGORY_SLOTS];
+    int alias_count;
+    CategoryAlias aliases[MAX_CATEGORY_ALIASES];
+} MonthFileHeaderV2;
+
+bool parse_month_file_name(const char *name, int *year, int *month)
+{
+    int length = 0;
+    return sscanf(name, "%d-%d%n", year, month, &length) == 2 && strcmp(name + length, ".dat") == 0 &&
+           *month >= 1 && *month <= 12;
+}
+
+void sidecar_path(char *path, size_t size, int year, int month, const char *extension, const char *suffix)
+{
+    snprintf(path, size, "%s/%d-%d.%s%s", data_storage_dir, year, month, extension, suffix);
+}
+
+int *removal_slot_map(int slot, int moved_slot, int old_count)
+{
+    int *new_slots = malloc((old_count > 0 ? old_count : 1) * sizeof(int));
+    if (new_slots == NULL)
+    {
+        return NULL;
+    }
+    for (int i = 0; i < old_count; i++)
+    {
+        new_slots[i] = i;
+    }
+    if (slot >= 0 && slot < old_count)
+    {
+        new_slots[slot] = -1;
+    }
+    if (moved_slot >= 0 && moved_slot < old_count)
+    {
+        new_slots[moved_slot] = slot;
+    }
+    return new_slots;
+}
+
+void init_month_header(MonthFileHeader *header)
+{
+    memset(header, 0, sizeof(MonthFileHeader));
+    strcpy(header->magic, MONTH_FILE_MAGIC);
+    header->version = MONTH_FILE_VERSION;
+    header->next_sequence = 1;
+    category_ids_init(&header->category_ids, 0);
+}
+
+int read_month_header(FILE *file, MonthFileHeader *header)
+{
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0)
+    {
+        return 0;
+    }
+    fseek(file, 0, SEEK_SET);
+    if (fread(header, sizeof(MonthFileHeader), 1, file) != 1 ||
+        strncmp(header->magic, MONTH_FILE_MAGIC, sizeof(header->magic)) != 0 || header->version != MONTH_FILE_VERSION)
+    {
+        return -1;
+    }
+    return 1;
+}
+
+int write_month_header(FILE *file, const MonthFileHeader *header)
+{
+    fseek(file, 0, SEEK_SET);
+    return fwrite(header, sizeof(MonthFileHeader), 1, file) == 1 ? 1 : -1;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int read_month_categories_section(FILE *file, const MonthFileHeader *header, Category **out_slots)
+{
+    *out_slots = malloc((header->category_slots > 0 ? header->category_slots : 1) * sizeof(Category));
+    if (*out_slots == NULL)
+    {
+        return -2;
+    }
+    fseek(file, MONTH_CATEGORY_OFFSET(0), SEEK_SET);
+    if (fread(*out_slots, sizeof(Category), header->category_slots, file) != (size_t)header->category_slots)
+    {
+        free(*out_slots);
+        *out_slots = NULL;
+        return -1;
+    }
+    return 1;
+}
+
+/*
+ * Shift the uncategorized total, transaction count and records one Category further
+ * along and write an empty slot in the gap. The header is written last, so until then
+ * the file still reads as it did.
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int grow_month_categories(FILE *file, MonthFileHeader *header)
+{
+    long tail_offset = MONTH_UNCATEGORIZED_OFFSET(header);
+    fseek(file, 0, SEEK_END);
+    long tail_size = ftell(file) - tail_offset;
+    char *tail = malloc(tail_size > 0 ? tail_size : 1);
+    if (tail_size < 0 || tail == NULL)
+    {
+        free(tail);
+        return tail_size < 0 ? -1 : -2;
+    }
+    Category empty = {0};
+    empty.id = -1;
+    fseek(file, tail_offset, SEEK_SET);
+    bool ok = (tail_size == 0 || fread(tail, tail_size, 1, file) == 1) &&
+              fseek(file, tail_offset + (long)sizeof(Category), SEEK_SET) == 0 &&
+              (tail_size == 0 || fwrite(tail, tail_size, 1, file) == 1) &&
+              fseek(file, tail_offset, SEEK_SET) == 0 &&
+              fwrite(&empty, sizeof(Category), 1, file) == 1;
+    free(tail);
+    if (!ok)
+    {
+        return -1;
+    }
+    header->category_slots++;
+    return write_month_header(file, header);
+}
+
+// An older month file, read into memory before it is written out in the current layout
+typedef struct
+{
+    MonthFileHeader header;
+    Money budget;
+    int category_count;
+    Category *categories; // header.category_slots of them
+    Money uncategorized_spent;
+    int transaction_count;
+    Transaction *transactions;
+} OldMonth;
+
+static void category_from_doubles(Category *category, double budget, double spent, double extra, const char *name)
+{
+    memset(category, 0, sizeof(Category));
+    category->budget = money_from_double(budget);
+    category->spent = money_from_double(spent);
+    category->extra = money_from_double(extra);
+    memcpy(category->name, name, sizeof(category->name));
+    category->parent_id = -1;
+}
+
+/*
+ * Read the sections that every layout before version 4 shares, starting at the budget.
+ * Version 0 is the headerless layout. Before version 3 there were always
+ * LEGACY_CATEGORY_SLOTS category records; from version 3 on, header.category_slots.
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error, or the sizes don't add up to a month file
+ *   -2    - Malloc error
+ */
+static int read_old_sections(FILE *file, long size, int version, OldMonth *old)
+{
+    int slots = version >= 3 ? old->header.category_slots : LEGACY_CATEGORY_SLOTS;
+    size_t category_size = version >= 3 ? sizeof(CategoryV3) : sizeof(LegacyCategory);
+    size_t record_size = version == 0 ? sizeof(LegacyTransaction) : sizeof(TransactionV3);
+    double budget, uncategorized_spent;
+    if (slots < 0 || fread(&budget, sizeof(double), 1, file) != 1 ||
+        fread(&old->category_count, sizeof(int), 1, file) != 1)
+    {
+        return -1;
+    }
+    char *file_categories = malloc(slots > 0 ? slots * category_size : 1);
+    old->categories = calloc(slots > 0 ? slots : 1, sizeof(Category));
+    if (file_categories == NULL || old->categories == NULL)
+    {
+        free(file_categories);
+        return -2;
+    }
+    bool ok = fread(file_categories, category_size, slots, file) == (size_t)slots &&
+              fread(&uncategorized_spent, sizeof(double), 1, file) == 1 &&
+              fread(&old->transaction_count, sizeof(int), 1, file) == 1 &&
+              old->transaction_count >= 0 && ftell(file) + (long)record_size * old->transaction_count == size;
+    for (int i = 0; ok && i < slots; i++)
+    {
+        if (version >= 3)
+        {
+            const CategoryV3 *stored = (const CategoryV3 *)file_categories + i;
+            category_from_doubles(&old->categories[i], stored->budget, stored->spent, stored->extra, stored->name);
+            old->categories[i].id = stored->id;
+        }
+        else
+        {
+            const LegacyCategory *stored = (const LegacyCategory *)file_categories + i;
+            category_from_doubles(&old->categories[i], stored->budget, stored->spent, stored->extra, stored->name);
+            old->categories[i].id = i; // slot i has id i unless a version 2 header says otherwise
+        }
+    }
+    free(file_categories);
+    if (!ok)
+    {
+        return -1;
+    }
+    old->header.category_slots = slots;
+    old->budget = money_from_double(budget);
+    old->uncategorized_spent = money_from_double(uncategorized_spent);
+
+    int count = old->transaction_count;
+    old->transactions = calloc(count > 0 ? count : 1, sizeof(Transaction));
+    if (old->transactions == NULL)
+    {
+        return -2;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        Transaction *transaction = &old->transactions[i];
+        if (version == 0)
+        {
+            LegacyTransaction legacy;
+            if (fread(&legacy, sizeof(LegacyTransaction), 1, file) != 1)
+            {
+                return -1;
+            }
+            transaction->expense = legacy.expense;
+            transaction->amt = money_from_double(legacy.amt);
+            transaction->cat_id = legacy.cat_index;
+            memcpy(transaction->desc, legacy.desc, sizeof(transaction->desc));
+            memcpy(transaction->date, legacy.date, sizeof(transaction->date));
+            continue;
+        }
+        TransactionV3 stored;
+        if (fread(&stored, sizeof(TransactionV3), 1, file) != 1)
+        {
+            return -1;
+        }
+        transaction->expense = stored.expense;
+        transaction->amt = money_from_double(stored.amt);
+        transaction->cat_id = stored.cat_id;
+        memcpy(transaction->desc, stored.desc, sizeof(transaction->desc));
+        memcpy(transaction->date, stored.date, sizeof(transaction->date));
+        transaction->id = stored.id;
+    }
+    return 1;
+}
+
+/*
+ * Read the sections of a version 4 or 5 file after its header: the current layout,
+ * except that transactions have no tags and, in version 4, categories no parent.
+ * Both went into what used to be padding, so it is cleared rather than trusted.
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error, or the sizes don't add up to a month file
+ *   -2    - Malloc error
+ */
+static int read_cents_sections(FILE *file, long size, int version, OldMonth *old)
+{
+    int slots = old->header.category_slots;
+    if (slots < 0 || fread(&old->budget, sizeof(Money), 1, file) != 1 ||
+        fread(&old->category_count, sizeof(int), 1, file) != 1)
+    {
+        return -1;
+    }
+    old->categories = calloc(slots > 0 ? slots : 1, sizeof(Category));
+    if (old->categories == NULL)
+    {
+        return -2;
+    }
+    bool ok;
+    if (version == 5)
+    {
+        ok = fread(old->categories, sizeof(Category), slots, file) == (size_t)slots;
+    }
+    else
+    {
+        CategoryV4 *file_categories = malloc((slots > 0 ? slots : 1) * sizeof(CategoryV4));
+        if (file_categories == NULL)
+        {
+            return -2;
+        }
+        ok = fread(file_categories, sizeof(CategoryV4), slots, file) == (size_t)slots;
+        for (int i = 0; ok && i < slots; i++)
+        {
+            old->categories[i].budget = file_categories[i].budget;
+            old->categories[i].spent = file_categories[i].spent;
+            old->categories[i].extra = file_categories[i].extra;
+            memcpy(old->categories[i].name, file_categories[i].name, sizeof(old->categories[i].name));
+            old->categories[i].id = file_categories[i].id;
+            old->categories[i].parent_id = -1;
+        }
+        free(file_categories);
+    }
+    ok = ok && fread(&old->uncategorized_spent, sizeof(Money), 1, file) == 1 &&
+         fread(&old->transaction_count, sizeof(int), 1, file) == 1 &&
+         old->transaction_count >= 0 && ftell(file) + (long)sizeof(Transaction) * old->transaction_count == size;
+    if (!ok)
+    {
+        return -1;
+    }
+    int count = old->transaction_count;
+    old->transactions = malloc((count > 0 ? count : 1) * sizeof(Transaction));
+    if (old->transactions == NULL)
+    {
+        return -2;
+    }
+    if (fread(old->transactions, sizeof(Transaction), count, file) != (size_t)count)
+    {
+        return -1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        old->transactions[i].tags = 0;
+    }
+    return 1;
+}
+
+// Slots past the last one ever used carry nothing worth keeping
+static void trim_unused_slots(OldMonth *old)
+{
+    int slots = old->header.category_slots;
+    while (slots > 0 && old->categories[slots - 1].name[0] == '\0' &&
+           old->categories[slots - 1].budget == 0 && old->categories[slots - 1].spent == 0)
+    {
+        slots--;
+    }
+    old->header.category_slots = slots;
+}
+
+// Write the month to a temporary file and rename it over path
+static int write_old_month(const char *path, OldMonth *old)
+{
+    char tmp_path[MAX_BUFFER + 300];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *out = fopen(tmp_path, "wb");
+    if (out == NULL)
+    {
+        return -1;
+    }
+    int slots = old->header.category_slots;
+    int count = old->transaction_count;
+    bool ok = fwrite(&old->header, sizeof(MonthFileHeader), 1, out) == 1 &&
+              fwrite(&old->budget, sizeof(Money), 1, out) == 1 &&
+              fwrite(&old->category_count, sizeof(int), 1, out) == 1 &&
+              fwrite(old->categories, sizeof(Category), slots, out) == (size_t)slots &&
+              fwrite(&old->uncategorized_spent, sizeof(Money), 1, out) == 1 &&
+              fwrite(&old->transaction_count, sizeof(int), 1, out) == 1 &&
+              fwrite(old->transactions, sizeof(Transaction), count, out) == (size_t)count;
+    if (fclose(out) != 0 || !ok || rename(tmp_path, path) != 0)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return 1;
+}
+
+/*
+ * Rewrite one month file written by an older version. Headerless files get a header
+ * and an id on every transaction; versions 1 and 2 get their category ids moved into
+ * the category records and lose the slots they never used; every version before 4
+ * has its amounts converted from doubles to cents, every version before 5 has its
+ * categories made top-level, and every version before 6 has its transactions'
+ * tags cleared. The new file is written next to the old one and renamed over it.
+ *
+ * Returns:
+ *   1     - Migrated
+ *   0     - Already current, or empty
+ *   -1    - I/O error, or not a month file this version recognizes
+ *   -2    - Malloc error
+ */
+static int migrate_month_file(const char *path, int year, int month)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    MonthFileHeader header;
+    if (read_month_header(file, &header) >= 0)
+    {
+        fclose(file);
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+
+    OldMonth old;
+    memset(&old, 0, sizeof(OldMonth));
+    init_month_header(&old.header);
+    old.header.category_ids.next_id = LEGACY_CATEGORY_SLOTS;
+    MonthFileHeaderV2 old_header;
+    memset(&old_header, 0, sizeof(old_header));
+    fseek(file, 0, SEEK_SET);
+    int version = 0;
+    if (fread(&old_header.base, sizeof(MonthFileHeaderV1), 1, file) == 1 &&
+        strncmp(old_header.base.magic, MONTH_FILE_MAGIC, sizeof(old_header.base.magic)) == 0)
+    {
+        version = old_header.base.version;
+    }
+    int res = -1;
+    if (version == 0)
+    {
+        fseek(file, 0, SEEK_SET);
+        res = read_old_sections(file, size, 0, &old);
+        for (int i = 0; res > 0 && i < old.transaction_count; i++)
+        {
+            old.transactions[i].id = TRANSACTION_ID(year, month, i + 1);
+        }
+        old.header.next_sequence = old.transaction_count + 1;
+    }
+    else if (version == 1)
+    {
+        res = read_old_sections(file, size, 1, &old);
+        old.header.next_sequence = old_header.base.next_sequence;
+    }
+    else if (version == 2)
+    {
+        fseek(file, 0, SEEK_SET);
+        if (fread(&old_header, sizeof(MonthFileHeaderV2), 1, file) == 1)
+        {
+            res = read_old_sections(file, size, 2, &old);
+        }
+        old.header.next_sequence = old_header.base.next_sequence;
+        old.header.category_ids.next_id = old_header.next_id;
+        old.header.category_ids.alias_count = old_header.alias_count;
+        memcpy(old.header.category_ids.aliases, old_header.aliases, sizeof(old_header.aliases));
+        for (int i = 0; res > 0 && i < LEGACY_CATEGORY_SLOTS; i++)
+        {
+            old.categories[i].id = old_header.slot_ids[i];
+        }
+    }
+    else if (version == 3)
+    {
+        // Same header as now; only the amounts change
+        fseek(file, 0, SEEK_SET);
+        if (fread(&old.header, sizeof(MonthFileHeader), 1, file) == 1)
+        {
+            old.header.version = MONTH_FILE_VERSION;
+            res = read_old_sections(file, size, 3, &old);
+        }
+    }
+    else if (version == 4 || version == 5)
+    {
+        // Same header and amounts as now; only the records gain fields
+        fseek(file, 0, SEEK_SET);
+        if (fread(&old.header, sizeof(MonthFileHeader), 1, file) == 1)
+        {
+            old.header.version = MONTH_FILE_VERSION;
+            res = read_cents_sections(file, size, version, &old);
+        }
+    }
+    fclose(file);
+    if (res == -1)
+    {
+        fprintf(stderr, "Skipping %s: not a month file this version recognizes\n", path);
+    }
+    if (res > 0)
+    {
+        if (version < 3)
+        {
+            trim_unused_slots(&old);
+        }
+        res = write_old_month(path, &old);
+    }
+    free(old.categories);
+    free(old.transactions);
+    return res;
+}
+
+/*
+ * Must run before any month file is opened through the file cache
+ *
+ * Returns:
+ *   >=0   - Number of files migrated
+ *   -1    - Data directory unreadable
+ */
+int migrate_month_files(void)
+{
+    DIR *dir = opendir(data_storage_dir);
+    if (dir == NULL)
+    {
+        return -1;
+    }
+    int migrated = 0;
+    struct dirent *dir_entry;
+    while ((dir_entry = readdir(dir)) != NULL)
+    {
+        int year, month;
+        if (!parse_month_file_name(dir_entry->d_name, &year, &month))
+        {
+            continue;
+        }
+        char path[MAX_BUFFER + 288];
+        snprintf(path, sizeof(path), "%s/%s", data_storage_dir, dir_entry->d_name);
+        if (migrate_month_file(path, year, month) > 0)
+        {
+            migrated++;
+        }
+    }
+    closedir(dir);
+    return migrated;
+}
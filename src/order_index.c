@@ -0,0 +1,312 @@
+#include "order_index.h"
+
+int order_by_date(const Transaction *a, const Transaction *b)
+{
+    int res = strcmp(b->date, a->date);
+    if (res != 0)
+    {
+        return res;
+    }
+    return (a->id < b->id) - (a->id > b->id);
+}
+
+int order_by_amount(const Transaction *a, const Transaction *b)
+{
+    // Signed, so income sorts below every expense instead of among the largest charges
+    Money amount_a = a->expense ? a->amt : -a->amt;
+    Money amount_b = b->expense ? b->amt : -b->amt;
+    if (amount_a != amount_b)
+    {
+        return amount_a > amount_b ? -1 : 1;
+    }
+    return order_by_date(a, b);
+}
+
+static const char *category_name(const Transaction *transaction)
+{
+    const Category *category = category_of(transaction->cat_id);
+    return category != NULL ? category->name : "Uncategorized";
+}
+
+int order_by_category(const Transaction *a, const Transaction *b)
+{
+    int res = strcasecmp(category_name(a), category_name(b));
+    return res != 0 ? res : order_by_date(a, b);
+}
+
+int order_by_description(const Transaction *a, const Transaction *b)
+{
+    int res = strcasecmp(a->desc, b->desc);
+    return res != 0 ? res : order_by_date(a, b);
+}
+
+const char *sort_field_name(SortField field)
+{
+    switch (field)
+    {
+    case SORT_BY_AMOUNT:
+        return "Amount";
+    case SORT_BY_CATEGORY:
+        return "Category";
+    case SORT_BY_DESCRIPTION:
+        return "Description";
+    default:
+        return "Date";
+    }
+}
+
+// xorshift32; the priorities only need to look random to the tree shape
+static unsigned int next_priority(void)
+{
+    static unsigned int state = 2463534242u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static int subtree_size(const OrderNode *node)
+{
+    return node ? node->size : 0;
+}
+
+static void update_size(OrderNode *node)
+{
+    node->size = 1 + subtree_size(node->left) + subtree_size(node->right);
+}
+
+static OrderNode *rotate_right(OrderNode *node)
+{
+    OrderNode *left = node->left;
+    node->left = left->right;
+    left->right = node;
+    update_size(node);
+    update_size(left);
+    return left;
+}
+
+static OrderNode *rotate_left(OrderNode *node)
+{
+    OrderNode *right = node->right;
+    node->right = right->left;
+    right->left = node;
+    update_size(node);
+    update_size(right);
+    return right;
+}
+
+static OrderNode *insert_node(OrderCompare compare, OrderNode *root, OrderNode *node)
+{
+    if (root == NULL)
+    {
+        return node;
+    }
+    root->size++;
+    if (compare(&node->transaction->data, &root->transaction->data) < 0)
+    {
+        root->left = insert_node(compare, root->left, node);
+        if (root->left->priority > root->priority)
+        {
+            root = rotate_right(root);
+        }
+    }
+    else
+    {
+        root->right = insert_node(compare, root->right, node);
+        if (root->right->priority > root->priority)
+        {
+            root = rotate_left(root);
+        }
+    }
+    return root;
+}
+
+// Join two trees where everything in left sorts before everything in right
+static OrderNode *merge(OrderNode *left, OrderNode *right)
+{
+    if (left == NULL)
+    {
+        return right;
+    }
+    if (right == NULL)
+    {
+        return left;
+    }
+    if (left->priority > right->priority)
+    {
+        left->right = merge(left->right, right);
+        update_size(left);
+        return left;
+    }
+    right->left = merge(left, right->left);
+    update_size(right);
+    return right;
+}
+
+static OrderNode *remove_node(OrderCompare compare, OrderNode *root, const TransactionNode *transaction, bool *removed)
+{
+    if (root == NULL)
+    {
+        return NULL;
+    }
+    if (root->transaction == transaction)
+    {
+        OrderNode *rest = merge(root->left, root->right);
+        free(root);
+        *removed = true;
+        return rest;
+    }
+    if (compare(&transaction->data, &root->transaction->data) < 0)
+    {
+        root->left = remove_node(compare, root->left, transaction, removed);
+    }
+    else
+    {
+        root->right = remove_node(compare, root->right, transaction, removed);
+    }
+    if (*removed)
+    {
+        root->size--;
+    }
+    return root;
+}
+
+static void free_nodes(OrderNode *node)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+    free_nodes(node->left);
+    free_nodes(node->right);
+    free(node);
+}
+
+void order_index_init(OrderIndex *index, OrderCompare compare)
+{
+    index->compare = compare;
+    index->root = NULL;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error (the index is left empty)
+ */
+int order_index_build(OrderIndex *index, TransactionNode *head)
+{
+    order_index_free(index);
+    for (TransactionNode *node = head; node != NULL; node = node->next)
+    {
+        if (order_index_insert(index, node) < 0)
+        {
+            order_index_free(index);
+            return -2;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+int order_index_insert(OrderIndex *index, TransactionNode *transaction)
+{
+    OrderNode *node = malloc(sizeof(OrderNode));
+    if (node == NULL)
+    {
+        return -2;
+    }
+    node->transaction = transaction;
+    node->left = NULL;
+    node->right = NULL;
+    node->priority = next_priority();
+    node->size = 1;
+    index->root = insert_node(index->compare, index->root, node);
+    return 1;
+}
+
+bool order_index_remove(OrderIndex *index, const TransactionNode *transaction)
+{
+    bool removed = false;
+    index->root = remove_node(index->compare, index->root, transaction, &removed);
+    return removed;
+}
+
+TransactionNode *order_index_at(const OrderIndex *index, int row)
+{
+    const OrderNode *node = index->root;
+    while (node != NULL)
+    {
+        int left_size = subtree_size(node->left);
+        if (row < left_size)
+        {
+            node = node->left;
+        }
+        else if (row == left_size)
+        {
+            return node->transaction;
+        }
+        else
+        {
+            row -= left_size + 1;
+            node = node->right;
+        }
+    }
+    return NULL;
+}
+
+int order_index_rank(const OrderIndex *index, const TransactionNode *transaction)
+{
+    int rank = 0;
+    const OrderNode *node = index->root;
+    while (node != NULL)
+    {
+        if (node->transaction == transaction)
+        {
+            return rank + subtree_size(node->left);
+        }
+        if (index->compare(&transaction->data, &node->transaction->data) < 0)
+        {
+            node = node->left;
+        }
+        else
+        {
+            rank += subtree_size(node->left) + 1;
+            node = node->right;
+        }
+    }
+    return -1;
+}
+
+int order_index_lower_bound(const OrderIndex *index, const Transaction *probe)
+{
+    int rank = 0;
+    const OrderNode *node = index->root;
+    while (node != NULL)
+    {
+        if (index->compare(&node->transaction->data, probe) < 0)
+        {
+            rank += subtree_size(node->left) + 1;
+            node = node->right;
+        }
+        else
+        {
+            node = node->left;
+        }
+    }
+    return rank;
+}
+
+int order_index_count(const OrderIndex *index)
+{
+    return subtree_size(index->root);
+}
+
+void order_index_free(OrderIndex *index)
+{
+    free_nodes(index->root);
+    index->root = NULL;
+}
@@ -4,6 +4,14 @@
 
 void init_pie_chart_colors()
 {
+    // Redefining a pair that is on screen makes curses repaint every cell using it
+    static bool initialized = false;
+    if (initialized)
+    {
+        return;
+    }
+    initialized = true;
+
     // Initialize color pairs for the pie chart - normal colors
     for (int i = 0; i < (int)NUM_PIE_COLORS; i++)
     {
@@ -27,7 +35,63 @@ static bool is_point_in_slice(double angle, double start_angle, double end_angle
     return (angle >= start_angle && angle <= end_angle);
 }
 
-// Get the appropriate character and determine which color pair to use based on distance from center
+// Get the color pair of the pie cell at (y, x), or 0 if the cell is outside the ellipse
+static int pie_cell_color(int y, int x, int center_y, int center_x, double x_radius, double y_radius, double tilt, PieSlice slices[], int slice_count)
+{
+    // Calculate normalized coordinates relative to center
+    double dx = (double)(x - center_x);
+    double dy = (double)(y - center_y);
+
+    // Normalized coordinates for quadrant determination (-1 to 1 range)
+    double norm_x = dx / x_radius;
+    double norm_y = dy / y_radius;
+
+    // Calculate if point is within the ellipse
+    // Formula: (x/a)² + (y/b)² <= 1
+    if ((dx * dx) / (x_radius * x_radius) + (dy * dy) / (y_radius * y_radius) > 1.0)
+    {
+        return 0;
+    }
+
+    // Convert 2D ellipse coordinates to 3D circle coordinates with perspective tilt
+    // First, calculate the angle on the ellipse
+    double ellipse_angle = atan2(dy, dx);
+
+    // Calculate the radial distance from center (0-1 range)
+    double distance = sqrt(norm_x * norm_x + norm_y * norm_y);
+
+    // Adjust the angle based on the 3D perspective effect
+    // The adjustment is stronger at the edges and diminishes toward the center
+    double perspective_factor = sin(ellipse_angle) * sin(tilt) * (distance * 0.5);
+
+    // Calculate the final 3D-adjusted angle
+    double angle = atan2(dy / y_radius, (dx / x_radius) - perspective_factor) * 180.0 / PI;
+    if (angle < 0)
+        angle += 360.0;
+
+    // Find which slice this point belongs to
+    double slice_start = 0.0;
+    for (int i = 0; i < slice_count; i++)
+    {
+        double slice_angle = (slices[i].percentage / 100.0) * 360.0;
+        double slice_end = slice_start + slice_angle;
+
+        if (is_point_in_slice(angle, slice_start, slice_end))
+        {
+            // Determine if we should use the darker character variant
+            // for bottom portion of the pie chart (shadow effect)
+            bool use_darker = (sqrt(norm_x * norm_x * 0.6 + norm_y * norm_y) > 0.78 && dy > 0) || i == slice_count - 1;
+
+            int color = slices[i].color_pair;
+            return use_darker ? color : color - NUM_PIE_COLORS;
+        }
+
+        slice_start = slice_end;
+    }
+
+    // If not in any slice (rounding errors), use the last slice color
+    return slice_count > 0 ? slices[slice_count - 1].color_pair : 0;
+}
 
 void draw_pie_chart(WINDOW *win, int center_y, int center_x, double height, double width, PieSlice slices[], int slice_count)
 {
@@ -37,81 +101,31 @@ void draw_pie_chart(WINDOW *win, int center_y, int center_x, double height, doub
     double y_radius = height / 2; // Vertical radius (shorter for perspective)
     double tilt = atan(y_radius / x_radius);
 
-    // For each position in a rectangular area around the center
+    // Cells are emitted as runs of one color pair so each row costs one attribute
+    // switch per slice boundary instead of one per cell
     for (int y = center_y - y_radius; y <= center_y + y_radius; y++)
     {
-        for (int x = center_x - x_radius; x <= center_x + x_radius; x++)
+        int run_start = 0, run_color = 0;
+        int x_end = center_x + x_radius;
+        for (int x = center_x - x_radius; x <= x_end + 1; x++)
         {
-            // Calculate normalized coordinates relative to center
-            double dx = (double)(x - center_x);
-            double dy = (double)(y - center_y);
-
-            // Normalized coordinates for quadrant determination (-1 to 1 range)
-            double norm_x = dx / x_radius;
-            double norm_y = dy / y_radius;
-
-            // Calculate if point is within the ellipse
-            // Formula: (x/a)² + (y/b)² <= 1
-            if ((dx * dx) / (x_radius * x_radius) + (dy * dy) / (y_radius * y_radius) <= 1.0)
+            int color = x <= x_end ? pie_cell_color(y, x, center_y, center_x, x_radius, y_radius, tilt, slices, slice_count) : 0;
+            if (color == run_color)
+            {
+                continue;
+            }
+            if (run_color != 0)
             {
-                // Convert 2D ellipse coordinates to 3D circle coordinates with perspective tilt
-                // First, calculate the angle on the ellipse
-                double ellipse_angle = atan2(dy, dx);
-
-                // Calculate the radial distance from center (0-1 range)
-                double distance = sqrt(norm_x * norm_x + norm_y * norm_y);
-
-                // Adjust the angle based on the 3D perspective effect
-                // The adjustment is stronger at the edges and diminishes toward the center
-                double perspective_factor = sin(ellipse_angle) * sin(tilt) * (distance * 0.5);
-
-                // Calculate the final 3D-adjusted angle
-                double angle = atan2(dy / y_radius, (dx / x_radius) - perspective_factor) * 180.0 / PI;
-                if (angle < 0)
-                    angle += 360.0;
-
-                // Find which slice this point belongs to
-                double slice_start = 0.0;
-                bool found = false;
-
-                for (int i = 0; i < slice_count; i++)
-                {
-                    double slice_angle = (slices[i].percentage / 100.0) * 360.0;
-                    double slice_end = slice_start + slice_angle;
-
-                    if (is_point_in_slice(angle, slice_start, slice_end))
-                    {
-                        // Determine if we should use the darker character variant
-                        // for bottom portion of the pie chart (shadow effect)
-                        bool use_darker = (sqrt(norm_x * norm_x * 0.6 + norm_y * norm_y) > 0.78 && dy > 0) || i == slice_count - 1;
-
-                        int color = slices[i].color_pair;
-
-                        wattron(win, COLOR_PAIR(use_darker ? color : color - NUM_PIE_COLORS));
-                        mvwaddch(win, y, x, ' ');
-                        wattroff(win, COLOR_PAIR(use_darker ? color : color - NUM_PIE_COLORS));
-                        found = true;
-                        break;
-                    }
-
-                    slice_start = slice_end;
-                }
-
-                // If not in any slice (rounding errors), use the last slice color
-                if (!found && slice_count > 0)
-                {
-                    int color = slices[slice_count - 1].color_pair;
-
-                    wattron(win, COLOR_PAIR(color));
-                    mvwaddch(win, y, x, ' ');
-                    wattroff(win, COLOR_PAIR(color));
-                }
+                mvwhline(win, y, run_start, ' ' | COLOR_PAIR(run_color), x - run_start);
             }
+            run_start = x;
+            run_color = color;
         }
     }
 }
 
-void display_budget_pie_chart(WINDOW *win, double width, double height)
+// Slices follow the rows display_categories shows at the same level, colored to match
+void display_budget_pie_chart(WINDOW *win, double width, double height, bool top_level)
 {
     int max_y, max_x;
     getmaxyx(win, max_y, max_x);
@@ -131,29 +145,33 @@ void display_budget_pie_chart(WINDOW *win, double width, double height)
 
     PieSlice slices[NUM_PIE_COLORS] = {0};
     int slice_count = 0;
-    double used_budget = 0.0;
+    Money used_budget = 0;
 
-    for (int i = 0; i < category_count; i++)
+    int *rows = malloc(category_count * sizeof(int));
+    int row_count = rows != NULL ? category_display_order(rows, top_level) : 0;
+    for (int i = 0; i < row_count; i++)
     {
-        if (categories[sorted_categories_indices[i]].budget > 0)
+        Money budget = category_figures(rows[i], top_level).budget;
+        if (budget > 0)
         {
-            used_budget += categories[sorted_categories_indices[i]].budget;
+            used_budget += budget;
             if (i >= NUM_PIE_COLORS - 1)
             {
                 strcpy(slices[slice_count - 1].label, "Other");
-                slices[slice_count - 1].percentage += (categories[sorted_categories_indices[i]].budget / current_month_total_budget) * 100.0;
+                slices[slice_count - 1].percentage += 100.0 * budget / current_month_total_budget;
             }
             else
             {
-                slices[slice_count].percentage = (categories[sorted_categories_indices[i]].budget / current_month_total_budget) * 100.0;
+                slices[slice_count].percentage = 100.0 * budget / current_month_total_budget;
                 slices[slice_count].color_pair = PIE_DARKER_COLOR_START + i;
-                strncpy(slices[slice_count].label, categories[sorted_categories_indices[i]].name, MAX_NAME_LEN - 1);
+                strncpy(slices[slice_count].label, categories[rows[i]].name, MAX_NAME_LEN - 1);
                 slices[slice_count].label[MAX_NAME_LEN - 1] = '\0';
                 slice_count++;
             }
         }
     }
-    slices[slice_count].percentage = 100.0 - used_budget;
+    free(rows);
+    slices[slice_count].percentage = 100.0 * (current_month_total_budget - used_budget) / current_month_total_budget;
     slices[slice_count].color_pair = PIE_DARKER_COLOR_START + NUM_PIE_COLORS - 1;
     strncpy(slices[slice_count].label, "Savings", MAX_NAME_LEN - 1);
     slices[slice_count].label[MAX_NAME_LEN - 1] = '\0';
@@ -0,0 +1,406 @@
+#include "query.h"
+
+// Open-addressed table of partial aggregates keyed by group name
+typedef struct
+{
+    QueryGroup *slots;
+    int capacity;
+    int count;
+} QueryTable;
+
+typedef struct
+{
+    int year;
+    int month;
+    unsigned long long *tag_matches; // slots passing the tag filters, NULL without them
+    int slot_count;                  // slots the bitmap covers
+} QueryMonth;
+
+// Shared between the workers of one query; next_month is handed out under lock
+typedef struct
+{
+    const Query *query;
+    const QueryMonth *months;
+    int month_count;
+    int next_month;
+    int error;
+    pthread_mutex_t lock;
+} QueryJob;
+
+typedef struct
+{
+    pthread_t thread;
+    QueryJob *job;
+    QueryTable table;
+    int months_scanned;
+} QueryWorker;
+
+static unsigned long hash_key(const char *key)
+{
+    // FNV-1a
+    unsigned long hash = 2166136261u;
+    for (; *key; key++)
+    {
+        hash ^= (unsigned char)*key;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int table_init(QueryTable *table, int capacity)
+{
+    table->slots = calloc(capacity, sizeof(QueryGroup));
+    table->capacity = capacity;
+    table->count = 0;
+    return table->slots ? 0 : -1;
+}
+
+// Empty keys are valid (ungrouped totals), so a slot is free when its count is 0
+static QueryGroup *table_slot(QueryTable *table, const char *key)
+{
+    int i = hash_key(key) & (table->capacity - 1);
+    while (table->slots[i].count != 0 && strcmp(table->slots[i].key, key) != 0)
+    {
+        i = (i + 1) & (table->capacity - 1);
+    }
+    return &table->slots[i];
+}
+
+static int table_add(QueryTable *table, const char *key, int count, Money sum)
+{
+    if ((table->count + 1) * 10 > table->capacity * 7)
+    {
+        QueryTable grown;
+        if (table_init(&grown, table->capacity * 2) < 0)
+        {
+            return -1;
+        }
+        for (int i = 0; i < table->capacity; i++)
+        {
+            if (table->slots[i].count != 0)
+            {
+                *table_slot(&grown, table->slots[i].key) = table->slots[i];
+                grown.count++;
+            }
+        }
+        free(table->slots);
+        *table = grown;
+    }
+
+    QueryGroup *group = table_slot(table, key);
+    if (group->count == 0)
+    {
+        strncpy(group->key, key, MAX_NAME_LEN - 1);
+        table->count++;
+    }
+    group->count += count;
+    group->sum += sum;
+    return 0;
+}
+
+// Aggregate one month into the worker's own table; no locking needed
+static int scan_month(QueryWorker *worker, const QueryMonth *month)
+{
+    const Query *query = worker->job->query;
+    MonthSnapshot snapshot;
+    int res = read_month_snapshot(month->year, month->month, &snapshot);
+    if (res <= 0)
+    {
+        return res;
+    }
+
+    // Category names map to different slots from month to month
+    int category_filter = -1;
+    if (query->has_category && query->category[0] != '\0')
+    {
+        category_filter = -2;
+        for (int i = 0; i < snapshot.category_slots; i++)
+        {
+            if (snapshot.categories[i].budget > 0 && strcmp(snapshot.categories[i].name, query->category) == 0)
+            {
+                category_filter = i;
+                break;
+            }
+        }
+        if (category_filter == -2)
+        {
+            free_month_snapshot(&snapshot);
+            return 1; // category doesn't exist this month
+        }
+    }
+    CategoryMap map = {NULL, 0};
+    if (category_map_build(&map, &snapshot.category_ids, snapshot.categories, snapshot.category_slots) < 0)
+    {
+        free_month_snapshot(&snapshot);
+        return -2;
+    }
+
+    char month_key[MAX_NAME_LEN];
+    snprintf(month_key, sizeof(month_key), "%04d-%02d", month->year, month->month);
+
+    for (int i = 0; i < snapshot.transaction_count; i++)
+    {
+        if (month->tag_matches != NULL &&
+            (i >= month->slot_count || !(month->tag_matches[i / 64] >> (i % 64) & 1)))
+        {
+            continue;
+        }
+        const Transaction *tx = &snapshot.transactions[i];
+        Money amount = tx->expense ? tx->amt : -tx->amt;
+        int slot = category_map_slot(&map, tx->cat_id);
+
+        if ((query->kind == QUERY_EXPENSES && !tx->expense) ||
+            (query->kind == QUERY_INCOME && tx->expense) ||
+            (query->has_category && slot != category_filter) ||
+            (query->from_date[0] && strcmp(tx->date, query->from_date) < 0) ||
+            (query->to_date[0] && strcmp(tx->date, query->to_date) > 0) ||
+            (query->has_min_amount && amount < query->min_amount) ||
+            (query->has_max_amount && amount > query->max_amount) ||
+            (query->match[0] && !contains_ignore_case(tx->desc, query->match)))
+        {
+            continue;
+        }
+
+        const char *key = "";
+        switch (query->group_by)
+        {
+        case QUERY_GROUP_NONE:
+            break;
+        case QUERY_GROUP_MONTH:
+            key = month_key;
+            break;
+        case QUERY_GROUP_CATEGORY:
+            key = slot >= 0 ? snapshot.categories[slot].name : "Uncategorized";
+            break;
+        case QUERY_GROUP_PAYEE:
+            key = tx->desc;
+            break;
+        }
+        if (table_add(&worker->table, key, 1, amount) < 0)
+        {
+            category_map_free(&map);
+            free_month_snapshot(&snapshot);
+            return -2;
+        }
+    }
+    category_map_free(&map);
+    free_month_snapshot(&snapshot);
+    return 1;
+}
+
+static void *query_worker(void *arg)
+{
+    QueryWorker *worker = arg;
+    QueryJob *job = worker->job;
+    while (1)
+    {
+        pthread_mutex_lock(&job->lock);
+        int index = job->error == 0 ? job->next_month++ : job->month_count;
+        pthread_mutex_unlock(&job->lock);
+        if (index >= job->month_count)
+        {
+            break;
+        }
+
+        int res = scan_month(worker, &job->months[index]);
+        if (res < 0)
+        {
+            pthread_mutex_lock(&job->lock);
+            job->error = res;
+            pthread_mutex_unlock(&job->lock);
+            break;
+        }
+        worker->months_scanned += res;
+    }
+    return NULL;
+}
+
+static bool month_in_range(int year, int month, const Query *query)
+{
+    char month_start[11], month_end[11];
+    snprintf(month_start, sizeof(month_start), "%04u-%02u-01", (unsigned)year % 10000, (unsigned)month % 100);
+    snprintf(month_end, sizeof(month_end), "%04u-%02u-31", (unsigned)year % 10000, (unsigned)month % 100);
+    return (!query->from_date[0] || strcmp(month_end, query->from_date) >= 0) &&
+           (!query->to_date[0] || strcmp(month_start, query->to_date) <= 0);
+}
+
+static void free_months(QueryMonth *months, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        free(months[i].tag_matches);
+    }
+    free(months);
+}
+
+/*
+ * Collect the months with transactions in the query's range from the manifest. Tag
+ * filters are resolved here from each month's tag bitmaps, on the main thread since
+ * a stale index is rebuilt, and months where nothing matches are left out.
+ */
+static int list_months(const Query *query, QueryMonth **out_months)
+{
+    int entry_count;
+    const ManifestEntry *entries = manifest_entries(&entry_count);
+    QueryMonth *months = malloc((entry_count > 0 ? entry_count : 1) * sizeof(QueryMonth));
+    if (months == NULL)
+    {
+        return -2;
+    }
+
+    int count = 0;
+    for (int i = 0; i < entry_count; i++)
+    {
+        if (entries[i].transaction_count > 0 && month_in_range(entries[i].year, entries[i].month, query))
+        {
+            months[count].year = entries[i].year;
+            months[count].month = entries[i].month;
+            months[count].tag_matches = NULL;
+            months[count].slot_count = entries[i].transaction_count;
+            if (query->all_tags != 0 || query->no_tags != 0)
+            {
+                int matches = tag_index_match(&entries[i], query->all_tags, query->no_tags, &months[count].tag_matches);
+                if (matches < 0)
+                {
+                    free_months(months, count);
+                    return matches;
+                }
+                if (matches == 0)
+                {
+                    free(months[count].tag_matches);
+                    continue;
+                }
+            }
+            count++;
+        }
+    }
+    *out_months = months;
+    return count;
+}
+
+static int compare_groups_by_key(const void *a, const void *b)
+{
+    return strcmp(((const QueryGroup *)a)->key, ((const QueryGroup *)b)->key);
+}
+
+static int compare_groups_by_sum(const void *a, const void *b)
+{
+    Money sum_a = ((const QueryGroup *)a)->sum, sum_b = ((const QueryGroup *)b)->sum;
+    if (sum_a != sum_b)
+    {
+        return sum_a < sum_b ? 1 : -1;
+    }
+    return compare_groups_by_key(a, b);
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ *   -3    - Could not start worker threads
+ */
+int run_query(const Query *query, QueryResult *result)
+{
+    memset(result, 0, sizeof(QueryResult));
+    QueryMonth *months;
+    int month_count = list_months(query, &months);
+    if (month_count < 0)
+    {
+        return month_count;
+    }
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int thread_count = cores < 1 ? 1 : cores > MAX_QUERY_THREADS ? MAX_QUERY_THREADS
+                                                                  : (int)cores;
+    if (thread_count > month_count)
+    {
+        thread_count = month_count > 0 ? month_count : 1;
+    }
+
+    QueryJob job = {
+        .query = query,
+        .months = months,
+        .month_count = month_count,
+        .next_month = 0,
+        .error = 0};
+    pthread_mutex_init(&job.lock, NULL);
+
+    QueryWorker workers[MAX_QUERY_THREADS];
+    int started = 0, status = 1;
+    for (int i = 0; i < thread_count; i++)
+    {
+        workers[i].job = &job;
+        workers[i].months_scanned = 0;
+        if (table_init(&workers[i].table, 64) < 0)
+        {
+            status = -2;
+            break;
+        }
+        if (pthread_create(&workers[i].thread, NULL, query_worker, &workers[i]) != 0)
+        {
+            free(workers[i].table.slots);
+            status = started == 0 ? -3 : status;
+            break;
+        }
+        started++;
+    }
+
+    // Merge the partial aggregates as workers finish
+    QueryTable merged = {0};
+    if (table_init(&merged, 64) < 0)
+    {
+        status = -2;
+    }
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        result->months_scanned += workers[i].months_scanned;
+        for (int j = 0; j < workers[i].table.capacity && merged.slots; j++)
+        {
+            QueryGroup *group = &workers[i].table.slots[j];
+            if (group->count != 0 && table_add(&merged, group->key, group->count, group->sum) < 0)
+            {
+                status = -2;
+            }
+        }
+        free(workers[i].table.slots);
+    }
+    pthread_mutex_destroy(&job.lock);
+    free_months(months, month_count);
+    if (job.error < 0 && status == 1)
+    {
+        status = job.error;
+    }
+    if (status < 0)
+    {
+        free(merged.slots);
+        return status;
+    }
+
+    // Flatten into a sorted array
+    result->groups = malloc((merged.count > 0 ? merged.count : 1) * sizeof(QueryGroup));
+    if (result->groups == NULL)
+    {
+        free(merged.slots);
+        return -2;
+    }
+    for (int i = 0; i < merged.capacity; i++)
+    {
+        if (merged.slots[i].count != 0)
+        {
+            result->groups[result->group_count++] = merged.slots[i];
+        }
+    }
+    free(merged.slots);
+    qsort(result->groups, result->group_count, sizeof(QueryGroup),
+          query->group_by == QUERY_GROUP_MONTH || query->group_by == QUERY_GROUP_NONE ? compare_groups_by_key : compare_groups_by_sum);
+    return 1;
+}
+
+void free_query_result(QueryResult *result)
+{
+    free(result->groups);
+    result->groups = NULL;
+    result->group_count = 0;
+}
@@ -0,0 +1,225 @@
+#include "range_view.h"
+#include "saveload.h"
+
+static int compare_rows_newest_first(const void *a, const void *b)
+{
+    return strcmp(((const Transaction *)b)->date, ((const Transaction *)a)->date);
+}
+
+static const char *run_head_date(const RangeView *view, int run)
+{
+    return view->runs[run].rows[view->runs[run].next].date;
+}
+
+static bool heap_before(const RangeView *view, int a, int b)
+{
+    int cmp = strcmp(run_head_date(view, a), run_head_date(view, b));
+    return cmp > 0 || (cmp == 0 && a > b); // later months first on equal dates
+}
+
+static void heap_sift_down(RangeView *view, int i)
+{
+    while (1)
+    {
+        int best = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < view->heap_size && heap_before(view, view->heap[left], view->heap[best]))
+            best = left;
+        if (right < view->heap_size && heap_before(view, view->heap[right], view->heap[best]))
+            best = right;
+        if (best == i)
+            return;
+        int tmp = view->heap[i];
+        view->heap[i] = view->heap[best];
+        view->heap[best] = tmp;
+        i = best;
+    }
+}
+
+// Restart the merge from the newest row
+static void reset_merge(RangeView *view)
+{
+    view->heap_size = 0;
+    for (int i = 0; i < view->run_count; i++)
+    {
+        view->runs[i].next = 0;
+        if (view->runs[i].count > 0)
+        {
+            view->heap[view->heap_size++] = i;
+        }
+    }
+    for (int i = view->heap_size / 2 - 1; i >= 0; i--)
+    {
+        heap_sift_down(view, i);
+    }
+    view->position = 0;
+}
+
+// Take the next row of the merged stream
+static bool merge_next(RangeView *view, RangeRow *row)
+{
+    if (view->heap_size == 0)
+    {
+        return false;
+    }
+    RangeRun *run = &view->runs[view->heap[0]];
+    const Transaction *tx = &run->rows[run->next++];
+    if (row != NULL)
+    {
+        row->transaction = tx;
+        int slot = category_map_slot(&run->category_map, tx->cat_id);
+        row->category = slot >= 0 ? run->categories[slot].name : "Uncategorized";
+    }
+    if (run->next == run->count)
+    {
+        view->heap[0] = view->heap[--view->heap_size];
+    }
+    heap_sift_down(view, 0);
+    view->position++;
+    return true;
+}
+
+/*
+ * Read and sort every month overlapping the range
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int range_view_open(RangeView *view, const char *from_date, const char *to_date)
+{
+    memset(view, 0, sizeof(RangeView));
+    strncpy(view->from_date, from_date, sizeof(view->from_date) - 1);
+    strncpy(view->to_date, to_date, sizeof(view->to_date) - 1);
+    view->generation = manifest_generation();
+
+    int entry_count;
+    const ManifestEntry *entries = manifest_entries(&entry_count);
+    view->runs = calloc(entry_count > 0 ? entry_count : 1, sizeof(RangeRun));
+    view->heap = malloc((entry_count > 0 ? entry_count : 1) * sizeof(int));
+    if (view->runs == NULL || view->heap == NULL)
+    {
+        range_view_close(view);
+        return -2;
+    }
+
+    for (int i = 0; i < entry_count; i++)
+    {
+        char month_start[11], month_end[11];
+        snprintf(month_start, sizeof(month_start), "%04u-%02u-01", (unsigned)entries[i].year % 10000, (unsigned)entries[i].month % 100);
+        snprintf(month_end, sizeof(month_end), "%04u-%02u-31", (unsigned)entries[i].year % 10000, (unsigned)entries[i].month % 100);
+        if (entries[i].transaction_count == 0 || strcmp(month_end, from_date) < 0 || strcmp(month_start, to_date) > 0)
+        {
+            continue;
+        }
+
+        MonthSnapshot snapshot;
+        int res = read_month_snapshot(entries[i].year, entries[i].month, &snapshot);
+        if (res < 0)
+        {
+            range_view_close(view);
+            return res;
+        }
+
+        // Keep only the rows inside the range; boundary months are partial
+        RangeRun *run = &view->runs[view->run_count++];
+        run->rows = snapshot.transactions;
+        run->count = 0;
+        for (int j = 0; j < snapshot.transaction_count; j++)
+        {
+            if (strcmp(snapshot.transactions[j].date, from_date) >= 0 && strcmp(snapshot.transactions[j].date, to_date) <= 0)
+            {
+                run->rows[run->count++] = snapshot.transactions[j];
+            }
+        }
+        qsort(run->rows, run->count, sizeof(Transaction), compare_rows_newest_first);
+        run->categories = snapshot.categories;
+        if (category_map_build(&run->category_map, &snapshot.category_ids, run->categories, snapshot.category_slots) < 0)
+        {
+            range_view_close(view);
+            return -2;
+        }
+        view->total_count += run->count;
+    }
+
+    reset_merge(view);
+    return 1;
+}
+
+void range_view_close(RangeView *view)
+{
+    for (int i = 0; i < view->run_count; i++)
+    {
+        free(view->runs[i].rows);
+        free(view->runs[i].categories);
+        category_map_free(&view->runs[i].category_map);
+    }
+    free(view->runs);
+    free(view->heap);
+    memset(view, 0, sizeof(RangeView));
+}
+
+int range_view_window(RangeView *view, int first, int count, RangeRow *out)
+{
+    // Scrolling down continues the merge; anything earlier restarts it
+    if (first < view->position)
+    {
+        reset_merge(view);
+    }
+    while (view->position < first && merge_next(view, NULL))
+        ;
+
+    int copied = 0;
+    while (copied < count && merge_next(view, &out[copied]))
+    {
+        copied++;
+    }
+    return copied;
+}
+
+bool range_view_stale(const RangeView *view)
+{
+    return view->generation != manifest_generation();
+}
+
+void history_range_dates(HistoryRange range, int year, int month, char *from_date, char *to_date)
+{
+    switch (range)
+    {
+    case HISTORY_LAST_90_DAYS:
+    {
+        time_t now = time(NULL);
+        struct tm today = *localtime(&now);
+        struct tm start = today;
+        start.tm_mday -= 89;
+        mktime(&start); // normalize across month and year boundaries
+        strftime(from_date, 11, "%Y-%m-%d", &start);
+        strftime(to_date, 11, "%Y-%m-%d", &today);
+        break;
+    }
+    case HISTORY_QUARTER:
+    {
+        int first_month = (month - 1) / 3 * 3 + 1;
+        snprintf(from_date, 11, "%04u-%02u-01", (unsigned)year % 10000, (unsigned)first_month % 100);
+        snprintf(to_date, 11, "%04u-%02u-31", (unsigned)year % 10000, (unsigned)(first_month + 2) % 100);
+        break;
+    }
+    default:
+        snprintf(from_date, 11, "%04u-%02u-01", (unsigned)year % 10000, (unsigned)month % 100);
+        snprintf(to_date, 11, "%04u-%02u-31", (unsigned)year % 10000, (unsigned)month % 100);
+        break;
+    }
+}
+
+const char *history_range_name(HistoryRange range)
+{
+    switch (range)
+    {
+    case HISTORY_LAST_90_DAYS:
+        return "Last 90 Days";
+    case HISTORY_QUARTER:
+        return "Quarter";
+    default:
+        return "Month";
+    }
+}
@@ -0,0 +1,385 @@
+#include "recurring.h"
+
+#define RECURRING_KEY_LEN (MAX_NAME_LEN + 16)
+
+typedef struct
+{
+    char key[RECURRING_KEY_LEN]; // normalized description, kind and amount bucket
+    bool used;
+    Transaction latest;          // most recent occurrence
+    char category[MAX_NAME_LEN]; // of the most recent occurrence, "" if uncategorized
+    int *days;                   // day numbers of every occurrence
+    int day_count;
+    int day_capacity;
+} RecurringGroup;
+
+// Open-addressed, like the query tables
+typedef struct
+{
+    RecurringGroup *slots;
+    int capacity;
+    int count;
+} RecurringTable;
+
+static void normalize(const char *desc, char *out, size_t size)
+{
+    size_t len = 0;
+    for (size_t i = 0; desc[i] != '\0' && len + 1 < size; i++)
+    {
+        if (isalnum((unsigned char)desc[i]))
+        {
+            out[len++] = tolower((unsigned char)desc[i]);
+        }
+    }
+    out[len] = '\0';
+}
+
+static unsigned long hash_key(const char *key)
+{
+    // FNV-1a
+    unsigned long hash = 2166136261u;
+    for (; *key; key++)
+    {
+        hash ^= (unsigned char)*key;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static RecurringGroup *table_slot(RecurringTable *table, const char *key)
+{
+    int i = hash_key(key) & (table->capacity - 1);
+    while (table->slots[i].used && strcmp(table->slots[i].key, key) != 0)
+    {
+        i = (i + 1) & (table->capacity - 1);
+    }
+    return &table->slots[i];
+}
+
+static int table_grow(RecurringTable *table)
+{
+    RecurringTable grown = {calloc(table->capacity * 2, sizeof(RecurringGroup)), table->capacity * 2, table->count};
+    if (grown.slots == NULL)
+    {
+        return -2;
+    }
+    for (int i = 0; i < table->capacity; i++)
+    {
+        if (table->slots[i].used)
+        {
+            *table_slot(&grown, table->slots[i].key) = table->slots[i];
+        }
+    }
+    free(table->slots);
+    *table = grown;
+    return 1;
+}
+
+static void table_free(RecurringTable *table)
+{
+    for (int i = 0; i < table->capacity; i++)
+    {
+        free(table->slots[i].days);
+    }
+    free(table->slots);
+}
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar
+static int day_number(const char *date)
+{
+    int year, month, day;
+    if (sscanf(date, "%d-%d-%d", &year, &month, &day) != 3)
+    {
+        return 0;
+    }
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era = year - era * 400;
+    int day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+static int weekday(int day)
+{
+    return ((day + 4) % 7 + 7) % 7; // 1970-01-01 was a Thursday; 0 is Sunday
+}
+
+// Add one transaction to its group
+static int add_occurrence(RecurringTable *table, const Transaction *tx, const char *category)
+{
+    char name[MAX_NAME_LEN];
+    normalize(tx->desc, name, sizeof(name));
+    if (name[0] == '\0' || tx->amt <= 0)
+    {
+        return 1;
+    }
+    if ((table->count + 1) * 10 > table->capacity * 7 && table_grow(table) < 0)
+    {
+        return -2;
+    }
+    // An amount near a bucket edge joins the group already started next to it
+    char key[RECURRING_KEY_LEN];
+    int bucket = (int)floor(log((double)tx->amt) / log(RECURRING_BUCKET_STEP));
+    static const int offsets[] = {0, -1, 1};
+    RecurringGroup *group = NULL;
+    for (int i = 0; i < 3 && (group == NULL || !group->used); i++)
+    {
+        snprintf(key, sizeof(key), "%s|%c%d", name, tx->expense ? 'e' : 'i', bucket + offsets[i]);
+        group = table_slot(table, key);
+    }
+    if (!group->used)
+    {
+        snprintf(key, sizeof(key), "%s|%c%d", name, tx->expense ? 'e' : 'i', bucket);
+        group = table_slot(table, key);
+    }
+    if (!group->used)
+    {
+        group->used = true;
+        strcpy(group->key, key);
+        table->count++;
+    }
+    if (group->day_count == group->day_capacity)
+    {
+        int new_capacity = group->day_capacity > 0 ? group->day_capacity * 2 : 8;
+        int *grown = realloc(group->days, new_capacity * sizeof(int));
+        if (grown == NULL)
+        {
+            return -2;
+        }
+        group->days = grown;
+        group->day_capacity = new_capacity;
+    }
+    group->days[group->day_count++] = day_number(tx->date);
+    if (group->day_count == 1 || strcmp(tx->date, group->latest.date) >= 0)
+    {
+        group->latest = *tx;
+        strcpy(group->category, category);
+    }
+    return 1;
+}
+
+static int compare_ints(const void *a, const void *b)
+{
+    int int_a = *(const int *)a, int_b = *(const int *)b;
+    return int_a < int_b ? -1 : int_a > int_b;
+}
+
+// Whether enough of the gaps fall within [low, high]
+static bool gaps_fit(const int *gaps, int gap_count, int low, int high)
+{
+    int fitting = 0;
+    for (int i = 0; i < gap_count; i++)
+    {
+        fitting += gaps[i] >= low && gaps[i] <= high;
+    }
+    return fitting >= 2 && fitting >= gap_count * RECURRING_MIN_MATCHING;
+}
+
+/*
+ * Find the period of a group's sorted, same-day-merged occurrences
+ *
+ * Returns:
+ *   true  - *out_type is a PERIOD_* and *out_days its length in days
+ *   false - No steady period
+ */
+static bool find_period(const int *days, int day_count, int *out_type, int *out_days)
+{
+    int gap_count = day_count - 1;
+    int *gaps = malloc((gap_count > 0 ? gap_count : 1) * sizeof(int));
+    if (gaps == NULL)
+    {
+        return false;
+    }
+    for (int i = 0; i < gap_count; i++)
+    {
+        gaps[i] = days[i + 1] - days[i];
+    }
+    bool found = true;
+    if (gaps_fit(gaps, gap_count, 6, 8))
+    {
+        *out_type = PERIOD_WEEKLY;
+        *out_days = 7;
+    }
+    else if (gaps_fit(gaps, gap_count, 27, 34))
+    {
+        *out_type = PERIOD_MONTHLY;
+        *out_days = 31;
+    }
+    else if (gaps_fit(gaps, gap_count, 358, 372))
+    {
+        *out_type = PERIOD_YEARLY;
+        *out_days = 366;
+    }
+    else
+    {
+        // Any other steady gap, within 10% of the median
+        qsort(gaps, gap_count, sizeof(int), compare_ints);
+        int median = gaps[gap_count / 2];
+        int tolerance = median / 10 > 1 ? median / 10 : 1;
+        *out_type = PERIOD_CUSTOM_DAYS;
+        *out_days = median;
+        found = median >= 2 && median <= 365 && gaps_fit(gaps, gap_count, median - tolerance, median + tolerance);
+    }
+    free(gaps);
+    return found;
+}
+
+static bool has_subscription(const char *name, bool expense)
+{
+    for (int i = 0; i < subscription_count; i++)
+    {
+        char existing[MAX_NAME_LEN];
+        normalize(subscriptions[i].name, existing, sizeof(existing));
+        if (subscriptions[i].expense == expense && strcmp(existing, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Turn a group into a suggestion if its occurrences are periodic and recent
+ *
+ * Returns:
+ *   true  - *out holds the suggestion
+ *   false - Not a recurring payment
+ */
+static bool suggest(RecurringGroup *group, int today, RecurringSuggestion *out)
+{
+    qsort(group->days, group->day_count, sizeof(int), compare_ints);
+    int distinct = 0;
+    for (int i = 0; i < group->day_count; i++)
+    {
+        if (i == 0 || group->days[i] != group->days[distinct - 1])
+        {
+            group->days[distinct++] = group->days[i];
+        }
+    }
+    int type, period;
+    char name[MAX_NAME_LEN];
+    normalize(group->latest.desc, name, sizeof(name));
+    if (distinct < RECURRING_MIN_OCCURRENCES || !find_period(group->days, distinct, &type, &period) ||
+        group->days[distinct - 1] + 2 * period < today || has_subscription(name, group->latest.expense))
+    {
+        return false;
+    }
+
+    memset(out, 0, sizeof(RecurringSuggestion));
+    Subscription *sub = &out->subscription;
+    const char *last = group->latest.date;
+    int last_year, last_month, last_day;
+    sscanf(last, "%d-%d-%d", &last_year, &last_month, &last_day);
+    strcpy(sub->name, group->latest.desc);
+    sub->expense = group->latest.expense;
+    sub->amount = group->latest.amt;
+    sub->period_type = type;
+    switch (type)
+    {
+    case PERIOD_WEEKLY:
+        sub->period_day = weekday(group->days[distinct - 1]);
+        break;
+    case PERIOD_MONTHLY:
+        sub->period_day = last_day;
+        break;
+    case PERIOD_YEARLY:
+        sub->period_day = last_month;
+        sub->period_month_day = last_day;
+        break;
+    default:
+        sub->period_day = period;
+        break;
+    }
+    // Catch-up starts after the last occurrence already recorded
+    strcpy(sub->start_date, last);
+    strcpy(sub->end_date, "9999-12-31");
+    sub->last_updated.tm_year = last_year - 1900;
+    sub->last_updated.tm_mon = last_month - 1;
+    sub->last_updated.tm_mday = last_day;
+    mktime(&sub->last_updated);
+    strcpy(sub->cat_name, group->category[0] != '\0' ? group->category : "Uncategorized");
+    out->occurrences = distinct;
+    time_t first = (time_t)group->days[0] * 86400;
+    strftime(out->first_date, sizeof(out->first_date), "%Y-%m-%d", gmtime(&first));
+    return true;
+}
+
+static int compare_suggestions(const void *a, const void *b)
+{
+    const RecurringSuggestion *sa = a, *sb = b;
+    if (sa->occurrences != sb->occurrences)
+    {
+        return sb->occurrences - sa->occurrences;
+    }
+    return strcmp(sa->subscription.name, sb->subscription.name);
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int detect_recurring(int from_month_index, int to_month_index, RecurringSuggestion **out_suggestions, int *out_count)
+{
+    RecurringTable table = {calloc(256, sizeof(RecurringGroup)), 256, 0};
+    if (table.slots == NULL)
+    {
+        return -2;
+    }
+    int entry_count, res = 1;
+    const ManifestEntry *entries = manifest_entries(&entry_count);
+    for (int i = 0; i < entry_count && res > 0; i++)
+    {
+        int month_index = entries[i].year * 12 + entries[i].month - 1;
+        if (month_index < from_month_index || month_index > to_month_index || entries[i].transaction_count == 0)
+        {
+            continue;
+        }
+        MonthSnapshot snapshot;
+        res = read_month_snapshot(entries[i].year, entries[i].month, &snapshot);
+        if (res <= 0)
+        {
+            res = res < 0 ? res : 1;
+            continue;
+        }
+        CategoryMap map = {NULL, 0};
+        res = category_map_build(&map, &snapshot.category_ids, snapshot.categories, snapshot.category_slots) < 0 ? -2 : 1;
+        for (int j = 0; j < snapshot.transaction_count && res > 0; j++)
+        {
+            int slot = category_map_slot(&map, snapshot.transactions[j].cat_id);
+            res = add_occurrence(&table, &snapshot.transactions[j], slot >= 0 ? snapshot.categories[slot].name : "");
+        }
+        category_map_free(&map);
+        free_month_snapshot(&snapshot);
+    }
+
+    RecurringSuggestion *suggestions = res > 0 ? malloc((table.count > 0 ? table.count : 1) * sizeof(RecurringSuggestion)) : NULL;
+    if (res > 0 && suggestions == NULL)
+    {
+        res = -2;
+    }
+    int count = 0;
+    char today_date[11];
+    time_t now = time(NULL);
+    strftime(today_date, sizeof(today_date), "%Y-%m-%d", localtime(&now));
+    int today = day_number(today_date);
+    for (int i = 0; i < table.capacity && res > 0; i++)
+    {
+        if (table.slots[i].used && suggest(&table.slots[i], today, &suggestions[count]))
+        {
+            count++;
+        }
+    }
+    table_free(&table);
+    if (res < 0)
+    {
+        free(suggestions);
+        return res;
+    }
+    qsort(suggestions, count, sizeof(RecurringSuggestion), compare_suggestions);
+    *out_suggestions = suggestions;
+    *out_count = count;
+    return 1;
+}
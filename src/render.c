@@ -0,0 +1,104 @@
+#include "render.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+RenderStats render_stats = {0};
+
+long long monotonic_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// ncurses writes straight to the terminal fd, so the only exact per-frame count
+// available is the kernel's write counter for this process. doupdate() is the sole
+// writer while it runs, so the delta around it is the frame's output.
+static bool read_written_bytes(size_t *out)
+{
+#ifdef __linux__
+    FILE *io = fopen("/proc/self/io", "r");
+    if (io == NULL)
+    {
+        return false;
+    }
+    char line[128];
+    bool found = false;
+    while (fgets(line, sizeof(line), io) != NULL)
+    {
+        unsigned long long value;
+        if (sscanf(line, "wchar: %llu", &value) == 1)
+        {
+            *out = (size_t)value;
+            found = true;
+            break;
+        }
+    }
+    fclose(io);
+    return found;
+#else
+    (void)out;
+    return false;
+#endif
+}
+
+void render_set_low_bandwidth(int fps)
+{
+    render_stats.low_bandwidth = true;
+    if (fps <= 0)
+    {
+        fps = DEFAULT_LOW_BANDWIDTH_FPS;
+    }
+    render_stats.max_fps = fps > MAX_LOW_BANDWIDTH_FPS ? MAX_LOW_BANDWIDTH_FPS : fps;
+}
+
+int render_frame_wait_ms()
+{
+    if (!render_stats.low_bandwidth || render_stats.frames == 0)
+    {
+        return 0;
+    }
+    long long interval = 1000 / render_stats.max_fps;
+    long long elapsed = monotonic_ms() - render_stats.last_frame_ms;
+    return elapsed >= interval ? 0 : (int)(interval - elapsed);
+}
+
+void render_present()
+{
+    if (!render_stats.low_bandwidth)
+    {
+        doupdate();
+        render_stats.frames++;
+        render_stats.last_frame_ms = monotonic_ms();
+        return;
+    }
+
+    size_t before = 0, after = 0;
+    bool counted = read_written_bytes(&before);
+    doupdate();
+    counted = counted && read_written_bytes(&after);
+
+    render_stats.bytes_available = counted;
+    render_stats.frame_bytes = counted ? after - before : 0;
+    render_stats.total_bytes += render_stats.frame_bytes;
+    render_stats.frames++;
+    render_stats.last_frame_ms = monotonic_ms();
+}
+
+void render_format_stats(char *buffer, size_t size)
+{
+    if (!render_stats.low_bandwidth)
+    {
+        buffer[0] = '\0';
+        return;
+    }
+    if (render_stats.bytes_available)
+    {
+        snprintf(buffer, size, "%dfps %zuB/frame", render_stats.max_fps, render_stats.frame_bytes);
+    }
+    else
+    {
+        snprintf(buffer, size, "%dfps", render_stats.max_fps);
+    }
+}
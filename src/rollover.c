@@ -0,0 +1,321 @@
+#include "rollover.h"
+
+typedef struct
+{
+    int year;
+    int month;
+    int balance_count;
+    unsigned long long chain_generation;
+    RolloverBalance *balances;
+} RolloverMonth;
+
+static RolloverMonth *months = NULL; // ordered by month
+static int month_count = 0;
+static int month_capacity = 0;
+static bool cache_loaded = false;
+
+static void rollover_path(char *path, size_t size, const char *suffix)
+{
+    snprintf(path, size, "%s/%s%s", data_storage_dir, ROLLOVER_FILE_NAME, suffix);
+}
+
+static int compare_months(int year_a, int month_a, int year_b, int month_b)
+{
+    return year_a != year_b ? year_a - year_b : month_a - month_b;
+}
+
+// Index of the month's entry, or where it would be inserted (as -index - 1)
+static int find_index(int year, int month)
+{
+    int left = 0, right = month_count - 1;
+    while (left <= right)
+    {
+        int mid = (left + right) / 2;
+        int cmp = compare_months(months[mid].year, months[mid].month, year, month);
+        if (cmp == 0)
+        {
+            return mid;
+        }
+        if (cmp < 0)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid - 1;
+        }
+    }
+    return -left - 1;
+}
+
+/*
+ * Keep balances as the month's closing balances, replacing any older ones. The cache
+ * takes ownership of balances.
+ *
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error (balances are freed)
+ */
+static int store_month(int year, int month, unsigned long long chain_generation, RolloverBalance *balances, int count)
+{
+    int index = find_index(year, month);
+    if (index < 0)
+    {
+        if (month_count == month_capacity)
+        {
+            int new_capacity = month_capacity > 0 ? month_capacity * 2 : 32;
+            RolloverMonth *grown = realloc(months, new_capacity * sizeof(RolloverMonth));
+            if (grown == NULL)
+            {
+                free(balances);
+                return -2;
+            }
+            months = grown;
+            month_capacity = new_capacity;
+        }
+        index = -index - 1;
+        memmove(&months[index + 1], &months[index], (month_count - index) * sizeof(RolloverMonth));
+        month_count++;
+    }
+    else
+    {
+        free(months[index].balances);
+    }
+    months[index].year = year;
+    months[index].month = month;
+    months[index].balance_count = count;
+    months[index].chain_generation = chain_generation;
+    months[index].balances = balances;
+    return 1;
+}
+
+// A cache that can't be read is dropped and rebuilt as months are opened
+static void read_cache(void)
+{
+    char path[MAX_BUFFER + 32];
+    rollover_path(path, sizeof(path), "");
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return;
+    }
+    RolloverHeader header;
+    bool ok = fread(&header, sizeof(RolloverHeader), 1, file) == 1 &&
+              strncmp(header.magic, ROLLOVER_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == ROLLOVER_VERSION && header.month_count >= 0;
+    for (int i = 0; ok && i < header.month_count; i++)
+    {
+        RolloverMonthRecord record;
+        ok = fread(&record, sizeof(RolloverMonthRecord), 1, file) == 1 && record.balance_count >= 0;
+        RolloverBalance *balances = ok ? malloc((record.balance_count > 0 ? record.balance_count : 1) * sizeof(RolloverBalance)) : NULL;
+        ok = balances != NULL &&
+             fread(balances, sizeof(RolloverBalance), record.balance_count, file) == (size_t)record.balance_count;
+        if (!ok)
+        {
+            free(balances);
+            break;
+        }
+        ok = store_month(record.year, record.month, record.chain_generation, balances, record.balance_count) > 0;
+    }
+    fclose(file);
+    if (!ok)
+    {
+        rollover_free();
+    }
+}
+
+// Write to a temporary file and rename it over the cache so readers never see half a file
+static int save_cache(void)
+{
+    char path[MAX_BUFFER + 32], tmp_path[MAX_BUFFER + 32];
+    rollover_path(path, sizeof(path), "");
+    rollover_path(tmp_path, sizeof(tmp_path), ".tmp");
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    RolloverHeader header = {
+        .magic = ROLLOVER_MAGIC,
+        .version = ROLLOVER_VERSION,
+        .month_count = month_count};
+    bool ok = fwrite(&header, sizeof(RolloverHeader), 1, file) == 1;
+    for (int i = 0; ok && i < month_count; i++)
+    {
+        RolloverMonthRecord record = {
+            .year = months[i].year,
+            .month = months[i].month,
+            .balance_count = months[i].balance_count,
+            .chain_generation = months[i].chain_generation};
+        ok = fwrite(&record, sizeof(RolloverMonthRecord), 1, file) == 1 &&
+             fwrite(months[i].balances, sizeof(RolloverBalance), record.balance_count, file) == (size_t)record.balance_count;
+    }
+    if (fclose(file) != 0 || !ok)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return rename(tmp_path, path) == 0 ? 1 : -1;
+}
+
+static Money carried(const RolloverBalance *balances, int count, const char *name)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(balances[i].name, name) == 0)
+        {
+            return balances[i].balance;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Closing balance of every category in a month, given what it carried in. The
+ * manifest holds each month's budgets and spending, so no month file is read.
+ *
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+static int close_month(const ManifestEntry *entry, const RolloverBalance *carry_in, int carry_count, RolloverBalance **out, int *out_count)
+{
+    const ManifestCategory *records = manifest_categories(entry);
+    RolloverBalance *balances = malloc((entry->category_records > 0 ? entry->category_records : 1) * sizeof(RolloverBalance));
+    if (balances == NULL)
+    {
+        return -2;
+    }
+    for (int i = 0; i < entry->category_records; i++)
+    {
+        memcpy(balances[i].name, records[i].name, sizeof(balances[i].name));
+        balances[i].balance = records[i].budget + carried(carry_in, carry_count, records[i].name) - records[i].spent;
+    }
+    *out = balances;
+    *out_count = entry->category_records;
+    return 1;
+}
+
+/*
+ * Walk back through the materialized months before this one to the latest whose
+ * cached balances are still current, then close each month after it in turn.
+ *
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error (every extra is left at zero)
+ */
+int rollover_apply(int year, int month, Category *slots, int slot_count)
+{
+    for (int i = 0; i < slot_count; i++)
+    {
+        slots[i].extra = 0;
+    }
+    if (!cache_loaded)
+    {
+        read_cache();
+        cache_loaded = true;
+    }
+
+    int entry_count;
+    const ManifestEntry *entries = manifest_entries(&entry_count);
+    int before = 0;
+    while (before < entry_count && compare_months(entries[before].year, entries[before].month, year, month) < 0)
+    {
+        before++;
+    }
+    if (before == 0)
+    {
+        return 1;
+    }
+    unsigned long long *chain_generations = malloc(before * sizeof(unsigned long long));
+    if (chain_generations == NULL)
+    {
+        return -2;
+    }
+    for (int i = 0; i < before; i++)
+    {
+        unsigned long long previous = i > 0 ? chain_generations[i - 1] : 0;
+        chain_generations[i] = MAX(previous, entries[i].generation);
+    }
+
+    int start = before;
+    const RolloverMonth *cached = NULL;
+    while (start > 0 && cached == NULL)
+    {
+        start--;
+        int index = find_index(entries[start].year, entries[start].month);
+        if (index >= 0 && months[index].chain_generation == chain_generations[start])
+        {
+            cached = &months[index];
+        }
+    }
+    int res = 1;
+    int carry_count = 0;
+    RolloverBalance *carry_in = NULL;
+    if (cached != NULL)
+    {
+        carry_count = cached->balance_count;
+        carry_in = malloc((carry_count > 0 ? carry_count : 1) * sizeof(RolloverBalance));
+        if (carry_in == NULL)
+        {
+            res = -2;
+        }
+        else
+        {
+            memcpy(carry_in, cached->balances, carry_count * sizeof(RolloverBalance));
+        }
+        start++;
+    }
+
+    bool changed = false;
+    for (int i = start; res > 0 && i < before; i++)
+    {
+        RolloverBalance *closing;
+        int closing_count;
+        res = close_month(&entries[i], carry_in, carry_count, &closing, &closing_count);
+        if (res < 0)
+        {
+            break;
+        }
+        free(carry_in);
+        carry_in = malloc((closing_count > 0 ? closing_count : 1) * sizeof(RolloverBalance));
+        carry_count = closing_count;
+        if (carry_in == NULL)
+        {
+            free(closing);
+            res = -2;
+            break;
+        }
+        memcpy(carry_in, closing, closing_count * sizeof(RolloverBalance));
+        res = store_month(entries[i].year, entries[i].month, chain_generations[i], closing, closing_count);
+        changed = true;
+    }
+    free(chain_generations);
+
+    for (int i = 0; res > 0 && i < slot_count; i++)
+    {
+        if (slots[i].budget > 0)
+        {
+            slots[i].extra = carried(carry_in, carry_count, slots[i].name);
+        }
+    }
+    free(carry_in);
+    if (changed)
+    {
+        save_cache();
+    }
+    return res;
+}
+
+void rollover_free(void)
+{
+    for (int i = 0; i < month_count; i++)
+    {
+        free(months[i].balances);
+    }
+    free(months);
+    months = NULL;
+    month_count = 0;
+    month_capacity = 0;
+}
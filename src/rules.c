@@ -0,0 +1,478 @@
+#include "rules.h"
+
+typedef struct
+{
+    char category[MAX_NAME_LEN];
+    bool has_min;
+    bool has_max;
+    Money min;
+    Money max;
+    bool at_start; // pattern began with ^
+    bool at_end;   // pattern ended with $
+    int length;    // pattern length, 0 for a rule on the amount alone
+    int next_same; // next rule with the same pattern text, in file order, or -1
+} Rule;
+
+static Rule *rules = NULL;
+static int rule_count = 0;
+static bool loaded = false;
+
+// Automaton over byte classes: bytes that appear in no pattern share class 0, so the
+// transition table is state_count * class_count ints with every move filled in
+static unsigned char byte_class[256];
+static int class_count = 0;
+static int *transitions = NULL;
+static int *first_rule = NULL;  // per state: first rule whose pattern ends there, or -1
+static int *output_link = NULL; // per state: nearest proper suffix state with rules, 0 for none
+static int state_count = 0;
+
+// Rules without a pattern: range_rules[k] is the first one covering amounts from
+// range_starts[k] up to the next start, or -1
+static Money *range_starts = NULL;
+static int *range_rules = NULL;
+static int range_count = 0;
+
+static void trim(char **text)
+{
+    while (**text == ' ' || **text == '\t')
+    {
+        (*text)++;
+    }
+    size_t len = strlen(*text);
+    while (len > 0 && ((*text)[len - 1] == ' ' || (*text)[len - 1] == '\t'))
+    {
+        (*text)[--len] = '\0';
+    }
+}
+
+// Parse "category,min,max,pattern" into rule and its lowercased pattern text
+static bool parse_rule(char *line, Rule *rule, char *pattern)
+{
+    char *fields[4];
+    fields[0] = line;
+    for (int i = 1; i < 4; i++)
+    {
+        char *comma = strchr(fields[i - 1], ',');
+        if (comma == NULL)
+        {
+            return false;
+        }
+        *comma = '\0';
+        fields[i] = comma + 1;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        trim(&fields[i]);
+    }
+    memset(rule, 0, sizeof(Rule));
+    if (fields[0][0] == '\0' || strlen(fields[0]) >= MAX_NAME_LEN ||
+        (fields[1][0] != '\0' && !money_parse(fields[1], &rule->min)) ||
+        (fields[2][0] != '\0' && !money_parse(fields[2], &rule->max)))
+    {
+        return false;
+    }
+    strcpy(rule->category, fields[0]);
+    rule->has_min = fields[1][0] != '\0';
+    rule->has_max = fields[2][0] != '\0';
+
+    char *text = fields[3];
+    size_t len = strlen(text);
+    if (len > 0 && text[len - 1] == '$')
+    {
+        rule->at_end = true;
+        text[--len] = '\0';
+    }
+    if (text[0] == '^')
+    {
+        rule->at_start = true;
+        text++;
+        len--;
+    }
+    for (size_t i = 0; i <= len; i++)
+    {
+        pattern[i] = tolower((unsigned char)text[i]);
+    }
+    rule->length = (int)len;
+    rule->next_same = -1;
+    return true;
+}
+
+static int add_state(int *capacity)
+{
+    if (state_count == *capacity)
+    {
+        int new_capacity = *capacity > 0 ? *capacity * 2 : 256;
+        int *grown_transitions = realloc(transitions, (size_t)new_capacity * class_count * sizeof(int));
+        if (grown_transitions == NULL)
+        {
+            return -2;
+        }
+        transitions = grown_transitions;
+        int *grown_rules = realloc(first_rule, new_capacity * sizeof(int));
+        if (grown_rules == NULL)
+        {
+            return -2;
+        }
+        first_rule = grown_rules;
+        int *grown_links = realloc(output_link, new_capacity * sizeof(int));
+        if (grown_links == NULL)
+        {
+            return -2;
+        }
+        output_link = grown_links;
+        *capacity = new_capacity;
+    }
+    for (int c = 0; c < class_count; c++)
+    {
+        transitions[(size_t)state_count * class_count + c] = -1;
+    }
+    first_rule[state_count] = -1;
+    output_link[state_count] = 0;
+    return state_count++;
+}
+
+/*
+ * Build the trie of every pattern, then fill in the failure moves breadth first so
+ * each state has a move for every class and matching never backtracks
+ *
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+static int compile_patterns(char **patterns)
+{
+    memset(byte_class, 0, sizeof(byte_class));
+    class_count = 1;
+    for (int r = 0; r < rule_count; r++)
+    {
+        for (const unsigned char *p = (const unsigned char *)patterns[r]; *p; p++)
+        {
+            if (byte_class[*p] == 0)
+            {
+                byte_class[*p] = class_count++;
+            }
+        }
+    }
+
+    int capacity = 0;
+    if (add_state(&capacity) < 0)
+    {
+        return -2;
+    }
+    int *last_rule = NULL; // per state: last rule in its first_rule chain
+    for (int r = 0; r < rule_count; r++)
+    {
+        if (rules[r].length == 0)
+        {
+            continue;
+        }
+        int state = 0;
+        for (const unsigned char *p = (const unsigned char *)patterns[r]; *p; p++)
+        {
+            int *next = &transitions[(size_t)state * class_count + byte_class[*p]];
+            if (*next < 0)
+            {
+                int added = add_state(&capacity);
+                if (added < 0)
+                {
+                    free(last_rule);
+                    return -2;
+                }
+                // add_state may have moved the table
+                transitions[(size_t)state * class_count + byte_class[*p]] = added;
+            }
+            state = transitions[(size_t)state * class_count + byte_class[*p]];
+        }
+        int *grown = realloc(last_rule, capacity * sizeof(int));
+        if (grown == NULL)
+        {
+            free(last_rule);
+            return -2;
+        }
+        last_rule = grown;
+        if (first_rule[state] < 0)
+        {
+            first_rule[state] = r;
+        }
+        else
+        {
+            rules[last_rule[state]].next_same = r;
+        }
+        last_rule[state] = r;
+    }
+    free(last_rule);
+
+    int *fail = malloc(state_count * sizeof(int));
+    int *queue = malloc(state_count * sizeof(int));
+    if (fail == NULL || queue == NULL)
+    {
+        free(fail);
+        free(queue);
+        return -2;
+    }
+    int head = 0, tail = 0;
+    fail[0] = 0;
+    queue[tail++] = 0;
+    while (head < tail)
+    {
+        int state = queue[head++];
+        for (int c = 0; c < class_count; c++)
+        {
+            int *next = &transitions[(size_t)state * class_count + c];
+            int fallback = state == 0 ? 0 : transitions[(size_t)fail[state] * class_count + c];
+            if (*next < 0)
+            {
+                *next = fallback;
+                continue;
+            }
+            fail[*next] = fallback;
+            output_link[*next] = first_rule[fallback] >= 0 ? fallback : output_link[fallback];
+            queue[tail++] = *next;
+        }
+    }
+    free(fail);
+    free(queue);
+    return 1;
+}
+
+static int compare_money(const void *a, const void *b)
+{
+    Money money_a = *(const Money *)a, money_b = *(const Money *)b;
+    return money_a < money_b ? -1 : money_a > money_b;
+}
+
+// Index of the range holding amount
+static int find_range(Money amount)
+{
+    int left = 0, right = range_count - 1;
+    while (left < right)
+    {
+        int mid = (left + right + 1) / 2;
+        if (range_starts[mid] <= amount)
+        {
+            left = mid;
+        }
+        else
+        {
+            right = mid - 1;
+        }
+    }
+    return left;
+}
+
+/*
+ * Split the amounts at every bound of a rule without a pattern, and record the first
+ * such rule covering each piece
+ *
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+static int compile_ranges(void)
+{
+    range_starts = malloc((2 * rule_count + 1) * sizeof(Money));
+    range_rules = malloc((2 * rule_count + 1) * sizeof(int));
+    if (range_starts == NULL || range_rules == NULL)
+    {
+        return -2;
+    }
+    range_count = 0;
+    range_starts[range_count++] = LLONG_MIN;
+    for (int r = 0; r < rule_count; r++)
+    {
+        if (rules[r].length > 0)
+        {
+            continue;
+        }
+        if (rules[r].has_min)
+        {
+            range_starts[range_count++] = rules[r].min;
+        }
+        if (rules[r].has_max && rules[r].max < LLONG_MAX)
+        {
+            range_starts[range_count++] = rules[r].max + 1;
+        }
+    }
+    qsort(range_starts, range_count, sizeof(Money), compare_money);
+    int unique = 0;
+    for (int i = 0; i < range_count; i++)
+    {
+        if (i == 0 || range_starts[i] != range_starts[unique - 1])
+        {
+            range_starts[unique++] = range_starts[i];
+        }
+    }
+    range_count = unique;
+    for (int i = 0; i < range_count; i++)
+    {
+        range_rules[i] = -1;
+    }
+    // Latest rule first, so earlier rules overwrite the pieces they share
+    for (int r = rule_count - 1; r >= 0; r--)
+    {
+        if (rules[r].length > 0 || (rules[r].has_min && rules[r].has_max && rules[r].min > rules[r].max))
+        {
+            continue;
+        }
+        int first = rules[r].has_min ? find_range(rules[r].min) : 0;
+        int end = rules[r].has_max && rules[r].max < LLONG_MAX ? find_range(rules[r].max + 1) : range_count;
+        for (int i = first; i < end; i++)
+        {
+            range_rules[i] = r;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Returns:
+ *   1     - Rules loaded (possibly none, when there is no rules file)
+ *   -2    - Malloc error
+ */
+int rules_load(int *out_skipped)
+{
+    rules_free();
+    loaded = true;
+    if (out_skipped != NULL)
+    {
+        *out_skipped = 0;
+    }
+    char path[MAX_BUFFER + 32];
+    snprintf(path, sizeof(path), "%s/%s", data_storage_dir, RULES_FILE_NAME);
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return 1;
+    }
+
+    int capacity = 0, res = 1;
+    char **patterns = NULL;
+    char line[MAX_BUFFER];
+    while (res > 0 && fgets(line, sizeof(line), file) != NULL)
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#')
+        {
+            continue;
+        }
+        if (rule_count == capacity)
+        {
+            int new_capacity = capacity > 0 ? capacity * 2 : 64;
+            Rule *grown_rules = realloc(rules, new_capacity * sizeof(Rule));
+            char **grown_patterns = grown_rules != NULL ? realloc(patterns, new_capacity * sizeof(char *)) : NULL;
+            if (grown_rules != NULL)
+            {
+                rules = grown_rules;
+            }
+            if (grown_patterns == NULL)
+            {
+                res = -2;
+                break;
+            }
+            patterns = grown_patterns;
+            capacity = new_capacity;
+        }
+        char pattern[MAX_BUFFER];
+        if (!parse_rule(line, &rules[rule_count], pattern))
+        {
+            if (out_skipped != NULL)
+            {
+                (*out_skipped)++;
+            }
+            continue;
+        }
+        patterns[rule_count] = strdup(pattern);
+        if (patterns[rule_count] == NULL)
+        {
+            res = -2;
+            break;
+        }
+        rule_count++;
+    }
+    fclose(file);
+
+    if (res > 0)
+    {
+        res = compile_patterns(patterns);
+    }
+    if (res > 0)
+    {
+        res = compile_ranges();
+    }
+    for (int i = 0; i < rule_count; i++)
+    {
+        free(patterns[i]);
+    }
+    free(patterns);
+    if (res < 0)
+    {
+        rules_free();
+        loaded = true; // don't retry on every transaction
+    }
+    return res;
+}
+
+static bool amount_in_range(const Rule *rule, Money amount)
+{
+    return (!rule->has_min || amount >= rule->min) && (!rule->has_max || amount <= rule->max);
+}
+
+const char *rules_suggest(const char *desc, Money amount)
+{
+    if (!loaded)
+    {
+        rules_load(NULL);
+    }
+    if (rule_count == 0)
+    {
+        return NULL;
+    }
+
+    int best = range_count > 0 ? range_rules[find_range(amount)] : -1;
+    if (best < 0)
+    {
+        best = rule_count;
+    }
+    int len = (int)strlen(desc);
+    int state = 0;
+    for (int i = 0; i < len; i++)
+    {
+        state = transitions[(size_t)state * class_count + byte_class[(unsigned char)tolower((unsigned char)desc[i])]];
+        for (int match = first_rule[state] >= 0 ? state : output_link[state]; match != 0; match = output_link[match])
+        {
+            // Rules sharing a pattern are in file order, so stop at the first that can't win
+            for (int r = first_rule[match]; r >= 0 && r < best; r = rules[r].next_same)
+            {
+                if ((!rules[r].at_start || i + 1 == rules[r].length) &&
+                    (!rules[r].at_end || i == len - 1) &&
+                    amount_in_range(&rules[r], amount))
+                {
+                    best = r;
+                    break;
+                }
+            }
+        }
+    }
+    return best < rule_count ? rules[best].category : NULL;
+}
+
+void rules_free(void)
+{
+    free(rules);
+    free(transitions);
+    free(first_rule);
+    free(output_link);
+    free(range_starts);
+    free(range_rules);
+    rules = NULL;
+    transitions = NULL;
+    first_rule = NULL;
+    output_link = NULL;
+    range_starts = NULL;
+    range_rules = NULL;
+    rule_count = 0;
+    state_count = 0;
+    class_count = 0;
+    range_count = 0;
+    loaded = false;
+}
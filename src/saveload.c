@@ -75,6 +75,86 @@ void initialize_data_directories()
     create_directory_if_not_exists(data_storage_dir);
 }
 
+// Keep the month's categories as the defaults for months created later, without the gaps
+static int remember_default_categories(const Category *slots, int slot_count)
+{
+    Category *grown = realloc(default_categories, (slot_count > 0 ? slot_count : 1) * sizeof(Category));
+    if (grown == NULL)
+    {
+        return -2;
+    }
+    default_categories = grown;
+    default_category_count = 0;
+    for (int i = 0; i < slot_count; i++)
+    {
+        if (slots[i].budget > 0)
+        {
+            default_categories[default_category_count++] = slots[i];
+        }
+    }
+    return 1;
+}
+
+// The double an older data file stored in a field that is now Money
+static double stored_double(Money raw)
+{
+    double value;
+    memcpy(&value, &raw, sizeof(double));
+    return value;
+}
+
+/*
+ * Read the default categories of a version 1 data file: always LEGACY_CATEGORY_SLOTS
+ * records without ids, of which new months only ever took the first count. The rest
+ * may hold whatever an older build wrote there, so only those are kept.
+ */
+static int read_legacy_default_categories(FILE *file, int count)
+{
+    LegacyCategory legacy[LEGACY_CATEGORY_SLOTS];
+    if (count < 0 || count > LEGACY_CATEGORY_SLOTS ||
+        fread(legacy, sizeof(LegacyCategory), LEGACY_CATEGORY_SLOTS, file) != LEGACY_CATEGORY_SLOTS)
+    {
+        return -1;
+    }
+    Category slots[LEGACY_CATEGORY_SLOTS];
+    memset(slots, 0, sizeof(slots));
+    for (int i = 0; i < count; i++)
+    {
+        slots[i].budget = money_from_double(legacy[i].budget);
+        slots[i].spent = money_from_double(legacy[i].spent);
+        slots[i].extra = money_from_double(legacy[i].extra);
+        memcpy(slots[i].name, legacy[i].name, sizeof(slots[i].name));
+    }
+    return remember_default_categories(slots, count);
+}
+
+// Read the default categories of a version 2 data file, whose amounts were doubles
+static int read_v2_default_categories(FILE *file, int count)
+{
+    CategoryV3 *stored = malloc((count > 0 ? count : 1) * sizeof(CategoryV3));
+    Category *slots = calloc(count > 0 ? count : 1, sizeof(Category));
+    int res = -2;
+    if (stored != NULL && slots != NULL)
+    {
+        res = fread(stored, sizeof(CategoryV3), count, file) == (size_t)count ? 1 : -1;
+    }
+    for (int i = 0; res > 0 && i < count; i++)
+    {
+        slots[i].budget = money_from_double(stored[i].budget);
+        slots[i].spent = money_from_double(stored[i].spent);
+        slots[i].extra = money_from_double(stored[i].extra);
+        memcpy(slots[i].name, stored[i].name, sizeof(slots[i].name));
+        slots[i].id = stored[i].id;
+    }
+    if (res > 0)
+    {
+        res = remember_default_categories(slots, count);
+    }
+    free(stored);
+    free(slots);
+    return res;
+}
+
 /*
  * Initialize data from the data file
  *
@@ -85,106 +165,134 @@ void initialize_data_directories()
  */
 int load_budget_data()
 {
-    FILE *file;
-    if (access(data_file_path, F_OK) == 0)
+    if (access(data_file_path, F_OK) != 0)
     {
-        // File exists
-        file = fopen(data_file_path, "r+b");
+        // First run: no default budget, categories or subscriptions yet
+        return save_budget_data();
     }
-    else
-    {
-        file = fopen(data_file_path, "w+b");
-        FileHeader header = {
-            .name = "tbudget_1.0",
-            .last_modified = time(NULL)};
-        fwrite(&header, sizeof(FileHeader), 1, file);
-        const int default_constants[NUM_CONSTANTS] = {
-            MAX_CATEGORIES,
-            MAX_NAME_LEN};
-        fwrite(default_constants, sizeof(int), NUM_CONSTANTS, file);
-        fwrite(&(double){0}, sizeof(double), 1, file); // no default monthly budget
-        fwrite(&(int){0}, sizeof(int), 1, file);       // no default categories
-        fwrite(&(Category){0}, sizeof(Category), MAX_CATEGORIES, file);
-        fwrite(&(int){0}, sizeof(int), 1, file); // no default subscriptions
-    }
-    fseek(file, 0, SEEK_SET);
-
-    // Read and validate header
-    FileHeader header;
-    if (fread(&header, sizeof(FileHeader), 1, file) != 1)
+    FILE *file = fopen(data_file_path, "rb");
+    if (file == NULL)
     {
-        fclose(file);
         return -1;
     }
 
+    // Read and validate header
+    FileHeader header;
     int constants[NUM_CONSTANTS];
-    if (fread(constants, sizeof(int), NUM_CONSTANTS, file) != NUM_CONSTANTS)
+    if (fread(&header, sizeof(FileHeader), 1, file) != 1 ||
+        fread(constants, sizeof(int), NUM_CONSTANTS, file) != NUM_CONSTANTS)
     {
         fclose(file);
         return -1;
     }
-
-    const int prev_constants[NUM_CONSTANTS] = {
-        MAX_CATEGORIES,
+    // Version 1 files stored a fixed number of category slots and no category ids,
+    // versions before 3 stored amounts as doubles, versions before 4 no parents and
+    // versions before 5 no tags
+    bool legacy = strcmp(header.name, DATA_FILE_LEGACY_VERSION) == 0;
+    bool double_amounts = legacy || strcmp(header.name, DATA_FILE_V2_VERSION) == 0;
+    bool no_parents = double_amounts || strcmp(header.name, DATA_FILE_V3_VERSION) == 0;
+    bool no_tags = no_parents || strcmp(header.name, DATA_FILE_V4_VERSION) == 0;
+    const int expected_constants[NUM_CONSTANTS] = {
+        legacy ? LEGACY_CATEGORY_SLOTS : (int)sizeof(Category),
         MAX_NAME_LEN};
-
-    if (memcmp(constants, prev_constants, NUM_CONSTANTS) != 0)
+    if (memcmp(constants, expected_constants, sizeof(constants)) != 0)
     {
-        fprintf(stderr, "Error: set in globals.h MAX_CATEGORIES=%d, MAX_NAME_LEN=%d\n", constants[0], constants[1]);
+        fprintf(stderr, "Error: data file was written with Category size %d, MAX_NAME_LEN=%d\n", constants[0], constants[1]);
         fclose(file);
         return -1;
     }
 
-    // Read default monthly budget
-    if (fread(&default_monthly_budget, sizeof(double), 1, file) != 1)
+    // Read default monthly budget and categories
+    int count;
+    if (fread(&default_monthly_budget, sizeof(Money), 1, file) != 1 ||
+        fread(&count, sizeof(int), 1, file) != 1)
     {
         fclose(file);
         return -1;
     }
-
-    // Read default categories
-    if (fread(&default_category_count, sizeof(int), 1, file) != 1 ||
-        default_category_count > MAX_CATEGORIES || default_category_count < 0)
+    if (double_amounts)
+    {
+        default_monthly_budget = money_from_double(stored_double(default_monthly_budget));
+    }
+    int res;
+    if (legacy)
+    {
+        res = read_legacy_default_categories(file, count);
+    }
+    else if (count < 0)
     {
-        default_category_count = 0;
+        res = -2;
+    }
+    else if (double_amounts)
+    {
+        res = read_v2_default_categories(file, count);
     }
     else
     {
-        if (fread(default_categories, sizeof(Category), MAX_CATEGORIES, file) != (size_t)MAX_CATEGORIES)
+        Category *slots = malloc((count > 0 ? count : 1) * sizeof(Category));
+        if (slots == NULL)
         {
-            fclose(file);
-            return -1;
+            res = -2;
         }
+        else
+        {
+            res = fread(slots, sizeof(Category), count, file) == (size_t)count ? remember_default_categories(slots, count) : -1;
+        }
+        free(slots);
+    }
+    if (res < 0)
+    {
+        fclose(file);
+        return res;
+    }
+    for (int i = 0; no_parents && i < default_category_count; i++)
+    {
+        default_categories[i].parent_id = -1;
     }
 
     // Read subscription count and validate
     if (fread(&subscription_count, sizeof(int), 1, file) != 1)
     {
+        fclose(file);
         return -1;
     }
-    if (
-        subscription_count < 0)
+    if (subscription_count < 0)
     {
+        fclose(file);
         return -2;
     }
-    else
+    subscriptions = (Subscription *)malloc((subscription_count > 0 ? subscription_count : 1) * sizeof(Subscription));
+    // Read subscriptions
+    if (subscriptions == NULL ||
+        fread(subscriptions, sizeof(Subscription), subscription_count, file) != (size_t)subscription_count)
+    {
+        fclose(file);
+        return -1;
+    }
+    tag_count = 0;
+    if (!no_tags &&
+        (fread(&tag_count, sizeof(int), 1, file) != 1 || tag_count < 0 || tag_count > MAX_TAGS ||
+         fread(tag_names, MAX_NAME_LEN, tag_count, file) != (size_t)tag_count))
+    {
+        tag_count = 0;
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    if (double_amounts)
     {
-        subscriptions = (Subscription *)malloc(subscription_count * sizeof(Subscription));
-        // Read subscriptions
-        if (fread(subscriptions, sizeof(Subscription), subscription_count, file) != (size_t)subscription_count)
+        for (int i = 0; i < subscription_count; i++)
         {
-            fclose(file);
-            return -1;
+            subscriptions[i].amount = money_from_double(stored_double(subscriptions[i].amount));
         }
     }
 
-    fclose(file);
-
-    return 1;
+    return no_tags ? save_budget_data() : 1;
 }
 
 /*
- * Initialize data from the data file
+ * Write the whole data file to a temporary file and rename it over the old one, since
+ * the default categories section changes length and everything after it moves
  *
  * Returns:
  *   1     - Success
@@ -192,43 +300,325 @@ int load_budget_data()
  */
 int save_budget_data()
 {
-    FILE *file;
-    if (access(data_file_path, F_OK) == 0)
+    char tmp_path[MAX_BUFFER + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", data_file_path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL)
     {
-        // File exists
-        file = fopen(data_file_path, "r+b");
+        return -1;
     }
-    else
-    {
+
+    FileHeader header = {
+        .name = DATA_FILE_VERSION,
+        .last_modified = time(NULL)};
+    const int constants[NUM_CONSTANTS] = {
+        (int)sizeof(Category),
+        MAX_NAME_LEN};
+    bool ok = fwrite(&header, sizeof(FileHeader), 1, file) == 1 &&
+              fwrite(constants, sizeof(int), NUM_CONSTANTS, file) == NUM_CONSTANTS &&
+              fwrite(&default_monthly_budget, sizeof(Money), 1, file) == 1 &&
+              fwrite(&default_category_count, sizeof(int), 1, file) == 1 &&
+              fwrite(default_categories, sizeof(Category), default_category_count, file) == (size_t)default_category_count &&
+              fwrite(&subscription_count, sizeof(int), 1, file) == 1 &&
+              fwrite(subscriptions, sizeof(Subscription), subscription_count, file) == (size_t)subscription_count &&
+              fwrite(&tag_count, sizeof(int), 1, file) == 1 &&
+              fwrite(tag_names, MAX_NAME_LEN, tag_count, file) == (size_t)tag_count;
+    if (fclose(file) != 0 || !ok || rename(tmp_path, data_file_path) != 0)
+    {
+        remove(tmp_path);
         return -1;
     }
+    return 1;
+}
+
+// Generation the manifest holds for a month, 0 if it has no entry
+static unsigned long long month_generation(int year, int month)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    return entry ? entry->generation : 0;
+}
+
+/*
+ * Bring every per-month sidecar (search index, tag bitmaps, fingerprints, category
+ * statistics) in step with a write to the month file, once the manifest has recorded
+ * it. Each sidecar rebuilds itself when it can't follow, so failures aren't reported.
+ */
+static void sidecars_add(int year, int month, int first_slot, const Transaction *transactions, int count, unsigned long long previous_generation)
+{
+    search_index_add(year, month, first_slot, transactions, count, previous_generation);
+    tag_index_add(year, month, first_slot, transactions, count, previous_generation);
+    fingerprint_index_add(year, month, first_slot, transactions, count, previous_generation);
+    category_stats_add(year, month, first_slot, transactions, count, previous_generation);
+    category_stats_advance();
+}
+
+static void sidecars_remove(int year, int month, int slot, int moved_slot, unsigned long long previous_generation)
+{
+    search_index_remove(year, month, slot, moved_slot, previous_generation);
+    tag_index_remove(year, month, slot, moved_slot, previous_generation);
+    fingerprint_index_remove(year, month, slot, moved_slot, previous_generation);
+    category_stats_remove(year, month, slot, moved_slot, previous_generation);
+    category_stats_advance();
+}
 
-    fseek(file, sizeof(FileHeader) + sizeof(int) * NUM_CONSTANTS, SEEK_SET);
-    if (fwrite(&default_monthly_budget, sizeof(double), 1, file) != 1)
+static void sidecars_remove_slots(int year, int month, const int *new_slots, int old_count, unsigned long long previous_generation)
+{
+    search_index_remove_slots(year, month, new_slots, old_count, previous_generation);
+    tag_index_remove_slots(year, month, new_slots, old_count, previous_generation);
+    fingerprint_index_remove_slots(year, month, new_slots, old_count, previous_generation);
+    category_stats_remove_slots(year, month, new_slots, old_count, previous_generation);
+    category_stats_advance();
+}
+
+static void sidecars_update(int year, int month, int slot, const Transaction *transaction, unsigned long long previous_generation)
+{
+    search_index_update(year, month, slot, transaction, previous_generation);
+    tag_index_update(year, month, slot, transaction, previous_generation);
+    fingerprint_index_update(year, month, slot, transaction, previous_generation);
+    category_stats_update(year, month, slot, transaction, previous_generation);
+    category_stats_advance();
+}
+
+// id -> node for the loaded month: open addressing with linear probing, kept at most half full
+static TransactionNode **id_table = NULL;
+static int id_table_capacity = 0;
+static int id_table_count = 0;
+
+static int id_table_home(unsigned long long id)
+{
+    // Fibonacci hashing spreads the sequential low bits over the whole table
+    return (int)((id * 11400714819323198485ULL) >> 32) & (id_table_capacity - 1);
+}
+
+static void id_table_put(TransactionNode *node)
+{
+    int i = id_table_home(node->data.id);
+    while (id_table[i] != NULL && id_table[i]->data.id != node->data.id)
     {
-        return -1;
+        i = (i + 1) & (id_table_capacity - 1);
     }
-    if (fwrite(&default_category_count, sizeof(int), 1, file) != 1)
+    if (id_table[i] == NULL)
     {
-        return -1;
+        id_table_count++;
     }
-    if (fwrite(&default_categories, sizeof(Category), MAX_CATEGORIES, file) != 1)
+    id_table[i] = node;
+}
+
+/*
+ * Make room for at least count entries, rehashing what is there
+ *
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+static int id_table_reserve(int count)
+{
+    if (id_table != NULL && count * 2 <= id_table_capacity)
     {
-        return -1;
+        return 1;
     }
-    if (fwrite(&subscription_count, sizeof(int), 1, file) != 1)
+    int capacity = 64;
+    while (capacity < count * 2)
     {
-        return -1;
+        capacity *= 2;
     }
-    if (fwrite(&subscriptions, sizeof(Subscription), subscription_count, file) != 1)
+    TransactionNode **old_table = id_table;
+    int old_capacity = id_table_capacity;
+    id_table = calloc(capacity, sizeof(TransactionNode *));
+    if (id_table == NULL)
     {
-        return -1;
+        id_table = old_table;
+        return -2;
     }
-    fclose(file);
-
+    id_table_capacity = capacity;
+    id_table_count = 0;
+    for (int i = 0; i < old_capacity; i++)
+    {
+        if (old_table[i] != NULL)
+        {
+            id_table_put(old_table[i]);
+        }
+    }
+    free(old_table);
     return 1;
 }
 
+// Backward-shift deletion, so lookups never need tombstones
+static void id_table_delete(unsigned long long id)
+{
+    if (id_table == NULL)
+    {
+        return;
+    }
+    int mask = id_table_capacity - 1;
+    int i = id_table_home(id);
+    while (id_table[i] != NULL && id_table[i]->data.id != id)
+    {
+        i = (i + 1) & mask;
+    }
+    if (id_table[i] == NULL)
+    {
+        return;
+    }
+    id_table_count--;
+    int hole = i;
+    for (int j = (i + 1) & mask; id_table[j] != NULL; j = (j + 1) & mask)
+    {
+        // An entry may fill the hole only if its home is not between the hole and itself
+        int home = id_table_home(id_table[j]->data.id);
+        if (((j - home) & mask) >= ((j - hole) & mask))
+        {
+            id_table[hole] = id_table[j];
+            hole = j;
+        }
+    }
+    id_table[hole] = NULL;
+}
+
+// The loaded month's node for an id, or NULL
+TransactionNode *find_transaction(unsigned long long id)
+{
+    if (id_table == NULL || id == 0)
+    {
+        return NULL;
+    }
+    int i = id_table_home(id);
+    while (id_table[i] != NULL)
+    {
+        if (id_table[i]->data.id == id)
+        {
+            return id_table[i];
+        }
+        i = (i + 1) & (id_table_capacity - 1);
+    }
+    return NULL;
+}
+
+// The loaded month in the other column orders; each is built the first time it is asked
+// for and then kept in step with every add, remove and edit
+static OrderIndex column_orders[NUM_SORT_FIELDS] = {
+    [SORT_BY_AMOUNT] = {order_by_amount, NULL},
+    [SORT_BY_CATEGORY] = {order_by_category, NULL},
+    [SORT_BY_DESCRIPTION] = {order_by_description, NULL},
+};
+static bool column_order_built[NUM_SORT_FIELDS];
+
+static void drop_column_order(SortField field)
+{
+    order_index_free(&column_orders[field]);
+    column_order_built[field] = false;
+}
+
+void drop_column_orders(void)
+{
+    for (int field = SORT_BY_DATE + 1; field < NUM_SORT_FIELDS; field++)
+    {
+        drop_column_order(field);
+    }
+}
+
+// An order that can't take the node is dropped and rebuilt when next asked for
+static void column_orders_insert(TransactionNode *node)
+{
+    for (int field = SORT_BY_DATE + 1; field < NUM_SORT_FIELDS; field++)
+    {
+        if (column_order_built[field] && order_index_insert(&column_orders[field], node) < 0)
+        {
+            drop_column_order(field);
+        }
+    }
+}
+
+static void column_orders_remove(const TransactionNode *node)
+{
+    for (int field = SORT_BY_DATE + 1; field < NUM_SORT_FIELDS; field++)
+    {
+        if (column_order_built[field])
+        {
+            order_index_remove(&column_orders[field], node);
+        }
+    }
+}
+
+// A node the date order can't take has it rebuilt from the list. If even that fails,
+// the month is reloaded on the dashboard's next pass instead of showing rows that
+// are missing from the view.
+static void sorted_transactions_insert(TransactionNode *node)
+{
+    if (order_index_insert(&sorted_transactions, node) < 0 &&
+        order_index_build(&sorted_transactions, transaction_head) < 0)
+    {
+        loaded_month = 0;
+    }
+}
+
+// The loaded month sorted on a column, or NULL if it could not be built
+const OrderIndex *transaction_order(SortField field)
+{
+    if (field == SORT_BY_DATE)
+    {
+        return &sorted_transactions;
+    }
+    if (!column_order_built[field])
+    {
+        if (order_index_build(&column_orders[field], transaction_head) < 0)
+        {
+            return NULL;
+        }
+        column_order_built[field] = true;
+    }
+    return &column_orders[field];
+}
+
+// A new month's categories: the defaults, numbered from 0 and with nothing spent yet
+static Category *new_month_categories(CategoryIds *ids)
+{
+    Category *slots = malloc((default_category_count > 0 ? default_category_count : 1) * sizeof(Category));
+    if (slots == NULL)
+    {
+        return NULL;
+    }
+    category_ids_init(ids, 0);
+    for (int i = 0; i < default_category_count; i++)
+    {
+        slots[i] = default_categories[i];
+        slots[i].spent = 0;
+        slots[i].extra = 0;
+        slots[i].id = category_ids_assign(ids);
+    }
+    // Parents were ids of the month the defaults came from; point them at the new ones
+    for (int i = 0; i < default_category_count; i++)
+    {
+        int parent_id = default_categories[i].parent_id;
+        slots[i].parent_id = -1;
+        for (int j = 0; parent_id >= 0 && j < default_category_count; j++)
+        {
+            if (default_categories[j].id == parent_id)
+            {
+                slots[i].parent_id = slots[j].id;
+                break;
+            }
+        }
+    }
+    return slots;
+}
+
+// Lay out a fresh month file with the default budget and categories
+static void write_empty_month(FILE *file)
+{
+    MonthFileHeader header;
+    init_month_header(&header);
+    Category *slots = new_month_categories(&header.category_ids);
+    header.category_slots = slots != NULL ? default_category_count : 0;
+    fwrite(&header, sizeof(MonthFileHeader), 1, file);
+    fwrite(&default_monthly_budget, sizeof(Money), 1, file);
+    fwrite(&header.category_slots, sizeof(int), 1, file);
+    fwrite(slots, sizeof(Category), header.category_slots, file);
+    fwrite(&(Money){0}, sizeof(Money), 1, file);   // uncategorized spent
+    fwrite(&(int){0}, sizeof(int), 1, file);       // number of transactions (0)
+    free(slots);
+}
+
 /*
  * Load the month's data from the data file
  *
@@ -253,6 +643,11 @@ int load_month(int year, int month)
         transaction_tail = NULL;
         current_month_transaction_count = 0;
     }
+    // The id table only pointed into the list just freed
+    free(id_table);
+    id_table = NULL;
+    id_table_capacity = 0;
+    id_table_count = 0;
 
     FILE *file = open_month_file(year, month);
     if (!file)
@@ -262,42 +657,33 @@ int load_month(int year, int month)
     fseek(file, 0, SEEK_END);
     if (ftell(file) == 0)
     {
-        fwrite(&default_monthly_budget, sizeof(double), 1, file);
-        fwrite(&default_category_count, sizeof(int), 1, file);
-        // fills with empty category data
-        fwrite(&(Category){0}, sizeof(Category), MAX_CATEGORIES, file);
-        // fills with default categories if there are any
-        fseek(file, sizeof(double) + sizeof(int), SEEK_SET);
-        fwrite(default_categories, sizeof(Category), default_category_count, file);
-        fseek(file, 0, SEEK_END);
-        fwrite(&(double){0}, sizeof(double), 1, file); // uncategorized spent
-        fwrite(&(int){0}, sizeof(int), 1, file);       // number of transactions (0)
+        write_empty_month(file);
+        manifest_record_month(year, month, file);
     }
-    fseek(file, 0, SEEK_SET);
+    MonthFileHeader header;
+    if (read_month_header(file, &header) != 1)
+    {
+        return -1;
+    }
+    category_ids = header.category_ids;
 
     // Read monthly budget
-    if (fread(&current_month_total_budget, sizeof(double), 1, file) != 1)
+    if (fread(&current_month_total_budget, sizeof(Money), 1, file) != 1)
     {
         return -1;
     }
 
     // Read the categories
-    // TODO default to default categories if empty
-    if (fread(&category_count, sizeof(int), 1, file) == 1)
-    {
-        if (fread(categories, sizeof(Category), category_count, file) != (size_t)category_count)
-        {
-            return -1;
-        }
-    }
-    else
+    int live_count;
+    if (fread(&live_count, sizeof(int), 1, file) != 1 ||
+        category_table_reserve(header.category_slots) < 0 ||
+        fread(categories, sizeof(Category), header.category_slots, file) != (size_t)header.category_slots ||
+        category_table_rebuild(header.category_slots) < 0)
     {
         return -1;
     }
-    sort_categories_by_budget();
-    fseek(file, sizeof(double) + sizeof(int) + (sizeof(Category) * MAX_CATEGORIES), SEEK_SET);
     // Read uncategorized spent
-    if (fread(&uncategorized_spent, sizeof(double), 1, file) != 1)
+    if (fread(&uncategorized_spent, sizeof(Money), 1, file) != 1)
     {
         return -1;
     }
@@ -315,11 +701,12 @@ int load_month(int year, int month)
     {
         cleanup_transactions();
     }
-    if (sorted_transactions)
+    order_index_free(&sorted_transactions); // its nodes pointed into the list just freed
+    drop_column_orders();
+    if (id_table_reserve(current_month_transaction_count) < 0)
     {
-        free(sorted_transactions);
+        return -1;
     }
-    sorted_transactions = (TransactionNode **)malloc(sizeof(TransactionNode *) * current_month_transaction_count);
     for (int i = 0; i < current_month_transaction_count; i++)
     {
         Transaction temp_transaction;
@@ -330,7 +717,6 @@ int load_month(int year, int month)
 
         // Create a new node
         TransactionNode *new_node = (TransactionNode *)malloc(sizeof(TransactionNode));
-        sorted_transactions[i] = new_node;
         if (!new_node)
         {
             return -1;
@@ -340,6 +726,7 @@ int load_month(int year, int month)
         new_node->data = temp_transaction;
         new_node->index = i;
         new_node->next = NULL;
+        id_table_put(new_node);
 
         // Add to the linked list
         if (transaction_tail)
@@ -355,25 +742,55 @@ int load_month(int year, int month)
         }
     }
 
-    qsort(sorted_transactions, current_month_transaction_count, sizeof(TransactionNode *), compare_transactions_by_date);
+    if (order_index_build(&sorted_transactions, transaction_head) < 0)
+    {
+        return -1;
+    }
+    // Last, from the manifest's budgets and spending of the months before this one
+    if (rollover_apply(year, month, categories, category_slot_count) == -2)
+    {
+        return -1;
+    }
+    category_rollups_rebuild();
     loaded_month = month;
     loaded_year = year;
     if (year == today_year && month == today_month)
     {
         default_monthly_budget = current_month_total_budget;
-        default_category_count = category_count;
-        memcpy(default_categories, categories, category_count * sizeof(Category));
+        remember_default_categories(categories, category_slot_count);
     }
     return 1;
 }
 
+// Slot of the category cat_id names among a month file's records: -1 for
+// uncategorized, -3 when the id belongs to no category of that month
+static int month_category_slot(const Category *slots, int slot_count, const CategoryIds *ids, int cat_id)
+{
+    int live_id = category_ids_resolve(ids, cat_id);
+    if (live_id < 0)
+    {
+        return -1;
+    }
+    for (int slot = 0; slot < slot_count; slot++)
+    {
+        if (slots[slot].id == live_id && slots[slot].budget > 0)
+        {
+            return slot;
+        }
+    }
+    return -3;
+}
+
 /*
- * Add a transaction to the current month's data file
+ * Add a transaction to the current month's data file, giving it the month's next id
+ * (written back into transaction->id). Once the record is written it counts as
+ * added: if the loaded month can't take it in memory, the month is reloaded on the
+ * dashboard's next pass.
  *
  * Returns:
  *   1     - Success
  *   -1    - I/O error occurred
- *   -2    - Malloc error
+ *   -3    - Unknown category id
  */
 int add_transaction(Transaction *transaction, int year, int month)
 {
@@ -385,35 +802,53 @@ int add_transaction(Transaction *transaction, int year, int month)
     fseek(file, 0, SEEK_END);
     if (ftell(file) == 0) // pointer starts at the end of the file, so this checks if the file is empty
     {
-        fwrite(&default_monthly_budget, sizeof(double), 1, file);
-        fwrite(&default_category_count, sizeof(int), 1, file);
-        fwrite(&(Category){0}, sizeof(Category), MAX_CATEGORIES, file);
-        fseek(file, sizeof(double) + sizeof(int), SEEK_SET);
-        fwrite(default_categories, sizeof(Category), default_category_count, file);
-        fseek(file, 0, SEEK_END);
-        fwrite(&(double){0}, sizeof(double), 1, file); // uncategorized spent
-        fwrite(&(int){0}, sizeof(int), 1, file);       // number of transactions
+        write_empty_month(file);
     }
 
-    // update categories
-    fseek(file, sizeof(double), SEEK_SET);
-    int cat_count = 0;
-    Category cat;
-    if (fread(&cat_count, sizeof(int), 1, file) != 1)
+    MonthFileHeader header;
+    Category *file_categories;
+    if (read_month_header(file, &header) != 1 ||
+        read_month_categories_section(file, &header, &file_categories) != 1)
     {
         return -1;
     }
-    fseek(file, sizeof(double) + sizeof(int) + (sizeof(Category) * transaction->cat_index), SEEK_SET);
-    if (fread(&cat, sizeof(Category), 1, file) != 1)
+    int cat_slot = month_category_slot(file_categories, header.category_slots, &header.category_ids, transaction->cat_id);
+    free(file_categories);
+    if (cat_slot == -3)
     {
-        return -1;
+        return -3;
     }
+    transaction->id = TRANSACTION_ID(year, month, header.next_sequence++);
+    write_month_header(file, &header);
 
-    cat.spent += transaction->amt;
-    fwrite(&cat, sizeof(Category), 1, file);
+    // update categories
+    if (cat_slot == -1)
+    {
+        Money file_uncategorized_spent;
+        fseek(file, MONTH_UNCATEGORIZED_OFFSET(&header), SEEK_SET);
+        if (fread(&file_uncategorized_spent, sizeof(Money), 1, file) != 1)
+        {
+            return -1;
+        }
+        file_uncategorized_spent += transaction->amt;
+        fseek(file, MONTH_UNCATEGORIZED_OFFSET(&header), SEEK_SET);
+        fwrite(&file_uncategorized_spent, sizeof(Money), 1, file);
+    }
+    else
+    {
+        Category cat;
+        fseek(file, MONTH_CATEGORY_OFFSET(cat_slot), SEEK_SET);
+        if (fread(&cat, sizeof(Category), 1, file) != 1)
+        {
+            return -1;
+        }
+        cat.spent += transaction->amt;
+        fseek(file, MONTH_CATEGORY_OFFSET(cat_slot), SEEK_SET);
+        fwrite(&cat, sizeof(Category), 1, file);
+    }
 
     // add transaction
-    fseek(file, sizeof(double) + sizeof(int) + (sizeof(Category) * MAX_CATEGORIES) + sizeof(double), SEEK_SET);
+    fseek(file, MONTH_TRANSACTION_COUNT_OFFSET(&header), SEEK_SET);
     int tmp_count;
     if (fread(&tmp_count, sizeof(int), 1, file) != 1)
     {
@@ -423,18 +858,31 @@ int add_transaction(Transaction *transaction, int year, int month)
     fseek(file, -sizeof(int), SEEK_CUR);
     fwrite(&tmp_count, sizeof(int), 1, file);
 
-    fseek(file, 0, SEEK_END);
+    fseek(file, MONTH_TRANSACTION_OFFSET(&header, tmp_count - 1), SEEK_SET);
     fwrite(transaction, sizeof(Transaction), 1, file);
+    unsigned long long previous_generation = month_generation(year, month);
+    manifest_record_month(year, month, file);
+    sidecars_add(year, month, tmp_count - 1, transaction, 1, previous_generation);
     if (year != current_year || month != current_month) // don't need to store it in memory
     {
         return 1;
     }
+    int slot = category_slot(transaction->cat_id);
+    if (slot >= 0)
+    {
+        category_add_spent(slot, transaction->amt);
+    }
+    else
+    {
+        uncategorized_spent += transaction->amt;
+    }
 
     // Add the transaction to the linked list
     TransactionNode *new_node = (TransactionNode *)malloc(sizeof(TransactionNode));
     if (!new_node)
     {
-        return -2;
+        loaded_month = 0;
+        return 1;
     }
 
     // Copy transaction data to the new node
@@ -442,8 +890,16 @@ int add_transaction(Transaction *transaction, int year, int month)
     new_node->next = NULL;
     new_node->prev = transaction_tail;
     new_node->index = current_month_transaction_count++;
-
-    // Add to the linked list
+    if (id_table_reserve(current_month_transaction_count) < 0)
+    {
+        free(new_node);
+        current_month_transaction_count--;
+        loaded_month = 0;
+        return 1;
+    }
+    id_table_put(new_node);
+
+    // Add to the linked list
     if (transaction_tail)
     {
         transaction_tail->next = new_node;
@@ -454,42 +910,103 @@ int add_transaction(Transaction *transaction, int year, int month)
         transaction_head = transaction_tail = new_node;
     }
 
-    // Binary search to insert into sorted transactions array
-    int left = 0;
-    int right = current_month_transaction_count - 2;
-    int insert_pos = 0;
+    column_orders_insert(new_node);
+    sorted_transactions_insert(new_node);
+    return 1;
+}
+
+/*
+ * Append a batch of transactions that all fall in the given month. The category
+ * totals and transaction count are read and written once for the whole batch.
+ * Each transaction's id is filled in.
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Unknown category id
+ */
+int add_transactions(Transaction *transactions, int count, int year, int month)
+{
+    if (count <= 0)
+    {
+        return 1;
+    }
+    FILE *file = open_month_file(year, month);
+    if (!file)
+    {
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0)
+    {
+        write_empty_month(file);
+    }
+
+    MonthFileHeader header;
+    Category *file_categories;
+    Money file_uncategorized_spent;
+    int tx_count;
+    if (read_month_header(file, &header) != 1 ||
+        read_month_categories_section(file, &header, &file_categories) != 1)
+    {
+        return -1;
+    }
+    if (fread(&file_uncategorized_spent, sizeof(Money), 1, file) != 1 ||
+        fread(&tx_count, sizeof(int), 1, file) != 1)
+    {
+        free(file_categories);
+        return -1;
+    }
 
-    while (left <= right)
+    for (int i = 0; i < count; i++)
     {
-        int mid = (left + right) / 2;
-        if (compare_transactions_by_date(&sorted_transactions[mid], &new_node) > 0)
+        int cat_slot = month_category_slot(file_categories, header.category_slots, &header.category_ids, transactions[i].cat_id);
+        if (cat_slot == -3)
         {
-            right = mid - 1;
+            free(file_categories);
+            return -2;
+        }
+        if (cat_slot == -1)
+        {
+            file_uncategorized_spent += transactions[i].amt;
         }
         else
         {
-            left = mid + 1;
+            file_categories[cat_slot].spent += transactions[i].amt;
         }
     }
-    insert_pos = left;
-
-    // Reallocate the sorted_transactions array to make room for the new element
-    TransactionNode **new_sorted = (TransactionNode **)realloc(sorted_transactions, (current_month_transaction_count + 1) * sizeof(TransactionNode *));
-    if (new_sorted)
-        sorted_transactions = new_sorted;
-    else
+    for (int i = 0; i < count; i++)
     {
-        free(new_node); // Don't leak the transaction node we created earlier
-        return -2;
+        transactions[i].id = TRANSACTION_ID(year, month, header.next_sequence++);
     }
 
-    memmove(&sorted_transactions[insert_pos + 1],
-            &sorted_transactions[insert_pos],
-            (current_month_transaction_count - insert_pos) * sizeof(TransactionNode *));
-    sorted_transactions[insert_pos] = new_node;
-
-    current_month_transaction_count++;
+    // Append the records before bumping the count so a failed write leaves the month readable
+    fseek(file, MONTH_TRANSACTION_OFFSET(&header, tx_count), SEEK_SET);
+    if (fwrite(transactions, sizeof(Transaction), count, file) != (size_t)count)
+    {
+        free(file_categories);
+        return -1;
+    }
+    int first_slot = tx_count;
+    tx_count += count;
+    write_month_header(file, &header);
+    fseek(file, MONTH_CATEGORY_OFFSET(0), SEEK_SET);
+    fwrite(file_categories, sizeof(Category), header.category_slots, file);
+    free(file_categories);
+    fwrite(&file_uncategorized_spent, sizeof(Money), 1, file);
+    if (fwrite(&tx_count, sizeof(int), 1, file) != 1 || fflush(file) != 0)
+    {
+        return -1;
+    }
+    unsigned long long previous_generation = month_generation(year, month);
+    manifest_record_month(year, month, file);
+    sidecars_add(year, month, first_slot, transactions, count, previous_generation);
 
+    // The in-memory copy is stale now; the dashboard reloads it on its next pass
+    if (year == loaded_year && month == loaded_month)
+    {
+        loaded_month = 0;
+    }
     return 1;
 }
 
@@ -502,36 +1019,14 @@ int add_transaction(Transaction *transaction, int year, int month)
  */
 int add_subscription(Subscription *subscription)
 {
-    FILE *file;
-    if (access(data_file_path, F_OK) == 0)
-    {
-        // File exists
-        file = fopen(data_file_path, "r+b");
-    }
-    else
-        return -1;
-    subscription_count++;
-    fseek(file, sizeof(FileHeader) + sizeof(int) * NUM_CONSTANTS + sizeof(double) + sizeof(int) + sizeof(Category) * MAX_CATEGORIES, SEEK_SET);
-    if (fwrite(&subscription_count, sizeof(int), 1, file) != 1)
+    Subscription *new_subscriptions = realloc(subscriptions, (subscription_count + 1) * sizeof(Subscription));
+    if (new_subscriptions == NULL)
     {
-        return -1;
-    }
-    fseek(file, sizeof(Subscription) * (subscription_count - 1), SEEK_CUR);
-
-    if (fwrite(subscription, sizeof(Subscription), 1, file) != 1)
-    {
-        return -1;
-    }
-
-    Subscription *new_subscriptions = realloc(subscriptions, subscription_count * sizeof(Subscription));
-    if (new_subscriptions)
-    {
-        subscriptions = new_subscriptions;
-        subscriptions[subscription_count - 1] = *subscription;
-    }
-    else
         return -2;
-    return 1;
+    }
+    subscriptions = new_subscriptions;
+    subscriptions[subscription_count++] = *subscription;
+    return save_budget_data();
 }
 
 /*
@@ -543,53 +1038,26 @@ int add_subscription(Subscription *subscription)
  */
 int remove_subscription(int index)
 {
-    FILE *file;
-    if (access(data_file_path, F_OK) == 0)
-    {
-        // File exists
-        file = fopen(data_file_path, "r+b");
-    }
-    else
-        return -1;
-    subscription_count--;
-    fseek(file, sizeof(FileHeader) + sizeof(int) * NUM_CONSTANTS + sizeof(double) + sizeof(int) + sizeof(Category) * MAX_CATEGORIES, SEEK_SET);
-    if (fwrite(&subscription_count, sizeof(int), 1, file) != 1)
+    if (index < 0 || index >= subscription_count)
     {
         return -1;
     }
-    Subscription to_replace = subscriptions[subscription_count];
-
-    fseek(file, sizeof(FileHeader) + sizeof(int) * NUM_CONSTANTS + sizeof(double) + sizeof(int) + sizeof(Category) * MAX_CATEGORIES + sizeof(int) + sizeof(Subscription) * index, SEEK_CUR);
-    if (fwrite(&to_replace, sizeof(Subscription), 1, file) != 1)
-    {
-        return -1;
-    }
-    Subscription *new_subscriptions = realloc(subscriptions, subscription_count * sizeof(Subscription));
-    if (new_subscriptions)
-    {
-        subscriptions = new_subscriptions;
-        subscriptions[index] = to_replace;
-    }
-    else
-    {
-        return -2;
-    }
-
-    int new_size = sizeof(double) + sizeof(int) * NUM_CONSTANTS + sizeof(double) + sizeof(int) + (sizeof(Category) * MAX_CATEGORIES) + sizeof(int) + subscription_count * sizeof(Transaction);
-    ftruncate(fileno(file), new_size);
-
-    return 1;
+    // The last subscription takes the removed one's place
+    subscriptions[index] = subscriptions[--subscription_count];
+    return save_budget_data();
 }
 
 /*
- * Add a category to the current month's data file
+ * Add a category to the current month's data file. It takes the first empty slot,
+ * or a new one at the end of the categories when there is none. Its parent_id is -1
+ * or the id of a top-level category.
  *
  * Returns:
  *   1     - Success
  *   -1    - I/O error occurred
  *   -2    - Category already exists
  *   -3    - Not in current month (shouldn't be possible with current app structure)
- *   -1XX  - Category count mismatch (XX = expected count)
+ *   -4    - Parent is missing or not a top-level category
  */
 int add_category(Category *category, int year, int month)
 {
@@ -597,45 +1065,109 @@ int add_category(Category *category, int year, int month)
     {
         return -3;
     }
+    int parent_slot = category_slot(category->parent_id);
+    if (category->parent_id != -1 &&
+        (parent_slot < 0 || categories[parent_slot].budget <= 0 || categories[parent_slot].parent_id != -1))
+    {
+        return -4;
+    }
     FILE *file = open_month_file(year, month);
-    int write_index = category_count;
     if (!file)
     {
         return -1;
     }
-    for (int i = 0; i < MAX_CATEGORIES; i++)
+    int write_index = -1;
+    for (int i = 0; i < category_slot_count; i++)
     {
-        if (categories[i].budget > 0.0)
+        if (categories[i].budget > 0)
         {
             if (strcmp(categories[i].name, category->name) == 0)
             {
                 return -2;
             }
         }
-        else if (write_index > i)
+        else if (write_index == -1)
         {
             write_index = i;
         }
     }
-    fseek(file, sizeof(double) + sizeof(int) + write_index * sizeof(Category), SEEK_SET);
+    MonthFileHeader header;
+    if (read_month_header(file, &header) != 1)
+    {
+        return -1;
+    }
+    if (write_index == -1)
+    {
+        write_index = header.category_slots;
+        if (category_table_reserve(header.category_slots + 1) < 0 ||
+            grow_month_categories(file, &header) != 1)
+        {
+            return -1;
+        }
+        category_slot_count = header.category_slots;
+    }
+    // A fresh id, so rows of whatever used to live in this slot don't follow it here
+    category->id = category_ids_assign(&header.category_ids);
+    write_month_header(file, &header);
+    category_ids = header.category_ids;
+
+    fseek(file, MONTH_CATEGORY_OFFSET(write_index), SEEK_SET);
     fwrite(category, sizeof(Category), 1, file);
     categories[write_index] = *category;
-    category_count++;
+    category_order_insert(write_index);
+    category_table_refresh_ids();
+    drop_column_order(SORT_BY_CATEGORY); // rows may now show a different category name
 
-    fseek(file, sizeof(double), SEEK_SET);
+    fseek(file, MONTH_CATEGORY_COUNT_OFFSET, SEEK_SET);
     fwrite(&category_count, sizeof(int), 1, file);
+    manifest_record_month(year, month, file);
 
     // if it's the most recent month, make this a default category
     if (year == today_year && month == today_month)
     {
-        default_category_count++;
-        memcpy(default_categories, categories, sizeof(categories));
+        remember_default_categories(categories, category_slot_count);
+        save_budget_data();
     }
     return 1;
 }
 
 /*
- * Remove a category from the current month's data file
+ * Point every alias at its target id in the stored rows themselves and empty the
+ * alias table. Only needed once the table fills up.
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ */
+static int flatten_category_aliases(FILE *file, MonthFileHeader *header)
+{
+    CategoryIds *ids = &header->category_ids;
+    for (TransactionNode *iter = transaction_head; iter != NULL; iter = iter->next)
+    {
+        for (int i = 0; i < ids->alias_count; i++)
+        {
+            if (iter->data.cat_id == ids->aliases[i].from_id)
+            {
+                order_index_remove(&sorted_transactions, iter);
+                iter->data.cat_id = ids->aliases[i].to_id;
+                sorted_transactions_insert(iter);
+                fseek(file, MONTH_TRANSACTION_OFFSET(header, iter->index), SEEK_SET);
+                if (fwrite(&iter->data, sizeof(Transaction), 1, file) != 1)
+                {
+                    return -1;
+                }
+                break;
+            }
+        }
+    }
+    ids->alias_count = 0;
+    return 1;
+}
+
+/*
+ * Remove a category from the current month's data file, moving its transactions
+ * to new_index (-1 leaves them uncategorized). The rows keep their category id;
+ * an alias in the month's id table sends it to the new category instead.
  *
  * Returns:
  *   1     - Success
@@ -643,84 +1175,93 @@ int add_category(Category *category, int year, int month)
  *   -2    - Category index out of bounds
  *   -3    - Not in current month (shouldn't be possible with current app structure)
  *   -4    - Category already doesn't exist
- *   -1XX  - Category count mismatch (XX = expected count)
  */
-int remove_category(int category_index, int year, int month)
+int remove_category(int category_index, int new_index, int year, int month)
 {
     if (year != current_year || month != current_month)
     {
         return -3;
     }
 
-    if (category_index < 0 || category_index >= MAX_CATEGORIES)
+    if (category_index < 0 || category_index >= category_slot_count ||
+        new_index < -1 || new_index >= category_slot_count || new_index == category_index)
     {
         return -2; // Category index out of bounds
     }
+    if (categories[category_index].budget <= 0)
+    {
+        return -4;
+    }
 
     FILE *file = open_month_file(year, month);
     if (!file)
     {
         return -1;
     }
-
-    categories[category_index].budget = 0.0; // effectively deletes it, but lets us use other data later
-    category_count--;
-    sort_categories_by_budget();
-    WINDOW *win = stdscr;
-    int max_y, max_x;
-    getmaxyx(win, max_y, max_x);
-
-    int new_index = -1;
-    if (category_count > 0)
+    MonthFileHeader header;
+    if (read_month_header(file, &header) != 1)
     {
-        // Keep the variable height calculation for transactions
-        int max_display = 10;
-        int display_count = current_month_transaction_count < max_display ? current_month_transaction_count : max_display;
-        int dialog_height = display_count > 1 ? display_count + 8 : 10;
-        int dialog_width = DEFAULT_DIALOG_WIDTH;
-        int start_y = (max_y - dialog_height) / 2;
-        int start_x = (max_x - dialog_width) / 2;
-        BoundedWindow dialog = draw_bounded_with_title(dialog_height, dialog_width, start_y, start_x, "Removing Category", false, ALIGN_CENTER);
-        wnoutrefresh(dialog.boundary);
-        int choice = get_category_choice_recategorize(dialog.textbox, categories[category_index].name);
-        if (choice > -1)
-            new_index = sorted_categories_indices[choice];
+        return -1;
     }
-    // update transactions
-    TransactionNode *iter = transaction_head;
-    while (iter != NULL)
+    int old_id = categories[category_index].id;
+    int new_id = category_id(new_index);
+    if (!category_ids_alias(&header.category_ids, old_id, new_id))
     {
-        if (iter->data.cat_index == category_index)
+        if (flatten_category_aliases(file, &header) < 0)
         {
-            iter->data.cat_index = new_index;
-            fseek(file, sizeof(double) + sizeof(int) + (sizeof(Category) * MAX_CATEGORIES) + sizeof(double) + iter->index * sizeof(Transaction), SEEK_SET);
-            fwrite(&iter->data, sizeof(Transaction), 1, file);
+            return -1;
+        }
+        category_ids_alias(&header.category_ids, old_id, new_id);
+    }
+    write_month_header(file, &header);
+    category_ids = header.category_ids;
+
+    drop_column_order(SORT_BY_CATEGORY); // its rows are about to change category
+    category_order_remove(category_index);
+    categories[category_index].budget = 0; // effectively deletes it, but lets us use other data later
+    categories[category_index].id = -1;      // nothing may resolve to the freed slot, even once a new category fills it
+    // Its children move up to the top level rather than going with it
+    for (int slot = 0; slot < category_slot_count; slot++)
+    {
+        if (categories[slot].budget > 0 && categories[slot].parent_id == old_id)
+        {
+            categories[slot].parent_id = -1;
+            fseek(file, MONTH_CATEGORY_OFFSET(slot), SEEK_SET);
+            fwrite(&categories[slot], sizeof(Category), 1, file);
         }
-        iter = iter->next;
     }
+    category_table_refresh_ids();
 
     if (new_index != -1)
     {
-        categories[new_index].spent += categories[category_index].spent;
+        category_add_spent(new_index, categories[category_index].spent);
     }
     else
     {
         uncategorized_spent += categories[category_index].spent;
     }
 
-    // Rewrite the file with the updated categories
-    fseek(file, sizeof(double), SEEK_SET);
+    // Write back the count and the two slots that changed
+    fseek(file, MONTH_CATEGORY_COUNT_OFFSET, SEEK_SET);
     fwrite(&category_count, sizeof(int), 1, file);
-    fwrite(&categories, sizeof(Category), MAX_CATEGORIES, file);
-    fwrite(&uncategorized_spent, sizeof(double), 1, file);
+    fseek(file, MONTH_CATEGORY_OFFSET(category_index), SEEK_SET);
+    fwrite(&categories[category_index], sizeof(Category), 1, file);
+    if (new_index != -1)
+    {
+        fseek(file, MONTH_CATEGORY_OFFSET(new_index), SEEK_SET);
+        fwrite(&categories[new_index], sizeof(Category), 1, file);
+    }
+    fseek(file, MONTH_UNCATEGORIZED_OFFSET(&header), SEEK_SET);
+    fwrite(&uncategorized_spent, sizeof(Money), 1, file);
+    manifest_record_month(year, month, file);
 
     // Update default categories if it's the current month
     if (year == today_year && month == today_month)
     {
-        memcpy(default_categories, categories, sizeof(categories));
+        remember_default_categories(categories, category_slot_count);
+        save_budget_data();
     }
 
-    fclose(file);
     return 1;
 }
 
@@ -732,7 +1273,7 @@ int remove_category(int category_index, int year, int month)
  *   -1    - Not in current month (shouldn't be possible with current app structure)
  *   -2    - I/O error occurred
  */
-int set_budget(double budget, int year, int month)
+int set_budget(Money budget, int year, int month)
 {
     if (year != current_year || month != current_month)
     {
@@ -743,8 +1284,9 @@ int set_budget(double budget, int year, int month)
     {
         return 0;
     }
-    fseek(file, 0, SEEK_SET);
-    fwrite(&budget, sizeof(double), 1, file);
+    fseek(file, MONTH_BUDGET_OFFSET, SEEK_SET);
+    fwrite(&budget, sizeof(Money), 1, file);
+    manifest_record_month(year, month, file);
     if (year == today_year && month == today_month)
     {
         default_monthly_budget = budget;
@@ -760,21 +1302,27 @@ int remove_transaction(int index)
     {
         return -1;
     }
-    TransactionNode *tx = sorted_transactions[index];
-    int cat_index = tx->data.cat_index;
-    if (cat_index == -1)
+    MonthFileHeader header;
+    TransactionNode *tx = order_index_at(&sorted_transactions, index);
+    if (tx == NULL || read_month_header(file, &header) != 1)
+    {
+        return 0;
+    }
+    int cat_slot = category_slot(tx->data.cat_id);
+    // Undo exactly what adding it did
+    if (cat_slot == -1)
     {
-        fseek(file, sizeof(double) + sizeof(int) + sizeof(Category) * MAX_CATEGORIES, SEEK_SET);
-        uncategorized_spent -= (-1 * (1 - tx->data.expense)) * tx->data.amt;
-        fwrite(&uncategorized_spent, sizeof(double), 1, file);
+        uncategorized_spent -= tx->data.amt;
+        fseek(file, MONTH_UNCATEGORIZED_OFFSET(&header), SEEK_SET);
+        fwrite(&uncategorized_spent, sizeof(Money), 1, file);
     }
     else
     {
-        categories[cat_index].spent -= (-1 * (1 - tx->data.expense)) * tx->data.amt;
-        fseek(file, sizeof(double) + sizeof(int) + sizeof(Category) * cat_index, SEEK_SET);
-        fwrite(&categories[cat_index], sizeof(Category), 1, file);
-        fseek(file, sizeof(double) + sizeof(int) + sizeof(Category) * MAX_CATEGORIES + sizeof(double), SEEK_SET);
+        category_add_spent(cat_slot, -tx->data.amt);
+        fseek(file, MONTH_CATEGORY_OFFSET(cat_slot), SEEK_SET);
+        fwrite(&categories[cat_slot], sizeof(Category), 1, file);
     }
+    fseek(file, MONTH_TRANSACTION_COUNT_OFFSET(&header), SEEK_SET);
     int tmp_count;
     if (fread(&tmp_count, sizeof(int), 1, file) != 1)
     {
@@ -784,101 +1332,566 @@ int remove_transaction(int index)
     fseek(file, -sizeof(int), SEEK_CUR);
     fwrite(&tmp_count, sizeof(int), 1, file);
 
-    TransactionNode *to_remove = sorted_transactions[index]; // parent -> transaction in LL
-
-    // Remove from UI by shifting all transactions after it one position back
-    for (int i = index; i < current_month_transaction_count - 1; i++)
-    {
-        sorted_transactions[i] = sorted_transactions[i + 1];
-    } // we should implement the changes buffer thing here instead
+    TransactionNode *to_remove = tx; // parent -> transaction in LL
+    order_index_remove(&sorted_transactions, to_remove);
+    column_orders_remove(to_remove);
 
     int remove_id = to_remove->index;
+    int moved_id = to_remove == transaction_tail ? -1 : transaction_tail->index;
+    id_table_delete(to_remove->data.id);
 
     if (to_remove == transaction_tail)
     {
         transaction_tail = to_remove->prev;
-        transaction_tail->next = NULL;
-        free(to_remove);
+        if (transaction_tail)
+        {
+            transaction_tail->next = NULL;
+        }
+        else
+        {
+            transaction_head = NULL;
+        }
     }
     else
     {
+        // Move the last record into the freed slot so the file stays dense
         TransactionNode *last = transaction_tail;
-        last->index = to_remove->index;
+        last->index = remove_id;
         transaction_tail = last->prev;
+        transaction_tail->next = NULL;
         last->next = to_remove->next;
         last->prev = to_remove->prev;
-        free(to_remove);
-        fseek(file, sizeof(double) + sizeof(int) + sizeof(Category) * MAX_CATEGORIES + sizeof(double) + sizeof(int) + sizeof(Transaction) * remove_id, SEEK_SET);
+        if (last->prev)
+        {
+            last->prev->next = last;
+        }
+        else
+        {
+            transaction_head = last;
+        }
+        if (last->next)
+        {
+            last->next->prev = last;
+        }
+        else
+        {
+            transaction_tail = last;
+        }
+        fseek(file, MONTH_TRANSACTION_OFFSET(&header, remove_id), SEEK_SET);
         fwrite(&last->data, sizeof(Transaction), 1, file);
     }
+    free(to_remove);
+    current_month_transaction_count--;
 
-    int new_size = sizeof(double) + sizeof(int) + (sizeof(Category) * MAX_CATEGORIES) + sizeof(double) + sizeof(int) + (tmp_count * sizeof(Transaction));
+    long new_size = MONTH_TRANSACTION_OFFSET(&header, tmp_count);
+    fflush(file); // buffered writes must land before the file is cut
     ftruncate(fileno(file), new_size);
+    unsigned long long previous_generation = month_generation(current_year, current_month);
+    manifest_record_month(current_year, current_month, file);
+    sidecars_remove(current_year, current_month, remove_id, moved_id, previous_generation);
     return 1;
 }
 
-int get_category_index(int year, int month, char *name)
+/*
+ * Remove many of the loaded month's transactions in one go. Totals are adjusted in
+ * memory, the surviving records are packed down in one pass keeping their order, and
+ * the totals, the count and the file length are each written once. Ids that aren't in
+ * the loaded month are skipped.
+ *
+ * Returns:
+ *   >= 0  - Number of transactions removed
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int remove_transactions(const unsigned long long *ids, int count)
 {
-    FILE *file = open_month_file(year, month);
+    FILE *file = open_month_file(current_year, current_month);
+    MonthFileHeader header;
+    if (!file || read_month_header(file, &header) != 1)
+    {
+        return -1;
+    }
+    int old_count = current_month_transaction_count;
+    int size = old_count > 0 ? old_count : 1;
+    TransactionNode **by_slot = calloc(size, sizeof(TransactionNode *));
+    bool *doomed = calloc(size, sizeof(bool));
+    int *new_slots = malloc(size * sizeof(int));
+    Transaction *packed = malloc(size * sizeof(Transaction));
+    if (by_slot == NULL || doomed == NULL || new_slots == NULL || packed == NULL)
+    {
+        free(by_slot);
+        free(doomed);
+        free(new_slots);
+        free(packed);
+        return -2;
+    }
+
+    int removed = 0;
+    int first_hole = old_count;
+    for (int i = 0; i < count; i++)
+    {
+        TransactionNode *node = find_transaction(ids[i]);
+        if (node != NULL && !doomed[node->index])
+        {
+            doomed[node->index] = true;
+            first_hole = MIN(first_hole, node->index);
+            removed++;
+        }
+    }
+    if (removed == 0)
+    {
+        free(by_slot);
+        free(doomed);
+        free(new_slots);
+        free(packed);
+        return 0;
+    }
+    for (TransactionNode *node = transaction_head; node != NULL; node = node->next)
+    {
+        by_slot[node->index] = node;
+    }
+
+    // One pass over the slots: drop the doomed nodes, renumber and relink the rest
+    int kept = 0;
+    transaction_head = transaction_tail = NULL;
+    for (int slot = 0; slot < old_count; slot++)
+    {
+        TransactionNode *node = by_slot[slot];
+        if (doomed[slot])
+        {
+            new_slots[slot] = -1;
+            int cat_slot = category_slot(node->data.cat_id);
+            if (cat_slot == -1)
+            {
+                uncategorized_spent -= node->data.amt;
+            }
+            else
+            {
+                category_add_spent(cat_slot, -node->data.amt);
+            }
+            order_index_remove(&sorted_transactions, node);
+            column_orders_remove(node);
+            id_table_delete(node->data.id);
+            free(node);
+            continue;
+        }
+        new_slots[slot] = kept;
+        node->index = kept;
+        node->prev = transaction_tail;
+        node->next = NULL;
+        if (transaction_tail)
+        {
+            transaction_tail->next = node;
+        }
+        else
+        {
+            transaction_head = node;
+        }
+        transaction_tail = node;
+        if (kept >= first_hole)
+        {
+            packed[kept - first_hole] = node->data;
+        }
+        kept++;
+    }
+    free(by_slot);
+    free(doomed);
+    current_month_transaction_count = kept;
+
+    // Records, then totals and count, then the length
+    bool ok = fseek(file, MONTH_TRANSACTION_OFFSET(&header, first_hole), SEEK_SET) == 0 &&
+              fwrite(packed, sizeof(Transaction), kept - first_hole, file) == (size_t)(kept - first_hole) &&
+              fseek(file, MONTH_CATEGORY_OFFSET(0), SEEK_SET) == 0 &&
+              fwrite(categories, sizeof(Category), category_slot_count, file) == (size_t)category_slot_count &&
+              fwrite(&uncategorized_spent, sizeof(Money), 1, file) == 1 &&
+              fwrite(&current_month_transaction_count, sizeof(int), 1, file) == 1 &&
+              fflush(file) == 0 &&
+              ftruncate(fileno(file), MONTH_TRANSACTION_OFFSET(&header, kept)) == 0;
+    free(packed);
+    if (!ok)
+    {
+        free(new_slots);
+        return -1;
+    }
+    unsigned long long previous_generation = month_generation(current_year, current_month);
+    manifest_record_month(current_year, current_month, file);
+    sidecars_remove_slots(current_year, current_month, new_slots, old_count, previous_generation);
+    free(new_slots);
+    return removed;
+}
+
+/*
+ * Rewrite one stored transaction, found by its id, and move its amount between the
+ * month's totals if the amount or category changed. The transaction stays in the
+ * month its id was issued for; moving it to another month is a remove and an add.
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Unknown category id
+ *   -3    - Date is in another month
+ *   -4    - No transaction with that id
+ */
+int update_transaction(const Transaction *updated)
+{
+    int year = TRANSACTION_ID_YEAR(updated->id);
+    int month = TRANSACTION_ID_MONTH(updated->id);
+    if (get_year_from_date(updated->date) != year || get_month_from_date(updated->date) != month)
+    {
+        return -3;
+    }
+    FILE *file = open_existing_month_file(year, month);
     if (!file)
+    {
+        return -4;
+    }
+    MonthFileHeader header;
+    if (read_month_header(file, &header) != 1)
+    {
+        return -4;
+    }
+    Category *file_categories;
+    if (read_month_categories_section(file, &header, &file_categories) != 1)
     {
         return -1;
     }
-    // Read category count
-    fseek(file, 0, SEEK_END);
-    if (ftell(file) == 0)
+    int new_slot = month_category_slot(file_categories, header.category_slots, &header.category_ids, updated->cat_id);
+    if (new_slot == -3)
+    {
+        free(file_categories);
+        return -2;
+    }
+
+    // The loaded month knows every slot; any other month is scanned once
+    TransactionNode *node = year == loaded_year && month == loaded_month ? find_transaction(updated->id) : NULL;
+    Transaction old;
+    int slot = -1;
+    if (node != NULL)
     {
-        fwrite(&default_monthly_budget, sizeof(double), 1, file);
-        fwrite(&default_category_count, sizeof(int), 1, file);
-        // fills with empty category data
-        fwrite(&(Category){0}, sizeof(Category), MAX_CATEGORIES, file);
-        // fills with default categories if there are any
-        fseek(file, sizeof(double) + sizeof(int), SEEK_SET);
-        fwrite(default_categories, sizeof(Category), default_category_count, file);
-        fseek(file, 0, SEEK_END);
-        fwrite(&(double){0}, sizeof(double), 1, file); // uncategorized spent
-        fwrite(&(int){0}, sizeof(int), 1, file);       // number of transactions (0)
-    }
-    fseek(file, sizeof(double), SEEK_SET);
-    int file_category_count = 0;
-    if (fread(&file_category_count, sizeof(int), 1, file) != 1)
+        old = node->data;
+        slot = node->index;
+    }
+    else
     {
-        fclose(file);
+        int tx_count;
+        fseek(file, MONTH_TRANSACTION_COUNT_OFFSET(&header), SEEK_SET);
+        if (fread(&tx_count, sizeof(int), 1, file) != 1)
+        {
+            free(file_categories);
+            return -1;
+        }
+        for (int i = 0; i < tx_count && slot < 0; i++)
+        {
+            if (fread(&old, sizeof(Transaction), 1, file) != 1)
+            {
+                free(file_categories);
+                return -1;
+            }
+            if (old.id == updated->id)
+            {
+                slot = i;
+            }
+        }
+    }
+    Money file_uncategorized_spent;
+    if (slot < 0)
+    {
+        free(file_categories);
+        return -4;
+    }
+    fseek(file, MONTH_UNCATEGORIZED_OFFSET(&header), SEEK_SET);
+    if (fread(&file_uncategorized_spent, sizeof(Money), 1, file) != 1)
+    {
+        free(file_categories);
         return -1;
     }
-    // Read categories
-    Category file_categories[MAX_CATEGORIES];
-    if (fread(file_categories, sizeof(Category), file_category_count, file) != (size_t)file_category_count)
+    int old_slot = month_category_slot(file_categories, header.category_slots, &header.category_ids, old.cat_id);
+    if (old_slot >= 0)
     {
-        fclose(file);
+        file_categories[old_slot].spent -= old.amt;
+    }
+    else
+    {
+        file_uncategorized_spent -= old.amt;
+    }
+    if (new_slot >= 0)
+    {
+        file_categories[new_slot].spent += updated->amt;
+    }
+    else
+    {
+        file_uncategorized_spent += updated->amt;
+    }
+
+    fseek(file, MONTH_CATEGORY_OFFSET(0), SEEK_SET);
+    fwrite(file_categories, sizeof(Category), header.category_slots, file);
+    fwrite(&file_uncategorized_spent, sizeof(Money), 1, file);
+    fseek(file, MONTH_TRANSACTION_OFFSET(&header, slot), SEEK_SET);
+    if (fwrite(updated, sizeof(Transaction), 1, file) != 1 || fflush(file) != 0)
+    {
+        free(file_categories);
         return -1;
     }
-    fclose(file);
-    for (int i = 0; i < file_category_count; i++)
+    unsigned long long previous_generation = month_generation(year, month);
+    manifest_record_month(year, month, file);
+    sidecars_update(year, month, slot, updated, previous_generation);
+
+    if (node != NULL)
     {
-        if (strcmp(file_categories[i].name, name) == 0)
+        // Out of the sorted view while its sort key changes
+        order_index_remove(&sorted_transactions, node);
+        column_orders_remove(node);
+        node->data = *updated;
+        sorted_transactions_insert(node);
+        column_orders_insert(node);
+        // Only spent changed, so the budget order still holds
+        if (old_slot >= 0)
+        {
+            category_add_spent(old_slot, -old.amt);
+        }
+        if (new_slot >= 0)
         {
-            return i;
+            category_add_spent(new_slot, updated->amt);
         }
+        uncategorized_spent = file_uncategorized_spent;
     }
-    return -1; // Not found
+    free(file_categories);
+    return 1;
 }
 
-// Reads categories for a given month from the savefile into out_categories and out_count, without modifying global state
-int read_month_categories(int year, int month, Category *out_categories, int *out_count)
+// Id of the named category in that month, or -1 if it has none
+int get_category_index(int year, int month, char *name)
 {
-    FILE *file = open_month_file(year, month);
+    Category *file_categories;
+    int slot_count;
+    if (read_month_categories(year, month, &file_categories, &slot_count, NULL) != 1)
+    {
+        return -1;
+    }
+    // Removed categories leave holes, so every slot is checked
+    int id = -1;
+    for (int i = 0; i < slot_count && id == -1; i++)
+    {
+        if (file_categories[i].budget > 0 && strcmp(file_categories[i].name, name) == 0)
+        {
+            id = file_categories[i].id;
+        }
+    }
+    free(file_categories);
+    return id;
+}
+
+/*
+ * Reads categories for a given month from the savefile, without modifying global state.
+ * A month with no file yet reports the categories it would be created with.
+ * out_ids, if not NULL, receives the month's category id table.
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int read_month_categories(int year, int month, Category **out_categories, int *out_slots, CategoryIds *out_ids)
+{
+    *out_categories = NULL;
+    *out_slots = 0;
+    CategoryIds ids;
+    FILE *file = open_existing_month_file(year, month);
+    MonthFileHeader header;
+    int res = file ? read_month_header(file, &header) : 0;
+    if (res < 0)
+    {
+        return -1;
+    }
+    if (res == 0)
+    {
+        *out_categories = new_month_categories(&ids);
+        if (*out_categories == NULL)
+        {
+            return -2;
+        }
+        *out_slots = default_category_count;
+    }
+    else
+    {
+        res = read_month_categories_section(file, &header, out_categories);
+        if (res != 1)
+        {
+            return res;
+        }
+        *out_slots = header.category_slots;
+        ids = header.category_ids;
+    }
+    if (out_ids != NULL)
+    {
+        *out_ids = ids;
+    }
+    return 1;
+}
+
+/*
+ * Read every transaction stored for a month without touching the loaded month.
+ * Months that were never written are reported as empty rather than created.
+ * The caller frees *out_transactions.
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - No data file for this month
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int read_month_transactions(int year, int month, Transaction **out_transactions, int *out_count)
+{
+    *out_transactions = NULL;
+    *out_count = 0;
+    FILE *file = open_existing_month_file(year, month);
     if (!file)
+    {
+        return 0;
+    }
+    MonthFileHeader header;
+    int res = read_month_header(file, &header);
+    if (res <= 0)
+    {
+        return res; // 0 if created but never written
+    }
+
+    int tx_count;
+    fseek(file, MONTH_TRANSACTION_COUNT_OFFSET(&header), SEEK_SET);
+    if (fread(&tx_count, sizeof(int), 1, file) != 1 || tx_count < 0)
+    {
         return -1;
-    fseek(file, sizeof(double), SEEK_SET);
-    if (fread(out_count, sizeof(int), 1, file) != 1)
+    }
+    if (tx_count == 0)
+    {
+        return 1;
+    }
+    Transaction *transactions = malloc(tx_count * sizeof(Transaction));
+    if (!transactions)
+    {
+        return -2;
+    }
+    if (fread(transactions, sizeof(Transaction), tx_count, file) != (size_t)tx_count)
+    {
+        free(transactions);
+        return -1;
+    }
+    *out_transactions = transactions;
+    *out_count = tx_count;
+    return 1;
+}
+
+/*
+ * Read the transaction stored in one slot of a month
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - No data file for this month, or no such slot
+ *   -1    - I/O error occurred
+ */
+int read_month_transaction(int year, int month, int slot, Transaction *out_transaction)
+{
+    FILE *file = open_existing_month_file(year, month);
+    if (!file)
+    {
+        return 0;
+    }
+    MonthFileHeader header;
+    int res = read_month_header(file, &header);
+    if (res <= 0)
+    {
+        return res;
+    }
+
+    int tx_count;
+    fseek(file, MONTH_TRANSACTION_COUNT_OFFSET(&header), SEEK_SET);
+    if (fread(&tx_count, sizeof(int), 1, file) != 1 || tx_count < 0)
     {
         return -1;
     }
-    if (fread(out_categories, sizeof(Category), MAX_CATEGORIES, file) != (size_t)MAX_CATEGORIES)
+    if (slot < 0 || slot >= tx_count)
+    {
+        return 0;
+    }
+    fseek(file, MONTH_TRANSACTION_OFFSET(&header, slot), SEEK_SET);
+    return fread(out_transaction, sizeof(Transaction), 1, file) == 1 ? 1 : -1;
+}
+
+/*
+ * Read a whole month file through a private handle. Touches no globals and not the
+ * file cache, so it is safe to call from worker threads. The caller releases the
+ * transactions with free_month_snapshot.
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - No data file for this month
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int read_month_snapshot(int year, int month, MonthSnapshot *snapshot)
+{
+    memset(snapshot, 0, sizeof(MonthSnapshot));
+    char path[MAX_BUFFER + 32];
+    snprintf(path, sizeof(path), "%s/%d-%d.dat", data_storage_dir, year, month);
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return 0;
+    }
+
+    MonthFileHeader header;
+    int res = read_month_header(file, &header);
+    if (res <= 0)
     {
+        fclose(file);
+        return res; // 0 if created but never written
+    }
+    snapshot->category_ids = header.category_ids;
+    snapshot->category_slots = header.category_slots;
+    snapshot->categories = malloc((header.category_slots > 0 ? header.category_slots : 1) * sizeof(Category));
+    if (!snapshot->categories)
+    {
+        fclose(file);
+        return -2;
+    }
+    if (fread(&snapshot->budget, sizeof(Money), 1, file) != 1 ||
+        fread(&snapshot->category_count, sizeof(int), 1, file) != 1 ||
+        fread(snapshot->categories, sizeof(Category), header.category_slots, file) != (size_t)header.category_slots ||
+        fread(&snapshot->uncategorized_spent, sizeof(Money), 1, file) != 1 ||
+        fread(&snapshot->transaction_count, sizeof(int), 1, file) != 1 ||
+        snapshot->transaction_count < 0)
+    {
+        free_month_snapshot(snapshot);
+        fclose(file);
         return -1;
     }
+
+    if (snapshot->transaction_count > 0)
+    {
+        snapshot->transactions = malloc(snapshot->transaction_count * sizeof(Transaction));
+        if (!snapshot->transactions)
+        {
+            free_month_snapshot(snapshot);
+            fclose(file);
+            return -2;
+        }
+        if (fread(snapshot->transactions, sizeof(Transaction), snapshot->transaction_count, file) != (size_t)snapshot->transaction_count)
+        {
+            free_month_snapshot(snapshot);
+            fclose(file);
+            return -1;
+        }
+    }
     fclose(file);
     return 1;
-}
\ No newline at end of file
+}
+
+void free_month_snapshot(MonthSnapshot *snapshot)
+{
+    free(snapshot->categories);
+    snapshot->categories = NULL;
+    snapshot->category_slots = 0;
+    free(snapshot->transactions);
+    snapshot->transactions = NULL;
+    snapshot->transaction_count = 0;
+}
@@ -0,0 +1,963 @@
+#include "search_index.h"
+#include "saveload.h"
+
+// Longest description is MAX_NAME_LEN - 1 chars, so at most this many trigrams
+#define MAX_DESC_TRIGRAMS (MAX_NAME_LEN - 3)
+
+// Distinct lowercase trigrams of text; returns how many were written
+static int extract_trigrams(const char *text, unsigned int *out)
+{
+    int count = 0;
+    size_t len = strlen(text);
+    for (size_t i = 0; i + 3 <= len && count < MAX_DESC_TRIGRAMS; i++)
+    {
+        unsigned int trigram = (unsigned int)tolower((unsigned char)text[i]) << 16 |
+                               (unsigned int)tolower((unsigned char)text[i + 1]) << 8 |
+                               (unsigned int)tolower((unsigned char)text[i + 2]);
+        bool seen = false;
+        for (int j = 0; j < count && !seen; j++)
+        {
+            seen = out[j] == trigram;
+        }
+        if (!seen)
+        {
+            out[count++] = trigram;
+        }
+    }
+    return count;
+}
+
+static int compare_postings(const void *a, const void *b)
+{
+    const TrigramPosting *pa = a, *pb = b;
+    if (pa->trigram != pb->trigram)
+    {
+        return pa->trigram < pb->trigram ? -1 : 1;
+    }
+    return pa->slot - pb->slot;
+}
+
+// Make room for extra more postings
+static int reserve_postings(TrigramPosting **postings, int count, int *capacity, int extra)
+{
+    if (count + extra > *capacity)
+    {
+        int new_capacity = *capacity > 0 ? *capacity : 256;
+        while (new_capacity < count + extra)
+        {
+            new_capacity *= 2;
+        }
+        TrigramPosting *grown = realloc(*postings, new_capacity * sizeof(TrigramPosting));
+        if (grown == NULL)
+        {
+            return -2;
+        }
+        *postings = grown;
+        *capacity = new_capacity;
+    }
+    return 1;
+}
+
+// Append the postings for one description, growing the array as needed
+static int add_postings(TrigramPosting **postings, int *count, int *capacity, const char *desc, int slot)
+{
+    unsigned int trigrams[MAX_DESC_TRIGRAMS];
+    int trigram_count = extract_trigrams(desc, trigrams);
+    if (reserve_postings(postings, *count, capacity, trigram_count) < 0)
+    {
+        return -2;
+    }
+    for (int i = 0; i < trigram_count; i++)
+    {
+        (*postings)[*count].trigram = trigrams[i];
+        (*postings)[*count].slot = slot;
+        (*count)++;
+    }
+    return 1;
+}
+
+// Append a delta group: the clear record for slot, then the postings for desc
+static int add_group(TrigramPosting **postings, int *count, int *capacity, const char *desc, int slot)
+{
+    if (reserve_postings(postings, *count, capacity, 1) < 0)
+    {
+        return -2;
+    }
+    (*postings)[*count].trigram = SEARCH_DELTA_CLEAR;
+    (*postings)[*count].slot = slot;
+    (*count)++;
+    return add_postings(postings, count, capacity, desc, slot);
+}
+
+/*
+ * Write the postings as a trigram directory followed by the slot lists, through a
+ * temporary file so a search never sees half an index
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+static int save_index(int year, int month, TrigramPosting *postings, int count, int transaction_count, unsigned long long generation)
+{
+    qsort(postings, count, sizeof(TrigramPosting), compare_postings);
+    SearchTrigram *directory = malloc((count > 0 ? count : 1) * sizeof(SearchTrigram));
+    int *slots = malloc((count > 0 ? count : 1) * sizeof(int));
+    if (directory == NULL || slots == NULL)
+    {
+        free(directory);
+        free(slots);
+        return -2;
+    }
+
+    SearchIndexHeader header = {
+        .magic = SEARCH_INDEX_MAGIC,
+        .version = SEARCH_INDEX_VERSION,
+        .transaction_count = transaction_count,
+        .trigram_count = 0,
+        .posting_count = count,
+        .generation = generation};
+    for (int i = 0; i < count; i++)
+    {
+        if (i == 0 || postings[i].trigram != postings[i - 1].trigram)
+        {
+            directory[header.trigram_count].trigram = postings[i].trigram;
+            directory[header.trigram_count].first = i;
+            directory[header.trigram_count].count = 0;
+            header.trigram_count++;
+        }
+        directory[header.trigram_count - 1].count++;
+        slots[i] = postings[i].slot;
+    }
+
+    char path[MAX_BUFFER + 32], tmp_path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "tri", "");
+    sidecar_path(tmp_path, sizeof(tmp_path), year, month, "tri", ".tmp");
+    FILE *file = fopen(tmp_path, "wb");
+    bool ok = file != NULL &&
+              fwrite(&header, sizeof(SearchIndexHeader), 1, file) == 1 &&
+              fwrite(directory, sizeof(SearchTrigram), header.trigram_count, file) == (size_t)header.trigram_count &&
+              fwrite(slots, sizeof(int), count, file) == (size_t)count;
+    free(directory);
+    free(slots);
+    if (file == NULL || fclose(file) != 0 || !ok)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return rename(tmp_path, path) == 0 ? 1 : -1;
+}
+
+/*
+ * Read a month's index back into flat postings with the delta applied: postings a
+ * later delta group replaced are dropped, and so are slots at or past
+ * transaction_count. On return header->posting_count counts the postings kept and
+ * header->delta_count is 0.
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - No index, or one written by another version
+ *   -2    - Malloc error
+ */
+static int load_index(int year, int month, SearchIndexHeader *header, TrigramPosting **out_postings, int *out_capacity)
+{
+    char path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "tri", "");
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    if (fread(header, sizeof(SearchIndexHeader), 1, file) != 1 ||
+        strcmp(header->magic, SEARCH_INDEX_MAGIC) != 0 || header->version != SEARCH_INDEX_VERSION ||
+        header->transaction_count < 0 || header->trigram_count < 0 || header->posting_count < 0 || header->delta_count < 0)
+    {
+        fclose(file);
+        return 0;
+    }
+
+    int capacity = header->posting_count + header->delta_count > 0 ? header->posting_count + header->delta_count : 1;
+    SearchTrigram *directory = malloc((header->trigram_count > 0 ? header->trigram_count : 1) * sizeof(SearchTrigram));
+    int *slots = malloc(capacity * sizeof(int));
+    TrigramPosting *postings = malloc(capacity * sizeof(TrigramPosting));
+    // Start of the last delta group for each slot, or -1 if its postings are still in the lists
+    int *last_group = malloc((header->transaction_count > 0 ? header->transaction_count : 1) * sizeof(int));
+    if (directory == NULL || slots == NULL || postings == NULL || last_group == NULL)
+    {
+        free(directory);
+        free(slots);
+        free(postings);
+        free(last_group);
+        fclose(file);
+        return -2;
+    }
+    int res = 1;
+    if (fread(directory, sizeof(SearchTrigram), header->trigram_count, file) != (size_t)header->trigram_count ||
+        fread(slots, sizeof(int), header->posting_count, file) != (size_t)header->posting_count)
+    {
+        res = 0;
+    }
+    for (int i = 0; i < header->trigram_count && res > 0; i++)
+    {
+        if (directory[i].first < 0 || directory[i].count < 0 || directory[i].first + directory[i].count > header->posting_count)
+        {
+            res = 0;
+            break;
+        }
+        for (int j = directory[i].first; j < directory[i].first + directory[i].count; j++)
+        {
+            postings[j].trigram = directory[i].trigram;
+            postings[j].slot = slots[j];
+        }
+    }
+    TrigramPosting *delta = &postings[header->posting_count];
+    if (res > 0 &&
+        fread(delta, sizeof(TrigramPosting), header->delta_count, file) != (size_t)header->delta_count)
+    {
+        res = 0;
+    }
+    free(directory);
+    free(slots);
+    fclose(file);
+    if (res <= 0)
+    {
+        free(postings);
+        free(last_group);
+        return res;
+    }
+
+    for (int i = 0; i < header->transaction_count; i++)
+    {
+        last_group[i] = -1;
+    }
+    for (int i = 0; i < header->delta_count; i++)
+    {
+        if (delta[i].trigram == SEARCH_DELTA_CLEAR && delta[i].slot >= 0 && delta[i].slot < header->transaction_count)
+        {
+            last_group[delta[i].slot] = i;
+        }
+    }
+    int kept = 0;
+    for (int i = 0; i < header->posting_count; i++)
+    {
+        int slot = postings[i].slot;
+        if (slot >= 0 && slot < header->transaction_count && last_group[slot] < 0)
+        {
+            postings[kept++] = postings[i];
+        }
+    }
+    // kept never passes the record being read, so the delta compacts in place
+    for (int i = 0, group = -1; i < header->delta_count; i++)
+    {
+        int slot = delta[i].slot;
+        if (delta[i].trigram == SEARCH_DELTA_CLEAR)
+        {
+            group = i;
+        }
+        else if (slot >= 0 && slot < header->transaction_count && last_group[slot] == group)
+        {
+            postings[kept++] = delta[i];
+        }
+    }
+    free(last_group);
+    header->posting_count = kept;
+    header->delta_count = 0;
+    *out_postings = postings;
+    *out_capacity = capacity;
+    return 1;
+}
+
+// Index every description in the month file from scratch
+static int rebuild_index(int year, int month, unsigned long long generation)
+{
+    Transaction *transactions;
+    int transaction_count;
+    int res = read_month_transactions(year, month, &transactions, &transaction_count);
+    if (res < 0)
+    {
+        return res;
+    }
+    TrigramPosting *postings = NULL;
+    int count = 0, capacity = 0;
+    for (int i = 0; i < transaction_count && res >= 0; i++)
+    {
+        res = add_postings(&postings, &count, &capacity, transactions[i].desc, i);
+    }
+    free(transactions);
+    if (res >= 0)
+    {
+        res = save_index(year, month, postings, count, transaction_count, generation);
+    }
+    free(postings);
+    return res;
+}
+
+/*
+ * Append delta groups to the index of a month that had expected_count records, then
+ * rewrite the header to cover them
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - The index needs a full rewrite: it doesn't match, or the delta is full
+ *   -1    - I/O error occurred
+ */
+static int append_delta(int year, int month, const TrigramPosting *records, int record_count, int expected_count,
+                        unsigned long long previous_generation, const ManifestEntry *entry)
+{
+    char path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "tri", "");
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    SearchIndexHeader header;
+    int limit = 0;
+    if (fread(&header, sizeof(SearchIndexHeader), 1, file) == 1)
+    {
+        limit = header.posting_count / 8 > SEARCH_INDEX_MIN_DELTA ? header.posting_count / 8 : SEARCH_INDEX_MIN_DELTA;
+    }
+    if (limit == 0 ||
+        strcmp(header.magic, SEARCH_INDEX_MAGIC) != 0 || header.version != SEARCH_INDEX_VERSION ||
+        header.generation != previous_generation || header.transaction_count != expected_count ||
+        header.trigram_count < 0 || header.posting_count < 0 || header.delta_count < 0 ||
+        header.delta_count + record_count > limit)
+    {
+        fclose(file);
+        return 0;
+    }
+
+    // A torn append is past the old header's delta_count, so readers never see it
+    long delta_end = sizeof(SearchIndexHeader) + header.trigram_count * sizeof(SearchTrigram) +
+                     header.posting_count * sizeof(int) + header.delta_count * sizeof(TrigramPosting);
+    header.transaction_count = entry->transaction_count;
+    header.delta_count += record_count;
+    header.generation = entry->generation;
+    bool ok = fseek(file, delta_end, SEEK_SET) == 0 &&
+              fwrite(records, sizeof(TrigramPosting), record_count, file) == (size_t)record_count &&
+              fflush(file) == 0 &&
+              fseek(file, 0, SEEK_SET) == 0 &&
+              fwrite(&header, sizeof(SearchIndexHeader), 1, file) == 1;
+    return fclose(file) == 0 && ok ? 1 : -1;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int search_index_add(int year, int month, int first_slot, const Transaction *transactions, int count, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        return 1;
+    }
+
+    if (previous_generation != 0 || first_slot != 0)
+    {
+        TrigramPosting *records = NULL;
+        int record_count = 0, record_capacity = 0, res = 1;
+        for (int i = 0; i < count && res >= 0; i++)
+        {
+            res = add_group(&records, &record_count, &record_capacity, transactions[i].desc, first_slot + i);
+        }
+        if (res >= 0)
+        {
+            res = append_delta(year, month, records, record_count, first_slot, previous_generation, entry);
+        }
+        free(records);
+        if (res != 0)
+        {
+            return res;
+        }
+    }
+
+    SearchIndexHeader header;
+    TrigramPosting *postings = NULL;
+    int posting_count = 0, capacity = 0;
+    if (previous_generation != 0 || first_slot != 0)
+    {
+        int res = load_index(year, month, &header, &postings, &capacity);
+        if (res < 0)
+        {
+            return res;
+        }
+        if (res == 0 || header.generation != previous_generation || header.transaction_count != first_slot)
+        {
+            free(postings);
+            return rebuild_index(year, month, entry->generation);
+        }
+        posting_count = header.posting_count;
+    }
+
+    int res = 1;
+    for (int i = 0; i < count && res >= 0; i++)
+    {
+        res = add_postings(&postings, &posting_count, &capacity, transactions[i].desc, first_slot + i);
+    }
+    if (res >= 0)
+    {
+        res = save_index(year, month, postings, posting_count, entry->transaction_count, entry->generation);
+    }
+    free(postings);
+    return res;
+}
+
+/*
+ * Append a delta group for every slot that holds a different record after a removal,
+ * read back from the month file. Slots past the new count need nothing.
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - The index needs a full rewrite
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+static int append_moves(int year, int month, const int *new_slots, int old_count,
+                        unsigned long long previous_generation, const ManifestEntry *entry)
+{
+    int new_count = entry->transaction_count;
+    bool *kept = calloc(new_count > 0 ? new_count : 1, sizeof(bool));
+    if (kept == NULL)
+    {
+        return -2;
+    }
+    for (int i = 0; i < old_count && i < new_count; i++)
+    {
+        kept[i] = new_slots[i] == i;
+    }
+
+    TrigramPosting *records = NULL;
+    int record_count = 0, record_capacity = 0, res = 1;
+    for (int slot = 0; slot < new_count && res > 0; slot++)
+    {
+        if (kept[slot])
+        {
+            continue;
+        }
+        Transaction moved;
+        res = read_month_transaction(year, month, slot, &moved);
+        if (res > 0)
+        {
+            res = add_group(&records, &record_count, &record_capacity, moved.desc, slot);
+        }
+    }
+    free(kept);
+    if (res > 0)
+    {
+        res = append_delta(year, month, records, record_count, old_count, previous_generation, entry);
+    }
+    free(records);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int search_index_remove(int year, int month, int slot, int moved_slot, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    int old_count = entry != NULL ? entry->transaction_count + 1 : 1;
+    int *new_slots = removal_slot_map(slot, moved_slot, old_count);
+    if (new_slots == NULL)
+    {
+        return -2;
+    }
+    int res = search_index_remove_slots(year, month, new_slots, old_count, previous_generation);
+    free(new_slots);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int search_index_remove_slots(int year, int month, const int *new_slots, int old_count, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        // Month is empty now
+        char path[MAX_BUFFER + 32];
+        sidecar_path(path, sizeof(path), year, month, "tri", "");
+        remove(path);
+        return 1;
+    }
+
+    int res = append_moves(year, month, new_slots, old_count, previous_generation, entry);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    SearchIndexHeader header;
+    TrigramPosting *postings = NULL;
+    int capacity;
+    res = load_index(year, month, &header, &postings, &capacity);
+    if (res < 0)
+    {
+        return res;
+    }
+    if (res == 0 || header.generation != previous_generation || header.transaction_count != old_count)
+    {
+        free(postings);
+        return rebuild_index(year, month, entry->generation);
+    }
+
+    int kept = 0;
+    for (int i = 0; i < header.posting_count; i++)
+    {
+        int slot = postings[i].slot >= 0 && postings[i].slot < old_count ? new_slots[postings[i].slot] : -1;
+        if (slot < 0)
+        {
+            continue;
+        }
+        postings[kept] = postings[i];
+        postings[kept++].slot = slot;
+    }
+    res = save_index(year, month, postings, kept, entry->transaction_count, entry->generation);
+    free(postings);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int search_index_update(int year, int month, int slot, const Transaction *transaction, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        return 1;
+    }
+
+    TrigramPosting *records = NULL;
+    int record_count = 0, record_capacity = 0;
+    int res = add_group(&records, &record_count, &record_capacity, transaction->desc, slot);
+    if (res >= 0)
+    {
+        res = append_delta(year, month, records, record_count, entry->transaction_count, previous_generation, entry);
+    }
+    free(records);
+    if (res != 0)
+    {
+        return res;
+    }
+
+    SearchIndexHeader header;
+    TrigramPosting *postings = NULL;
+    int capacity;
+    res = load_index(year, month, &header, &postings, &capacity);
+    if (res < 0)
+    {
+        return res;
+    }
+    if (res == 0 || header.generation != previous_generation || header.transaction_count != entry->transaction_count)
+    {
+        free(postings);
+        return rebuild_index(year, month, entry->generation);
+    }
+
+    int kept = 0;
+    for (int i = 0; i < header.posting_count; i++)
+    {
+        if (postings[i].slot != slot)
+        {
+            postings[kept++] = postings[i];
+        }
+    }
+    res = add_postings(&postings, &kept, &capacity, transaction->desc, slot);
+    if (res >= 0)
+    {
+        res = save_index(year, month, postings, kept, entry->transaction_count, entry->generation);
+    }
+    free(postings);
+    return res;
+}
+
+static const SearchTrigram *find_trigram(const SearchTrigram *directory, int count, unsigned int trigram)
+{
+    int left = 0, right = count - 1;
+    while (left <= right)
+    {
+        int mid = (left + right) / 2;
+        if (directory[mid].trigram == trigram)
+        {
+            return &directory[mid];
+        }
+        if (directory[mid].trigram < trigram)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid - 1;
+        }
+    }
+    return NULL;
+}
+
+static int compare_trigrams_by_count(const void *a, const void *b)
+{
+    return (*(const SearchTrigram *const *)a)->count - (*(const SearchTrigram *const *)b)->count;
+}
+
+// A delta group as seen by a search
+typedef struct
+{
+    int slot;
+    int order; // position in the delta, so a slot's last group sorts last
+    bool matched;
+} DeltaGroup;
+
+static int compare_groups(const void *a, const void *b)
+{
+    const DeltaGroup *ga = a, *gb = b;
+    if (ga->slot != gb->slot)
+    {
+        return ga->slot < gb->slot ? -1 : 1;
+    }
+    return ga->order - gb->order;
+}
+
+/*
+ * Slots in a month whose descriptions contain every query trigram. Without query
+ * trigrams (text shorter than three characters) every slot is a candidate.
+ *
+ * Returns:
+ *   >=0   - Number of candidates written to *out_slots
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+static int month_candidates(const ManifestEntry *entry, const unsigned int *trigrams, int trigram_count, int **out_slots)
+{
+    *out_slots = NULL;
+    if (trigram_count == 0)
+    {
+        int *slots = malloc((entry->transaction_count > 0 ? entry->transaction_count : 1) * sizeof(int));
+        if (slots == NULL)
+        {
+            return -2;
+        }
+        for (int i = 0; i < entry->transaction_count; i++)
+        {
+            slots[i] = i;
+        }
+        *out_slots = slots;
+        return entry->transaction_count;
+    }
+
+    char path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), entry->year, entry->month, "tri", "");
+    SearchIndexHeader header;
+    FILE *file = NULL;
+    for (int attempt = 0; attempt < 2 && file == NULL; attempt++)
+    {
+        file = fopen(path, "rb");
+        if (file != NULL &&
+            (fread(&header, sizeof(SearchIndexHeader), 1, file) != 1 ||
+             strcmp(header.magic, SEARCH_INDEX_MAGIC) != 0 || header.version != SEARCH_INDEX_VERSION ||
+             header.generation != entry->generation || header.trigram_count < 0))
+        {
+            fclose(file);
+            file = NULL;
+        }
+        if (file == NULL && attempt == 0)
+        {
+            // Missing or behind the month file: index it now, once
+            int res = rebuild_index(entry->year, entry->month, entry->generation);
+            if (res < 0)
+            {
+                return res;
+            }
+        }
+    }
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    SearchTrigram *directory = malloc((header.trigram_count > 0 ? header.trigram_count : 1) * sizeof(SearchTrigram));
+    if (directory == NULL)
+    {
+        fclose(file);
+        return -2;
+    }
+    if (fread(directory, sizeof(SearchTrigram), header.trigram_count, file) != (size_t)header.trigram_count)
+    {
+        free(directory);
+        fclose(file);
+        return -1;
+    }
+
+    // Intersect the posting lists, rarest first so the candidate set starts small
+    const SearchTrigram *lists[MAX_DESC_TRIGRAMS];
+    bool all_listed = true;
+    for (int i = 0; i < trigram_count && all_listed; i++)
+    {
+        lists[i] = find_trigram(directory, header.trigram_count, trigrams[i]);
+        all_listed = lists[i] != NULL;
+    }
+    int first_count = 0;
+    if (all_listed)
+    {
+        qsort(lists, trigram_count, sizeof(lists[0]), compare_trigrams_by_count);
+        first_count = lists[0]->count;
+    }
+
+    // Room for the main candidates and every record in the delta
+    long postings_start = sizeof(SearchIndexHeader) + header.trigram_count * sizeof(SearchTrigram);
+    int capacity = first_count + header.delta_count;
+    int *slots = malloc((capacity > 0 ? capacity : 1) * sizeof(int));
+    int *other = malloc((first_count > 0 ? first_count : 1) * sizeof(int));
+    TrigramPosting *delta = malloc((header.delta_count > 0 ? header.delta_count : 1) * sizeof(TrigramPosting));
+    int slot_count = first_count;
+    int res = 0;
+    if (slots == NULL || other == NULL || delta == NULL)
+    {
+        res = -2;
+    }
+    else if (slot_count > 0)
+    {
+        fseek(file, postings_start + lists[0]->first * sizeof(int), SEEK_SET);
+        if (fread(slots, sizeof(int), slot_count, file) != (size_t)slot_count)
+        {
+            res = -1;
+        }
+    }
+    for (int i = 1; i < trigram_count && res == 0 && slot_count > 0; i++)
+    {
+        // Walk the next list in step with the candidates, keeping only shared slots
+        fseek(file, postings_start + lists[i]->first * sizeof(int), SEEK_SET);
+        int kept = 0, candidate = 0, read = 0;
+        while (read < lists[i]->count && candidate < slot_count)
+        {
+            int chunk = lists[i]->count - read < slot_count ? lists[i]->count - read : slot_count;
+            if (fread(other, sizeof(int), chunk, file) != (size_t)chunk)
+            {
+                res = -1;
+                break;
+            }
+            read += chunk;
+            for (int j = 0; j < chunk && candidate < slot_count; j++)
+            {
+                while (candidate < slot_count && slots[candidate] < other[j])
+                {
+                    candidate++;
+                }
+                if (candidate < slot_count && slots[candidate] == other[j])
+                {
+                    slots[kept++] = slots[candidate++];
+                }
+            }
+        }
+        slot_count = kept;
+    }
+
+    // Each delta group replaces its slot's earlier postings, so only a slot's last
+    // group counts, and main candidates that have one are dropped
+    DeltaGroup *groups = NULL;
+    int group_count = 0;
+    if (res == 0 && header.delta_count > 0)
+    {
+        fseek(file, postings_start + header.posting_count * sizeof(int), SEEK_SET);
+        groups = malloc(header.delta_count * sizeof(DeltaGroup));
+        if (groups == NULL)
+        {
+            res = -2;
+        }
+        else if (fread(delta, sizeof(TrigramPosting), header.delta_count, file) != (size_t)header.delta_count)
+        {
+            res = -1;
+        }
+        for (int i = 0; i < header.delta_count && res == 0;)
+        {
+            if (delta[i].trigram != SEARCH_DELTA_CLEAR)
+            {
+                i++; // not in a group; never written
+                continue;
+            }
+            DeltaGroup *group = &groups[group_count];
+            group->slot = delta[i].slot;
+            group->order = group_count++;
+            int matched = 0;
+            for (i++; i < header.delta_count && delta[i].trigram != SEARCH_DELTA_CLEAR; i++)
+            {
+                for (int j = 0; j < trigram_count; j++)
+                {
+                    matched += delta[i].trigram == trigrams[j];
+                }
+            }
+            group->matched = matched == trigram_count;
+        }
+        qsort(groups, group_count, sizeof(DeltaGroup), compare_groups);
+    }
+
+    // Merge the lists' candidates with the last group of each slot, keeping slot order
+    int *merged = res == 0 ? malloc((capacity > 0 ? capacity : 1) * sizeof(int)) : NULL;
+    int merged_count = 0;
+    if (res == 0 && merged == NULL)
+    {
+        res = -2;
+    }
+    for (int i = 0, g = 0; res == 0 && (i < slot_count || g < group_count);)
+    {
+        if (g < group_count && (i == slot_count || groups[g].slot <= slots[i]))
+        {
+            int slot = groups[g].slot;
+            while (g + 1 < group_count && groups[g + 1].slot == slot)
+            {
+                g++;
+            }
+            if (groups[g].matched && slot >= 0 && slot < header.transaction_count)
+            {
+                merged[merged_count++] = slot;
+            }
+            g++;
+            while (i < slot_count && slots[i] == slot)
+            {
+                i++;
+            }
+        }
+        else
+        {
+            if (slots[i] < header.transaction_count)
+            {
+                merged[merged_count++] = slots[i];
+            }
+            i++;
+        }
+    }
+    free(groups);
+    free(slots);
+    slots = merged;
+    slot_count = merged_count;
+    free(delta);
+    free(other);
+    free(directory);
+    fclose(file);
+    if (res < 0)
+    {
+        free(slots);
+        return res;
+    }
+    *out_slots = slots;
+    return slot_count;
+}
+
+// Read the candidate records and keep the ones that really contain the text
+static int collect_hits(const ManifestEntry *entry, const int *slots, int slot_count, const char *text,
+                        SearchHit **hits, int *hit_count, int *hit_capacity)
+{
+    char path[MAX_BUFFER + 32];
+    snprintf(path, sizeof(path), "%s/%d-%d.dat", data_storage_dir, entry->year, entry->month);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    MonthFileHeader header;
+    Category *month_categories = NULL;
+    CategoryMap map = {NULL, 0};
+    int res = read_month_header(file, &header) == 1 ? read_month_categories_section(file, &header, &month_categories) : -1;
+    if (res == 1)
+    {
+        res = category_map_build(&map, &header.category_ids, month_categories, header.category_slots);
+    }
+
+    for (int i = 0; i < slot_count && res == 1; i++)
+    {
+        Transaction tx;
+        fseek(file, MONTH_TRANSACTION_OFFSET(&header, slots[i]), SEEK_SET);
+        if (fread(&tx, sizeof(Transaction), 1, file) != 1)
+        {
+            res = -1;
+            break;
+        }
+        if (!contains_ignore_case(tx.desc, text))
+        {
+            continue; // shares the trigrams but not the substring
+        }
+        if (*hit_count == *hit_capacity)
+        {
+            int new_capacity = *hit_capacity > 0 ? *hit_capacity * 2 : 64;
+            SearchHit *grown = realloc(*hits, new_capacity * sizeof(SearchHit));
+            if (grown == NULL)
+            {
+                res = -2;
+                break;
+            }
+            *hits = grown;
+            *hit_capacity = new_capacity;
+        }
+        SearchHit *hit = &(*hits)[(*hit_count)++];
+        hit->year = entry->year;
+        hit->month = entry->month;
+        hit->transaction = tx;
+        int cat_slot = category_map_slot(&map, tx.cat_id);
+        strcpy(hit->category, cat_slot >= 0 ? month_categories[cat_slot].name : "");
+    }
+    category_map_free(&map);
+    free(month_categories);
+    fclose(file);
+    return res;
+}
+
+static int compare_hits_newest_first(const void *a, const void *b)
+{
+    return strcmp(((const SearchHit *)b)->transaction.date, ((const SearchHit *)a)->transaction.date);
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int search_transactions(const char *text, SearchHit **out_hits, int *out_count)
+{
+    *out_hits = NULL;
+    *out_count = 0;
+    unsigned int trigrams[MAX_DESC_TRIGRAMS];
+    int trigram_count = extract_trigrams(text, trigrams);
+
+    int entry_count;
+    const ManifestEntry *entries = manifest_entries(&entry_count);
+    SearchHit *hits = NULL;
+    int hit_count = 0, hit_capacity = 0;
+    for (int i = entry_count - 1; i >= 0; i--)
+    {
+        if (entries[i].transaction_count == 0)
+        {
+            continue;
+        }
+        int *slots;
+        int slot_count = month_candidates(&entries[i], trigrams, trigram_count, &slots);
+        int res = slot_count;
+        if (slot_count > 0)
+        {
+            res = collect_hits(&entries[i], slots, slot_count, text, &hits, &hit_count, &hit_capacity);
+        }
+        free(slots);
+        if (res < 0)
+        {
+            free(hits);
+            return res;
+        }
+    }
+
+    qsort(hits, hit_count, sizeof(SearchHit), compare_hits_newest_first);
+    *out_hits = hits;
+    *out_count = hit_count;
+    return 1;
+}
@@ -124,21 +124,32 @@ static void get_next_yearly(const char *start_date, int target_month, int target
           date.tm_mday);
 }
 
-void update_subscription(int index)
+// The category picked for a subscription's occurrences in one month, reused for the
+// rest of that month
+static struct
+{
+  char name[MAX_NAME_LEN];
+  int year;
+  int month;
+  int cat_id;
+} chosen = {"", 0, 0, -1};
+
+bool update_subscription(int index, SubscriptionOccurrence *pending)
 {
   time_t now = time(NULL);
   struct tm *today = localtime(&now);
   char today_date[11];
   get_today_date(today_date);
-  int cat_index = -1, cat_index_month = -1, cat_index_year = -1;
+  int cat_id = -1, cat_id_month = -1, cat_id_year = -1;
+  FingerprintSet emitted = {0}; // the month's transactions, loaded with cat_id
 
   // Skip if subscription hasn't started yet
   if (is_date_after(subscriptions[index].start_date, today_date))
-    return;
+    return true;
 
   // Skip if subscription has ended
   if (is_date_before(subscriptions[index].end_date, today_date))
-    return;
+    return true;
 
   // Convert last_updated to string for comparison
   char last_updated_date[11];
@@ -153,17 +164,6 @@ void update_subscription(int index)
 
   // Keep track of next occurrence date
   char next_date[11];
-  WINDOW *win = stdscr;
-  int max_y, max_x;
-  getmaxyx(win, max_y, max_x);
-
-  // Keep the variable height calculation for transactions
-  int max_display = 10;
-  int display_count = current_month_transaction_count < max_display ? current_month_transaction_count : max_display;
-  int dialog_height = display_count > 1 ? display_count + 8 : 10;
-  int dialog_width = DEFAULT_DIALOG_WIDTH;
-  int start_y = (max_y - dialog_height) / 2;
-  int start_x = (max_x - dialog_width) / 2;
 
   // Iterate until we catch up to today
   while (is_date_before(date_iterator, today_date))
@@ -195,24 +195,39 @@ void update_subscription(int index)
 
     Transaction new_trans = {
         .expense = subscriptions[index].expense,
-        .amt = subscriptions[index].amount,
-        .cat_index = cat_index};
+        .amt = subscriptions[index].amount};
     strcpy(new_trans.desc, subscriptions[index].name);
     strcpy(new_trans.date, next_date);
     new_trans.date[sizeof(new_trans.date) - 1] = '\0';
     int month = get_month_from_date(new_trans.date);
     int year = get_year_from_date(new_trans.date);
-    if (cat_index_month != month || cat_index_year != year)
+    if (cat_id_month != month || cat_id_year != year)
     {
-      cat_index_month = month;
-      cat_index_year = year;
-      cat_index = get_category_index(year, month, subscriptions[index].cat_name);
+      cat_id_month = month;
+      cat_id_year = year;
+      cat_id = get_category_index(year, month, subscriptions[index].cat_name);
+      fingerprint_set_free(&emitted);
+      fingerprint_set_load(year, month, &emitted); // left empty if it can't be read
     }
-    if (cat_index == -1)
+    // Emitted by an earlier run whose last_updated never reached the data file
+    if (fingerprint_set_take(&emitted, &new_trans))
     {
-      BoundedWindow dialog = draw_bounded_with_title(dialog_height, dialog_width, start_y, start_x, "Updating Subscriptions", false, ALIGN_CENTER);
-      wnoutrefresh(dialog.boundary);
-      cat_index = get_category_choice_subscription(dialog.textbox, year, month, subscriptions[index].name, subscriptions[index].cat_name);
+      strcpy(date_iterator, next_date);
+      continue;
+    }
+    if (cat_id == -1 && strcmp(chosen.name, subscriptions[index].name) == 0 && chosen.year == year && chosen.month == month)
+      cat_id = chosen.cat_id;
+    new_trans.cat_id = cat_id; // ids belong to one month, so resolved after the date
+    if (cat_id == -1)
+    {
+      // Someone has to pick the category; last_updated stays put, so the next run
+      // starts over and the fingerprints skip what was already added
+      pending->index = index;
+      pending->year = year;
+      pending->month = month;
+      pending->transaction = new_trans;
+      fingerprint_set_free(&emitted);
+      return false;
     }
 
     add_transaction(&new_trans, year, month);
@@ -221,15 +236,35 @@ void update_subscription(int index)
     strcpy(date_iterator, next_date);
   }
 
+  fingerprint_set_free(&emitted);
+
   // Update subscription's last_updated to today
   subscriptions[index].last_updated = *today;
+  return true;
 }
 
 // Function to update subscriptions and create transactions
-void update_subscriptions()
+bool update_subscriptions(SubscriptionOccurrence *pending)
 {
   for (int i = 0; i < subscription_count; i++)
   {
-    update_subscription(i);
+    if (!update_subscription(i, pending))
+      return false;
+  }
+  return true;
+}
+
+int add_subscription_occurrence(const SubscriptionOccurrence *occurrence, int cat_id)
+{
+  Transaction transaction = occurrence->transaction;
+  transaction.cat_id = cat_id;
+  int res = add_transaction(&transaction, occurrence->year, occurrence->month);
+  if (res >= 0 && cat_id != -1)
+  {
+    strcpy(chosen.name, subscriptions[occurrence->index].name);
+    chosen.year = occurrence->year;
+    chosen.month = occurrence->month;
+    chosen.cat_id = cat_id;
   }
+  return res;
 }
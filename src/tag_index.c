@@ -0,0 +1,668 @@
+#include "tag_index.h"
+#include "saveload.h"
+
+// A month's bitmaps held expanded while they are edited: row t is tag t, each row
+// TAG_WORDS(transaction_count) words, and rows past tag_count stay zero
+typedef struct
+{
+    int transaction_count;
+    int words;
+    unsigned long long *bits;
+} TagRows;
+
+static unsigned long long *row_of(const TagRows *rows, int tag)
+{
+    return &rows->bits[(size_t)tag * rows->words];
+}
+
+static int alloc_rows(TagRows *rows, int transaction_count)
+{
+    rows->transaction_count = transaction_count;
+    rows->words = TAG_WORDS(transaction_count);
+    rows->bits = calloc((size_t)MAX_TAGS * (rows->words > 0 ? rows->words : 1), sizeof(unsigned long long));
+    return rows->bits != NULL ? 1 : -2;
+}
+
+// Set or clear slot's bit in every row to match a transaction's tags
+static void set_slot(TagRows *rows, int slot, unsigned int tags)
+{
+    unsigned long long bit = 1ULL << (slot % 64);
+    for (int tag = 0; tag < MAX_TAGS; tag++)
+    {
+        unsigned long long *word = &row_of(rows, tag)[slot / 64];
+        *word = tags & (1U << tag) ? *word | bit : *word & ~bit;
+    }
+}
+
+// Tags whose rows have slot's bit set
+static unsigned int slot_tags(const TagRows *rows, int slot)
+{
+    unsigned int tags = 0;
+    for (int tag = 0; tag < MAX_TAGS; tag++)
+    {
+        if (row_of(rows, tag)[slot / 64] >> (slot % 64) & 1)
+        {
+            tags |= 1U << tag;
+        }
+    }
+    return tags;
+}
+
+static bool clean_word(unsigned long long word)
+{
+    return word == 0 || word == ~0ULL;
+}
+
+/*
+ * Append the compressed form of words[0 .. count) to *out: a marker per run of
+ * identical clean words (all zero or all one), followed by the literal words up to
+ * the next clean one
+ *
+ * Returns:
+ *   1     - Success
+ *   -2    - Malloc error
+ */
+static int compress_row(const unsigned long long *words, int count, unsigned long long **out, int *out_count, int *capacity)
+{
+    int i = 0;
+    while (i < count)
+    {
+        unsigned long long fill = words[i] == ~0ULL ? ~0ULL : 0;
+        int run = 0;
+        while (i + run < count && words[i + run] == fill && clean_word(words[i + run]) && run < 0x7FFFFFFF)
+        {
+            run++;
+        }
+        int literals = 0;
+        while (i + run + literals < count && !clean_word(words[i + run + literals]))
+        {
+            literals++;
+        }
+        if (*out_count + 1 + literals > *capacity)
+        {
+            int new_capacity = *capacity > 0 ? *capacity : 64;
+            while (new_capacity < *out_count + 1 + literals)
+            {
+                new_capacity *= 2;
+            }
+            unsigned long long *grown = realloc(*out, new_capacity * sizeof(unsigned long long));
+            if (grown == NULL)
+            {
+                return -2;
+            }
+            *out = grown;
+            *capacity = new_capacity;
+        }
+        (*out)[(*out_count)++] = (fill != 0 ? TAG_MARKER_FILL_BIT : 0) | (unsigned long long)run << 32 | (unsigned long long)literals;
+        memcpy(&(*out)[*out_count], &words[i + run], literals * sizeof(unsigned long long));
+        *out_count += literals;
+        i += run + literals;
+    }
+    return 1;
+}
+
+// Expand a compressed bitmap into words[0 .. count); false if it doesn't fit exactly
+static bool expand_row(const unsigned long long *encoded, int encoded_count, unsigned long long *words, int count)
+{
+    int e = 0, w = 0;
+    while (e < encoded_count)
+    {
+        unsigned long long marker = encoded[e++];
+        int run = TAG_MARKER_RUN(marker), literals = TAG_MARKER_LITERALS(marker);
+        if (run > count - w || literals > count - w - run || literals > encoded_count - e)
+        {
+            return false;
+        }
+        unsigned long long fill = marker & TAG_MARKER_FILL_BIT ? ~0ULL : 0;
+        for (int i = 0; i < run; i++)
+        {
+            words[w++] = fill;
+        }
+        memcpy(&words[w], &encoded[e], literals * sizeof(unsigned long long));
+        w += literals;
+        e += literals;
+    }
+    return w == count;
+}
+
+/*
+ * Compress a row per defined tag and write them after a directory, through a
+ * temporary file so a filter never sees half an index
+ *
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+static int save_index(int year, int month, const TagRows *rows, unsigned long long generation)
+{
+    TagIndexHeader header = {
+        .magic = TAG_INDEX_MAGIC,
+        .version = TAG_INDEX_VERSION,
+        .transaction_count = rows->transaction_count,
+        .tag_count = tag_count,
+        .word_count = 0,
+        .delta_count = 0,
+        .base_count = rows->transaction_count,
+        .generation = generation};
+    TagBitmap directory[MAX_TAGS];
+    unsigned long long *encoded = NULL;
+    int capacity = 0;
+    for (int tag = 0; tag < tag_count; tag++)
+    {
+        directory[tag].first = header.word_count;
+        if (compress_row(row_of(rows, tag), rows->words, &encoded, &header.word_count, &capacity) < 0)
+        {
+            free(encoded);
+            return -2;
+        }
+        directory[tag].count = header.word_count - directory[tag].first;
+    }
+
+    char path[MAX_BUFFER + 32], tmp_path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "tag", "");
+    sidecar_path(tmp_path, sizeof(tmp_path), year, month, "tag", ".tmp");
+    FILE *file = fopen(tmp_path, "wb");
+    bool ok = file != NULL &&
+              fwrite(&header, sizeof(TagIndexHeader), 1, file) == 1 &&
+              fwrite(directory, sizeof(TagBitmap), header.tag_count, file) == (size_t)header.tag_count &&
+              fwrite(encoded, sizeof(unsigned long long), header.word_count, file) == (size_t)header.word_count;
+    free(encoded);
+    if (file == NULL || fclose(file) != 0 || !ok)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return rename(tmp_path, path) == 0 ? 1 : -1;
+}
+
+// Copy rows into a fresh set sized for transaction_count, keeping the bits that still fit
+static int resize_rows(TagRows *rows, int transaction_count)
+{
+    TagRows grown;
+    if (alloc_rows(&grown, transaction_count) < 0)
+    {
+        return -2;
+    }
+    int words = rows->words < grown.words ? rows->words : grown.words;
+    unsigned long long tail = transaction_count % 64 != 0 ? (1ULL << (transaction_count % 64)) - 1 : ~0ULL;
+    for (int tag = 0; tag < MAX_TAGS; tag++)
+    {
+        memcpy(row_of(&grown, tag), row_of(rows, tag), words * sizeof(unsigned long long));
+        if (words == grown.words && words > 0)
+        {
+            // Slots past the end are gone
+            row_of(&grown, tag)[words - 1] &= tail;
+        }
+    }
+    free(rows->bits);
+    *rows = grown;
+    return 1;
+}
+
+/*
+ * Read a month's index back into expanded rows, with its deltas applied
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - No index, or one written by another version or not matching generation
+ *   -2    - Malloc error
+ */
+static int load_index(int year, int month, int transaction_count, unsigned long long generation, TagRows *rows)
+{
+    char path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "tag", "");
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    TagIndexHeader header;
+    TagBitmap directory[MAX_TAGS];
+    if (fread(&header, sizeof(TagIndexHeader), 1, file) != 1 ||
+        strcmp(header.magic, TAG_INDEX_MAGIC) != 0 || header.version != TAG_INDEX_VERSION ||
+        header.generation != generation || header.transaction_count != transaction_count ||
+        header.tag_count < 0 || header.tag_count > MAX_TAGS || header.word_count < 0 ||
+        header.delta_count < 0 || header.base_count < 0 ||
+        header.transaction_count > header.base_count + header.delta_count ||
+        fread(directory, sizeof(TagBitmap), header.tag_count, file) != (size_t)header.tag_count)
+    {
+        fclose(file);
+        return 0;
+    }
+
+    // Slots only grow by one per delta, so base_count + delta_count bounds them all
+    int span = header.base_count + header.delta_count;
+    unsigned long long *encoded = malloc((header.word_count > 0 ? header.word_count : 1) * sizeof(unsigned long long));
+    TagDelta *deltas = malloc((header.delta_count > 0 ? header.delta_count : 1) * sizeof(TagDelta));
+    if (encoded == NULL || deltas == NULL || alloc_rows(rows, span) < 0)
+    {
+        free(encoded);
+        free(deltas);
+        fclose(file);
+        return -2;
+    }
+    int res = fread(encoded, sizeof(unsigned long long), header.word_count, file) == (size_t)header.word_count &&
+              fread(deltas, sizeof(TagDelta), header.delta_count, file) == (size_t)header.delta_count;
+    fclose(file);
+    for (int tag = 0; tag < header.tag_count && res > 0; tag++)
+    {
+        if (directory[tag].first < 0 || directory[tag].count < 0 ||
+            directory[tag].first > header.word_count - directory[tag].count ||
+            !expand_row(&encoded[directory[tag].first], directory[tag].count, row_of(rows, tag), TAG_WORDS(header.base_count)))
+        {
+            res = 0;
+        }
+    }
+    free(encoded);
+    for (int i = 0; i < header.delta_count && res > 0; i++)
+    {
+        if (deltas[i].slot < 0 || deltas[i].slot >= span || deltas[i].source < -1 || deltas[i].source >= span)
+        {
+            res = 0;
+            break;
+        }
+        set_slot(rows, deltas[i].slot, deltas[i].source >= 0 ? slot_tags(rows, deltas[i].source) : deltas[i].tags);
+    }
+    free(deltas);
+    if (res > 0)
+    {
+        res = resize_rows(rows, transaction_count);
+    }
+    if (res <= 0)
+    {
+        free(rows->bits);
+        rows->bits = NULL;
+    }
+    return res;
+}
+
+// Index every transaction's tags in the month file from scratch; keeps the rows in
+// *out_rows when it isn't NULL
+static int rebuild_index(int year, int month, unsigned long long generation, TagRows *out_rows)
+{
+    Transaction *transactions;
+    int transaction_count;
+    int res = read_month_transactions(year, month, &transactions, &transaction_count);
+    if (res < 0)
+    {
+        return res;
+    }
+    TagRows rows;
+    if (alloc_rows(&rows, transaction_count) < 0)
+    {
+        free(transactions);
+        return -2;
+    }
+    for (int i = 0; i < transaction_count; i++)
+    {
+        set_slot(&rows, i, transactions[i].tags);
+    }
+    free(transactions);
+    res = save_index(year, month, &rows, generation);
+    if (res > 0 && out_rows != NULL)
+    {
+        *out_rows = rows;
+        return res;
+    }
+    free(rows.bits);
+    return res;
+}
+
+/*
+ * Append deltas to an index that was current at previous_generation with
+ * old_count slots, leaving it current for entry
+ *
+ * Returns:
+ *   1     - Success
+ *   0     - Index has to be written out whole instead
+ *   -1    - I/O error occurred
+ */
+static int append_delta(int year, int month, int old_count, const TagDelta *deltas, int count,
+                        unsigned long long previous_generation, const ManifestEntry *entry)
+{
+    char path[MAX_BUFFER + 32];
+    sidecar_path(path, sizeof(path), year, month, "tag", "");
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    TagIndexHeader header;
+    int limit = 0;
+    if (fread(&header, sizeof(TagIndexHeader), 1, file) == 1)
+    {
+        limit = header.base_count / 8 > TAG_INDEX_MIN_DELTA ? header.base_count / 8 : TAG_INDEX_MIN_DELTA;
+    }
+    if (limit == 0 ||
+        strcmp(header.magic, TAG_INDEX_MAGIC) != 0 || header.version != TAG_INDEX_VERSION ||
+        header.generation != previous_generation || header.transaction_count != old_count ||
+        header.tag_count < 0 || header.tag_count > MAX_TAGS || header.word_count < 0 ||
+        header.delta_count < 0 || header.delta_count + count > limit)
+    {
+        fclose(file);
+        return 0;
+    }
+
+    // A torn append is past the old header's delta_count, so readers never see it
+    long delta_end = sizeof(TagIndexHeader) + header.tag_count * sizeof(TagBitmap) +
+                     header.word_count * sizeof(unsigned long long) + header.delta_count * sizeof(TagDelta);
+    header.transaction_count = entry->transaction_count;
+    header.delta_count += count;
+    header.generation = entry->generation;
+    bool ok = fseek(file, delta_end, SEEK_SET) == 0 &&
+              fwrite(deltas, sizeof(TagDelta), count, file) == (size_t)count &&
+              fflush(file) == 0 &&
+              fseek(file, 0, SEEK_SET) == 0 &&
+              fwrite(&header, sizeof(TagIndexHeader), 1, file) == 1;
+    return fclose(file) == 0 && ok ? 1 : -1;
+}
+
+int tag_find(const char *name)
+{
+    for (int i = 0; i < tag_count; i++)
+    {
+        if (strcmp(tag_names[i], name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Returns:
+ *   >=0   - Id of the tag
+ *   -1    - I/O error occurred
+ *   -2    - Every tag is taken
+ *   -3    - Invalid name
+ */
+int tag_create(const char *name)
+{
+    int tag = tag_find(name);
+    if (tag >= 0)
+    {
+        return tag;
+    }
+    if (name[0] == '\0' || strlen(name) >= MAX_NAME_LEN)
+    {
+        return -3;
+    }
+    if (tag_count == MAX_TAGS)
+    {
+        return -2;
+    }
+    memset(tag_names[tag_count], 0, MAX_NAME_LEN);
+    strcpy(tag_names[tag_count], name);
+    tag_count++;
+    if (save_budget_data() < 0)
+    {
+        tag_count--;
+        return -1;
+    }
+    return tag_count - 1;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int tag_index_add(int year, int month, int first_slot, const Transaction *transactions, int count, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        return 1;
+    }
+
+    if (previous_generation != 0 || first_slot != 0)
+    {
+        TagDelta *deltas = malloc((count > 0 ? count : 1) * sizeof(TagDelta));
+        if (deltas == NULL)
+        {
+            return -2;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            deltas[i] = (TagDelta){.slot = first_slot + i, .source = -1, .tags = transactions[i].tags};
+        }
+        int res = append_delta(year, month, first_slot, deltas, count, previous_generation, entry);
+        free(deltas);
+        if (res != 0)
+        {
+            return res;
+        }
+    }
+
+    TagRows rows;
+    int res = previous_generation != 0 || first_slot != 0
+                  ? load_index(year, month, first_slot, previous_generation, &rows)
+                  : alloc_rows(&rows, 0);
+    if (res < 0)
+    {
+        return res;
+    }
+    if (res == 0)
+    {
+        return rebuild_index(year, month, entry->generation, NULL);
+    }
+    res = resize_rows(&rows, entry->transaction_count);
+    for (int i = 0; i < count && res > 0 && first_slot + i < rows.transaction_count; i++)
+    {
+        set_slot(&rows, first_slot + i, transactions[i].tags);
+    }
+    if (res > 0)
+    {
+        res = save_index(year, month, &rows, entry->generation);
+    }
+    free(rows.bits);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int tag_index_remove(int year, int month, int slot, int moved_slot, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry != NULL && slot >= 0)
+    {
+        // The hole takes the moved record's tags; the count drops the old tail
+        TagDelta delta = {.slot = slot, .source = moved_slot, .tags = 0};
+        int res = append_delta(year, month, entry->transaction_count + 1, &delta, moved_slot >= 0 ? 1 : 0,
+                               previous_generation, entry);
+        if (res != 0)
+        {
+            return res;
+        }
+    }
+
+    int old_count = entry != NULL ? entry->transaction_count + 1 : 1;
+    int *new_slots = removal_slot_map(slot, moved_slot, old_count);
+    if (new_slots == NULL)
+    {
+        return -2;
+    }
+    int res = tag_index_remove_slots(year, month, new_slots, old_count, previous_generation);
+    free(new_slots);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int tag_index_remove_slots(int year, int month, const int *new_slots, int old_count, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        // Month is empty now
+        char path[MAX_BUFFER + 32];
+        sidecar_path(path, sizeof(path), year, month, "tag", "");
+        remove(path);
+        return 1;
+    }
+
+    TagRows old_rows, rows;
+    int res = load_index(year, month, old_count, previous_generation, &old_rows);
+    if (res < 0)
+    {
+        return res;
+    }
+    if (res == 0)
+    {
+        return rebuild_index(year, month, entry->generation, NULL);
+    }
+    if (alloc_rows(&rows, entry->transaction_count) < 0)
+    {
+        free(old_rows.bits);
+        return -2;
+    }
+    for (int slot = 0; slot < old_count; slot++)
+    {
+        int new_slot = new_slots[slot];
+        if (new_slot < 0 || new_slot >= rows.transaction_count)
+        {
+            continue;
+        }
+        set_slot(&rows, new_slot, slot_tags(&old_rows, slot));
+    }
+    free(old_rows.bits);
+    res = save_index(year, month, &rows, entry->generation);
+    free(rows.bits);
+    return res;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int tag_index_update(int year, int month, int slot, const Transaction *transaction, unsigned long long previous_generation)
+{
+    const ManifestEntry *entry = manifest_find(year, month);
+    if (entry == NULL)
+    {
+        return 1;
+    }
+
+    TagDelta delta = {.slot = slot, .source = -1, .tags = transaction->tags};
+    int res = slot >= 0 && slot < entry->transaction_count
+                  ? append_delta(year, month, entry->transaction_count, &delta, 1, previous_generation, entry)
+                  : 0;
+    if (res != 0)
+    {
+        return res;
+    }
+
+    TagRows rows;
+    res = load_index(year, month, entry->transaction_count, previous_generation, &rows);
+    if (res < 0)
+    {
+        return res;
+    }
+    if (res == 0)
+    {
+        return rebuild_index(year, month, entry->generation, NULL);
+    }
+    if (slot >= 0 && slot < rows.transaction_count)
+    {
+        set_slot(&rows, slot, transaction->tags);
+    }
+    res = save_index(year, month, &rows, entry->generation);
+    free(rows.bits);
+    return res;
+}
+
+// The month's rows as of its current generation
+static int load_current(const ManifestEntry *entry, TagRows *rows)
+{
+    int res = load_index(entry->year, entry->month, entry->transaction_count, entry->generation, rows);
+    if (res == 0)
+    {
+        // Missing or behind the month file: index it now
+        res = rebuild_index(entry->year, entry->month, entry->generation, rows);
+    }
+    return res;
+}
+
+/*
+ * Returns:
+ *   >=0   - Number of matching slots
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int tag_index_match(const ManifestEntry *entry, unsigned int all_tags, unsigned int no_tags, unsigned long long **out_bits)
+{
+    *out_bits = NULL;
+    TagRows rows;
+    int res = load_current(entry, &rows);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    unsigned long long *bits = malloc((rows.words > 0 ? rows.words : 1) * sizeof(unsigned long long));
+    if (bits == NULL)
+    {
+        free(rows.bits);
+        return -2;
+    }
+    int matches = 0;
+    for (int w = 0; w < rows.words; w++)
+    {
+        int tail = rows.transaction_count - w * 64;
+        unsigned long long word = tail >= 64 ? ~0ULL : (1ULL << tail) - 1;
+        for (int tag = 0; tag < MAX_TAGS && word != 0; tag++)
+        {
+            if (all_tags & (1U << tag))
+            {
+                word &= row_of(&rows, tag)[w];
+            }
+            else if (no_tags & (1U << tag))
+            {
+                word &= ~row_of(&rows, tag)[w];
+            }
+        }
+        bits[w] = word;
+        matches += __builtin_popcountll(word);
+    }
+    free(rows.bits);
+    *out_bits = bits;
+    return matches;
+}
+
+/*
+ * Returns:
+ *   1     - Success
+ *   -1    - I/O error occurred
+ *   -2    - Malloc error
+ */
+int tag_index_count(const ManifestEntry *entry, int *counts)
+{
+    TagRows rows;
+    int res = load_current(entry, &rows);
+    if (res < 0)
+    {
+        return res;
+    }
+    for (int tag = 0; tag < MAX_TAGS; tag++)
+    {
+        const unsigned long long *row = row_of(&rows, tag);
+        for (int w = 0; w < rows.words; w++)
+        {
+            counts[tag] += __builtin_popcountll(row[w]);
+        }
+    }
+    free(rows.bits);
+    return 1;
+}
@@ -1,453 +1,336 @@
 #include "ui.h"
 
-int get_transaction_choice(WINDOW *win, TransactionNode **sorted_transactions, int transaction_count, int max_visible_items) // optimized for case of many transactions
+static int transaction_field_rows(TransactionField *field)
 {
-  int start_index = 0;
-  int visible_items = max_visible_items;
-  int current_highlighted = 0;
-  bool redraw = true;
-
-  keypad(win, TRUE); // Enable arrow keys
+  return field->filtering ? field->matcher.match_count : field->transaction_count;
+}
 
-  mvwprintw(win, 3, 0, "%-10s %-24s %-9s %-24s",
-            "Date", "Description", "Amount", "Category");
+static int transaction_field_item(TransactionField *field, int row)
+{
+  return field->filtering ? field->matcher.matches[row].index : row;
+}
 
-  while (1)
+void transaction_field_draw(TransactionField *field)
+{
+  WINDOW *win = field->win;
+  int start_index = field->start_index;
+  int visible_items = field->visible_items;
+  int row_count = transaction_field_rows(field);
+
+  // Typed filter sits above the column headers
+  wmove(win, 2, 0);
+  wclrtoeol(win);
+  if (field->matcher.query_len > 0)
   {
-    if (redraw)
-    {
-      // Add scroll indicators if needed
-      if (start_index > 0)
-      {
-        mvwprintw(win, 3, getmaxx(win) - 3, "^");
-      }
-      else
-      {
-        mvwprintw(win, 3, getmaxx(win) - 3, " ");
-      }
+    mvwprintw(win, 2, 0, "> %s", field->matcher.query);
+  }
 
-      if (start_index + visible_items < transaction_count)
-      {
-        mvwprintw(win, 4 + visible_items, getmaxx(win) - 3, "v");
-      }
-      else
-      {
-        mvwprintw(win, 4 + visible_items, getmaxx(win) - 3, " ");
-      }
+  // Add scroll indicators if needed
+  if (start_index > 0)
+  {
+    mvwprintw(win, 3, getmaxx(win) - 3, "^");
+  }
+  else
+  {
+    mvwprintw(win, 3, getmaxx(win) - 3, " ");
+  }
 
-      char prev_date[11] = "";
-      for (int i = start_index; i < start_index + visible_items && i < transaction_count; i++)
-      {
-        // Clear the entire line first
-        wmove(win, 4 + i - start_index, 0);
-        wclrtoeol(win);
+  if (start_index + visible_items < row_count)
+  {
+    mvwprintw(win, 4 + visible_items, getmaxx(win) - 3, "v");
+  }
+  else
+  {
+    mvwprintw(win, 4 + visible_items, getmaxx(win) - 3, " ");
+  }
 
-        char row_item[MAX_NAME_LEN + 50] = "";
+  char prev_date[11] = "";
+  int positions[FUZZY_MAX_QUERY];
+  for (int i = start_index; i < start_index + visible_items && i < field->transaction_count; i++)
+  {
+    // Clear the entire line first
+    wmove(win, 4 + i - start_index, 0);
+    wclrtoeol(win);
+    if (i >= row_count)
+    {
+      continue; // left over from a longer list
+    }
+    int item = transaction_field_item(field, i);
+    Transaction *tx = &order_index_at(field->transactions, item)->data;
 
-        char category_name[MAX_NAME_LEN] = "Uncategorized";
-        strcpy(category_name, categories[sorted_transactions[i]->data.cat_index].name);
+    char row_item[MAX_NAME_LEN + 50] = "";
 
-        // Format date for display
-        char display_date[11] = "";
+    char category_name[MAX_NAME_LEN] = "Uncategorized";
+    const Category *category = category_of(tx->cat_id);
+    if (category != NULL)
+    {
+      strcpy(category_name, category->name);
+    }
 
-        // If this date is the same as the previous one, use blank space
-        if (strcmp(sorted_transactions[i]->data.date, prev_date) == 0 && i != current_highlighted)
-        {
-          strcpy(display_date, "          ");
-        }
-        else
-        {
-          // Format YYYY-MM-DD for display
-          if (strlen(sorted_transactions[i]->data.date) == 10)
-          {
-            strcpy(display_date, sorted_transactions[i]->data.date);
-          }
-          else
-          {
-            strcpy(display_date, sorted_transactions[i]->data.date); // Use as is if format is unexpected
-          }
-
-          // Remember this date for the next iteration
-          strcpy(prev_date, sorted_transactions[i]->data.date);
-        }
+    // Format date for display
+    char display_date[11] = "";
 
-        // Create a descriptive menu item
-        char desc[24] = "";
-        if (strlen(sorted_transactions[i]->data.desc) > 23)
-        {
-          strncpy(desc, sorted_transactions[i]->data.desc, 20);
-          desc[20] = '\0';
-          strcat(desc, "...");
-        }
-        else
-        {
-          strcpy(desc, sorted_transactions[i]->data.desc);
-        }
+    // If this date is the same as the previous one, use blank space
+    if (strcmp(tx->date, prev_date) == 0 && i != field->highlighted)
+    {
+      strcpy(display_date, "          ");
+    }
+    else
+    {
+      strcpy(display_date, tx->date);
 
-        sprintf(row_item, "%-10s %-24s $%-8.2f %-24s",
-                display_date,
-                desc,
-                sorted_transactions[i]->data.amt,
-                category_name);
+      // Remember this date for the next iteration
+      strcpy(prev_date, tx->date);
+    }
 
-        // Apply highlighting before printing if this is the current item
-        if (i == current_highlighted)
-        {
-          wattron(win, COLOR_PAIR(5));
-        }
+    // Create a descriptive menu item
+    char desc[24] = "";
+    int desc_shown = strlen(tx->desc);
+    if (strlen(tx->desc) > 23)
+    {
+      strncpy(desc, tx->desc, 20);
+      desc[20] = '\0';
+      strcat(desc, "...");
+      desc_shown = 20;
+    }
+    else
+    {
+      strcpy(desc, tx->desc);
+    }
 
-        // Print the row
-        wprintw(win, "%s", row_item);
-        // Turn off highlighting after printing
-        if (i == current_highlighted)
-        {
-          wattroff(win, COLOR_PAIR(4));
-        }
-      }
+    sprintf(row_item, "%-10s %-24s $%-8s %-24s",
+            display_date,
+            desc,
+            money_str(tx->amt),
+            category_name);
 
-      wrefresh(win);
-      redraw = false;
+    // Apply highlighting before printing if this is the current item
+    if (i == field->highlighted)
+    {
+      wattron(win, COLOR_PAIR(5));
     }
 
-    int ch = wgetch(win);
-
-    switch (ch)
+    // Print the row
+    wprintw(win, "%s", row_item);
+    // Turn off highlighting after printing
+    if (i == field->highlighted)
     {
-    case KEY_UP:
-      if (current_highlighted > 0)
-      {
-        current_highlighted--;
-        if (current_highlighted < start_index)
-        {
-          start_index = current_highlighted;
-        }
-        redraw = true;
-      }
-      continue;
+      wattroff(win, COLOR_PAIR(5));
+    }
 
-    case KEY_DOWN:
-      if (current_highlighted < transaction_count - 1)
+    // Underline the matched characters that are visible in the description column
+    if (field->matcher.query_len > 0 && fuzzy_score(field->labels[item], field->matcher.query, positions) >= 0)
+    {
+      for (int j = 0; j < field->matcher.query_len; j++)
       {
-        current_highlighted++;
-        if (current_highlighted >= start_index + visible_items)
+        if (positions[j] < desc_shown)
         {
-          start_index = current_highlighted - visible_items + 1;
+          mvwchgat(win, 4 + i - start_index, 11 + positions[j], 1, A_UNDERLINE | A_BOLD, i == field->highlighted ? 5 : 0, NULL);
         }
-        redraw = true;
       }
-      continue;
-
-    case '\n': // Enter key - proceed to confirmation
-      return current_highlighted;
-
-    case 27: // ASCII ESC key
-      return -1;
-
-    case KEY_BACKSPACE:
-#if KEY_BACKSPACE_ALT != 127 // Only include this case if the constants are different
-    case KEY_BACKSPACE_ALT:
-#endif
-    case 127: // Backspace alternative
-      return -1;
     }
   }
-  return -1; // @dev this should never happen
 }
 
-int get_category_choice_subscription(WINDOW *win, int year, int month, char *subscription_name, char *subscription_category)
+void transaction_field_begin(TransactionField *field, WINDOW *win, const OrderIndex *transactions, int max_visible_items) // optimized for case of many transactions
 {
-  int sorted_indices[MAX_CATEGORIES];
-  Category local_categories[MAX_CATEGORIES];
-  int local_category_count = 0;
-  if (read_month_categories(year, month, local_categories, &local_category_count) != 1)
+  memset(field, 0, sizeof(TransactionField));
+  field->win = win;
+  int transaction_count = order_index_count(transactions);
+  field->transactions = transactions;
+  field->transaction_count = transaction_count;
+  field->visible_items = max_visible_items;
+  field->start_index = 0;
+  field->highlighted = 0;
+
+  // Typing matches against the description and category name
+  int label_count = transaction_count > 0 ? transaction_count : 1;
+  field->labels = malloc(label_count * sizeof(*field->labels));
+  field->label_ptrs = malloc(label_count * sizeof(char *));
+  if (field->labels != NULL && field->label_ptrs != NULL)
   {
-    mvwprintw(win, 0, 0, "Failed to load categories for %d-%d", year, month);
-    wrefresh(win);
-    napms(1000);
-    return -1;
-  }
-  // Filter local_categories for nonzero budgets
-  int valid_count = 0;
-  double max = 0.0;
-  for (int i = 0; i < local_category_count; i++)
-  {
-    sorted_indices[valid_count] = -1;
-    for (int j = 0; j < local_category_count; j++)
+    for (int i = 0; i < transaction_count; i++)
     {
-      if (local_categories[j].budget > max)
-        sorted_indices[valid_count] = j;
+      Transaction *tx = &order_index_at(transactions, i)->data;
+      const Category *category = category_of(tx->cat_id);
+      snprintf(field->labels[i], sizeof(field->labels[i]), "%.31s %.31s", tx->desc,
+               category != NULL ? category->name : "Uncategorized");
+      field->label_ptrs[i] = field->labels[i];
     }
-    if (sorted_indices[valid_count] == -1)
-      break;
-    max = 0.0;
-    valid_count++;
+    field->filtering = fuzzy_init(&field->matcher, field->label_ptrs, transaction_count) > 0;
   }
-  int start_index = 0;
-  int visible_items = getmaxy(win) - 6;
-  if (visible_items > valid_count)
-    visible_items = valid_count;
-  int current_highlighted = 0;
-  bool redraw = true;
-
-  keypad(win, TRUE);
 
-  mvwprintw(win, 0, 0, "Subscription \"%s\" (%s) didn't match any category for month %d-%d. Select one or press ESC to skip.", subscription_name, subscription_category, year, month);
-  mvwprintw(win, 3, 0, "%-30s %-15s %-15s", "Category", "Spent", "Budget");
+  keypad(win, TRUE); // Enable arrow keys
 
-  while (1)
-  {
-    if (redraw)
-    {
-      if (start_index > 0)
-        mvwprintw(win, 2, getmaxx(win) - 3, "^");
-      else
-        mvwprintw(win, 2, getmaxx(win) - 3, " ");
+  mvwprintw(win, 3, 0, "%-10s %-24s %-9s %-24s",
+            "Date", "Description", "Amount", "Category");
+  transaction_field_draw(field);
+}
 
-      if (start_index + visible_items < valid_count)
-        mvwprintw(win, 3 + visible_items, getmaxx(win) - 3, "v");
-      else
-        mvwprintw(win, 3 + visible_items, getmaxx(win) - 3, " ");
+int transaction_field_value(TransactionField *field)
+{
+  return field->choice;
+}
 
-      for (int i = start_index; i < start_index + visible_items && i < valid_count; i++)
-      {
-        int idx = sorted_indices[i];
-        wmove(win, 3 + i - start_index, 0);
-        wclrtoeol(win);
-        char name[MAX_NAME_LEN + 4];
-        if (strlen(local_categories[idx].name) > 29)
-        {
-          strncpy(name, local_categories[idx].name, 26);
-          name[26] = '\0';
-          strcat(name, "...");
-        }
-        else
-        {
-          strcpy(name, local_categories[idx].name);
-        }
-        if (i == current_highlighted)
-        {
-          wattron(win, COLOR_PAIR(5));
-        }
-        int color_pair = PIE_COLOR_START + (i >= NUM_PIE_COLORS - 1 ? NUM_PIE_COLORS - 2 : i);
-        wattron(win, COLOR_PAIR(color_pair));
-        mvwprintw(win, 3 + i - start_index, 2, "  ");
-        wattroff(win, COLOR_PAIR(color_pair));
-        mvwprintw(win, 3 + i - start_index, 4, " %-27s $%-14.2f $%-14.2f",
-                  name, local_categories[idx].spent, local_categories[idx].budget);
-        if (i == current_highlighted)
-        {
-          wattroff(win, COLOR_PAIR(5));
-        }
-      }
-      wrefresh(win);
-      redraw = false;
-    }
-    int ch = wgetch(win);
-    switch (ch)
-    {
-    case KEY_UP:
-    case 'k':
-    case 'K':
-      current_highlighted = (current_highlighted - 1) % category_count;
-      if (current_highlighted < start_index)
-      {
-        start_index = current_highlighted;
-      }
-      else if (current_highlighted >= start_index + visible_items)
-      {
-        start_index = current_highlighted - visible_items + 1;
-      }
-      redraw = true;
-      continue;
-    case KEY_DOWN:
-    case 'j':
-    case 'J':
-      current_highlighted = (current_highlighted + 1) % category_count;
-      if (current_highlighted >= start_index + visible_items)
-      {
-        start_index = current_highlighted - visible_items + 1;
-      }
-      else if (current_highlighted < start_index)
-      {
-        start_index = current_highlighted;
-      }
-      redraw = true;
-      continue;
-    case '\n':
-      return sorted_indices[current_highlighted];
-    case 27:
-      return -1;
-    case KEY_BACKSPACE:
-#if KEY_BACKSPACE_ALT != 127
-    case KEY_BACKSPACE_ALT:
-#endif
-    case 127:
-      return -1;
-    }
+void transaction_field_end(TransactionField *field)
+{
+  if (field->filtering)
+  {
+    fuzzy_free(&field->matcher);
+    field->filtering = false;
   }
-  return -1;
+  free(field->labels);
+  free(field->label_ptrs);
+  field->labels = NULL;
+  field->label_ptrs = NULL;
 }
 
-int get_category_choice_recategorize(WINDOW *win, char *category_name)
+static void transaction_field_filter(TransactionField *field, const char *query)
 {
-  int start_index = 0;
-  int visible_items = getmaxy(win) - 6; // Leave space for header/footer
-  if (visible_items > category_count)
-    visible_items = category_count;
-  int current_highlighted = 0;
-  bool redraw = true;
+  fuzzy_set_query(&field->matcher, query);
+  field->highlighted = 0;
+  field->start_index = 0;
+  transaction_field_draw(field);
+}
 
-  keypad(win, TRUE);
+WidgetStatus transaction_field_feed(TransactionField *field, int ch)
+{
+  int row_count = transaction_field_rows(field);
 
-  mvwprintw(win, 0, 0, "You may choose a new category for transactions in category %s. ESC to leave them uncategorized.", category_name);
+  // j and k move like the arrows until a filter is being typed
+  if ((ch == 'j' || ch == 'k') && field->matcher.query_len == 0)
+  {
+    ch = ch == 'j' ? KEY_DOWN : KEY_UP;
+  }
 
-  // Header
-  mvwprintw(win, 3, 0, "%-30s %-15s %-15s", "Category", "Spent", "Budget");
+  // Other printable keys narrow the list
+  else if (field->filtering && ch < 256 && isprint(ch) && field->matcher.query_len < FUZZY_MAX_QUERY - 1)
+  {
+    char query[FUZZY_MAX_QUERY];
+    memcpy(query, field->matcher.query, field->matcher.query_len);
+    query[field->matcher.query_len] = ch;
+    query[field->matcher.query_len + 1] = '\0';
+    transaction_field_filter(field, query);
+    return WIDGET_ACTIVE;
+  }
 
-  while (1)
+  switch (ch)
   {
-    if (redraw)
+  case KEY_UP:
+    if (field->highlighted > 0)
     {
-      // Add scroll indicators if needed
-      if (start_index > 0)
-        mvwprintw(win, 2, getmaxx(win) - 3, "^");
-      else
-        mvwprintw(win, 2, getmaxx(win) - 3, " ");
-
-      if (start_index + visible_items < category_count)
-        mvwprintw(win, 3 + visible_items, getmaxx(win) - 3, "v");
-      else
-        mvwprintw(win, 3 + visible_items, getmaxx(win) - 3, " ");
-
-      // Print each visible category
-      for (int i = start_index; i < start_index + visible_items && i < category_count; i++)
+      field->highlighted--;
+      if (field->highlighted < field->start_index)
       {
-        wmove(win, 3 + i - start_index, 0);
-        wclrtoeol(win);
-
-        char name[MAX_NAME_LEN + 4];
-        if (strlen(categories[sorted_categories_indices[i]].name) > 29)
-        {
-          strncpy(name, categories[sorted_categories_indices[i]].name, 26);
-          name[26] = '\0';
-          strcat(name, "...");
-        }
-        else
-        {
-          strcpy(name, categories[sorted_categories_indices[i]].name);
-        }
-
-        if (i == current_highlighted)
-        {
-          wattron(win, COLOR_PAIR(5));
-        }
-
-        // Color block for pie chart legend
-        int color_pair = PIE_COLOR_START + (i >= NUM_PIE_COLORS - 1 ? NUM_PIE_COLORS - 2 : i);
-        wattron(win, COLOR_PAIR(color_pair));
-        mvwprintw(win, 3 + i - start_index, 2, "  ");
-        wattroff(win, COLOR_PAIR(color_pair));
-        mvwprintw(win, 3 + i - start_index, 4, " %-27s $%-14.2f $%-14.2f",
-                  name, categories[sorted_categories_indices[i]].spent, categories[sorted_categories_indices[i]].budget);
-
-        if (i == current_highlighted)
-        {
-          wattroff(win, COLOR_PAIR(5));
-        }
+        field->start_index = field->highlighted;
       }
-      wrefresh(win);
-      redraw = false;
+      transaction_field_draw(field);
     }
+    break;
 
-    int ch = wgetch(win);
-    switch (ch)
+  case KEY_DOWN:
+    if (field->highlighted < row_count - 1)
     {
-    case KEY_UP:
-    case 'k':
-    case 'K':
-      current_highlighted = (current_highlighted - 1) % category_count;
-      if (current_highlighted < start_index)
-      {
-        start_index = current_highlighted;
-      }
-      else if (current_highlighted >= start_index + visible_items)
-      {
-        start_index = current_highlighted - visible_items + 1;
-      }
-      redraw = true;
-      continue;
-    case KEY_DOWN:
-    case 'j':
-    case 'J':
-      current_highlighted = (current_highlighted + 1) % category_count;
-      if (current_highlighted >= start_index + visible_items)
-      {
-        start_index = current_highlighted - visible_items + 1;
-      }
-      else if (current_highlighted < start_index)
+      field->highlighted++;
+      if (field->highlighted >= field->start_index + field->visible_items)
       {
-        start_index = current_highlighted;
+        field->start_index = field->highlighted - field->visible_items + 1;
       }
-      redraw = true;
-      continue;
-    case '\n':
-      if (category_count > 0)
-        return sorted_categories_indices[current_highlighted];
-      else
-        return -1;
-    case 27: // ESC
-      return -1;
-    case KEY_BACKSPACE:
-#if KEY_BACKSPACE_ALT != 127
-    case KEY_BACKSPACE_ALT:
+      transaction_field_draw(field);
+    }
+    break;
+
+  case '\n': // Enter key - proceed to confirmation
+    if (row_count == 0)
+    {
+      break; // nothing matches the filter
+    }
+    field->choice = transaction_field_item(field, field->highlighted);
+    transaction_field_end(field);
+    return WIDGET_DONE;
+
+  case 27: // ASCII ESC key
+    transaction_field_end(field);
+    return WIDGET_CANCELLED;
+
+  case KEY_BACKSPACE:
+#if KEY_BACKSPACE_ALT != 127 // Only include this case if the constants are different
+  case KEY_BACKSPACE_ALT:
 #endif
-    case 127:
-      return -1;
+  case 127: // Backspace alternative
+    if (field->matcher.query_len > 0)
+    {
+      char query[FUZZY_MAX_QUERY];
+      memcpy(query, field->matcher.query, field->matcher.query_len - 1);
+      query[field->matcher.query_len - 1] = '\0';
+      transaction_field_filter(field, query);
+      break;
     }
+    transaction_field_end(field);
+    return WIDGET_CANCELLED;
+  }
+  return WIDGET_ACTIVE;
+}
+
+// The name, indented under its parent, then what the envelope carried in from earlier
+// months if anything, cut to the 29 columns the name gets
+static void category_label(char *label, size_t size, const char *name, Money extra, bool indent)
+{
+  char carry[MONEY_FORMAT_LEN + 2] = "";
+  if (extra != 0)
+  {
+    snprintf(carry, sizeof(carry), " %s%s", extra > 0 ? "+" : "", money_str(extra));
+  }
+  const char *prefix = indent ? "  " : "";
+  int room = 29 - (int)strlen(prefix) - (int)strlen(carry);
+  if ((int)strlen(name) > room)
+  {
+    snprintf(label, size, "%s%.*s...%s", prefix, room - 3, name, carry);
+  }
+  else
+  {
+    snprintf(label, size, "%s%s%s", prefix, name, carry);
   }
-  return -1;
 }
 
-void display_categories(WINDOW *win, int start_y)
+// One row per top-level category with its children's figures rolled in, or every
+// category with its own figures and children indented under their parent
+void display_categories(WINDOW *win, int start_y, bool top_level)
 {
   int y = start_y;
 
   mvwprintw(win, y++, 2, "%-30s %-15s %-15s", "Category", "Spent", "Budget");
   mvwprintw(win, y++, 2, "-------------------------------------------------------------------");
 
-  double total_allocated = 0.0;
-  double total_spent = 0.0;
+  Money total_allocated = 0;
+  Money total_spent = 0;
 
-  for (int i = 0; i < category_count; i++)
+  int *rows = malloc((category_count > 0 ? category_count : 1) * sizeof(int));
+  int row_count = rows != NULL ? category_display_order(rows, top_level) : 0;
+  for (int i = 0; i < row_count; i++)
   {
-    total_allocated += categories[sorted_categories_indices[i]].budget;
-    total_spent += categories[sorted_categories_indices[i]].spent;
+    int slot = rows[i];
+    CategoryRollup figures = category_figures(slot, top_level);
+    total_allocated += figures.budget;
+    total_spent += figures.spent;
 
     char name[MAX_NAME_LEN];
-    if (strlen(categories[sorted_categories_indices[i]].name) > 29)
-    {
-      strncpy(name, categories[sorted_categories_indices[i]].name, 26);
-      name[26] = '\0';
-      strcat(name, "...");
-    }
-    else
-    {
-      strcpy(name, categories[sorted_categories_indices[i]].name);
-    }
+    category_label(name, sizeof(name), categories[slot].name, figures.extra, !top_level && category_parent_slot(slot) >= 0);
 
     // Display color block for pie chart legend
-    if (categories[sorted_categories_indices[i]].budget > 0.0)
+    if (figures.budget > 0)
     {
       int color_pair = PIE_COLOR_START + (i >= NUM_PIE_COLORS - 1 ? NUM_PIE_COLORS - 2 : i);
       wattron(win, COLOR_PAIR(color_pair));
       mvwprintw(win, y, 2, "  ");
       wattroff(win, COLOR_PAIR(color_pair));
       mvwprintw(win, y, 4, " %-27s", name);
-      if (categories[sorted_categories_indices[i]].spent > categories[sorted_categories_indices[i]].budget)
+      Money available = figures.budget + figures.extra;
+      if (figures.spent > available)
       {
         wattron(win, COLOR_PAIR(3));
       }
-      else if (categories[sorted_categories_indices[i]].spent < 0.5 * categories[sorted_categories_indices[i]].budget)
+      else if (2 * figures.spent < available)
       {
         wattron(win, COLOR_PAIR(2));
       }
@@ -455,46 +338,44 @@ void display_categories(WINDOW *win, int start_y)
       {
         wattron(win, COLOR_PAIR(1));
       }
-      mvwprintw(win, y, 32, " $%-14.2f", categories[sorted_categories_indices[i]].spent);
+      mvwprintw(win, y, 32, " $%-14s", money_str(figures.spent));
       wattroff(win, COLOR_PAIR(3) | COLOR_PAIR(2) | COLOR_PAIR(1));
-      mvwprintw(win, y++, 48, " $%-14.2f", categories[sorted_categories_indices[i]].budget);
+      mvwprintw(win, y++, 48, " $%-14s", money_str(figures.budget));
     }
     else
     {
-      mvwprintw(win, y++, 2, "%-30s $%-14.2f $%-14.2f",
-                name, categories[sorted_categories_indices[i]].spent, categories[sorted_categories_indices[i]].budget);
+      mvwprintw(win, y++, 2, "%-30s $%-14s $%-14s",
+                name, money_str(figures.spent), money_str(figures.budget));
     }
   }
+  free(rows);
   mvwprintw(win, y++, 2, "-------------------------------------------------------------------");
 
   if (total_allocated < current_month_total_budget)
   {
-    double savings = current_month_total_budget - total_allocated;
-    double savings_percent = (savings / current_month_total_budget) * 100.0;
+    Money savings = current_month_total_budget - total_allocated;
+    double savings_percent = 100.0 * savings / current_month_total_budget;
     mvwprintw(win, y, 2, "[]");
-    mvwprintw(win, y++, 4, " %-27s %-15s $%.2f (%.2f%%)",
-              "Savings", " ", savings, savings_percent);
+    mvwprintw(win, y++, 4, " %-27s %-15s $%s (%.2f%%)",
+              "Savings", " ", money_str(savings), savings_percent);
   }
   else
   {
     wattron(win, COLOR_PAIR(3));
-    double overspent = total_spent - current_month_total_budget;
-    double overspent_percent = (overspent / current_month_total_budget) * 100.0;
-    mvwprintw(win, y++, 2, "%-30s $%.2f (%.2f%%)",
-              "Overspent", overspent, overspent_percent);
+    Money overspent = total_spent - current_month_total_budget;
+    double overspent_percent = 100.0 * overspent / current_month_total_budget;
+    mvwprintw(win, y++, 2, "%-30s $%s (%.2f%%)",
+              "Overspent", money_str(overspent), overspent_percent);
     wattroff(win, COLOR_PAIR(3));
   }
-  mvwprintw(win, y++, 2, "%-30s $%-14.2f $%-14.2f",
-            "Total", total_spent, total_allocated);
+  mvwprintw(win, y++, 2, "%-30s $%-14s $%-14s",
+            "Total", money_str(total_spent), money_str(total_allocated));
 }
 
-void display_transactions(WINDOW *win, int start_y, int selected_transaction, int *first_display_transaction, bool highlight_selected)
+// Keep the selected row on screen and draw the column headers and scroll indicators.
+// Returns the number of rows that fit below the headers.
+static int begin_transaction_list(WINDOW *win, int start_y, SortField sort, int row_count, int selected_transaction, int *first_display_transaction)
 {
-  if (current_month_transaction_count == 0)
-  {
-    mvwprintw(win, 1, 2, "No transactions recorded yet.");
-    mvwprintw(win, 2, 2, "Select 'Add Transaction' from the Actions menu.");
-  }
   int y = start_y;
   int max_y, max_x;
   getmaxyx(win, max_y, max_x);
@@ -507,8 +388,8 @@ void display_transactions(WINDOW *win, int start_y, int selected_transaction, in
   // Ensure selected transaction is within valid range
   if (selected_transaction < 0)
     selected_transaction = 0;
-  if (selected_transaction >= current_month_transaction_count)
-    selected_transaction = current_month_transaction_count - 1;
+  if (selected_transaction >= row_count)
+    selected_transaction = row_count - 1;
 
   // Adjust first_display_transaction if necessary to keep selected transaction visible
   if (selected_transaction < *first_display_transaction)
@@ -519,86 +400,167 @@ void display_transactions(WINDOW *win, int start_y, int selected_transaction, in
   // Ensure first_display_transaction is within valid range
   if (*first_display_transaction < 0)
     *first_display_transaction = 0;
-  if (current_month_transaction_count > 0 && *first_display_transaction >= current_month_transaction_count)
-    *first_display_transaction = current_month_transaction_count - 1;
-
-  // Display headers
+  if (row_count > 0 && *first_display_transaction >= row_count)
+    *first_display_transaction = row_count - 1;
+
+  // Display headers, marking the sorted column with its direction
+  char headers[NUM_SORT_FIELDS][16];
+  for (SortField field = 0; field < NUM_SORT_FIELDS; field++)
+    snprintf(headers[field], sizeof(headers[field]), "%s%s", sort_field_name(field),
+             field != sort ? "" : sort == SORT_BY_DATE || sort == SORT_BY_AMOUNT ? " v" : " ^");
   mvwprintw(win, y++, 2, "%-10s %-24s %-10s %-24s",
-            "Date", "Description", "Amount", "Category");
+            headers[SORT_BY_DATE], headers[SORT_BY_DESCRIPTION], headers[SORT_BY_AMOUNT], headers[SORT_BY_CATEGORY]);
   mvwprintw(win, y++, 2, "-----------------------------------------------------------------------");
 
-  char prev_date[11] = "";
-
   // Display scroll indicators if needed
   if (*first_display_transaction > 0)
     mvwprintw(win, y - 1, max_x - 3, "^");
 
-  if (*first_display_transaction + displayable_rows < current_month_transaction_count)
+  if (*first_display_transaction + displayable_rows < row_count)
     mvwprintw(win, y + displayable_rows, max_x - 3, "v");
 
+  return displayable_rows;
+}
+
+// Print one row; repeated dates are blanked, except on the selected row
+static void draw_transaction_row(WINDOW *win, int y, const Transaction *transaction, const char *category_name, char *prev_date, bool selected, bool highlight_selected, bool marked)
+{
+  if (marked)
+    mvwaddch(win, y, 1, '*');
+
+  char display_date[11];
+  if (strcmp(transaction->date, prev_date) == 0 && !selected)
+  {
+    strcpy(display_date, "          ");
+  }
+  else
+  {
+    strncpy(display_date, transaction->date, sizeof(display_date) - 1);
+    display_date[sizeof(display_date) - 1] = '\0';
+
+    // Remember this date for the next iteration
+    strcpy(prev_date, display_date);
+  }
+
+  // Highlight selected transaction
+  attr_t row_attrs = selected && highlight_selected ? COLOR_PAIR(5) : A_NORMAL;
+  // Unusually large for its category: amount in bold red, selected or not
+  attr_t amount_attrs = category_stats_unusual(category_name, transaction) ? A_BOLD | COLOR_PAIR(3) : row_attrs;
+
+  // The amount follows wherever a long description left the cursor
+  wattron(win, row_attrs);
+  mvwprintw(win, y, 2, "%-10s %-24s ", display_date, transaction->desc);
+  wattroff(win, row_attrs);
+  wattron(win, amount_attrs);
+  wprintw(win, "$%-9s", money_str(transaction->amt));
+  wattroff(win, amount_attrs);
+  wattron(win, row_attrs);
+  wprintw(win, " %-24s", category_name);
+  wattroff(win, row_attrs);
+}
+
+// rows selects and orders the rows of the month's sort order to show; NULL shows them all.
+// Rows for which marked returns true get a '*'; marked may be NULL.
+void display_transactions(WINDOW *win, int start_y, SortField sort, const int *rows, int row_count, int selected_transaction, int *first_display_transaction, bool highlight_selected, bool (*marked)(unsigned long long id))
+{
+  const OrderIndex *order = transaction_order(sort);
+  if (order == NULL)
+  {
+    sort = SORT_BY_DATE;
+    order = &sorted_transactions;
+  }
+  if (rows == NULL)
+    row_count = current_month_transaction_count;
+  if (current_month_transaction_count == 0)
+  {
+    mvwprintw(win, 1, 2, "No transactions recorded yet.");
+    mvwprintw(win, 2, 2, "Select 'Add Transaction' from the Actions menu.");
+  }
+  else if (row_count == 0)
+  {
+    mvwprintw(win, 1, 2, "No transactions match the filter.");
+    return;
+  }
+  int displayable_rows = begin_transaction_list(win, start_y, sort, row_count, selected_transaction, first_display_transaction);
+  int y = start_y + 2;
+  char prev_date[11] = "";
+
   // Display visible transactions
   int last_display = *first_display_transaction + displayable_rows;
-  if (last_display > current_month_transaction_count)
-    last_display = current_month_transaction_count;
+  if (last_display > row_count)
+    last_display = row_count;
 
   for (int i = *first_display_transaction; i < last_display; i++)
   {
-    char category_name[MAX_NAME_LEN] = "Uncategorized";
-    strcpy(category_name, categories[sorted_transactions[i]->data.cat_index].name);
-    // Format date for display
-    char display_date[11];
-
-    // If this date is the same as the previous one, use blank space
-    // But always show date for selected transaction
-    if (strcmp(sorted_transactions[i]->data.date, prev_date) == 0 && i != selected_transaction)
-    {
-      strcpy(display_date, "          ");
-    }
-    else
-    {
-      // Format YYYY-MM-DD for display
-      if (strlen(sorted_transactions[i]->data.date) == 10)
-      {
-        strcpy(display_date, sorted_transactions[i]->data.date);
-      }
-      else
-      {
-        strcpy(display_date, sorted_transactions[i]->data.date); // Use as is if format is unexpected
-      }
+    const Transaction *transaction = &order_index_at(order, rows ? rows[i] : i)->data;
+    const Category *category = category_of(transaction->cat_id);
+    const char *category_name = category != NULL ? category->name : "Uncategorized";
+    if (sort != SORT_BY_DATE)
+      prev_date[0] = '\0'; // only runs of one date are worth blanking
+    draw_transaction_row(win, y++, transaction, category_name, prev_date, i == selected_transaction, highlight_selected,
+                         marked != NULL && marked(transaction->id));
+  }
+}
 
-      // Remember this date for the next iteration
-      strcpy(prev_date, sorted_transactions[i]->data.date);
-    }
+void display_range_transactions(WINDOW *win, int start_y, RangeView *view, int selected_transaction, int *first_display_transaction, bool highlight_selected)
+{
+  if (view->total_count == 0)
+  {
+    mvwprintw(win, 1, 2, "No transactions between %s and %s.", view->from_date, view->to_date);
+    return;
+  }
+  int displayable_rows = begin_transaction_list(win, start_y, SORT_BY_DATE, view->total_count, selected_transaction, first_display_transaction);
+  int y = start_y + 2;
+  char prev_date[11] = "";
 
-    // Highlight selected transaction
-    if (i == selected_transaction && highlight_selected)
-      wattron(win, COLOR_PAIR(5));
+  // Only the visible rows are pulled out of the merge
+  RangeRow *rows = malloc(displayable_rows * sizeof(RangeRow));
+  if (rows == NULL)
+    return;
+  int row_count = range_view_window(view, *first_display_transaction, displayable_rows, rows);
+  for (int i = 0; i < row_count; i++)
+  {
+    int index = *first_display_transaction + i;
+    draw_transaction_row(win, y++, rows[i].transaction, rows[i].category, prev_date, index == selected_transaction, highlight_selected, false);
+  }
+  free(rows);
+}
 
-    mvwprintw(win, y++, 2, "%-10s %-24s $%-9.2f %-24s",
-              display_date,
-              sorted_transactions[i]->data.desc,
-              sorted_transactions[i]->data.amt,
-              category_name);
+typedef struct
+{
+  int index; // position in sorted_categories_indices
+  double pct;
+} SpendingCategory;
 
-    if (i == selected_transaction && highlight_selected)
-      wattroff(win, COLOR_PAIR(5));
+// Larger share first; equal shares keep budget order
+static int compare_spending_desc(const void *a, const void *b)
+{
+  const SpendingCategory *cat_a = a, *cat_b = b;
+  if (cat_a->pct != cat_b->pct)
+  {
+    return cat_a->pct < cat_b->pct ? 1 : -1;
   }
+  return cat_a->index - cat_b->index;
 }
 
-BoundedWindow draw_bar_chart(WINDOW *parent_win)
+// Segments follow the rows display_categories shows at the same level, colored to match
+BoundedWindow draw_bar_chart(WINDOW *parent_win, bool top_level)
 {
-  double total_spent = 0.0;
-  double total_budget_allocated = 0.0;
+  Money total_spent = 0;
+  Money total_budget_allocated = 0;
 
   int y, x, start_y, start_x;
   getmaxyx(parent_win, y, x);
   getbegyx(parent_win, start_y, start_x);
 
   // First calculate totals and prepare data
-  for (int i = 0; i < category_count; i++)
+  int *rows = malloc((category_count > 0 ? category_count : 1) * sizeof(int));
+  int row_count = rows != NULL ? category_display_order(rows, top_level) : 0;
+  for (int i = 0; i < row_count; i++)
   {
-    total_spent += categories[sorted_categories_indices[i]].spent;
-    total_budget_allocated += categories[sorted_categories_indices[i]].budget;
+    CategoryRollup figures = category_figures(rows[i], top_level);
+    total_spent += figures.spent;
+    total_budget_allocated += figures.budget;
   }
 
   int bar_width = x - 20; // Leave some margin
@@ -614,46 +576,38 @@ BoundedWindow draw_bar_chart(WINDOW *parent_win)
   mvwprintw(parent_win, y - 5, 1, "Spending Distribution");
 
   // Sort categories by spent amount for the bar chart (highest to lowest)
-  typedef struct
-  {
-    int index;
-    double pct;
-  } SpendingCategory;
-
-  SpendingCategory sorted_cats[MAX_CATEGORIES];
+  SpendingCategory *sorted_cats = malloc((category_count > 0 ? category_count : 1) * sizeof(SpendingCategory));
   int num_active_cats = 0;
 
   // Fill array with categories that have spending
-  for (int i = 0; i < category_count; i++)
+  for (int i = 0; sorted_cats != NULL && i < row_count; i++)
   {
-    if (categories[sorted_categories_indices[i]].spent > 0)
+    Money spent = category_figures(rows[i], top_level).spent;
+    if (spent > 0)
     {
       sorted_cats[num_active_cats].index = i;
-      sorted_cats[num_active_cats].pct = categories[sorted_categories_indices[i]].spent / total_budget_allocated;
+      sorted_cats[num_active_cats].pct = (double)spent / total_budget_allocated;
       num_active_cats++;
     }
   }
+  free(rows);
 
-  // Sort by spent (bubble sort - simple but sufficient for small arrays)
-  for (int i = 0; i < num_active_cats - 1; i++)
-  {
-    for (int j = 0; j < num_active_cats - i - 1; j++)
-    {
-      if (sorted_cats[j].pct < sorted_cats[j + 1].pct)
-      {
-        SpendingCategory temp = sorted_cats[j];
-        sorted_cats[j] = sorted_cats[j + 1];
-        sorted_cats[j + 1] = temp;
-      }
-    }
-  }
+  // Sort by spent; there is no longer a small fixed number of categories
+  qsort(sorted_cats, num_active_cats, sizeof(SpendingCategory), compare_spending_desc);
 
   // Now draw the colored sections representing each category's portion
   int current_pos = 0;
   double drawn_pct = 0.0;
   char usage_str[50];
-  sprintf(usage_str, " $%.2f/$%.2f (%.2f%%)", total_spent, total_budget_allocated, (total_spent / total_budget_allocated) * 100.0);
-  int len = strlen(usage_str);
+  sprintf(usage_str, " $%s/$%s (%.2f%%)", money_str(total_spent), money_str(total_budget_allocated), 100.0 * total_spent / total_budget_allocated);
+
+  // Pad the label out to the bar width so each segment is one string write
+  char bar_text[MAX_BUFFER];
+  if (bar_width > MAX_BUFFER - 1)
+  {
+    bar_width = MAX_BUFFER - 1;
+  }
+  snprintf(bar_text, sizeof(bar_text), "%-*s", bar_width, usage_str);
 
   for (int i = 0; i < num_active_cats; i++)
   {
@@ -661,26 +615,30 @@ BoundedWindow draw_bar_chart(WINDOW *parent_win)
     int cat_index = sorted_cats[i].index;
     int color_pair = PIE_COLOR_START + (cat_index >= NUM_PIE_COLORS ? NUM_PIE_COLORS - 1 : cat_index);
 
-    wattron(bar_win.textbox, COLOR_PAIR(color_pair));
-    while (current_pos < bar_width * drawn_pct)
+    int segment_end = (int)ceil(bar_width * drawn_pct);
+    if (segment_end > bar_width)
     {
-      char ch = current_pos < len ? usage_str[current_pos] : ' ';
-      mvwaddch(bar_win.textbox, 0, current_pos, ch);
-      current_pos++;
+      segment_end = bar_width;
     }
+    if (segment_end <= current_pos)
+    {
+      continue;
+    }
+    wattron(bar_win.textbox, COLOR_PAIR(color_pair));
+    mvwaddnstr(bar_win.textbox, 0, current_pos, bar_text + current_pos, segment_end - current_pos);
     wattroff(bar_win.textbox, COLOR_PAIR(color_pair));
+    current_pos = segment_end;
   }
-  while (current_pos < bar_width)
+  if (current_pos < bar_width)
   {
-    char ch = current_pos < len ? usage_str[current_pos] : ' ';
-    mvwaddch(bar_win.textbox, 0, current_pos, ch);
-    current_pos++;
+    mvwaddnstr(bar_win.textbox, 0, current_pos, bar_text + current_pos, bar_width - current_pos);
   }
+  free(sorted_cats);
   return bar_win;
 }
 
 // New function to create a bar chart and add it as a child window
-BoundedWindow *create_bar_chart(BoundedWindow *parent)
+BoundedWindow *create_bar_chart(BoundedWindow *parent, bool top_level)
 {
   if (parent == NULL || parent->textbox == NULL)
   {
@@ -688,7 +646,7 @@ BoundedWindow *create_bar_chart(BoundedWindow *parent)
   }
 
   // Create the bar chart
-  BoundedWindow bar_win = draw_bar_chart(parent->textbox);
+  BoundedWindow bar_win = draw_bar_chart(parent->textbox, top_level);
 
   // Add it as a child window to the parent
   if (bar_win.textbox != NULL && bar_win.boundary != NULL)
@@ -817,11 +775,11 @@ void display_subscriptions(WINDOW *win, int start_y, int selected_subscription,
     char amt[50] = {0};
     if (subscriptions[i].expense)
     {
-      sprintf(amt, "$%.2f", subscriptions[i].amount);
+      sprintf(amt, "$%s", money_str(subscriptions[i].amount));
     }
     else
     {
-      sprintf(amt, "+$%.2f", subscriptions[i].amount);
+      sprintf(amt, "+$%s", money_str(subscriptions[i].amount));
     }
     strcat(row2, amt);
     switch (subscriptions[i].period_type)
@@ -861,237 +819,206 @@ void display_subscriptions(WINDOW *win, int start_y, int selected_subscription,
 }
 
 // Function to get date input with improved UX
-int get_date_input(WINDOW *win, char *date_buffer, char *prompt)
+void date_field_begin(DateField *field, WINDOW *win, char *prompt)
 {
-  int ch;
-  int highlighted_field = 2;           // 0 = year, 1 = month, 2 = day, 3 = "Today" button
-  int cursor_positions[3] = {0, 5, 8}; // Positions for YYYY-MM-DD: year, month, day
   int y, x;
   getyx(win, y, x);
   mvwprintw(win, y, x, "%s", prompt);
-  y++;
-  x = 0;
+
+  field->win = win;
+  field->y = y + 1;
+  field->x = 0;
+  field->highlighted_field = 2; // 0 = year, 1 = month, 2 = day, 3 = "Today" button
+  field->cursor_positions[0] = 0; // Positions for YYYY-MM-DD: year, month, day
+  field->cursor_positions[1] = 5;
+  field->cursor_positions[2] = 8;
 
   // Enable keypad mode for this window to properly detect arrow keys
   keypad(win, TRUE);
 
   // Date components
-  int day = 1;
-  int month = 1;
-  int year = 2025;
+  field->day = 1;
+  field->month = 1;
+  field->year = 2025;
 
   // If we have a last transaction, use its date
   if (current_month_transaction_count > 0)
   {
-    char temp[5];
-    strncpy(temp, sorted_transactions[0]->data.date, 4);
-    temp[4] = '\0';
-    year = atoi(temp);
-
-    strncpy(temp, sorted_transactions[0]->data.date + 5, 2);
-    temp[2] = '\0';
-    month = atoi(temp);
-
-    strncpy(temp, sorted_transactions[0]->data.date + 8, 2);
-    temp[2] = '\0';
-    day = atoi(temp);
+    sscanf(order_index_at(&sorted_transactions, 0)->data.date, "%d-%d-%d", &field->year, &field->month, &field->day);
   }
 
   // Save original cursor state to restore later
-  int original_cursor_state = curs_set(1); // Show cursor and save original state
+  field->original_cursor_state = curs_set(1); // Show cursor and save original state
 
   // Initial display
-  format_date(win, y, x, day, month, year, highlighted_field, cursor_positions);
-  wnoutrefresh(win);
-  doupdate();
-
-  // Process input
-  while (1)
-  {
-    ch = wgetch(win);
+  format_date(win, field->y, field->x, field->day, field->month, field->year, field->highlighted_field, field->cursor_positions);
+}
 
-    if (ch == '\n')
-    {
-      // If "Today" button is selected, set to today's date
-      if (highlighted_field == 3)
-      {
-        time_t now = time(NULL);
-        struct tm *today = localtime(&now);
-        day = today->tm_mday;
-        month = today->tm_mon + 1;
-        year = today->tm_year + 1900;
-
-        // Show updated date
-        format_date(win, y, x, day, month, year, highlighted_field, cursor_positions);
-        wnoutrefresh(win);
-        doupdate();
-
-        // Short delay to show the change
-        napms(300);
-
-        // Set the date buffer in YYYY-MM-DD format
-        sprintf(date_buffer, "%04d-%02d-%02d", year, month, day);
-
-        // Restore original cursor state
-        curs_set(original_cursor_state);
-        return 1;
-      }
-      else
-      {
-        // User is done editing, convert to YYYY-MM-DD format
-        sprintf(date_buffer, "%04d-%02d-%02d", year, month, day);
+WidgetStatus date_field_feed(DateField *field, int ch)
+{
+  int *day = &field->day, *month = &field->month, *year = &field->year;
 
-        // Restore original cursor state
-        curs_set(original_cursor_state);
-        format_date(win, y, x, day, month, year, 4, cursor_positions);
-        return 1;
-      }
-    }
-    else if (ch == 27)
-    { // ASCII value for ESC key
-      // Always treat as a true escape in date input
-      curs_set(original_cursor_state);
-      return 0;
-    }
-    else if (ch == KEY_BACKSPACE || ch == 127 || ch == KEY_BACKSPACE_ALT)
-    {
-      // User wants to cancel input
-      curs_set(original_cursor_state);
-      return 0;
-    }
-    else if (ch == KEY_RIGHT)
+  if (ch == '\n')
+  {
+    // If "Today" button is selected, set to today's date
+    if (field->highlighted_field == 3)
     {
-      // Move to next field
-      highlighted_field = (highlighted_field + 1) % 4;
-      format_date(win, y, x, day, month, year, highlighted_field, cursor_positions);
-      wnoutrefresh(win);
-      doupdate();
+      time_t now = time(NULL);
+      struct tm *today = localtime(&now);
+      *day = today->tm_mday;
+      *month = today->tm_mon + 1;
+      *year = today->tm_year + 1900;
+
+      // Show updated date
+      format_date(field->win, field->y, field->x, *day, *month, *year, field->highlighted_field, field->cursor_positions);
     }
-    else if (ch == KEY_LEFT)
+    else
     {
-      // Move to previous field
-      highlighted_field = (highlighted_field + 3) % 4;
-      format_date(win, y, x, day, month, year, highlighted_field, cursor_positions);
-      wnoutrefresh(win);
-      doupdate();
+      format_date(field->win, field->y, field->x, *day, *month, *year, 4, field->cursor_positions);
     }
-    else if (ch == KEY_UP)
+    // Restore original cursor state
+    curs_set(field->original_cursor_state);
+    return WIDGET_DONE;
+  }
+  else if (ch == 27)
+  { // ASCII value for ESC key
+    // Always treat as a true escape in date input
+    curs_set(field->original_cursor_state);
+    return WIDGET_CANCELLED;
+  }
+  else if (ch == KEY_BACKSPACE || ch == 127 || ch == KEY_BACKSPACE_ALT)
+  {
+    // User wants to cancel input
+    curs_set(field->original_cursor_state);
+    return WIDGET_CANCELLED;
+  }
+  else if (ch == KEY_RIGHT)
+  {
+    // Move to next field
+    field->highlighted_field = (field->highlighted_field + 1) % 4;
+  }
+  else if (ch == KEY_LEFT)
+  {
+    // Move to previous field
+    field->highlighted_field = (field->highlighted_field + 3) % 4;
+  }
+  else if (ch == KEY_UP)
+  {
+    // Increase current field value
+    if (field->highlighted_field == 2)
     {
-      // Increase current field value
-      if (highlighted_field == 2)
-      {
-        day++;
-        if (day > get_days_in_month(month, year))
-        {
-          day = 1;
-          month++;
-          if (month > 12)
-          {
-            month = 1;
-            year++;
-          }
-        }
-      }
-      else if (highlighted_field == 1)
+      (*day)++;
+      if (*day > get_days_in_month(*month, *year))
       {
-        month++;
-        if (month > 12)
+        *day = 1;
+        (*month)++;
+        if (*month > 12)
         {
-          month = 1;
-          year++;
+          *month = 1;
+          (*year)++;
         }
-        day = validate_day(day, month, year);
       }
-      else if (highlighted_field == 0)
-      {
-        year++;
-        day = validate_day(day, month, year);
-      }
-      // No action for "Today" button
-
-      format_date(win, y, x, day, month, year, highlighted_field, cursor_positions);
-      wnoutrefresh(win);
-      doupdate();
     }
-    else if (ch == KEY_DOWN)
+    else if (field->highlighted_field == 1)
     {
-      // Decrease current field value
-      if (highlighted_field == 2)
+      (*month)++;
+      if (*month > 12)
       {
-        day--;
-        if (day < 1)
-        {
-          day = get_days_in_month(month, year);
-          month--;
-          if (month < 1)
-          {
-            month = 12;
-            year--;
-          }
-        }
+        *month = 1;
+        (*year)++;
       }
-      else if (highlighted_field == 1)
+      *day = validate_day(*day, *month, *year);
+    }
+    else if (field->highlighted_field == 0)
+    {
+      (*year)++;
+      *day = validate_day(*day, *month, *year);
+    }
+    // No action for "Today" button
+  }
+  else if (ch == KEY_DOWN)
+  {
+    // Decrease current field value
+    if (field->highlighted_field == 2)
+    {
+      (*day)--;
+      if (*day < 1)
       {
-        month--;
-        if (month < 1)
+        *day = get_days_in_month(*month, *year);
+        (*month)--;
+        if (*month < 1)
         {
-          month = 12;
-          year--;
+          *month = 12;
+          (*year)--;
         }
-        day = validate_day(day, month, year);
       }
-      else if (highlighted_field == 0)
+    }
+    else if (field->highlighted_field == 1)
+    {
+      (*month)--;
+      if (*month < 1)
       {
-        year--;
-        day = validate_day(day, month, year);
+        *month = 12;
+        (*year)--;
       }
-      // No action for "Today" button
-
-      format_date(win, y, x, day, month, year, highlighted_field, cursor_positions);
-      wnoutrefresh(win);
-      doupdate();
+      *day = validate_day(*day, *month, *year);
     }
-    else if (isdigit(ch) && highlighted_field < 3)
+    else if (field->highlighted_field == 0)
     {
-      // Handle direct digit input for each field
-      int digit = ch - '0';
+      (*year)--;
+      *day = validate_day(*day, *month, *year);
+    }
+    // No action for "Today" button
+  }
+  else if (ch >= 0 && ch < 256 && isdigit(ch) && field->highlighted_field < 3)
+  {
+    // Handle direct digit input for each field
+    int digit = ch - '0';
 
-      if (highlighted_field == 2)
-      { // Day field
-        day = day % 10 * 10 + digit;
-        if (day > get_days_in_month(month, year))
-        {
-          day = digit;
-        }
-        if (day == 0)
-        {
-          day = digit;
-        }
+    if (field->highlighted_field == 2)
+    { // Day field
+      *day = *day % 10 * 10 + digit;
+      if (*day > get_days_in_month(*month, *year))
+      {
+        *day = digit;
       }
-      else if (highlighted_field == 1)
-      { // Month field
-        month = month % 10 * 10 + digit;
-        if (month > 12)
-        {
-          month = digit;
-        }
-        if (month == 0)
-        {
-          month = digit;
-        }
-        day = validate_day(day, month, year);
+      if (*day == 0)
+      {
+        *day = digit;
       }
-      else if (highlighted_field == 0)
-      { // Year field
-        year = year % 1000 * 10 + digit;
-        day = validate_day(day, month, year);
+    }
+    else if (field->highlighted_field == 1)
+    { // Month field
+      *month = *month % 10 * 10 + digit;
+      if (*month > 12)
+      {
+        *month = digit;
       }
-
-      format_date(win, y, x, day, month, year, highlighted_field, cursor_positions);
-      wnoutrefresh(win);
-      doupdate();
+      if (*month == 0)
+      {
+        *month = digit;
+      }
+      *day = validate_day(*day, *month, *year);
+    }
+    else if (field->highlighted_field == 0)
+    { // Year field
+      *year = *year % 1000 * 10 + digit;
+      *day = validate_day(*day, *month, *year);
     }
   }
+  else
+  {
+    return WIDGET_ACTIVE;
+  }
+
+  format_date(field->win, field->y, field->x, *day, *month, *year, field->highlighted_field, field->cursor_positions);
+  return WIDGET_ACTIVE;
+}
+
+// Writes the entered date as YYYY-MM-DD
+void date_field_value(DateField *field, char *date_buffer)
+{
+  sprintf(date_buffer, "%04d-%02d-%02d", field->year % 10000, field->month % 100, field->day % 100);
 }
 
 // Function to display the date in the input field and handle highlighting
@@ -1117,7 +1044,7 @@ void format_date(WINDOW *win, int y, int x, int day, int month, int year, int hi
         (i >= 5 && i <= 6 && highlighted_field == 1) ||
         (i >= 8 && i <= 9 && highlighted_field == 2))
     {
-      wattroff(win, COLOR_PAIR(4));
+      wattroff(win, COLOR_PAIR(5));
     }
   }
 
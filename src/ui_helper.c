@@ -156,33 +156,6 @@ BoundedWindow draw_alert(const char *title, const char *message[], int message_c
   return alert;
 }
 
-BoundedWindow draw_alert_persistent(const char *title, const char *message[], int message_count)
-{
-  const char *full_message[message_count + 1];
-  memcpy(full_message, message, message_count * sizeof(char *));
-  full_message[message_count] = "Press any key to continue...";
-  BoundedWindow alert = draw_alert(title, full_message, message_count + 1);
-  wnoutrefresh(alert.textbox);
-  doupdate();
-  getch();
-  return alert;
-}
-
-void draw_error(BoundedWindow win, const char *message)
-{
-  wclear(win.textbox);
-  mvwprintw(win.textbox, 1, 0, "%s", message);
-  mvwprintw(win.textbox, 2, 0, "Press any key to continue...");
-  wnoutrefresh(win.textbox);
-  doupdate();
-  getch();
-  delwin(win.boundary);
-  delwin(win.textbox);
-  touchwin(stdscr);
-  wnoutrefresh(stdscr);
-  doupdate();
-}
-
 // does not trigger refresh
 void delete_bounded(BoundedWindow win)
 {
@@ -271,12 +244,16 @@ void bwarrnoutrefresh(BoundedWindow *windows[], int count)
   }
 }
 
-int get_confirmation(WINDOW *win, const char *message[], int item_count)
-{
+static const char *confirm_menu[] = {
+    "Yes (y)",
+    "No (n)"};
 
-  const char *confirm_menu[] = {
-      "Yes (y)",
-      "No (n)"};
+void confirm_field_begin(ConfirmField *field, WINDOW *win, const char *message[], int item_count)
+{
+  field->win = win;
+  field->item_count = item_count;
+  field->highlighted = 0;
+  field->choice = 1;
 
   // Ask for confirmation
   wclear(win);
@@ -284,449 +261,485 @@ int get_confirmation(WINDOW *win, const char *message[], int item_count)
   {
     mvwprintw(win, i + 1, 0, "%s", message[i]);
   }
-  int highlighted_item = 0;
+  draw_menu(win, field->highlighted, confirm_menu, 2, item_count + 2);
+}
 
-  while (1)
+WidgetStatus confirm_field_feed(ConfirmField *field, int ch)
+{
+  if (ch == 'y' || ch == 'Y')
+  {
+    field->choice = 0;
+    return WIDGET_DONE;
+  }
+  else if (ch == 'n' || ch == 'N' || ch == KEY_BACKSPACE || ch == KEY_BACKSPACE_ALT || ch == 27)
   {
-    draw_menu(win, highlighted_item, confirm_menu, 2, item_count + 2);
-    wrefresh(win);
+    field->choice = 1;
+    return WIDGET_DONE;
+  }
+  else if (ch == KEY_DOWN || ch == KEY_UP || ch == '\t' || ch == KEY_BTAB)
+  {
+    field->highlighted = (field->highlighted + 1) % 2;
+  }
+  else if (ch == '\n')
+  {
+    field->choice = field->highlighted;
+    return WIDGET_DONE;
+  }
+  draw_menu(field->win, field->highlighted, confirm_menu, 2, field->item_count + 2);
+  return WIDGET_ACTIVE;
+}
 
-    int ch = getch();
+void menu_field_begin(MenuField *field, WINDOW *win, const char *prompt, const char *menu_items[], int item_count, int max_visible_items, int start_y, bool show_numbers)
+{
+  memset(field, 0, sizeof(MenuField));
+  field->win = win;
+  field->items = menu_items;
+  field->item_count = item_count;
+  field->visible_items = max_visible_items;
+  field->start_y = start_y;
+  field->show_numbers = show_numbers;
+  field->filtering = fuzzy_init(&field->matcher, menu_items, item_count) > 0;
 
-    if (ch == 'y' || ch == 'Y')
-    {
-      return 0;
-    }
-    else if (ch == 'n' || ch == 'N' || ch == KEY_BACKSPACE || ch == KEY_BACKSPACE_ALT || ch == 27)
-    {
-      return 1;
-    }
-    else if (ch == KEY_DOWN || ch == KEY_UP || ch == '\t' || ch == KEY_BTAB)
+  keypad(win, TRUE); // Enable arrow keys
+
+  mvwprintw(win, start_y, 0, "%s", prompt);
+  menu_field_draw(field);
+}
+
+// Rows currently listed: the fuzzy matches, or every item if the matcher couldn't be set up
+static int menu_field_rows(MenuField *field)
+{
+  return field->filtering ? field->matcher.match_count : field->item_count;
+}
+
+static int menu_field_item(MenuField *field, int row)
+{
+  return field->filtering ? field->matcher.matches[row].index : row;
+}
+
+// Print text with the characters at positions (sorted) underlined
+void print_fuzzy_highlighted(WINDOW *win, const char *text, const int *positions, int position_count)
+{
+  int next = 0;
+  for (int i = 0; text[i]; i++)
+  {
+    bool matched = next < position_count && positions[next] == i;
+    if (matched)
     {
-      highlighted_item = (highlighted_item + 1) % 2;
+      wattron(win, A_UNDERLINE | A_BOLD);
+      next++;
     }
-    else if (ch == '\n')
+    waddch(win, (unsigned char)text[i]);
+    if (matched)
     {
-      return highlighted_item;
+      wattroff(win, A_UNDERLINE | A_BOLD);
     }
   }
 }
 
-int get_menu_choice(WINDOW *win, const char *menu_items[], int item_count, int start_y, int allow_back)
+void menu_field_draw(MenuField *field)
 {
-  int highlighted_item = 0;
-  int ch;
-
-  // Enable keypad mode for this window to properly detect arrow keys
-  keypad(win, TRUE);
+  WINDOW *win = field->win;
+  int start_y = field->start_y;
+  int row_count = menu_field_rows(field);
 
-  draw_menu(win, highlighted_item, menu_items, item_count, start_y);
-  wrefresh(win);
+  // Typed filter goes on the line between the prompt and the items
+  wmove(win, start_y + 1, 0);
+  wclrtoeol(win);
+  if (field->matcher.query_len > 0)
+  {
+    mvwprintw(win, start_y + 1, 0, "> %s", field->matcher.query);
+  }
 
-  while (1)
+  // Add scroll indicators if needed
+  if (field->start_index > 0)
+  {
+    mvwprintw(win, start_y + 1, getmaxx(win) - 3, "^");
+  }
+  else
+  {
+    mvwprintw(win, start_y + 1, getmaxx(win) - 3, " ");
+  }
+  if (field->start_index + field->visible_items < row_count)
+  {
+    mvwprintw(win, start_y + 2 + field->visible_items, getmaxx(win) - 3, "v");
+  }
+  else
   {
-    ch = wgetch(win);
+    mvwprintw(win, start_y + 2 + field->visible_items, getmaxx(win) - 3, " ");
+  }
 
-    // Handle numeric key presses (1-9)
-    if (ch >= '1' && ch <= '9')
+  int positions[FUZZY_MAX_QUERY];
+  for (int i = field->start_index; i < field->start_index + field->visible_items && i < field->item_count; i++)
+  {
+    // Clear rows left over from a longer list
+    wmove(win, start_y + 2 + i - field->start_index, 0);
+    wclrtoeol(win);
+    if (i >= row_count)
     {
-      int choice = ch - '1';
-      if (choice < item_count)
-      {
-        return choice;
-      }
+      continue;
     }
+    int item = menu_field_item(field, i);
 
-    // Handle arrow keys and enter
-    switch (ch)
+    // Apply highlighting before printing if this is the current item
+    if (i == field->highlighted)
     {
-    case KEY_UP:
-      if (highlighted_item > 0)
-      {
-        highlighted_item--;
-      }
-      break;
-    case KEY_DOWN:
-      if (highlighted_item < item_count - 1)
-      {
-        highlighted_item++;
-      }
-      break;
-    case KEY_LEFT:
-    case KEY_RIGHT:
-      // Ignore left/right arrow keys in menus
-      break;
-    case '\n': // Enter key
-      return highlighted_item;
-    case KEY_BACKSPACE:
-    case KEY_BACKSPACE_ALT: // This is already 127 from the main.h define
-      if (allow_back)
-      {
-        return -1; // Signal to go back
-      }
-      break;
-    case 27: // ESC key (ASCII value)
-      if (allow_back)
-      {
-        return -1; // Signal to go back
-      }
-      break;
+      wattron(win, COLOR_PAIR(5));
     }
 
-    draw_menu(win, highlighted_item, menu_items, item_count, start_y);
-    wrefresh(win);
+    // Print the row
+    if (field->show_numbers)
+    {
+      wprintw(win, "%d. ", item + 1);
+    }
+    if (field->matcher.query_len > 0 && fuzzy_score(field->items[item], field->matcher.query, positions) >= 0)
+    {
+      print_fuzzy_highlighted(win, field->items[item], positions, field->matcher.query_len);
+    }
+    else
+    {
+      wprintw(win, "%s", field->items[item]);
+    }
+    // Turn off highlighting after printing
+    if (i == field->highlighted)
+    {
+      wattroff(win, COLOR_PAIR(5));
+    }
   }
 }
 
-int get_scrollable_menu_choice(WINDOW *win, char *prompt, const char *menu_items[], int item_count, int max_visible_items, int start_y, bool show_numbers)
+int menu_field_value(MenuField *field)
 {
-  int start_index = 0;
-  int visible_items = max_visible_items;
-  int current_highlighted = 0;
-  bool redraw = true;
+  return field->choice;
+}
 
-  keypad(win, TRUE); // Enable arrow keys
+void menu_field_end(MenuField *field)
+{
+  if (field->filtering)
+  {
+    fuzzy_free(&field->matcher);
+    field->filtering = false;
+  }
+}
 
-  mvwprintw(win, start_y, 0, "%s", prompt);
+// Apply an edited filter and go back to the best match
+static void menu_field_filter(MenuField *field, const char *query)
+{
+  fuzzy_set_query(&field->matcher, query);
+  field->highlighted = 0;
+  field->start_index = 0;
+}
 
-  char number_buffer[10] = {0};
-  int buffer_pos = 0;
-  time_t last_input_time = 0;
+WidgetStatus menu_field_feed(MenuField *field, int ch)
+{
+  int item_count = menu_field_rows(field);
+  int visible_items = field->visible_items;
 
-  while (1)
+  // Digits jump to a numbered row until a filter is being typed
+  if (isdigit(ch) && field->matcher.query_len == 0)
   {
-    if (redraw)
-    {
-      // Add scroll indicators if needed
-      if (start_index > 0)
-      {
-        mvwprintw(win, start_y + 1, getmaxx(win) - 3, "^");
-      }
-      else
-      {
-        mvwprintw(win, start_y + 1, getmaxx(win) - 3, " ");
-      }
-      if (start_index + visible_items < item_count)
-      {
-        mvwprintw(win, start_y + 2 + visible_items, getmaxx(win) - 3, "v");
-      }
-      else
-      {
-        mvwprintw(win, start_y + 2 + visible_items, getmaxx(win) - 3, " ");
-      }
-
-      for (int i = start_index; i < start_index + visible_items && i < item_count; i++)
-      {
-        // Apply highlighting before printing if this is the current item
-        if (i == current_highlighted)
-        {
-          wattron(win, COLOR_PAIR(5));
-        }
-
-        // Print the row
-        wmove(win, start_y + 2 + i - start_index, 0);
-        wclrtoeol(win);
-        if (show_numbers)
-        {
-          wprintw(win, "%d. ", i + 1);
-        }
-        wprintw(win, "%s", menu_items[i]);
-        // Turn off highlighting after printing
-        if (i == current_highlighted)
-        {
-          wattroff(win, COLOR_PAIR(4));
-        }
-      }
-
-      wrefresh(win);
-      redraw = false;
+    time_t current_time = time(NULL);
+    if (current_time - field->last_input_time > 1)
+    { // 1 second timeout
+      field->buffer_pos = 0;
+      memset(field->number_buffer, 0, sizeof(field->number_buffer));
     }
+    field->last_input_time = current_time;
 
-    int ch = wgetch(win);
+    // Add digit to buffer
+    if (field->buffer_pos < (int)sizeof(field->number_buffer) - 1)
+    {
+      field->number_buffer[field->buffer_pos++] = ch;
+      field->number_buffer[field->buffer_pos] = '\0';
+    }
 
-    switch (ch)
+    // Convert buffer to number and jump to that position
+    int selected_index = atoi(field->number_buffer) - 1; // Convert to 0-based index
+    if (selected_index >= item_count)
     {
-    case '0':
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-    case '8':
-    case '9':
+      // flush buffer
+      field->buffer_pos = 0;
+      memset(field->number_buffer, 0, sizeof(field->number_buffer));
+      field->number_buffer[field->buffer_pos++] = ch;
+      field->number_buffer[field->buffer_pos] = '\0';
+      selected_index = atoi(field->number_buffer) - 1;
+    }
+
+    // Validate the index
+    if (selected_index >= 0 && selected_index < item_count)
     {
-      time_t current_time = time(NULL);
-      if (current_time - last_input_time > 1)
-      { // 1 second timeout
-        buffer_pos = 0;
-        memset(number_buffer, 0, sizeof(number_buffer));
-      }
-      last_input_time = current_time;
+      field->highlighted = selected_index;
 
-      // Add digit to buffer
-      if (buffer_pos < (int)sizeof(number_buffer) - 1)
+      // Adjust scroll position if needed
+      if (field->highlighted < field->start_index)
       {
-        number_buffer[buffer_pos++] = ch;
-        number_buffer[buffer_pos] = '\0';
+        field->start_index = field->highlighted;
       }
-
-      // Convert buffer to number and jump to that position
-      int selected_index = atoi(number_buffer) - 1; // Convert to 0-based index
-      if (selected_index >= item_count)
+      else if (field->highlighted >= field->start_index + visible_items)
       {
-        // flush buffer
-        buffer_pos = 0;
-        memset(number_buffer, 0, sizeof(number_buffer));
-        number_buffer[buffer_pos++] = ch;
-        number_buffer[buffer_pos] = '\0';
-        selected_index = atoi(number_buffer) - 1;
+        field->start_index = field->highlighted - visible_items + 1;
       }
+    }
+    menu_field_draw(field);
+    return WIDGET_ACTIVE;
+  }
 
-      // Validate the index
-      if (selected_index >= 0 && selected_index < item_count)
-      {
-        current_highlighted = selected_index;
-
-        // Adjust scroll position if needed
-        if (current_highlighted < start_index)
-        {
-          start_index = current_highlighted;
-        }
-        else if (current_highlighted >= start_index + visible_items)
-        {
-          start_index = current_highlighted - visible_items + 1;
-        }
-
-        redraw = true;
-      }
-      continue;
+  // j and k move like the arrows until a filter is being typed
+  if ((ch == 'j' || ch == 'k') && field->matcher.query_len == 0)
+  {
+    ch = ch == 'j' ? KEY_DOWN : KEY_UP;
+  }
+
+  // Any other printable key narrows the list
+  else if (field->filtering && ch < 256 && isprint(ch) && field->matcher.query_len < FUZZY_MAX_QUERY - 1)
+  {
+    char query[FUZZY_MAX_QUERY];
+    memcpy(query, field->matcher.query, field->matcher.query_len);
+    query[field->matcher.query_len] = ch;
+    query[field->matcher.query_len + 1] = '\0';
+    menu_field_filter(field, query);
+    menu_field_draw(field);
+    return WIDGET_ACTIVE;
+  }
+
+  switch (ch)
+  {
+  case KEY_UP:
+    if (item_count == 0)
+    {
+      break;
     }
-    case KEY_UP:
-      if (current_highlighted > 0)
+    if (field->highlighted > 0)
+    {
+      field->highlighted--;
+      if (field->highlighted < field->start_index)
       {
-        current_highlighted--;
-        if (current_highlighted < start_index)
-        {
-          start_index = current_highlighted;
-        }
-        redraw = true;
+        field->start_index = field->highlighted;
       }
-      else
+    }
+    else
+    {
+      field->highlighted = item_count - 1;
+      field->start_index = field->highlighted - visible_items + 1;
+      if (field->start_index < 0)
       {
-        current_highlighted = item_count - 1;
-        start_index = current_highlighted - visible_items + 1;
-        if (start_index < 0)
-        {
-          start_index = 0;
-        }
-        redraw = true;
+        field->start_index = 0;
       }
-      continue;
+    }
+    break;
 
-    case KEY_DOWN:
-      if (current_highlighted < item_count - 1)
-      {
-        current_highlighted++;
-        if (current_highlighted >= start_index + visible_items)
-        {
-          start_index = current_highlighted - visible_items + 1;
-        }
-        redraw = true;
-      }
-      else
+  case KEY_DOWN:
+    if (item_count == 0)
+    {
+      break;
+    }
+    if (field->highlighted < item_count - 1)
+    {
+      field->highlighted++;
+      if (field->highlighted >= field->start_index + visible_items)
       {
-        current_highlighted = 0;
-        start_index = 0;
-        redraw = true;
+        field->start_index = field->highlighted - visible_items + 1;
       }
-      continue;
-
-    case '\n': // Enter key - proceed to confirmation
-      return current_highlighted;
+    }
+    else
+    {
+      field->highlighted = 0;
+      field->start_index = 0;
+    }
+    break;
 
-    case 27: // ASCII ESC key
-      return -1;
+  case '\n': // Enter key - proceed to confirmation
+    if (item_count == 0)
+    {
+      return WIDGET_ACTIVE; // nothing matches the filter
+    }
+    field->choice = menu_field_item(field, field->highlighted);
+    menu_field_end(field);
+    return WIDGET_DONE;
 
-    case KEY_BACKSPACE:
-    case KEY_BACKSPACE_ALT:
-      return -1;
+  case KEY_BACKSPACE:
+  case KEY_BACKSPACE_ALT:
+    if (field->matcher.query_len > 0)
+    {
+      char query[FUZZY_MAX_QUERY];
+      memcpy(query, field->matcher.query, field->matcher.query_len - 1);
+      query[field->matcher.query_len - 1] = '\0';
+      menu_field_filter(field, query);
+      break;
     }
+    menu_field_end(field);
+    return WIDGET_CANCELLED;
+
+  case 27: // ASCII ESC key
+    menu_field_end(field);
+    return WIDGET_CANCELLED;
+
+  default:
+    return WIDGET_ACTIVE;
   }
-  return -1; // @dev this should never happen
+
+  menu_field_draw(field);
+  return WIDGET_ACTIVE;
+}
+
+// Redraw the text being edited and park the cursor at the edit position
+static void input_field_draw(InputField *field)
+{
+  wmove(field->win, field->y, field->x);
+  wclrtoeol(field->win);
+  mvwprintw(field->win, field->y, field->x, "%s", field->buffer);
+  wmove(field->win, field->y, field->x + field->pos);
 }
 
-int get_input(WINDOW *win, void *value, char *prompt, int max_len, InputType type)
+void input_field_begin(InputField *field, WINDOW *win, const char *prompt, int max_len, InputType type)
 {
-  int ch;
-  int pos = 0;
   int y, x;
   getyx(win, y, x);
-  
+
   wclrtoeol(win);
   mvwprintw(win, y, 0, "%s", prompt);
-  x += strlen(prompt);
-  char buffer[max_len];
-  buffer[0] = '\0';
+
+  field->win = win;
+  field->y = y;
+  field->x = x + strlen(prompt);
+  field->pos = 0;
+  field->max_len = max_len < MAX_INPUT_LEN ? max_len : MAX_INPUT_LEN;
+  field->type = type;
+  field->buffer[0] = '\0';
 
   // Enable keypad mode for this window to properly detect arrow keys
   keypad(win, TRUE);
 
   // Turn on cursor
   curs_set(1);
+  input_field_draw(field);
+}
 
-  mvwprintw(win, y, x, "%s", buffer);
-  pos = strlen(buffer);
-  int cursor_x = x + pos;
+// Start the field out holding text, cursor at the end, for editing an existing value
+void input_field_set(InputField *field, const char *text)
+{
+  int len = strlen(text);
+  if (len > field->max_len - 1)
+  {
+    len = field->max_len - 1;
+  }
+  memcpy(field->buffer, text, len);
+  field->buffer[len] = '\0';
+  field->pos = len;
+  input_field_draw(field);
+}
 
-  wmove(win, y, cursor_x);
+WidgetStatus input_field_feed(InputField *field, int ch)
+{
+  char *buffer = field->buffer;
+  int len = strlen(buffer);
 
-  while (1)
+  if (ch == '\n')
   {
-    wrefresh(win);
-    ch = wgetch(win);
-
-    if (ch == '\n')
+    curs_set(0);
+    if (len == 0)
     {
-      buffer[pos] = '\0';
-      if (strlen(buffer) == 0)
-      {
-        curs_set(0);
-        return 0;
-      }
-      break;
+      return WIDGET_CANCELLED;
     }
-    else if (ch == 27)
-    { // ASCII value for ESC key
-      // Always treat as a true escape when in string input
-      curs_set(0);
-      return 0; // Cancel
-    }
-    else if (ch == KEY_BACKSPACE || ch == 127 || ch == KEY_BACKSPACE_ALT)
-    { // Handle backspace or delete
-      if (pos > 0)
-      {
-        pos--;
-        cursor_x--;
-
-        // Shift characters to the left
-        for (int i = pos; i < (int)strlen(buffer); i++)
-        {
-          buffer[i] = buffer[i + 1];
-        }
-
-        // Redraw the input field
-        wmove(win, y, x);
-        wclrtoeol(win);
-        mvwprintw(win, y, x, "%s", buffer);
-        wmove(win, y, cursor_x);
-      }
-    }
-    else if (ch == KEY_LEFT)
+    wmove(field->win, field->y + 1, 0);
+    return WIDGET_DONE;
+  }
+  else if (ch == 27)
+  { // ASCII value for ESC key
+    // Always treat as a true escape when in string input
+    curs_set(0);
+    return WIDGET_CANCELLED;
+  }
+  else if (ch == KEY_BACKSPACE || ch == 127 || ch == KEY_BACKSPACE_ALT)
+  { // Handle backspace or delete
+    if (field->pos > 0)
     {
-      if (pos > 0)
-      {
-        pos--;
-        cursor_x--;
-        wmove(win, y, cursor_x);
-      }
+      field->pos--;
+
+      // Shift characters to the left
+      memmove(buffer + field->pos, buffer + field->pos + 1, len - field->pos);
     }
-    else if (ch == KEY_RIGHT)
+  }
+  else if (ch == KEY_LEFT)
+  {
+    if (field->pos > 0)
     {
-      if (pos < (int)strlen(buffer))
-      {
-        pos++;
-        cursor_x++;
-        wmove(win, y, cursor_x);
-      }
+      field->pos--;
     }
-    else if (ch == KEY_UP || ch == KEY_DOWN)
+  }
+  else if (ch == KEY_RIGHT)
+  {
+    if (field->pos < len)
     {
-      // Ignore up/down arrow keys in text input
+      field->pos++;
     }
-    else if (isprint(ch) && pos < max_len - 1)
+  }
+  else if (ch >= 0 && ch < 256 && isprint(ch) && len < field->max_len - 1)
+  {
+    if (field->type == INPUT_MONEY)
     {
-      if (type == INPUT_DOUBLE)
+      char *point = strchr(buffer, '.');
+      if (!isdigit(ch) && ch != '.')
       {
-        if (isdigit(ch) || ch == '.')
-        {
-          if (ch == '.' && strchr(buffer, '.') != NULL)
-          {
-            continue;
-          }
-
-          if (ch == '-' && pos != 0)
-          {
-            continue; // Minus sign only at beginning
-          }
-        }
-        else
-        {
-          continue;
-        }
+        return WIDGET_ACTIVE;
       }
-      else if (type == INPUT_INT)
+      if (ch == '.' && point != NULL)
       {
-        if (isdigit(ch))
-        {
-          if (ch == '-' && pos != 0)
-          {
-            continue; // Minus sign only at beginning
-          }
-        }
-        else
-        {
-          continue;
-        }
+        return WIDGET_ACTIVE;
       }
-
-      // Shift characters to the right
-      for (int i = strlen(buffer); i >= pos; i--)
+      // Cents are the smallest unit, so a third decimal is refused rather than rounded
+      if (isdigit(ch) && point != NULL && field->pos > point - buffer && strlen(point + 1) >= 2)
       {
-        buffer[i + 1] = buffer[i];
+        return WIDGET_ACTIVE;
       }
-
-      buffer[pos] = ch;
-      pos++;
-      cursor_x++;
-
-      // Redraw the input field
-      wmove(win, y, x);
-      wclrtoeol(win);
-      mvwprintw(win, y, x, "%s", buffer);
-      wmove(win, y, cursor_x);
     }
+    else if (field->type == INPUT_INT)
+    {
+      if (!isdigit(ch))
+      {
+        return WIDGET_ACTIVE;
+      }
+    }
+
+    // Shift characters to the right
+    memmove(buffer + field->pos + 1, buffer + field->pos, len - field->pos + 1);
+    buffer[field->pos] = ch;
+    field->pos++;
+  }
+  else
+  {
+    // Up/down and anything unprintable are ignored in text input
+    return WIDGET_ACTIVE;
   }
 
-  if (type == INPUT_DOUBLE)
+  input_field_draw(field);
+  return WIDGET_ACTIVE;
+}
+
+void input_field_value(InputField *field, void *value)
+{
+  if (field->type == INPUT_MONEY)
   {
-    double val = -1.0; // Default to -1 if conversion fails
-    if (buffer[0] != '\0')
+    Money val;
+    if (!money_parse(field->buffer, &val))
     {
-      val = atof(buffer);
+      val = -1; // Empty, or just a point
     }
-    *(double *)value = val;
+    *(Money *)value = val;
   }
-  else if (type == INPUT_INT)
+  else if (field->type == INPUT_INT)
   {
     int val = -1; // Default to -1 if conversion fails
-    if (buffer[0] != '\0')
+    if (field->buffer[0] != '\0')
     {
-      val = atoi(buffer);
+      val = atoi(field->buffer);
     }
     *(int *)value = val;
   }
   else
   {
-    strcpy((char *)value, buffer);
+    strcpy((char *)value, field->buffer);
   }
-
-  wmove(win, y + 1, 0);
-  wrefresh(win);
-
-  curs_set(0);
-  return 1;
 }
 
 // New function to create a bounded window with initialization
@@ -1,12 +1,5 @@
 #include "utils.h"
 
-int compare_transactions_by_date(const void *a, const void *b)
-{
-    const TransactionNode *node_a = *(const TransactionNode **)a;
-    const TransactionNode *node_b = *(const TransactionNode **)b;
-    return strcmp(node_b->data.date, node_a->data.date);
-}
-
 // Helper function to get days in a month
 int get_days_in_month(int m, int y)
 {
@@ -33,30 +26,6 @@ int validate_day(int day, int month, int year)
     return day;
 }
 
-void sort_categories_by_budget()
-{
-    for (int i = 0; i < MAX_CATEGORIES; i++)
-    {
-        sorted_categories_indices[i] = i;
-    }
-    for (int i = 0; i < category_count; i++)
-    {
-        int max = categories[sorted_categories_indices[i]].budget;
-        int max_index = i;
-        for (int j = i; j < MAX_CATEGORIES; j++)
-        {
-            if (categories[sorted_categories_indices[j]].budget > max)
-            {
-                max = categories[sorted_categories_indices[j]].budget;
-                max_index = j;
-            }
-            int tmp = sorted_categories_indices[i];
-            sorted_categories_indices[i] = sorted_categories_indices[max_index];
-            sorted_categories_indices[max_index] = tmp;
-        }
-    }
-}
-
 void cleanup_transactions()
 {
     TransactionNode *current = transaction_head;
@@ -68,6 +37,8 @@ void cleanup_transactions()
     }
     transaction_head = NULL;
     transaction_tail = NULL;
+    order_index_free(&sorted_transactions);
+    drop_column_orders();
 }
 
 #ifdef __APPLE__
@@ -109,3 +80,22 @@ int get_year_from_date(const char *date)
     year_str[4] = '\0';
     return atoi(year_str);
 }
+
+bool contains_ignore_case(const char *haystack, const char *needle)
+{
+    size_t needle_len = strlen(needle);
+    for (; *haystack; haystack++)
+    {
+        size_t i = 0;
+        while (i < needle_len && haystack[i] &&
+               tolower((unsigned char)haystack[i]) == tolower((unsigned char)needle[i]))
+        {
+            i++;
+        }
+        if (i == needle_len)
+        {
+            return true;
+        }
+    }
+    return needle_len == 0;
+}